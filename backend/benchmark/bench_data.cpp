@@ -0,0 +1,150 @@
+#include <benchmark/benchmark.h>
+
+#include "Data/DataPoint.h"
+#include "Data/FixedTimeSeries.h"
+#include "Data/TimeSeries.h"
+
+using namespace STIMWALKER_NAMESPACE;
+
+// The time between two data points of the series (a 2 kHz device)
+static const std::chrono::microseconds DELTA_TIME(500);
+
+// The channel counts, from an analog device to the EMG and IMU of a Delsys
+// system, and the sizes of the series
+static void seriesSizes(benchmark::internal::Benchmark *benchmark) {
+  benchmark->ArgsProduct({{1, 16, 64}, {1000, 10000}});
+}
+
+// Fill a series with [bufferSize] data points of [channelCount] channels. The
+// data points are [DELTA_TIME] apart from the starting time of the series
+static void fill(data::TimeSeries &series, size_t channelCount,
+                 size_t bufferSize) {
+  series.setRollingVectorMaxSize(bufferSize);
+  std::vector<double> values(channelCount);
+  for (size_t i = 0; i < bufferSize; i++) {
+    for (size_t j = 0; j < channelCount; j++) {
+      values[j] = static_cast<double>(i + j);
+    }
+    series.add(DELTA_TIME * i, values);
+  }
+}
+
+static void BM_DataPointConstruct(benchmark::State &state) {
+  size_t channelCount = static_cast<size_t>(state.range(0));
+  std::vector<double> values(channelCount, 1.0);
+  for (auto _ : state) {
+    data::DataPoint point(std::chrono::microseconds(10), values);
+    benchmark::DoNotOptimize(point);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DataPointConstruct)->Arg(1)->Arg(16)->Arg(64);
+
+static void BM_DataPointDeserialize(benchmark::State &state) {
+  size_t channelCount = static_cast<size_t>(state.range(0));
+  auto json = data::DataPoint(std::chrono::microseconds(10),
+                              std::vector<double>(channelCount, 1.0))
+                  .serialize();
+  for (auto _ : state) {
+    data::DataPoint point(json);
+    benchmark::DoNotOptimize(point);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DataPointDeserialize)->Arg(1)->Arg(16)->Arg(64);
+
+// Adding to a full series, so each data point replaces the oldest one (the
+// steady state of the live data of a device)
+static void BM_TimeSeriesAdd(benchmark::State &state) {
+  size_t channelCount = static_cast<size_t>(state.range(0));
+  size_t bufferSize = static_cast<size_t>(state.range(1));
+  data::TimeSeries series;
+  fill(series, channelCount, bufferSize);
+
+  std::vector<double> values(channelCount, 1.0);
+  size_t index = bufferSize;
+  for (auto _ : state) {
+    series.add(DELTA_TIME * index++, values);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimeSeriesAdd)->Apply(seriesSizes);
+
+static void BM_FixedTimeSeriesAdd(benchmark::State &state) {
+  size_t channelCount = static_cast<size_t>(state.range(0));
+  size_t bufferSize = static_cast<size_t>(state.range(1));
+  data::FixedTimeSeries series(DELTA_TIME);
+  series.setRollingVectorMaxSize(bufferSize);
+  std::vector<double> values(channelCount, 1.0);
+  for (size_t i = 0; i < bufferSize; i++) {
+    series.add(values);
+  }
+
+  for (auto _ : state) {
+    series.add(values);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FixedTimeSeriesAdd)->Apply(seriesSizes);
+
+// Getting the second half of a series
+static void BM_TimeSeriesSince(benchmark::State &state) {
+  size_t channelCount = static_cast<size_t>(state.range(0));
+  size_t bufferSize = static_cast<size_t>(state.range(1));
+  data::TimeSeries series;
+  fill(series, channelCount, bufferSize);
+
+  auto half = series.getStartingTime() + DELTA_TIME * (bufferSize / 2);
+  for (auto _ : state) {
+    auto data = series.since(half);
+    benchmark::DoNotOptimize(data);
+  }
+  state.SetItemsProcessed(state.iterations() * bufferSize);
+}
+BENCHMARK(BM_TimeSeriesSince)->Apply(seriesSizes);
+
+// Getting the last tenth of a series
+static void BM_TimeSeriesTail(benchmark::State &state) {
+  size_t channelCount = static_cast<size_t>(state.range(0));
+  size_t bufferSize = static_cast<size_t>(state.range(1));
+  data::TimeSeries series;
+  fill(series, channelCount, bufferSize);
+
+  for (auto _ : state) {
+    auto data = series.tail(bufferSize / 10);
+    benchmark::DoNotOptimize(data);
+  }
+  state.SetItemsProcessed(state.iterations() * (bufferSize / 10));
+}
+BENCHMARK(BM_TimeSeriesTail)->Apply(seriesSizes);
+
+static void BM_TimeSeriesSerialize(benchmark::State &state) {
+  size_t channelCount = static_cast<size_t>(state.range(0));
+  size_t bufferSize = static_cast<size_t>(state.range(1));
+  data::TimeSeries series;
+  fill(series, channelCount, bufferSize);
+
+  for (auto _ : state) {
+    auto json = series.serialize();
+    benchmark::DoNotOptimize(json);
+  }
+  state.SetItemsProcessed(state.iterations() * bufferSize);
+}
+BENCHMARK(BM_TimeSeriesSerialize)->Apply(seriesSizes);
+
+// Computing the zero level over the whole series
+static void BM_TimeSeriesSetZeroLevel(benchmark::State &state) {
+  size_t channelCount = static_cast<size_t>(state.range(0));
+  size_t bufferSize = static_cast<size_t>(state.range(1));
+  data::TimeSeries series;
+  fill(series, channelCount, bufferSize);
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      DELTA_TIME * bufferSize);
+  for (auto _ : state) {
+    series.setZeroLevel(duration);
+    benchmark::DoNotOptimize(series.getZeroLevel());
+  }
+  state.SetItemsProcessed(state.iterations() * bufferSize);
+}
+BENCHMARK(BM_TimeSeriesSetZeroLevel)->Apply(seriesSizes);
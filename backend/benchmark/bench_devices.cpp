@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+
+#include "Data/TimeSeries.h"
+#include "Devices/Devices.h"
+
+using namespace STIMWALKER_NAMESPACE;
+
+// Deserializing the data of a trial, as a client of the server does with the
+// answer to [GET_LAST_TRIAL_DATA]. The trial holds two devices of [channels]
+// channels and [bufferSize] data points each, and the event markers (which
+// are skipped)
+static void BM_DevicesDeserializeData(benchmark::State &state) {
+  size_t channelCount = static_cast<size_t>(state.range(0));
+  size_t bufferSize = static_cast<size_t>(state.range(1));
+
+  data::TimeSeries series;
+  series.setRollingVectorMaxSize(bufferSize);
+  std::vector<double> values(channelCount);
+  for (size_t i = 0; i < bufferSize; i++) {
+    for (size_t j = 0; j < channelCount; j++) {
+      values[j] = static_cast<double>(i + j);
+    }
+    series.add(std::chrono::microseconds(500 * i), values);
+  }
+
+  // The layout of the devices of [Devices::getLastTrialDataSerialized]
+  nlohmann::json json = nlohmann::json::array();
+  json.push_back({{"name", "First device"}, {"data", series.serialize()}});
+  json.push_back({{"name", "Second device"}, {"data", series.serialize()}});
+  auto bytes = json.dump().size();
+
+  for (auto _ : state) {
+    auto data = devices::Devices::deserializeData(json);
+    benchmark::DoNotOptimize(data);
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * bufferSize);
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_DevicesDeserializeData)
+    ->ArgsProduct({{1, 16, 64}, {1000, 10000}})
+    ->Unit(benchmark::kMillisecond);
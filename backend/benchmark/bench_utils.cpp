@@ -0,0 +1,124 @@
+#include <benchmark/benchmark.h>
+
+#include "Data/DataPoint.h"
+#include "Utils/RollingVector.h"
+
+using namespace STIMWALKER_NAMESPACE;
+
+// The sizes of the buffers, from a few seconds of a slow device to a minute of
+// a fast one
+static void bufferSizes(benchmark::internal::Benchmark *benchmark) {
+  benchmark->RangeMultiplier(10)->Range(1000, 100000);
+}
+
+// Adding to a vector that is not full yet, each iteration fills a new vector
+static void BM_RollingVectorPushBack(benchmark::State &state) {
+  size_t bufferSize = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    utils::RollingVector<double> vector(bufferSize);
+    for (size_t i = 0; i < bufferSize; i++) {
+      vector.push_back(static_cast<double>(i));
+    }
+    benchmark::DoNotOptimize(vector.back());
+  }
+  state.SetItemsProcessed(state.iterations() * bufferSize);
+}
+BENCHMARK(BM_RollingVectorPushBack)->Apply(bufferSizes);
+
+// Adding to a full vector, so each value replaces the oldest one (the steady
+// state of a live buffer)
+static void BM_RollingVectorPushBackWrapped(benchmark::State &state) {
+  size_t bufferSize = static_cast<size_t>(state.range(0));
+  utils::RollingVector<double> vector(bufferSize);
+  for (size_t i = 0; i < bufferSize; i++) {
+    vector.push_back(static_cast<double>(i));
+  }
+
+  double value = 0.0;
+  for (auto _ : state) {
+    vector.push_back(value);
+    value += 1.0;
+  }
+  benchmark::DoNotOptimize(vector.back());
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RollingVectorPushBackWrapped)->Apply(bufferSizes);
+
+// Adding data points of [channels] channels to a full vector, which copies
+// the data of each point
+static void BM_RollingVectorPushBackDataPoint(benchmark::State &state) {
+  size_t channelCount = static_cast<size_t>(state.range(0));
+  size_t bufferSize = static_cast<size_t>(state.range(1));
+  utils::RollingVector<data::DataPoint> vector(bufferSize);
+  std::vector<double> values(channelCount, 1.0);
+  for (size_t i = 0; i < bufferSize; i++) {
+    vector.push_back(data::DataPoint(std::chrono::microseconds(i), values));
+  }
+
+  int64_t timeStamp = static_cast<int64_t>(bufferSize);
+  for (auto _ : state) {
+    vector.push_back(
+        data::DataPoint(std::chrono::microseconds(timeStamp++), values));
+  }
+  benchmark::DoNotOptimize(vector.back());
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RollingVectorPushBackDataPoint)
+    ->ArgsProduct({{1, 16, 64}, {1000, 10000}});
+
+// Going through a vector that wrapped, from the oldest value to the newest
+static void BM_RollingVectorIterate(benchmark::State &state) {
+  size_t bufferSize = static_cast<size_t>(state.range(0));
+  utils::RollingVector<double> vector(bufferSize);
+  for (size_t i = 0; i < bufferSize + bufferSize / 2; i++) {
+    vector.push_back(static_cast<double>(i));
+  }
+
+  for (auto _ : state) {
+    double sum = 0.0;
+    for (const auto &value : vector) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * bufferSize);
+}
+BENCHMARK(BM_RollingVectorIterate)->Apply(bufferSizes);
+
+// Same as [BM_RollingVectorIterate], through the indices
+static void BM_RollingVectorIndex(benchmark::State &state) {
+  size_t bufferSize = static_cast<size_t>(state.range(0));
+  utils::RollingVector<double> vector(bufferSize);
+  for (size_t i = 0; i < bufferSize + bufferSize / 2; i++) {
+    vector.push_back(static_cast<double>(i));
+  }
+
+  for (auto _ : state) {
+    double sum = 0.0;
+    for (size_t i = 0; i < bufferSize; i++) {
+      sum += vector[i];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * bufferSize);
+}
+BENCHMARK(BM_RollingVectorIndex)->Apply(bufferSizes);
+
+// Changing the size of a vector that wrapped, which keeps its most recent
+// values
+static void BM_RollingVectorResize(benchmark::State &state) {
+  size_t bufferSize = static_cast<size_t>(state.range(0));
+  utils::RollingVector<double> vector(bufferSize);
+  for (size_t i = 0; i < bufferSize + bufferSize / 2; i++) {
+    vector.push_back(static_cast<double>(i));
+  }
+
+  bool isLarge = false;
+  for (auto _ : state) {
+    vector.resize(isLarge ? bufferSize : 2 * bufferSize);
+    isLarge = !isLarge;
+    benchmark::DoNotOptimize(vector.back());
+  }
+  state.SetItemsProcessed(state.iterations() * bufferSize);
+}
+BENCHMARK(BM_RollingVectorResize)->Apply(bufferSizes);
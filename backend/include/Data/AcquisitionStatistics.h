@@ -0,0 +1,139 @@
+#ifndef __STIMWALKER_DATA_ACQUISITION_STATISTICS_H__
+#define __STIMWALKER_DATA_ACQUISITION_STATISTICS_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "Utils/CppMacros.h"
+
+namespace STIMWALKER_NAMESPACE::data {
+
+/// @brief Accounting of the samples of an acquisition: how many were expected
+/// from the sampling rate of the device, how many were received and where (and
+/// why) some were lost. Positions are indices in the received samples, so a gap
+/// at position [n] means the samples are missing right before the n-th sample
+/// of the series.
+/// @note This class is not thread safe, the owner must protect it
+class AcquisitionStatistics {
+public:
+  /// @brief Why samples are missing
+  enum class GapReason {
+    /// @brief The read from the device failed
+    FAILED_READ = 0,
+
+    /// @brief The device sent a frame without any data (all zeros)
+    EMPTY_FRAME = 1,
+
+    /// @brief The trial writer could not keep up and dropped the block
+    WRITER_OVERFLOW = 2,
+  };
+
+  /// @brief Samples missing from the series
+  struct Gap {
+    /// @brief The position in the series of the sample following the gap
+    size_t position = 0;
+
+    /// @brief When the gap was detected (elapsed time since the start)
+    std::chrono::microseconds timeStamp = std::chrono::microseconds(0);
+
+    /// @brief The number of samples missing
+    size_t sampleCount = 0;
+
+    /// @brief Why the samples are missing
+    GapReason reason = GapReason::FAILED_READ;
+  };
+
+  /// @brief The maximum number of gaps kept in detail. Further gaps are only
+  /// counted, so a device sending empty frames forever cannot exhaust memory
+  static constexpr size_t MAX_GAP_COUNT = 1000;
+
+  /// @brief Constructor
+  /// @param samplePeriod The time between two samples of the device (zero if
+  /// the rate is unknown, in which case no sample is expected)
+  AcquisitionStatistics(
+      const std::chrono::microseconds &samplePeriod =
+          std::chrono::microseconds(0));
+
+  /// @brief Deserialize a json object (from [serialize] or
+  /// [serializeCounts])
+  /// @param json The json object to deserialize
+  AcquisitionStatistics(const nlohmann::json &json);
+
+  /// @brief Forget everything and start counting
+  /// @param samplePeriod The time between two samples of the device (zero if
+  /// the rate is unknown)
+  /// @param startTime When the counting starts (the samples are expected from
+  /// then)
+  void reset(const std::chrono::microseconds &samplePeriod,
+             const std::chrono::steady_clock::time_point &startTime =
+                 std::chrono::steady_clock::now());
+
+  /// @brief Count samples added to the series
+  /// @param count The number of samples received
+  void addReceivedSamples(size_t count);
+
+  /// @brief Record samples that were lost. Consecutive losses for the same
+  /// reason at the same position are merged into a single gap
+  /// @param count The number of samples lost
+  /// @param reason Why the samples were lost
+  /// @param offset The number of samples received after the last count but
+  /// before the lost ones (they are counted afterwards, e.g. a block of
+  /// samples with empty frames in the middle)
+  void addGap(size_t count, GapReason reason, size_t offset = 0);
+
+  /// @brief Count a data check that could not be scheduled on time
+  void addTimerOverrun();
+
+  /// @brief Update the number of samples expected from the time elapsed since
+  /// the start. This is frozen until the next call
+  void updateExpectedSampleCount();
+
+  /// @brief Get the number of samples expected but neither received nor
+  /// reported as dropped (e.g. silently lost by the device or the link)
+  /// @return The number of unaccounted samples
+  size_t getUnaccountedSampleCount() const;
+
+  /// @brief Convert the object to JSON
+  /// @return The JSON object
+  nlohmann::json serialize() const;
+
+  /// @brief Convert the object to JSON without the detail of the gaps (they
+  /// are only counted), so it stays small enough to go with every update of
+  /// the live data
+  /// @return The JSON object
+  nlohmann::json serializeCounts() const;
+
+protected:
+  /// @brief The time between two samples (zero if unknown)
+  DECLARE_PROTECTED_MEMBER(std::chrono::microseconds, SamplePeriod)
+
+  /// @brief When the counting started
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::steady_clock::time_point,
+                                 StartTime)
+
+  /// @brief The number of samples expected at the last
+  /// [updateExpectedSampleCount]
+  DECLARE_PROTECTED_MEMBER(size_t, ExpectedSampleCount)
+
+  /// @brief The number of samples added to the series
+  DECLARE_PROTECTED_MEMBER(size_t, ReceivedSampleCount)
+
+  /// @brief The number of samples reported as lost
+  DECLARE_PROTECTED_MEMBER(size_t, DroppedSampleCount)
+
+  /// @brief The number of gaps (including those not kept in [Gaps])
+  DECLARE_PROTECTED_MEMBER(size_t, GapCount)
+
+  /// @brief The number of data checks that were late
+  DECLARE_PROTECTED_MEMBER(size_t, TimerOverrunCount)
+
+  /// @brief The first [MAX_GAP_COUNT] gaps
+  DECLARE_PROTECTED_MEMBER(std::vector<Gap>, Gaps)
+};
+
+} // namespace STIMWALKER_NAMESPACE::data
+
+#endif // __STIMWALKER_DATA_ACQUISITION_STATISTICS_H__
@@ -0,0 +1,126 @@
+#ifndef __STIMWALKER_DATA_CLOCK_SYNCHRONIZER_H__
+#define __STIMWALKER_DATA_CLOCK_SYNCHRONIZER_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+
+#include "Utils/CppMacros.h"
+
+namespace STIMWALKER_NAMESPACE::data {
+
+/// @brief Estimate the relation between the sample index of a device and the
+/// host clock, so the samples can be given absolute time stamps that do not
+/// drift away from the host (nor from the other devices). Every block read from
+/// the device is a point (index of its last sample, host arrival time) and a
+/// line is fitted through them by a weighted least squares that is updated
+/// incrementally (constant cost per block). The points are weighted by a Huber
+/// weight on their residual, so a late block (e.g. the host was busy) barely
+/// moves the line, and older points are forgotten so the fit follows slow
+/// changes of the drift.
+/// @note The arrival time includes the transport latency, so the line is the
+/// time the samples reached the host, on average. This is common to all the
+/// samples and does not affect the drift
+class ClockSynchronizer {
+public:
+  /// @brief Constructor
+  /// @param samplePeriod The nominal time between two samples, used until
+  /// enough blocks are received to estimate it
+  /// @param blockWindow The number of blocks after which a block weighs
+  /// about a third of a new one in the fit
+  ClockSynchronizer(const std::chrono::microseconds &samplePeriod =
+                        std::chrono::microseconds(0),
+                    size_t blockWindow = 2000);
+
+  /// @brief Forget all the blocks. The next block starts a new fit
+  /// @param samplePeriod The nominal time between two samples
+  void reset(const std::chrono::microseconds &samplePeriod);
+
+  /// @brief Add a block to the fit
+  /// @param lastSampleIndex The index (since the device started) of the last
+  /// sample of the block
+  /// @param arrivalTime When the block arrived on the host
+  void addBlock(size_t lastSampleIndex,
+                const std::chrono::steady_clock::time_point &arrivalTime);
+
+  /// @brief Get the host time of a sample, from the current fit
+  /// @param sampleIndex The index of the sample since the device started
+  /// @return The corrected absolute time of the sample
+  std::chrono::system_clock::time_point getTime(double sampleIndex) const;
+
+  /// @brief Get the estimated time between two samples, in host time
+  /// @return The estimated sample period in microseconds
+  double getEstimatedSamplePeriod() const;
+
+  /// @brief Get how far the actual sample period (in host time) is from the
+  /// nominal one
+  /// @return The drift in parts per million (positive when the samples come
+  /// slower than announced, i.e. the device clock is slower than the host)
+  double getDriftPpm() const;
+
+  /// @brief Get the typical distance between the arrival of the blocks and
+  /// the fit (a robust standard deviation of the arrival jitter)
+  /// @return The jitter in microseconds
+  double getJitter() const;
+
+  /// @brief Get if enough blocks were received to estimate the sample period
+  /// @return True if the fit is estimated from the blocks
+  bool isSynchronized() const;
+
+  /// @brief Convert the fit to JSON. The mapping is given for the samples of a
+  /// series, i.e. the sample [i] of the series is at [origin + offset + i *
+  /// period] microseconds since epoch
+  /// @param firstSampleIndex The index (since the device started) of the first
+  /// sample of the series
+  /// @return The JSON object
+  nlohmann::json serialize(size_t firstSampleIndex = 0) const;
+
+protected:
+  /// @brief Get the fitted host time of a sample relative to [m_Origin]
+  /// @param sampleIndex The index of the sample since the device started
+  /// @return The time in microseconds since [m_Origin]
+  double predict(double sampleIndex) const;
+
+  /// @brief The nominal time between two samples
+  DECLARE_PROTECTED_MEMBER(std::chrono::microseconds, SamplePeriod)
+
+  /// @brief The forgetting factor applied to the previous blocks
+  DECLARE_PROTECTED_MEMBER_NOGET(double, Forgetting)
+
+  /// @brief The number of blocks added since the last reset
+  DECLARE_PROTECTED_MEMBER(size_t, BlockCount)
+
+  /// @brief The number of blocks that were down-weighted as outliers
+  DECLARE_PROTECTED_MEMBER(size_t, OutlierCount)
+
+  /// @brief The host time of the first block (the zero of the fit)
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::steady_clock::time_point,
+                                 SteadyOrigin)
+
+  /// @brief The absolute time corresponding to [m_SteadyOrigin]
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::system_clock::time_point,
+                                 Origin)
+
+  /// @brief The sum of the (forgotten) weights
+  DECLARE_PROTECTED_MEMBER_NOGET(double, WeightSum)
+
+  /// @brief The weighted mean of the sample indices
+  DECLARE_PROTECTED_MEMBER_NOGET(double, MeanIndex)
+
+  /// @brief The weighted mean of the arrival times
+  DECLARE_PROTECTED_MEMBER_NOGET(double, MeanTime)
+
+  /// @brief The weighted sum of squares of the sample indices (centered)
+  DECLARE_PROTECTED_MEMBER_NOGET(double, IndexVariance)
+
+  /// @brief The weighted sum of products of the indices and times (centered)
+  DECLARE_PROTECTED_MEMBER_NOGET(double, Covariance)
+
+  /// @brief The robust scale of the residuals (mean absolute residual)
+  DECLARE_PROTECTED_MEMBER_NOGET(double, ResidualScale)
+};
+
+} // namespace STIMWALKER_NAMESPACE::data
+
+#endif // __STIMWALKER_DATA_CLOCK_SYNCHRONIZER_H__
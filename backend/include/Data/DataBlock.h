@@ -0,0 +1,131 @@
+#ifndef __STIMWALKER_DATA_DATA_BLOCK_H__
+#define __STIMWALKER_DATA_DATA_BLOCK_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+
+#include "Data/DataPoint.h"
+#include "Utils/RollingVector.h"
+
+namespace STIMWALKER_NAMESPACE::data {
+
+/// @brief Non-owning view of a block of consecutive samples. The samples are
+/// either contiguous arrays, stored sample after sample so the value of
+/// [channel] for the [index]th sample is at
+/// [samples()[index * channelCount() + channel]], or consecutive data points of
+/// a rolling vector (e.g. the live data of a collector)
+/// @note The view does not own its data. It is only valid for as long as the
+/// memory it points to, usually the duration of the callback it is passed to
+class DataBlock {
+public:
+  /// @brief Tells [utils::StimwalkerEvent] that the block cannot be copied to
+  /// be notified later
+  static constexpr bool IS_VIEW = true;
+
+  /// @brief Empty constructor
+  DataBlock()
+      : m_TimeStamps(nullptr), m_Samples(nullptr), m_DataPoints(nullptr),
+        m_FirstIndex(0), m_SampleCount(0), m_ChannelCount(0) {}
+
+  /// @brief Constructor
+  /// @param timeStamps The [sampleCount] time stamps of the samples
+  /// @param samples The [sampleCount] x [channelCount] values of the samples
+  /// @param sampleCount The number of samples in the block
+  /// @param channelCount The number of channels of each sample
+  DataBlock(const std::chrono::microseconds *timeStamps, const double *samples,
+            size_t sampleCount, size_t channelCount)
+      : m_TimeStamps(timeStamps), m_Samples(samples), m_DataPoints(nullptr),
+        m_FirstIndex(0), m_SampleCount(sampleCount),
+        m_ChannelCount(channelCount) {}
+
+  /// @brief Constructor over data points already stored
+  /// @param dataPoints The data points holding the samples
+  /// @param firstIndex The index in [dataPoints] of the first sample
+  /// @param sampleCount The number of samples in the block
+  /// @param channelCount The number of channels of each sample
+  DataBlock(const utils::RollingVector<DataPoint> &dataPoints,
+            size_t firstIndex, size_t sampleCount, size_t channelCount)
+      : m_TimeStamps(nullptr), m_Samples(nullptr), m_DataPoints(&dataPoints),
+        m_FirstIndex(firstIndex), m_SampleCount(sampleCount),
+        m_ChannelCount(channelCount) {}
+
+  /// @brief Get the number of samples in the block
+  /// @return The number of samples in the block
+  size_t size() const { return m_SampleCount; }
+
+  /// @brief Get if the block has no sample
+  /// @return True if the block has no sample
+  bool empty() const { return m_SampleCount == 0; }
+
+  /// @brief Get the number of channels of each sample
+  /// @return The number of channels
+  size_t channelCount() const { return m_ChannelCount; }
+
+  /// @brief Get the time stamp of a sample
+  /// @param index The index of the sample
+  /// @return The time stamp of the sample
+  const std::chrono::microseconds &timeStamp(size_t index) const {
+    if (m_DataPoints != nullptr) {
+      return (*m_DataPoints)[m_FirstIndex + index].getTimeStamp();
+    }
+    return m_TimeStamps[index];
+  }
+
+  /// @brief Get the values of a sample
+  /// @param index The index of the sample
+  /// @return A pointer to the [channelCount] values of the sample
+  const double *sample(size_t index) const {
+    if (m_DataPoints != nullptr) {
+      return (*m_DataPoints)[m_FirstIndex + index].getData().data();
+    }
+    return m_Samples + index * m_ChannelCount;
+  }
+
+  /// @brief Get the value of a channel of a sample
+  /// @param index The index of the sample
+  /// @param channel The index of the channel
+  /// @return The value
+  double value(size_t index, size_t channel) const {
+    return sample(index)[channel];
+  }
+
+  /// @brief Get all the time stamps of the block
+  /// @return A pointer to the [size] time stamps (nullptr if the block views
+  /// data points)
+  const std::chrono::microseconds *timeStamps() const { return m_TimeStamps; }
+
+  /// @brief Get all the values of the block
+  /// @return A pointer to the [size] x [channelCount] values (nullptr if the
+  /// block views data points)
+  const double *samples() const { return m_Samples; }
+
+  /// @brief Copy a sample to a DataPoint
+  /// @param index The index of the sample
+  /// @return The sample as a DataPoint
+  DataPoint dataPoint(size_t index) const;
+
+protected:
+  /// @brief The time stamps of the samples
+  const std::chrono::microseconds *m_TimeStamps;
+
+  /// @brief The values of the samples
+  const double *m_Samples;
+
+  /// @brief The data points holding the samples (nullptr if the samples are
+  /// in [m_TimeStamps] and [m_Samples])
+  const utils::RollingVector<DataPoint> *m_DataPoints;
+
+  /// @brief The index in [m_DataPoints] of the first sample
+  size_t m_FirstIndex;
+
+  /// @brief The number of samples
+  size_t m_SampleCount;
+
+  /// @brief The number of channels of each sample
+  size_t m_ChannelCount;
+};
+
+} // namespace STIMWALKER_NAMESPACE::data
+
+#endif // __STIMWALKER_DATA_DATA_BLOCK_H__
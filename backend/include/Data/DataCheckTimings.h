@@ -0,0 +1,64 @@
+#ifndef __STIMWALKER_DATA_DATA_CHECK_TIMINGS_H__
+#define __STIMWALKER_DATA_DATA_CHECK_TIMINGS_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+
+#include "Data/TimingHistogram.h"
+#include "Utils/CppMacros.h"
+
+namespace STIMWALKER_NAMESPACE::data {
+
+/// @brief The timing of the periodic data checks of an asynchronous data
+/// collector: how long each check took, how late the worker was woken up for
+/// it and how long the worker waited before it.
+/// @note This class is not thread safe, the owner must protect it
+class DataCheckTimings {
+public:
+  /// @brief Constructor
+  DataCheckTimings();
+
+  /// @brief Deserialize a json object
+  /// @param json The json object to deserialize
+  DataCheckTimings(const nlohmann::json &json);
+
+  /// @brief Count a data check
+  /// @param idleTime The time the worker waited before the check
+  /// @param lateness The time the worker was woken up after the intended time
+  /// @param duration The time the check took
+  void add(const std::chrono::nanoseconds &idleTime,
+           const std::chrono::nanoseconds &lateness,
+           const std::chrono::nanoseconds &duration);
+
+  /// @brief Forget all the data checks
+  void clear();
+
+  /// @brief Get the number of data checks counted
+  /// @return The number of data checks
+  size_t size() const;
+
+  /// @brief Convert the timings to JSON. The times are in nanoseconds
+  /// @return The JSON object
+  nlohmann::json serialize() const;
+
+  /// @brief Convert the summary of the timings (count, mean, p99 and max of
+  /// each) to JSON, without the bins. The times are in nanoseconds
+  /// @return The JSON object
+  nlohmann::json serializeSummary() const;
+
+protected:
+  /// @brief The time the worker waited before each check
+  DECLARE_PROTECTED_MEMBER(TimingHistogram, IdleTimes)
+
+  /// @brief The time the worker was woken up after the intended time
+  DECLARE_PROTECTED_MEMBER(TimingHistogram, Latenesses)
+
+  /// @brief The time each check took
+  DECLARE_PROTECTED_MEMBER(TimingHistogram, Durations)
+};
+
+} // namespace STIMWALKER_NAMESPACE::data
+
+#endif // __STIMWALKER_DATA_DATA_CHECK_TIMINGS_H__
@@ -0,0 +1,91 @@
+#ifndef __STIMWALKER_DATA_EVENT_MARKER_RECORDER_H__
+#define __STIMWALKER_DATA_EVENT_MARKER_RECORDER_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+#include <mutex>
+
+#include "Data/EventMarkers.h"
+#include "Utils/CppMacros.h"
+#include "Utils/MpscQueue.h"
+
+namespace STIMWALKER_NAMESPACE::data {
+
+/// @brief The channel that collects the event markers of a session. Any thread
+/// (e.g. a device worker) can [add] a marker without taking a lock: it is
+/// stamped right away and pushed to a lock-free queue. The queue is moved into
+/// the sorted [EventMarkers] when the markers are read
+class EventMarkerRecorder {
+  /// @brief A marker waiting in the queue, stamped with the steady clock the
+  /// data collectors time their blocks with
+  struct PendingMarker {
+    std::chrono::steady_clock::time_point time;
+    EventMarkerType type = EventMarkerType::RECORDING_STARTED;
+    std::int64_t payload = 0;
+  };
+
+public:
+  /// @brief Constructor. The session starts now
+  EventMarkerRecorder();
+  EventMarkerRecorder(const EventMarkerRecorder &other) = delete;
+  EventMarkerRecorder &operator=(const EventMarkerRecorder &other) = delete;
+
+  /// @brief Record that an event happens now. This can be called from any
+  /// thread and does not block
+  /// @param type The kind of event
+  /// @param payload A value that depends on [type]
+  void add(EventMarkerType type, std::int64_t payload = 0);
+
+  /// @brief Record that an event happened at [time]. This can be called from
+  /// any thread and does not block
+  /// @param time When the event happened
+  /// @param type The kind of event
+  /// @param payload A value that depends on [type]
+  void addAt(const std::chrono::steady_clock::time_point &time,
+             EventMarkerType type, std::int64_t payload = 0);
+
+  /// @brief Forget the markers and start a new session now. The starting time
+  /// and the time stamps then match those of the time series reset at the
+  /// same moment
+  void reset();
+
+  /// @brief Get the number of markers recorded in the session
+  /// @return The number of markers
+  size_t size() const;
+
+  /// @brief Get the markers that happened in [from, to]. The range is given on
+  /// the steady clock the markers are stamped with, so a range taken around a
+  /// call to [add] always contains its marker (the markers are stored to the
+  /// microsecond, so [to] is included even if taken in the same microsecond)
+  /// @param from The first time of the range
+  /// @param to The last time of the range (included)
+  /// @return The markers of the range
+  EventMarkers
+  between(const std::chrono::steady_clock::time_point &from,
+          const std::chrono::steady_clock::time_point &to) const;
+
+  /// @brief Get all the markers of the session
+  /// @return The markers
+  EventMarkers getMarkers() const;
+
+protected:
+  /// @brief Move the queued markers to [m_Markers]. [m_Mutex] must be held
+  void flush() const;
+
+  /// @brief The markers added but not yet sorted in [m_Markers]
+  mutable utils::MpscQueue<PendingMarker> m_Queue;
+
+  /// @brief The sorted markers of the session
+  mutable EventMarkers m_Markers;
+
+  /// @brief The steady time of the zero time stamp of [m_Markers]
+  std::chrono::steady_clock::time_point m_StopWatch;
+
+  /// @brief The mutex serializing the readers (the consumers of the queue)
+  mutable std::mutex m_Mutex;
+};
+
+} // namespace STIMWALKER_NAMESPACE::data
+
+#endif // __STIMWALKER_DATA_EVENT_MARKER_RECORDER_H__
@@ -0,0 +1,117 @@
+#ifndef __STIMWALKER_DATA_EVENT_MARKERS_H__
+#define __STIMWALKER_DATA_EVENT_MARKERS_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "Utils/CppMacros.h"
+
+namespace STIMWALKER_NAMESPACE::data {
+
+/// @brief The kind of event a marker records
+enum class EventMarkerType : std::uint16_t {
+  /// @brief The devices started recording a trial
+  RECORDING_STARTED = 0,
+
+  /// @brief The devices stopped recording a trial
+  RECORDING_STOPPED = 1,
+
+  /// @brief A stimulator was armed
+  STIMULATOR_ARMED = 10,
+
+  /// @brief A stimulator was disarmed
+  STIMULATOR_DISARMED = 11,
+
+  /// @brief A stimulator delivered a pulse (the payload is its intensity)
+  STIMULATION_PULSE = 12,
+
+  /// @brief A stimulation rule started stimulating (the payload is the index
+  /// of the rule)
+  STIMULATION_RULE_STARTED = 13,
+
+  /// @brief A stimulation rule stopped stimulating (the payload is the index
+  /// of the rule)
+  STIMULATION_RULE_STOPPED = 14,
+
+  /// @brief The server received a command (the payload is the command)
+  SERVER_COMMAND = 20,
+};
+
+/// @brief A timestamped event that happened during the acquisition
+struct EventMarker {
+  /// @brief When the event happened (elapsed time since the starting time of
+  /// the markers, the same way the time stamps of a [TimeSeries] are)
+  std::chrono::microseconds timeStamp = std::chrono::microseconds(0);
+
+  /// @brief The kind of event
+  EventMarkerType type = EventMarkerType::RECORDING_STARTED;
+
+  /// @brief A value that depends on [type]
+  std::int64_t payload = 0;
+};
+
+/// @brief A sparse series of event markers, sorted by time stamp. The markers
+/// are in the same time frame as the time series (absolute time is
+/// [StartingTime] + time stamp), so they can be aligned with the data
+class EventMarkers {
+public:
+  /// @brief Constructor
+  /// @param startingTime The absolute time of the zero time stamp
+  EventMarkers(const std::chrono::system_clock::time_point &startingTime =
+                   std::chrono::system_clock::now());
+
+  /// @brief Deserialize the markers
+  /// @param json The markers in serialized form
+  EventMarkers(const nlohmann::json &json);
+
+  /// @brief Get the number of markers
+  /// @return The number of markers
+  size_t size() const;
+
+  /// @brief Get the marker at a specific index
+  /// @param index The index of the marker
+  /// @return The marker at the given index
+  const EventMarker &operator[](size_t index) const;
+
+  /// @brief Add a marker, keeping the markers sorted. Markers are expected to
+  /// come almost in order, so this is an append most of the time
+  /// @param marker The marker to add
+  void add(const EventMarker &marker);
+
+  /// @brief Remove all the markers. This does not change the starting time
+  void clear();
+
+  /// @brief Get the markers that happened in [from, to). The markers are found
+  /// by binary search
+  /// @param from The first time of the range
+  /// @param to The end of the range (excluded)
+  /// @return The markers of the range (with the same starting time)
+  EventMarkers between(const std::chrono::system_clock::time_point &from,
+                       const std::chrono::system_clock::time_point &to) const;
+
+  /// @brief Get the absolute time of a marker
+  /// @param marker The marker
+  /// @return When the marker happened
+  std::chrono::system_clock::time_point
+  getTime(const EventMarker &marker) const;
+
+  /// @brief Convert the markers to JSON. Each marker is [timeStamp, type,
+  /// payload]
+  /// @return The JSON object
+  nlohmann::json serialize() const;
+
+protected:
+  /// @brief The absolute time of the zero time stamp
+  DECLARE_PROTECTED_MEMBER(std::chrono::system_clock::time_point, StartingTime)
+
+  /// @brief The markers, sorted by time stamp
+  DECLARE_PROTECTED_MEMBER(std::vector<EventMarker>, Markers)
+};
+
+} // namespace STIMWALKER_NAMESPACE::data
+
+#endif // __STIMWALKER_DATA_EVENT_MARKERS_H__
@@ -30,14 +30,30 @@ public:
   virtual void add(const std::chrono::microseconds &timeStamp,
                    const std::vector<double> &data);
 
-  /// @brief Add new data to the collection with the timestamp set to
-  /// StartingTime + delta time * number of data points.
+  /// @brief Add new data to the collection with the timestamp set to the one
+  /// of the last data point + delta time (zero for the first data point)
   /// @param data The data to add.
   void add(const std::vector<double> &data) override;
 
+  /// @brief Add new data to the collection with the timestamp set to the one
+  /// of the last data point + delta time (the acquisition time is ignored)
+  /// @param acquisitionTime When the data were acquired
+  /// @param data The data to add
+  void addAcquiredAt(
+      const std::chrono::high_resolution_clock::time_point &acquisitionTime,
+      const std::vector<double> &data) override;
+
+  /// @brief Account for data that were lost just before the next data added,
+  /// so its time stamp also jumps over them
+  /// @param count The number of data lost
+  void skip(size_t count) override;
+
 protected:
   /// @brief The time frequency of the data
   DECLARE_PROTECTED_MEMBER(std::chrono::microseconds, DeltaTime);
+
+  /// @brief The number of data lost since the last data added
+  DECLARE_PROTECTED_MEMBER_NOGET(size_t, SkippedCount);
 };
 
 } // namespace STIMWALKER_NAMESPACE::data
@@ -0,0 +1,140 @@
+#ifndef __STIMWALKER_DATA_GAIT_PHASE_ESTIMATOR_H__
+#define __STIMWALKER_DATA_GAIT_PHASE_ESTIMATOR_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+
+#include "Data/DataBlock.h"
+#include "Utils/CppMacros.h"
+#include "Utils/StimwalkerEvent.h"
+
+namespace STIMWALKER_NAMESPACE::data {
+
+/// @brief The events of the gait cycle
+enum class GaitEvent {
+  /// @brief No event happened at this sample
+  NONE = 0,
+
+  /// @brief The heel touches the ground (0% of the stride)
+  HEEL_STRIKE = 1,
+
+  /// @brief The toe leaves the ground (the start of the swing)
+  TOE_OFF = 2,
+};
+
+/// @brief Where a sample falls in the gait cycle
+struct GaitPhase {
+  /// @brief The time stamp of the sample
+  std::chrono::microseconds timeStamp;
+
+  /// @brief The percentage of the stride, in [0; 1[ (-1 while the stride is
+  /// not known yet)
+  double percentage;
+
+  /// @brief The event that happened at this sample
+  GaitEvent event;
+};
+
+/// @brief Estimate online the percentage of the stride of a leg from its hip
+/// angle. The maximum of hip flexion happens at a fixed percentage of the
+/// stride, so it is detected on every stride (with a hysteresis, to be robust
+/// to the noise) and the stride duration is averaged from the time between
+/// them. The percentage of each sample is then extrapolated from the last
+/// maximum, so it does not wait for the detection (it is held rather than
+/// moved backward when a maximum comes late), and the heel strikes and toe
+/// offs are published when the percentage reaches them. Each sample has a
+/// constant cost.
+/// @note This class is not thread safe, it is meant to be fed from the
+/// [onNewDataBlock] event of a single collector
+class GaitPhaseEstimator {
+public:
+  /// @brief Constructor
+  /// @param hipChannel The channel of the hip angle in the blocks (deg,
+  /// positive in flexion)
+  /// @param peakPercentage The percentage of the stride where the hip flexion
+  /// is maximal (about 92% for a normal gait)
+  /// @param toeOffPercentage The percentage of the stride of the toe off
+  /// @param hysteresis How much the hip angle must come back from a maximum
+  /// (or a minimum) for it to be detected (deg)
+  GaitPhaseEstimator(size_t hipChannel, double peakPercentage = 0.925,
+                     double toeOffPercentage = 0.6, double hysteresis = 2.0);
+
+  /// @brief Forget the strides, the percentage is unknown until two maxima
+  /// are detected again
+  void reset();
+
+  /// @brief Estimate the phase of all the samples of a block. [onNewGaitPhase]
+  /// is notified for each of them
+  /// @param block The block, with the hip angle at [HipChannel]
+  void addBlock(const DataBlock &block);
+
+  /// @brief Estimate the phase of a sample
+  /// @param timeStamp The time stamp of the sample
+  /// @param hipAngle The hip angle of the sample (deg)
+  /// @return The phase of the sample
+  GaitPhase addSample(const std::chrono::microseconds &timeStamp,
+                      double hipAngle);
+
+  /// @brief Get the percentage of the stride of the last sample
+  /// @return The percentage in [0; 1[, or -1 if the stride is not known yet
+  double getPercentage() const;
+
+  /// @brief Get if enough strides were seen to estimate the percentage
+  /// @return True if the percentage is known
+  bool isTracking() const;
+
+  /// @brief Event called with the phase of every sample added through
+  /// [addBlock]
+  utils::StimwalkerEvent<GaitPhase> onNewGaitPhase;
+
+protected:
+  /// @brief Handle a maximum of the hip flexion
+  /// @param timeStamp When the maximum happened
+  void handlePeak(const std::chrono::microseconds &timeStamp);
+
+  /// @brief The channel of the hip angle in the blocks
+  DECLARE_PROTECTED_MEMBER(size_t, HipChannel)
+
+  /// @brief The percentage of the stride where the hip flexion is maximal
+  DECLARE_PROTECTED_MEMBER(double, PeakPercentage)
+
+  /// @brief The percentage of the stride of the toe off
+  DECLARE_PROTECTED_MEMBER(double, ToeOffPercentage)
+
+  /// @brief How much the angle must come back from an extremum to detect it
+  DECLARE_PROTECTED_MEMBER(double, Hysteresis)
+
+  /// @brief The estimated duration of a stride (zero until two maxima are
+  /// detected)
+  DECLARE_PROTECTED_MEMBER(std::chrono::microseconds, StrideDuration)
+
+  /// @brief The number of maxima accepted as strides
+  DECLARE_PROTECTED_MEMBER(size_t, StrideCount)
+
+  /// @brief The time of the last maximum accepted
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::microseconds, LastPeakTime)
+
+  /// @brief If the angle is going toward a maximum (otherwise a minimum)
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsSeekingPeak)
+
+  /// @brief The extremum of the angle since the last detection
+  DECLARE_PROTECTED_MEMBER_NOGET(double, CandidateAngle)
+
+  /// @brief When [m_CandidateAngle] happened
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::microseconds, CandidateTime)
+
+  /// @brief If no sample was added since the last reset
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsFirstSample)
+
+  /// @brief The phase of the last sample
+  DECLARE_PROTECTED_MEMBER_NOGET(GaitPhase, LastPhase)
+
+  /// @brief When the last heel strike and toe off were published
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::microseconds, LastHeelStrikeTime)
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::microseconds, LastToeOffTime)
+};
+
+} // namespace STIMWALKER_NAMESPACE::data
+
+#endif // __STIMWALKER_DATA_GAIT_PHASE_ESTIMATOR_H__
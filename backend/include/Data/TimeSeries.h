@@ -38,6 +38,15 @@ public:
   /// @param maxSize The maximum size of the rolling vector
   void setRollingVectorMaxSize(size_t maxSize);
 
+  /// @brief Change the maximum size of the rolling vector without losing the
+  /// most recent data
+  /// @param maxSize The new maximum size of the rolling vector
+  void resizeRollingVector(size_t maxSize);
+
+  /// @brief Get the maximum number of data kept by the rolling vector
+  /// @return The maximum number of data kept
+  size_t getRollingVectorMaxSize() const;
+
   /// @brief Clear the data in the collection. This will not change the starting
   /// time
   void clear();
@@ -55,12 +64,26 @@ public:
   /// to the elapsed since [m_StartingTime]
   virtual void add(const std::vector<double> &data);
 
+  /// @brief Add new data to the collection as if [add] was called at
+  /// [acquisitionTime]. This allows to add the data later than they were
+  /// acquired (e.g. from another thread) without changing their time stamp
+  /// @param acquisitionTime When the data were acquired
+  /// @param data The data to add
+  virtual void addAcquiredAt(
+      const std::chrono::high_resolution_clock::time_point &acquisitionTime,
+      const std::vector<double> &data);
+
+  /// @brief Account for data that were lost just before the next data added.
+  /// The time stamps of this series come from the clock, so this does nothing
+  /// @param count The number of data lost
+  virtual void skip(size_t count);
+
   /// @brief Get the data at a specific index
   /// @param index The index of the data
   /// @return The data at the given index
   const DataPoint &operator[](size_t index) const;
 
-  /// @brief Get the last n data
+  /// @brief Get the last n data (all of them if fewer are held)
   /// @param n The number of data to get from the end
   TimeSeries tail(size_t n) const;
 
@@ -72,6 +95,16 @@ public:
   /// @return The last data
   const DataPoint &back() const;
 
+  /// @brief Replace the data by the last [duration] of [source]. The data are
+  /// spliced by blocks and keep their time stamps, so this series takes the
+  /// time reference (starting time and stop watch) of [source]. The data are
+  /// only touched one by one if the zero levels of both series differ
+  /// @param source The series to take the data from
+  /// @param duration How much of the end of [source] to take
+  /// @return The number of data taken
+  size_t seedFrom(const TimeSeries &source,
+                  const std::chrono::microseconds &duration);
+
   /// @brief Get the data since a specific time
   /// @param time The time to get the data since
   TimeSeries since(const std::chrono::system_clock::time_point &time) const;
@@ -0,0 +1,100 @@
+#ifndef __STIMWALKER_DATA_TIMING_HISTOGRAM_H__
+#define __STIMWALKER_DATA_TIMING_HISTOGRAM_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "Utils/CppMacros.h"
+
+namespace STIMWALKER_NAMESPACE::data {
+
+/// @brief Histogram of timing errors (e.g. achieved minus requested time).
+/// The bins are of equal width and centered on zero by default, so early
+/// (negative) and late (positive) errors are both kept. Errors out of the
+/// range are counted in the first or the last bin, the exact extremes are kept
+/// aside.
+/// @note This class is not thread safe, the owner must protect it
+class TimingHistogram {
+public:
+  /// @brief Constructor
+  /// @param binWidth The width of each bin
+  /// @param binCount The number of bins (the range is binCount * binWidth,
+  /// half of it before zero)
+  TimingHistogram(
+      const std::chrono::nanoseconds &binWidth = std::chrono::microseconds(1),
+      size_t binCount = 2000);
+
+  /// @brief Constructor for a range that is not centered on zero (e.g. a
+  /// duration, which is never negative)
+  /// @param binWidth The width of each bin
+  /// @param binCount The number of bins
+  /// @param offset The lower edge of the first bin
+  TimingHistogram(const std::chrono::nanoseconds &binWidth, size_t binCount,
+                  const std::chrono::nanoseconds &offset);
+
+  /// @brief Deserialize a json object
+  /// @param json The json object to deserialize
+  TimingHistogram(const nlohmann::json &json);
+
+  /// @brief Count an error
+  /// @param error The timing error
+  void add(const std::chrono::nanoseconds &error);
+
+  /// @brief Forget all the errors. The bins are kept
+  void clear();
+
+  /// @brief Get the number of errors counted
+  /// @return The number of errors
+  size_t size() const;
+
+  /// @brief Get the mean of the errors
+  /// @return The mean error (zero if there is none)
+  std::chrono::nanoseconds mean() const;
+
+  /// @brief Get an approximation of a quantile of the errors (the center of
+  /// the bin it falls in)
+  /// @param quantile The quantile, between 0 and 1
+  /// @return The error at the quantile (zero if there is none)
+  std::chrono::nanoseconds quantile(double quantile) const;
+
+  /// @brief Convert the histogram to JSON. The errors are in nanoseconds
+  /// @return The JSON object
+  nlohmann::json serialize() const;
+
+  /// @brief Convert the summary of the histogram (count, mean, p99 and max) to
+  /// JSON, without the bins. The errors are in nanoseconds
+  /// @return The JSON object
+  nlohmann::json serializeSummary() const;
+
+protected:
+  /// @brief Get the index of the bin counting [error]
+  size_t binIndex(const std::chrono::nanoseconds &error) const;
+
+  /// @brief The width of each bin
+  DECLARE_PROTECTED_MEMBER(std::chrono::nanoseconds, BinWidth)
+
+  /// @brief The lower edge of the first bin
+  DECLARE_PROTECTED_MEMBER(std::chrono::nanoseconds, Offset)
+
+  /// @brief The number of errors in each bin
+  DECLARE_PROTECTED_MEMBER(std::vector<size_t>, Counts)
+
+  /// @brief The smallest error counted
+  DECLARE_PROTECTED_MEMBER(std::chrono::nanoseconds, Min)
+
+  /// @brief The largest error counted
+  DECLARE_PROTECTED_MEMBER(std::chrono::nanoseconds, Max)
+
+  /// @brief The sum of the errors counted (for the mean)
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::nanoseconds, Sum)
+
+  /// @brief The number of errors counted
+  DECLARE_PROTECTED_MEMBER_NOGET(size_t, Size)
+};
+
+} // namespace STIMWALKER_NAMESPACE::data
+
+#endif // __STIMWALKER_DATA_TIMING_HISTOGRAM_H__
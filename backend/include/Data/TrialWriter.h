@@ -0,0 +1,157 @@
+#ifndef __STIMWALKER_DATA_TRIAL_WRITER_H__
+#define __STIMWALKER_DATA_TRIAL_WRITER_H__
+
+#include "stimwalkerConfig.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Data/TimeSeries.h"
+#include "Utils/CppMacros.h"
+#include "Utils/SpscQueue.h"
+
+namespace STIMWALKER_NAMESPACE::data {
+
+/// @brief Worker that appends the recorded blocks to a trial TimeSeries so the
+/// acquisition thread never pays for the growth of the trial. The acquisition
+/// thread hands each block through a bounded lock-free queue and the writer
+/// appends everything pending at once, every [FlushInterval] or as soon as the
+/// queue is half full. The block buffers go back to the acquisition thread
+/// through a second queue, so a steady stream does not allocate.
+/// @note A single thread may call [write], and [start]/[stop] must not be
+/// called concurrently with it
+class TrialWriter {
+public:
+  /// @brief The state of the writer, to judge if it keeps up with the data
+  struct Metrics {
+    /// @brief The number of blocks waiting to be written
+    size_t queueDepth = 0;
+
+    /// @brief The maximum number of blocks that were waiting at once
+    size_t maxQueueDepth = 0;
+
+    /// @brief The number of blocks that can wait before being dropped
+    size_t queueCapacity = 0;
+
+    /// @brief The number of blocks written to the trial
+    size_t writtenBlockCount = 0;
+
+    /// @brief The number of samples written to the trial
+    size_t writtenSampleCount = 0;
+
+    /// @brief The number of blocks dropped because the queue was full
+    size_t droppedBlockCount = 0;
+
+    /// @brief The number of samples dropped because the queue was full
+    size_t droppedSampleCount = 0;
+
+    /// @brief The number of times the writer appended the pending blocks
+    size_t batchCount = 0;
+  };
+
+  /// @brief Constructor
+  /// @param queueCapacity The number of blocks that can wait to be written
+  /// @param flushInterval The maximum time a block waits to be written
+  TrialWriter(size_t queueCapacity = 256,
+              const std::chrono::milliseconds &flushInterval =
+                  std::chrono::milliseconds(20));
+
+  /// @brief Destructor. The pending blocks are written
+  ~TrialWriter();
+  TrialWriter(const TrialWriter &) = delete;
+  TrialWriter &operator=(const TrialWriter &) = delete;
+
+  /// @brief Start the writer thread that appends the blocks to [trial]. The
+  /// metrics are reset
+  /// @param trial The time series to append to. It must not be accessed by
+  /// anyone else until [stop] returns
+  void start(TimeSeries &trial);
+
+  /// @brief Write all the pending blocks and stop the writer thread
+  void stop();
+
+  /// @brief Get if the writer thread is running
+  /// @return True if the writer thread is running
+  bool isRunning() const;
+
+  /// @brief Hand a block of samples to the writer. This never blocks nor
+  /// allocates in steady state
+  /// @param acquisitionTime When the samples were acquired (see
+  /// [TimeSeries::addAcquiredAt])
+  /// @param samples The samples of the block
+  /// @param gaps The samples lost inside the block, as pairs of the index of
+  /// the sample following the loss and the number of samples lost (see
+  /// [TimeSeries::skip])
+  /// @return True if the block was queued, false if it was dropped (the
+  /// writer is stopped or the queue is full)
+  bool write(const std::chrono::high_resolution_clock::time_point
+                 &acquisitionTime,
+             const std::vector<std::vector<double>> &samples,
+             const std::vector<std::pair<size_t, size_t>> &gaps = {});
+
+  /// @brief Get the state of the writer
+  /// @return The state of the writer
+  Metrics getMetrics() const;
+
+protected:
+  /// @brief A block of samples waiting to be written. The values are stored
+  /// sample after sample so the buffer can be reused for the next block
+  struct Block {
+    std::chrono::high_resolution_clock::time_point acquisitionTime;
+    std::vector<double> values;
+    size_t sampleCount = 0;
+    size_t channelCount = 0;
+    std::vector<std::pair<size_t, size_t>> gaps;
+  };
+
+  /// @brief The loop of the writer thread
+  void writerLoop();
+
+  /// @brief Append all the pending blocks to the trial
+  void writePendingBlocks();
+
+  /// @brief The maximum time a block waits to be written
+  DECLARE_PROTECTED_MEMBER(std::chrono::milliseconds, FlushInterval)
+
+  /// @brief The blocks waiting to be written (acquisition to writer)
+  utils::SpscQueue<Block> m_PendingBlocks;
+
+  /// @brief The written blocks whose buffers can be reused (writer to
+  /// acquisition)
+  utils::SpscQueue<Block> m_FreeBlocks;
+
+  /// @brief The time series the blocks are appended to
+  TimeSeries *m_Trial;
+
+  /// @brief The writer thread
+  DECLARE_PROTECTED_MEMBER_NOGET(std::thread, Writer)
+
+  /// @brief If the writer thread should keep running
+  std::atomic<bool> m_IsRunning;
+
+  /// @brief If the writer was asked to write before the flush interval
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsWakeRequested)
+
+  /// @brief The mutex protecting the wake-up conditions of the writer
+  DECLARE_PROTECTED_MEMBER_NOGET(std::mutex, Mutex)
+
+  /// @brief Used to wake the writer
+  DECLARE_PROTECTED_MEMBER_NOGET(std::condition_variable, Condition)
+
+  /// METRICS
+  std::atomic<size_t> m_MaxQueueDepth;
+  std::atomic<size_t> m_WrittenBlockCount;
+  std::atomic<size_t> m_WrittenSampleCount;
+  std::atomic<size_t> m_DroppedBlockCount;
+  std::atomic<size_t> m_DroppedSampleCount;
+  std::atomic<size_t> m_BatchCount;
+};
+
+} // namespace STIMWALKER_NAMESPACE::data
+
+#endif // __STIMWALKER_DATA_TRIAL_WRITER_H__
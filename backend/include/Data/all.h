@@ -1,7 +1,16 @@
 #ifndef __STIMWALKER_DATA_ALL_H__
 #define __STIMWALKER_DATA_ALL_H__
 
+#include "Data/AcquisitionStatistics.h"
+#include "Data/ClockSynchronizer.h"
+#include "Data/DataBlock.h"
+#include "Data/DataCheckTimings.h"
 #include "Data/DataPoint.h"
+#include "Data/EventMarkerRecorder.h"
+#include "Data/EventMarkers.h"
+#include "Data/GaitPhaseEstimator.h"
 #include "Data/TimeSeries.h"
+#include "Data/TimingHistogram.h"
+#include "Data/TrialWriter.h"
 
 #endif // __STIMWALKER_DATA_ALL_H__
\ No newline at end of file
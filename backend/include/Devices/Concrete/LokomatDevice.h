@@ -3,14 +3,89 @@
 
 #include "stimwalkerConfig.h"
 
+#include <random>
+
 #include "Devices/Concrete/NidaqDevice.h"
 
 namespace STIMWALKER_NAMESPACE::devices {
 
+/// @brief The Lokomat gait orthosis, whose signals are acquired at 1 kHz by a
+/// NI-DAQ card. The channels are:
+///   0-3: the hip and knee angles of the left leg, then of the right leg (deg)
+///   4-7: the hip and knee interaction torques, same order (Nm)
+///   8-11: the hip and knee angular velocities, same order (deg/s)
+///   12: the treadmill speed (km/h)
+///   13: the body weight support (kg)
+///   14: the vertical displacement of the pelvis (mm)
+///   15-16: the gait phase of the left and right legs (0 at heel strike, 1)
+///   17-18: the heel strike triggers of the left and right legs (V)
+///   19-24: the auxiliary analog inputs (V)
 class LokomatDevice : public NidaqDevice {
 public:
-  LokomatDevice() : NidaqDevice(25, std::chrono::milliseconds(1)) {}
+  LokomatDevice();
+  LokomatDevice(const LokomatDevice &other) = delete;
+
+protected:
+  LokomatDevice(std::unique_ptr<AnalogInputTask> task);
+
+public:
+  std::string deviceName() const override;
+  std::string dataCollectorName() const override;
 };
+
+/// ------------ ///
+/// MOCK SECTION ///
+/// ------------ ///
+
+/// @brief A simulator of the Lokomat acquisition. It produces normative gait
+/// kinematics (hip and knee angles from a Fourier series of the gait cycle)
+/// and the signals derived from them, on a fixed stride duration. The blocks
+/// are delivered at the pace of a real card
+class LokomatSimulatorTask : public NidaqDevice::AnalogInputTask {
+public:
+  /// @brief Constructor
+  /// @param deltaTime The time between each frame (1/FrameRate)
+  /// @param sampleCount The number of frames of each block
+  LokomatSimulatorTask(std::chrono::microseconds deltaTime,
+                       size_t sampleCount);
+
+  bool open() override;
+  bool start() override;
+  bool read(std::vector<double> &buffer) override;
+
+  /// @brief Fill a frame. This is also used to produce the synthetic gait
+  /// without the pace of the acquisition (e.g. in the benchmarks)
+  /// @param frame The start of the frame to fill
+  /// @param time The time since the acquisition started (s)
+  void generateFrame(double *frame, double time);
+
+  /// @brief The duration of a stride (a full gait cycle)
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(std::chrono::microseconds,
+                                       StrideDuration)
+
+protected:
+
+  /// @brief The time at which the acquisition started
+  DECLARE_PROTECTED_MEMBER_NOGET(
+      std::chrono::time_point<std::chrono::high_resolution_clock>, StartTime);
+
+  /// @brief The number of frames generated since the acquisition started
+  DECLARE_PROTECTED_MEMBER_NOGET(size_t, FrameCounter)
+
+  /// @brief The generator of the measurement noise
+  DECLARE_PROTECTED_MEMBER_NOGET(std::mt19937, RandomGenerator)
+};
+
+class LokomatDeviceMock : public LokomatDevice {
+public:
+  LokomatDeviceMock();
+
+  bool shouldFailToConnect = false;
+
+protected:
+  bool handleConnect() override;
+};
+
 } // namespace STIMWALKER_NAMESPACE::devices
 
-#endif // __STIMWALKER_DEVICES_LOCOMAT_H__
\ No newline at end of file
+#endif // __STIMWALKER_DEVICES_LOCOMAT_H__
@@ -3,6 +3,13 @@
 
 #include "stimwalkerConfig.h"
 
+#include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 #include "Devices/Exceptions.h"
 #include "Devices/Generic/UsbDevice.h"
 
@@ -19,6 +26,7 @@ public:
   DECLARE_DEVICE_COMMAND(GET_TEMPERATURE, 3);
   DECLARE_DEVICE_COMMAND(ARM, 4);
   DECLARE_DEVICE_COMMAND(DISARM, 5);
+  DECLARE_DEVICE_COMMAND(SET_POWER, 6);
 
   virtual std::string toString() const override {
     switch (m_Value) {
@@ -34,6 +42,8 @@ public:
       return ARM_AS_STRING;
     case DISARM:
       return DISARM_AS_STRING;
+    case SET_POWER:
+      return SET_POWER_AS_STRING;
     default:
       throw UnknownCommandException("Unknown command in MagstimRapidCommands");
     }
@@ -44,9 +54,25 @@ protected:
   MagstimRapidCommands(int value) : DeviceCommands(value) {}
 };
 
+/// @brief Frames the responses of a Magstim Rapid. The length of a response is
+/// known from its first character. Bytes that cannot start a response and
+/// responses with a wrong CRC are skipped so the framing recovers from noise
+/// on the line
+class MagstimRapidFrameDecoder : public SerialFrameDecoder {
+public:
+  Status decode(const utils::ByteRingBuffer &buffer, size_t &length) override;
+};
+
 /// @brief A class representing a Magstim Rapid device
 /// @details This class provides a way to connect to a Magstim Rapid device and
-/// send commands to it
+/// send commands to it. A command is a few ASCII characters followed by a CRC
+/// byte, and the stimulator answers every command (in order) with a response
+/// of a length known from its first character, also followed by a CRC. The
+/// responses are framed by the I/O thread of the serial port and handed to
+/// the command waiting for it. The commands go through the command queue of
+/// the device, except [trigger] which queues its bytes to the serial port
+/// right away so a pulse is never delayed by a command waiting for its
+/// response
 class MagstimRapidDevice : public UsbDevice {
   /// Enums
 public:
@@ -63,10 +89,47 @@ public:
 
   std::string deviceName() const override;
 
-protected:
+  bool disconnect() override;
+
+  /// @brief Fire the stimulator now. This bypasses the command queue: the
+  /// fire command is queued from the calling thread and its response is
+  /// consumed by the I/O thread without being waited for
+  /// @return True if the fire command was queued, false otherwise (e.g. the
+  /// device is not armed)
+  bool trigger();
+
   /// @brief Get the armed state of the device
   /// @return The armed state of the device
-  DECLARE_PROTECTED_MEMBER(bool, IsArmed)
+  bool getIsArmed() const;
+
+  /// @brief Get the power of the pulses (in percent of the maximum output)
+  /// @return The power of the pulses
+  int getPower() const;
+
+  /// @brief The status bits sent by the stimulator with every response
+  enum class Status : std::uint8_t {
+    STANDBY = 1 << 0,
+    ARMED = 1 << 1,
+    READY = 1 << 2,
+    COIL_PRESENT = 1 << 3,
+    REPLACE_COIL = 1 << 4,
+    ERROR_PRESENT = 1 << 5,
+    ERROR_TYPE = 1 << 6,
+    REMOTE_CONTROL = 1 << 7,
+  };
+
+  /// @brief Get the length of a response from its first two characters (the
+  /// errors are reported in the second one, except for an invalid command)
+  /// @param firstCharacter The first character of the response
+  /// @param secondCharacter The second character of the response
+  /// @return The length of the response including the CRC (zero if no
+  /// response starts with [firstCharacter])
+  static size_t responseLength(char firstCharacter, char secondCharacter);
+
+protected:
+  /// @brief The armed state of the device. It is written by the device
+  /// worker and read by [trigger] from the calling thread
+  DECLARE_PROTECTED_MEMBER_NOGET(std::atomic<bool>, IsArmed)
 
   /// @brief Get the interval at which the device is poked when armed
   /// @return The interval at which the device is poked when armed
@@ -76,7 +139,38 @@ protected:
   /// @return The interval at which the device is poked when disarmed
   DECLARE_PROTECTED_MEMBER(std::chrono::milliseconds, DisarmedPokeInterval)
 
+  /// @brief The power of the pulses (in percent of the maximum output). It is
+  /// written by the device worker and read by [trigger] from the calling thread
+  DECLARE_PROTECTED_MEMBER_NOGET(std::atomic<int>, Power)
+
+  /// @brief Get how long a command waits for its response
+  /// @return How long a command waits for its response
+  DECLARE_PROTECTED_MEMBER(std::chrono::milliseconds, ResponseTimeout)
+
+protected:
+  /// @brief A command written to the stimulator that expects a response
+  struct PendingResponse {
+    /// @brief The first character of the expected response
+    char command;
+
+    /// @brief Where to put the response (nullptr if nobody waits for it)
+    std::shared_ptr<std::promise<std::string>> promise;
+  };
+
+  /// @brief The commands waiting for their response, in the order they were
+  /// written
+  DECLARE_PROTECTED_MEMBER_NOGET(std::deque<PendingResponse>, PendingResponses)
+
+  /// @brief The mutex protecting [m_PendingResponses]
+  DECLARE_PROTECTED_MEMBER_NOGET(std::mutex, PendingResponsesMutex)
+
+  /// @brief The mutex serializing the writes (and the order of
+  /// [m_PendingResponses])
+  DECLARE_PROTECTED_MEMBER_NOGET(std::mutex, WriteMutex)
+
 protected:
+  bool handleConnect() override;
+
   void pingDeviceWorker() override;
 
   /// @brief Parse a command received from the user and send to the device
@@ -88,15 +182,35 @@ protected:
   /// @brief Compute the CRC checksum of the data
   /// @param data The data to compute the CRC for
   /// @return The CRC checksum of the data
-  std::string computeCrc(const std::string &data);
+  static std::string computeCrc(const std::string &data);
 
   /// @brief Change the interval at which the device is poked
   void changePokeInterval(std::chrono::milliseconds interval);
+
+  /// @brief Write a command and wait for its response
+  /// @param command The command (without its CRC)
+  /// @return The response (including its CRC), or an empty string if the
+  /// stimulator did not answer in time or answered with an error
+  std::string request(const std::string &command);
+
+  /// @brief Write a command with its CRC and register its response
+  /// @param command The command (without its CRC)
+  /// @param promise Where to put the response (nullptr to ignore it)
+  /// @return True if the command was written, false otherwise
+  bool write(const std::string &command,
+             std::shared_ptr<std::promise<std::string>> promise);
+
+  /// @brief Give a response to the command waiting for it
+  /// @param frame The response (including its CRC)
+  void handleReceivedFrame(const std::string &frame) override;
+
+  friend class MagstimRapidFrameDecoder;
 };
 
 class MagstimRapidDeviceMock : public MagstimRapidDevice {
 public:
   MagstimRapidDeviceMock(const std::string &port);
+  ~MagstimRapidDeviceMock() override;
 
   static std::unique_ptr<MagstimRapidDeviceMock> findMagstimDevice();
 
@@ -104,11 +218,20 @@ public:
 
   bool shouldFailToConnect = false;
 
+  /// @brief If the simulated stimulator is armed
+  bool isStimulatorArmed = false;
+
+  /// @brief The number of pulses the simulated stimulator delivered
+  size_t pulseCount = 0;
+
 protected:
   bool handleConnect() override;
   bool handleDisconnect() override;
 
   void setFastCommunication(bool isFast) override;
+
+  /// @brief Answer the command as a Magstim Rapid would
+  void writeToDevice(const std::string &bytes) override;
 };
 
 } // namespace STIMWALKER_NAMESPACE::devices
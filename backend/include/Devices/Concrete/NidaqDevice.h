@@ -3,37 +3,91 @@
 
 #include "stimwalkerConfig.h"
 
-#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
+#include "Devices/Generic/AsyncDataCollector.h"
 #include "Devices/Generic/AsyncDevice.h"
-#include "Devices/Generic/DataCollector.h"
+#include "Utils/CppMacros.h"
 
 namespace STIMWALKER_NAMESPACE::devices {
 
-/// @brief Abstract class for devices
-class NidaqDevice : public AsyncDevice, public DataCollector {
-  // TODO Change DataCollector to AsyncDataCollector
+/// @brief A device acquiring analog inputs on a National Instruments card. The
+/// card samples all the channels on its own clock and buffers them, so each
+/// [dataCheck] blocks until a whole block of [SampleCount] frames is available
+/// and adds it at once
+class NidaqDevice : public AsyncDevice, public AsyncDataCollector {
+public:
+  /// @brief The acquisition task of the card (the NI-DAQmx task of the analog
+  /// input channels). This is what talks to the driver, so it can be replaced
+  /// by a simulator
+  class AnalogInputTask {
+  public:
+    /// @brief Constructor
+    /// @param channelCount The number of channels of the task
+    /// @param deltaTime The time between each frame (1/FrameRate)
+    /// @param sampleCount The number of frames of each block
+    AnalogInputTask(size_t channelCount, std::chrono::microseconds deltaTime,
+                    size_t sampleCount);
+    virtual ~AnalogInputTask() = default;
+
+    /// @brief Create the task and configure its channels and clock
+    /// @return True if the task is ready to start
+    virtual bool open();
+
+    /// @brief Release the task
+    virtual void close();
+
+    /// @brief Start the acquisition
+    /// @return True if the acquisition started
+    virtual bool start();
+
+    /// @brief Stop the acquisition
+    virtual void stop();
+
+    /// @brief Wait for the next block and read it
+    /// @param buffer The buffer to fill, frame after frame
+    /// ([SampleCount] x [ChannelCount] values)
+    /// @return True if the whole block was read, false otherwise
+    virtual bool read(std::vector<double> &buffer);
+
+  protected:
+    /// @brief The number of channels of the task
+    DECLARE_PROTECTED_MEMBER(size_t, ChannelCount)
+
+    /// @brief The time between each frame
+    DECLARE_PROTECTED_MEMBER(std::chrono::microseconds, DeltaTime)
+
+    /// @brief The number of frames of each block
+    DECLARE_PROTECTED_MEMBER(size_t, SampleCount)
+  };
 
 public:
   /// @brief Constructor
   /// @param channelCount The number of channels
-  /// @param dataCheckIntervals The interval to check for new data
-  NidaqDevice(size_t channelCount,
-              const std::chrono::microseconds &dataCheckIntervals);
+  /// @param deltaTime The time between each data point (1/FrameRate)
+  /// @param sampleCount The number of data points of each block read
+  NidaqDevice(size_t channelCount, std::chrono::microseconds deltaTime,
+              size_t sampleCount);
 
   // Delete copy constructor and assignment operator, this class cannot be
   // copied because of the mutex member
   NidaqDevice(const NidaqDevice &) = delete;
   NidaqDevice &operator=(const NidaqDevice &) = delete;
 
-  std::string deviceName() const override;
-  std::string dataCollectorName() const override;
+protected:
+  /// @brief Constructor that allows to pass a mocker task
+  NidaqDevice(std::unique_ptr<AnalogInputTask> task, size_t channelCount,
+              std::chrono::microseconds deltaTime, size_t sampleCount);
 
+public:
   ~NidaqDevice();
 
+  std::string deviceName() const override;
+  std::string dataCollectorName() const override;
+
 protected:
   bool handleConnect() override;
   bool handleDisconnect() override;
@@ -43,29 +97,24 @@ protected:
 
   DeviceResponses parseAsyncSendCommand(const DeviceCommands &command,
                                         const std::any &data) override;
-};
 
-// // TODO Reimplement the mocker
-// class NidaqDeviceMock : public NidaqDevice {
-// public:
-//   NidaqDeviceMock(int channelCount, int frameRate);
+  /// @brief The time between each data point
+  DECLARE_PROTECTED_MEMBER(std::chrono::microseconds, DeltaTime)
 
-//   // Delete copy constructor and assignment operator, this class cannot be
-//   // copied because of the mutex member
-//   NidaqDeviceMock(const NidaqDeviceMock &) = delete;
-//   NidaqDeviceMock &operator=(const NidaqDeviceMock &) = delete;
+  /// @brief The number of data points of each block read
+  DECLARE_PROTECTED_MEMBER(size_t, SampleCount)
 
-//   void startRecording() override;
-//   void stopRecording() override;
+  /// @brief The acquisition task of the card
+  DECLARE_PROTECTED_MEMBER_NOGET(std::unique_ptr<AnalogInputTask>, Task)
 
-// protected:
-//   /// @brief Simulate the recording
-//   void generateData();
+  /// @brief The buffer the blocks are read into
+  DECLARE_PROTECTED_MEMBER_NOGET(std::vector<double>, DataBuffer)
 
-//   ///< Should the mock continue generating data (thread safe)
-//   bool m_generateData = false;
-// };
+  /// DATA RELATED METHODS
+public: // protected:
+  void dataCheck() override;
+};
 
 } // namespace STIMWALKER_NAMESPACE::devices
 
-#endif // __STIMWALKER_DEVICES_NI_DAQ_DEVICE_H__
\ No newline at end of file
+#endif // __STIMWALKER_DEVICES_NI_DAQ_DEVICE_H__
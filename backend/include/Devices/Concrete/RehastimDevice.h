@@ -0,0 +1,522 @@
+#ifndef __STIMWALKER_DEVICES_REHASTIM_DEVICE_H__
+#define __STIMWALKER_DEVICES_REHASTIM_DEVICE_H__
+
+#include "stimwalkerConfig.h"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "Devices/Exceptions.h"
+#include "Devices/Generic/SerialPortDevice.h"
+#include "Devices/Generic/Stimulator.h"
+#include "Utils/StimwalkerEvent.h"
+
+// The ScienceMode2 protocol of the RehaStim 2, as implemented by
+// run/scienceMode2/ScienceMode2.cpp
+
+namespace STIMWALKER_NAMESPACE::devices {
+
+class RehastimCommands : public DeviceCommands {
+public:
+  DECLARE_DEVICE_COMMAND(START_STIMULATION, 0);
+  DECLARE_DEVICE_COMMAND(STOP_STIMULATION, 1);
+  DECLARE_DEVICE_COMMAND(WATCHDOG, 2);
+
+  virtual std::string toString() const override {
+    switch (m_Value) {
+    case START_STIMULATION:
+      return START_STIMULATION_AS_STRING;
+    case STOP_STIMULATION:
+      return STOP_STIMULATION_AS_STRING;
+    case WATCHDOG:
+      return WATCHDOG_AS_STRING;
+    default:
+      throw UnknownCommandException("Unknown command in RehastimCommands");
+    }
+  }
+
+protected:
+  RehastimCommands() = delete;
+  RehastimCommands(int value) : DeviceCommands(value) {}
+};
+
+/// @brief The pulses a channel delivers every stimulation period in the
+/// channel-list mode
+struct RehastimPulse {
+  /// @brief The number of pulses of each period (spaced by the group time)
+  enum class Mode : std::uint8_t {
+    SINGLE = 0,
+    DOUBLET = 1,
+    TRIPLET = 2,
+  };
+
+  /// @brief The number of pulses of each period
+  Mode mode = Mode::SINGLE;
+
+  /// @brief The width of the pulses (us, 0 to 500)
+  std::uint16_t pulseWidth = 0;
+
+  /// @brief The current of the pulses (mA, 0 to 127). A channel with no
+  /// current does not stimulate
+  std::uint8_t current = 0;
+
+  bool operator==(const RehastimPulse &other) const {
+    return mode == other.mode && pulseWidth == other.pulseWidth &&
+           current == other.current;
+  }
+};
+
+/// @brief The commands of the ScienceMode2 protocol. The acknowledgment of a
+/// command follows it
+enum class RehastimProtocolCommand : std::uint8_t {
+  INIT = 0x01,
+  INIT_ACK = 0x02,
+  UNKNOWN_COMMAND = 0x03,
+  WATCHDOG = 0x04,
+  GET_STIMULATION_MODE = 0x0A,
+  GET_STIMULATION_MODE_ACK = 0x0B,
+  INIT_CHANNEL_LIST_MODE = 0x1E,
+  INIT_CHANNEL_LIST_MODE_ACK = 0x1F,
+  START_CHANNEL_LIST_MODE = 0x20,
+  START_CHANNEL_LIST_MODE_ACK = 0x21,
+  STOP_CHANNEL_LIST_MODE = 0x22,
+  STOP_CHANNEL_LIST_MODE_ACK = 0x23,
+  SINGLE_PULSE = 0x24,
+  SINGLE_PULSE_ACK = 0x25,
+  STIMULATION_ERROR = 0x26,
+};
+
+/// @brief A packet of the ScienceMode2 protocol, once unstuffed
+struct RehastimPacket {
+  /// @brief The number of the packet
+  std::uint8_t number = 0;
+
+  /// @brief The command of the packet
+  RehastimProtocolCommand command = RehastimProtocolCommand::UNKNOWN_COMMAND;
+
+  /// @brief The data of the packet
+  std::string data;
+};
+
+/// @brief An acknowledgment sent by the stimulator
+struct RehastimAcknowledgment {
+  /// @brief The command acknowledged
+  RehastimProtocolCommand command;
+
+  /// @brief The number of the packet of the acknowledgment
+  std::uint8_t packetNumber;
+
+  /// @brief The error code (zero if the command succeeded, negative
+  /// otherwise)
+  std::int8_t errorCode;
+
+  /// @brief The data following the error code (e.g. the stimulation mode)
+  std::string data;
+};
+
+/// @brief Frames the packets of the ScienceMode2 protocol. A frame starts with
+/// a start byte and ends with a stop byte, which are stuffed when they appear
+/// in between. Bytes that cannot start a frame, frames cut by the start of
+/// the next one and frames with a wrong length or CRC are skipped so the
+/// framing recovers from noise on the line
+/// @details Each byte is looked at once: the decoder resumes where the
+/// previous call stopped, unstuffs the payload and updates its CRC as the
+/// bytes arrive, so a full frame is validated (and its packet available from
+/// [getPacket]) when its stop byte arrives, without going over the frame
+/// again
+class RehastimFrameDecoder : public SerialFrameDecoder {
+public:
+  RehastimFrameDecoder();
+
+  Status decode(const utils::ByteRingBuffer &buffer, size_t &length) override;
+
+  void reset() override;
+
+  /// @brief Get the packet of the last frame found. It is valid until the
+  /// next call to [decode]
+  /// @return The packet
+  const RehastimPacket &getPacket() const;
+
+  /// @brief The longest stuffed payload accepted: the update of the 8
+  /// channels, with every byte stuffed
+  static constexpr size_t MAX_PAYLOAD_LENGTH = 2 * (2 + 4 * 8);
+
+protected:
+  /// @brief Forget the frame being decoded and skip bytes
+  /// @param length Where to put the number of bytes to skip
+  /// @param count The number of bytes to skip
+  /// @return [Status::SKIP]
+  Status skip(size_t &length, size_t count);
+
+  /// @brief The number of bytes of the frame already decoded
+  size_t m_Position;
+
+  /// @brief The CRC announced by the frame
+  std::uint8_t m_ExpectedCrc;
+
+  /// @brief The length of the stuffed payload announced by the frame
+  size_t m_ExpectedLength;
+
+  /// @brief The CRC of the stuffed payload received so far
+  std::uint8_t m_Crc;
+
+  /// @brief If the previous byte was a stuffing byte
+  bool m_IsStuffed;
+
+  /// @brief The unstuffed payload received so far
+  char m_Payload[MAX_PAYLOAD_LENGTH];
+
+  /// @brief The number of bytes in [m_Payload]
+  size_t m_PayloadLength;
+
+  /// @brief The packet of the last frame found
+  RehastimPacket m_Packet;
+};
+
+/// @brief A class representing a RehaStim 2 stimulator
+/// @details The stimulator is driven in the channel-list mode of the
+/// ScienceMode2 protocol: once started, each active channel delivers its
+/// pulses every stimulation period, and the pulse width and current of the
+/// channels can be changed by sending them again. The start and stop go
+/// through the command queue of the device and wait for their
+/// acknowledgment. The changes of the pulses (e.g. from the stimulation rules
+/// through [setChannelAmplitudes]) only store the new values and return: the
+/// I/O thread of the serial port sends them at most once per stimulation
+/// period, so the stimulator gets the latest values of every period without
+/// the caller ever waiting for the line
+class RehastimDevice : public SerialPortDevice, public Stimulator {
+public:
+  /// @brief The number of channels of the stimulator
+  static constexpr size_t CHANNEL_COUNT = 8;
+
+  /// @brief The pulses of each channel
+  using ChannelPulses = std::array<RehastimPulse, CHANNEL_COUNT>;
+
+  /// @brief The commands of the ScienceMode2 protocol
+  using ProtocolCommand = RehastimProtocolCommand;
+
+  /// Constructors
+public:
+  /// @brief Constructor
+  /// @param port The port name of the device
+  RehastimDevice(const std::string &port);
+  RehastimDevice(const RehastimDevice &other) = delete;
+  ~RehastimDevice() override;
+
+  std::string deviceName() const override;
+
+  bool disconnect() override;
+
+  /// @brief Deliver a single pulse on each active channel with a current.
+  /// This is only possible while the channel-list mode is stopped
+  void stimulate() override;
+
+  /// @brief Change the current of some channels, keeping their pulse width.
+  /// This returns without waiting, the new currents are sent with the next
+  /// update of the stimulation period
+  void setChannelAmplitudes(const std::vector<size_t> &channels,
+                            const std::vector<double> &amplitudes) override;
+
+  /// @brief Change the pulses of some channels. This returns without waiting,
+  /// the new pulses are sent with the next update of the stimulation period
+  /// @param channels The channels to change (0 to [CHANNEL_COUNT] - 1)
+  /// @param pulses The new pulses of each of [channels]
+  void setChannelPulses(const std::vector<size_t> &channels,
+                        const std::vector<RehastimPulse> &pulses);
+
+  /// @brief Get the pulses a channel is set to deliver
+  /// @param channel The channel
+  /// @return The pulses of the channel
+  RehastimPulse getChannelPulse(size_t channel) const;
+
+  /// @brief Get if the channel-list mode is running
+  /// @return True if the stimulator is stimulating
+  bool getIsStimulating() const;
+
+  /// @brief Get the number of updates of the pulses sent to the stimulator
+  /// (including the start)
+  /// @return The number of updates
+  size_t getUpdateCount() const;
+
+  /// @brief Get the number of updates the stimulator acknowledged
+  /// @return The number of acknowledged updates
+  size_t getAcknowledgedUpdateCount() const;
+
+  /// @brief Get the number of errors reported by the stimulator
+  /// @return The number of errors
+  size_t getErrorCount() const;
+
+  /// @brief The acknowledgments sent by the stimulator (including those of
+  /// the updates, which are not waited for). The listeners are called by the
+  /// I/O thread of the serial port, so they should not block
+  utils::StimwalkerEvent<RehastimAcknowledgment> onAcknowledgment;
+
+  /// @brief Encode a packet into a frame: the start byte, the CRC and the
+  /// length of the stuffed payload, the stuffed payload (packet number,
+  /// command and data) and the stop byte
+  /// @param packetNumber The number of the packet
+  /// @param command The command of the packet
+  /// @param data The data of the packet
+  /// @return The frame
+  static std::string encodeFrame(std::uint8_t packetNumber,
+                                 ProtocolCommand command,
+                                 const std::string &data = "");
+
+  /// @brief Decode a frame into its packet
+  /// @param frame The frame, from its start byte to its stop byte
+  /// @param packetNumber The number of the packet
+  /// @param command The command of the packet
+  /// @param data The data of the packet
+  /// @return True if the frame is valid, false otherwise
+  static bool decodeFrame(const std::string &frame, std::uint8_t &packetNumber,
+                          ProtocolCommand &command, std::string &data);
+
+  /// @brief Compute the CRC-8 of some bytes (of a stuffed payload)
+  /// @param bytes The bytes
+  /// @param count The number of bytes
+  /// @return The CRC
+  static std::uint8_t computeCrc(const char *bytes, size_t count);
+
+protected:
+  /// @brief Get the time between two pulses of a channel (8 to 1024 ms, in
+  /// steps of 0.5 ms). It applies from the next start
+  /// @return The stimulation period
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(std::chrono::microseconds,
+                                       StimulationPeriod)
+
+  /// @brief Get the time between the pulses of a doublet or a triplet (8 to
+  /// 129 ms, in steps of 0.5 ms). It applies from the next start
+  /// @return The group time
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(std::chrono::microseconds, GroupTime)
+
+  /// @brief Get the channels used by the channel-list mode (bit i for the
+  /// channel i). It applies from the next start
+  /// @return The active channels
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(std::uint8_t, ActiveChannels)
+
+  /// @brief Get how long a command waits for its acknowledgment
+  /// @return How long a command waits for its acknowledgment
+  DECLARE_PROTECTED_MEMBER(std::chrono::milliseconds, ResponseTimeout)
+
+protected:
+  /// @brief A command written to the stimulator that expects an
+  /// acknowledgment
+  struct PendingResponse {
+    /// @brief The command
+    ProtocolCommand command;
+
+    /// @brief Where to put the acknowledgment
+    std::shared_ptr<std::promise<RehastimAcknowledgment>> promise;
+  };
+
+  /// @brief The commands waiting for their acknowledgment, in the order they
+  /// were written
+  DECLARE_PROTECTED_MEMBER_NOGET(std::deque<PendingResponse>, PendingResponses)
+
+  /// @brief The mutex protecting [m_PendingResponses]
+  DECLARE_PROTECTED_MEMBER_NOGET(std::mutex, PendingResponsesMutex)
+
+  /// @brief The number of the next packet
+  DECLARE_PROTECTED_MEMBER_NOGET(std::atomic<std::uint8_t>, PacketNumber)
+
+  /// @brief The pulses of each channel
+  DECLARE_PROTECTED_MEMBER_NOGET(ChannelPulses, Pulses)
+
+  /// @brief If the channel-list mode is running
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsStimulating)
+
+  /// @brief If an update of the pulses waits to be sent by the I/O thread
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsUpdateScheduled)
+
+  /// @brief The active channels of the running channel-list mode
+  DECLARE_PROTECTED_MEMBER_NOGET(std::uint8_t, RunningChannels)
+
+  /// @brief The stimulation period of the running channel-list mode
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::microseconds, RunningPeriod)
+
+  /// @brief The number of updates sent
+  DECLARE_PROTECTED_MEMBER_NOGET(size_t, UpdateCount)
+
+  /// @brief The number of updates acknowledged
+  DECLARE_PROTECTED_MEMBER_NOGET(size_t, AcknowledgedUpdateCount)
+
+  /// @brief The number of errors reported by the stimulator
+  DECLARE_PROTECTED_MEMBER_NOGET(size_t, ErrorCount)
+
+  /// @brief The mutex protecting the pulses, the state of the channel-list
+  /// mode and the counters
+  mutable std::mutex m_PulsesMutex;
+
+  /// @brief When the last update was sent (only used by the I/O thread)
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::steady_clock::time_point,
+                                 LastUpdateAt)
+
+  /// @brief The timer delaying an update to the next stimulation period
+  DECLARE_PROTECTED_MEMBER_NOGET(std::unique_ptr<asio::steady_timer>,
+                                 UpdateTimer)
+
+protected:
+  bool handleConnect() override;
+
+  void pingDeviceWorker() override;
+
+  /// @brief Parse a command received from the user and send to the device
+  /// @param command The command to parse
+  /// @param data The data to parse
+  DeviceResponses parseAsyncSendCommand(const DeviceCommands &command,
+                                        const std::any &data) override;
+
+  void HandleStimulation(const DataPoint &data) override;
+
+  /// @brief Initialize and start the channel-list mode with the current pulses
+  /// @return True if the stimulator acknowledged both, false otherwise
+  bool startChannelListMode();
+
+  /// @brief Stop the channel-list mode
+  /// @return True if the stimulator acknowledged it, false otherwise
+  bool stopChannelListMode();
+
+  /// @brief Encode the pulses of the active channels, as sent to start or
+  /// update the channel-list mode. [m_PulsesMutex] must be held
+  /// @return The data of the command
+  std::string encodePulses() const;
+
+  /// @brief Ask the I/O thread to send the pulses, if the channel-list mode
+  /// runs and no update is already waiting. [m_PulsesMutex] must be held
+  void scheduleUpdate();
+
+  /// @brief Send the pulses if the last update is at least a stimulation
+  /// period old, otherwise wait for the end of the period. This is called by
+  /// the I/O thread
+  void sendPendingUpdate();
+
+  /// @brief Write a command and wait for its acknowledgment
+  /// @param command The command
+  /// @param data The data of the command
+  /// @return The acknowledgment, or nothing if the stimulator did not answer
+  /// in time or answered with an error
+  std::optional<RehastimAcknowledgment>
+  request(ProtocolCommand command, const std::string &data = "");
+
+  /// @brief Write a command without waiting for its acknowledgment
+  /// @param command The command
+  /// @param data The data of the command
+  /// @return True if the command was written, false otherwise
+  bool write(ProtocolCommand command, const std::string &data = "");
+
+  /// @brief Hand the packet the decoder just found to [handlePacket]. The
+  /// frame is not decoded again
+  /// @param frame The frame of the packet
+  void handleReceivedFrame(const std::string &frame) override;
+
+  /// @brief Handle a packet sent by the stimulator: give an acknowledgment to
+  /// the command waiting for it, answer the initialization and keep track of
+  /// the errors
+  /// @param packet The packet
+  void handlePacket(const RehastimPacket &packet);
+
+  /// @brief Handle an acknowledgment sent by the stimulator
+  /// @param acknowledgment The acknowledgment
+  void handleAcknowledgment(const RehastimAcknowledgment &acknowledgment);
+};
+
+#ifndef _WIN32
+/// @brief A RehaStim 2 connected to a stimulator simulated on the other side
+/// of a pseudo-terminal. The simulated stimulator answers the commands as the
+/// ScienceMode2 protocol describes, so the device runs its real serial layer
+class RehastimDeviceMock : public RehastimDevice {
+public:
+  RehastimDeviceMock();
+  ~RehastimDeviceMock() override;
+
+  bool shouldFailToConnect = false;
+
+  /// @brief Get if the simulated stimulator runs the channel-list mode
+  /// @return True if the simulated stimulator is stimulating
+  bool isStimulatorRunning();
+
+  /// @brief Get the pulses of the last update received by the simulated
+  /// stimulator
+  /// @return The pulses of each channel
+  ChannelPulses getStimulatorPulses();
+
+  /// @brief Get the number of updates (including the start) received by the
+  /// simulated stimulator
+  /// @return The number of updates
+  size_t getStimulatorUpdateCount();
+
+  /// @brief Get the number of single pulses delivered by the simulated
+  /// stimulator
+  /// @return The number of single pulses
+  size_t getSinglePulseCount();
+
+  /// @brief Get if the device acknowledged the initialization of the
+  /// simulated stimulator
+  /// @return True if the initialization was acknowledged
+  bool isInitAcknowledged();
+
+  /// @brief Make the simulated stimulator stop on an error (e.g. an electrode
+  /// that came off)
+  /// @param errorCode The error code sent to the device
+  void simulateStimulationError(std::int8_t errorCode);
+
+protected:
+  bool handleConnect() override;
+  bool handleDisconnect() override;
+
+  /// @brief Read the commands from the pseudo-terminal and answer them
+  void simulateStimulator();
+
+  /// @brief Answer a command as a RehaStim 2 would
+  /// @param packet The packet of the command
+  void answer(const RehastimPacket &packet);
+
+  /// @brief Stop the simulated stimulator
+  void stopSimulator();
+
+  /// @brief The master side of the pseudo-terminal
+  int m_PtyMaster;
+
+  /// @brief The thread running the simulated stimulator
+  std::thread m_SimulatorWorker;
+
+  /// @brief If the simulated stimulator should keep running
+  std::atomic<bool> m_IsSimulating;
+
+  /// @brief The mutex protecting the state of the simulated stimulator
+  std::mutex m_SimulatorMutex;
+
+  /// @brief The channels initialized on the simulated stimulator
+  std::uint8_t m_SimulatedChannels = 0;
+
+  /// @brief If the simulated stimulator runs the channel-list mode
+  bool m_IsSimulatedRunning = false;
+
+  /// @brief The pulses of the last update received
+  ChannelPulses m_SimulatedPulses;
+
+  /// @brief The number of updates received
+  size_t m_SimulatedUpdateCount = 0;
+
+  /// @brief The number of single pulses delivered
+  size_t m_SinglePulseCount = 0;
+
+  /// @brief If the simulated stimulator introduced itself to the device
+  bool m_HasSentInit = false;
+
+  /// @brief If the device acknowledged the introduction
+  bool m_IsInitAcknowledged = false;
+
+  /// @brief The number of the next packet sent by the simulated stimulator
+  std::uint8_t m_SimulatedPacketNumber = 0;
+};
+#endif // _WIN32
+
+} // namespace STIMWALKER_NAMESPACE::devices
+#endif // __STIMWALKER_DEVICES_REHASTIM_DEVICE_H__
@@ -1,9 +1,11 @@
 #ifndef __STIMWALKER_DEVICES_CONCRETE_ALL_H__
 #define __STIMWALKER_DEVICES_CONCRETE_ALL_H__
 
+#include "Devices/Concrete/DelsysAnalogDevice.h"
 #include "Devices/Concrete/DelsysEmgDevice.h"
 #include "Devices/Concrete/LokomatDevice.h"
 #include "Devices/Concrete/MagstimRapidDevice.h"
 #include "Devices/Concrete/NidaqDevice.h"
+#include "Devices/Concrete/RehastimDevice.h"
 
 #endif // __STIMWALKER_DEVICES_CONCRETE_ALL_H__
\ No newline at end of file
@@ -4,12 +4,19 @@
 #include "stimwalkerConfig.h"
 
 #include "Utils/CppMacros.h"
+#include <chrono>
+#include <cstdint>
 #include <mutex>
 #include <nlohmann/json.hpp>
 
 namespace STIMWALKER_NAMESPACE {
 namespace data {
+class AcquisitionStatistics;
+class DataCheckTimings;
+class EventMarkerRecorder;
+class EventMarkers;
 class TimeSeries;
+enum class EventMarkerType : std::uint16_t;
 } // namespace data
 
 namespace devices {
@@ -22,7 +29,7 @@ class Devices {
   /// DEVICE MANAGEMENT METHODS ///
 public:
   /// @brief Constructor
-  Devices() = default;
+  Devices();
   ~Devices();
 
   /// @brief Create a new device in the collection
@@ -35,6 +42,19 @@ public:
   /// @param deviceName The name of the device to set the zero level
   bool zeroLevelDevice(const std::string &deviceName);
 
+  /// @brief Set the duration of live data kept by every data collector,
+  /// including those added later. Each collector sizes its buffer from its own
+  /// sample rate. This can be called while streaming
+  /// @param window The duration of live data to keep
+  void setLiveDataTimeWindow(const std::chrono::milliseconds &window);
+
+  /// @brief Set the duration of data before [startRecording] to put at the
+  /// beginning of the trials of all the data collectors, including those
+  /// added later
+  /// @param duration The duration of data to keep before the trigger (zero to
+  /// start the trials at the trigger)
+  void setPreTriggerDuration(const std::chrono::milliseconds &duration);
+
   /// @brief Remove the device from the collection
   /// @param deviceId The id of the device (the one returned by the add method)
   void remove(size_t deviceId);
@@ -64,11 +84,21 @@ public:
   /// @return The requested device
   const Device &getDevice(size_t deviceId) const;
 
+  /// @brief Get the requested device
+  /// @param deviceId The id of the device (the one returned by the add method)
+  /// @return The requested device
+  Device &getDevice(size_t deviceId);
+
   /// @brief Get the requested data collector
   /// @param deviceId The id of the data collector
   /// @return The requested data collector
   const DataCollector &getDataCollector(size_t deviceId) const;
 
+  /// @brief Get the requested data collector (e.g. to listen to its events)
+  /// @param deviceId The id of the data collector
+  /// @return The requested data collector
+  DataCollector &getDataCollector(size_t deviceId);
+
   /// DRIVING THE DEVICES METHODS ///
 public:
   /// @brief Connect all the devices in a blocking way (wait for all the devices
@@ -106,18 +136,60 @@ public:
   /// @return The live datain serialized form
   nlohmann::json getLiveDataSerialized() const;
 
-  /// @brief Get the data of the last recorded trial in serialized form
+  /// @brief Get the data of the last recorded trial in serialized form. The
+  /// devices are under [DEVICES_KEY] and the event markers of the trial under
+  /// [EVENT_MARKERS_KEY]
   /// @return The data of the last recorded trial in serialized form
   nlohmann::json getLastTrialDataSerialized() const;
 
+  /// @brief Get the whole timing of the data checks of the asynchronous data
+  /// collectors in serialized form (the live data only hold their summary)
+  /// @return The timing of the data checks in serialized form
+  nlohmann::json getDataCheckTimingsSerialized() const;
+
+  /// @brief Record that an event happens now in the event markers of the
+  /// session. This can be called from any thread and does not block
+  /// @param type The kind of event
+  /// @param payload A value that depends on [type]
+  void addEventMarker(data::EventMarkerType type, std::int64_t payload = 0);
+
+  /// @brief The key of the devices in the serialized trial
+  static constexpr const char *DEVICES_KEY = "devices";
+
+  /// @brief The key of the event markers in the serialized trial
+  static constexpr const char *EVENT_MARKERS_KEY = "eventMarkers";
+
   /// @brief Deserialize timeseries data. This is almost the opposite of
   /// serialized with the difference that the map is not a map of devices, but
   /// a map device names
-  /// @param json The serialized data
+  /// @param json The serialized devices (the live data, or the [DEVICES_KEY]
+  /// of the trial)
   /// @return The deserialized data
   static std::map<std::string, data::TimeSeries>
   deserializeData(const nlohmann::json &json);
 
+  /// @brief Deserialize the acquisition statistics that are sent along with the
+  /// serialized data. Only the trial holds the detail of the gaps, the live
+  /// data only count them
+  /// @param json The serialized devices (the live data, or the [DEVICES_KEY]
+  /// of the trial)
+  /// @return The statistics of each device name
+  static std::map<std::string, data::AcquisitionStatistics>
+  deserializeAcquisitionStatistics(const nlohmann::json &json);
+
+  /// @brief Deserialize the timing of the data checks serialized by
+  /// [getDataCheckTimingsSerialized]
+  /// @param json The serialized timings
+  /// @return The timing of the data checks of each device name
+  static std::map<std::string, data::DataCheckTimings>
+  deserializeDataCheckTimings(const nlohmann::json &json);
+
+  /// @brief Deserialize the event markers that are sent along with the
+  /// serialized trial data
+  /// @param json The serialized trial
+  /// @return The event markers (empty if there are none)
+  static data::EventMarkers deserializeEventMarkers(const nlohmann::json &json);
+
   /// INTERNAL ///
 protected:
   /// @brief If the devices are connected
@@ -129,6 +201,27 @@ protected:
   /// @brief If the devices are recording
   DECLARE_PROTECTED_MEMBER(bool, IsRecording)
 
+  /// @brief The duration of live data set by [setLiveDataTimeWindow] (zero to
+  /// keep the default of each data collector)
+  DECLARE_PROTECTED_MEMBER(std::chrono::milliseconds, LiveDataTimeWindow)
+
+  /// @brief The duration of data before the trigger set by
+  /// [setPreTriggerDuration]
+  DECLARE_PROTECTED_MEMBER(std::chrono::milliseconds, PreTriggerDuration)
+
+  /// @brief The event markers of the session (shared with the devices). They
+  /// are reset when the devices start streaming
+  DECLARE_PROTECTED_MEMBER(std::shared_ptr<data::EventMarkerRecorder>,
+                           EventMarkers)
+
+  /// @brief When the last trial started (including the pre-trigger)
+  DECLARE_PROTECTED_MEMBER_NOGET(
+      std::chrono::steady_clock::time_point, TrialStartTime)
+
+  /// @brief When the last trial stopped
+  DECLARE_PROTECTED_MEMBER_NOGET(
+      std::chrono::steady_clock::time_point, TrialStopTime)
+
 protected:
   /// @brief The collection of devices
   std::map<size_t, std::shared_ptr<Device>> m_Devices;
@@ -44,6 +44,12 @@ public:
       : DeviceException(filename) {}
 };
 
+class InvalidStimulationRuleException : public DeviceException {
+public:
+  InvalidStimulationRuleException(const std::string &message)
+      : DeviceException(message) {}
+};
+
 } // namespace STIMWALKER_NAMESPACE::devices
 
 #endif // __STIMWALKER_DEVICES_GENERIC_EXCEPTIONS_H__
\ No newline at end of file
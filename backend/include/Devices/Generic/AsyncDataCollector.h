@@ -1,6 +1,7 @@
 #ifndef __STIMWALKER_DEVICES_GENERIC_ASYNC_DATA_COLLECTOR_H__
 #define __STIMWALKER_DEVICES_GENERIC_ASYNC_DATA_COLLECTOR_H__
 
+#include "Data/DataCheckTimings.h"
 #include "Devices/Generic/DataCollector.h"
 #include <asio.hpp>
 
@@ -58,6 +59,17 @@ public:
   bool startRecording() override;
   bool stopRecording() override;
 
+  /// @brief Get the timing of the [dataCheck] calls since the data streaming
+  /// started (idle time before each check, lateness of the wake up and
+  /// duration of the check)
+  /// @return The timing of the data checks
+  data::DataCheckTimings getDataCheckTimings() const;
+
+  /// @brief Get the summary of the timing of the [dataCheck] calls (see
+  /// [data::DataCheckTimings::serializeSummary]), without copying the timings
+  /// @return The serialized summary of the timing of the data checks
+  nlohmann::json getSerializedDataCheckSummary() const;
+
 protected:
   /// @brief Stop the worker threads. This can be called by the destructor of
   /// the inherited class so it stops the worker threads before the object is
@@ -82,10 +94,24 @@ protected:
   /// other action such as analyzing the data
   virtual void dataCheck();
 
-  /// @brief The [m_IgnoreTooSlowWarning] member can be set by an inherited
-  /// class to ignore the warning that is displayed when the [dataCheck] method
-  /// takes too long to execute compared to the [KeepWorkerAliveInterval]
-  DECLARE_PROTECTED_MEMBER(bool, IgnoreTooSlowWarning)
+  /// @brief The [m_DataCheckWaitsForDevice] member can be set by an inherited
+  /// class whose [dataCheck] method blocks until the device sends data. The
+  /// duration of the checks then includes that wait, so a check longer than
+  /// the [KeepWorkerAliveInterval] is neither warned about nor counted as an
+  /// overrun in the acquisition statistics. The checks are timed either way
+  /// (see [getDataCheckTimings])
+  DECLARE_PROTECTED_MEMBER(bool, DataCheckWaitsForDevice)
+
+private:
+  /// @brief Mutex for the timing of the data checks
+  mutable std::mutex m_DataCheckTimingsMutex;
+
+  /// @brief The timing of the data checks since the data streaming started
+  data::DataCheckTimings m_DataCheckTimings;
+
+  /// @brief When the keep-alive timer was last set (the worker is idle from
+  /// then to the next data check)
+  std::chrono::steady_clock::time_point m_KeepDataWorkerAliveTimerSetAt;
 };
 
 } // namespace STIMWALKER_NAMESPACE::devices
@@ -5,7 +5,11 @@
 #include <functional>
 #include <vector>
 
+#include "Data/AcquisitionStatistics.h"
+#include "Data/ClockSynchronizer.h"
+#include "Data/DataBlock.h"
 #include "Data/TimeSeries.h"
+#include "Data/TrialWriter.h"
 #include "Devices/Generic/Device.h"
 #include "Utils/CppMacros.h"
 #include "Utils/StimwalkerEvent.h"
@@ -39,8 +43,9 @@ public:
   /// @return True if the data stopped streaming, false otherwise
   virtual bool stopDataStreaming();
 
-  /// @brief Start the recording. This resets the LiveTimeSeries and starts
-  /// sending the data to the TrialTimeSeries
+  /// @brief Start the recording. This resets the TrialTimeSeries (seeding it
+  /// with the last [PreTriggerDuration] of live data) and starts sending the
+  /// data to it
   /// @return True if the data are recording, false otherwise
   virtual bool startRecording();
 
@@ -70,6 +75,11 @@ protected:
   /// @return True if the device is recording, false otherwise
   DECLARE_PROTECTED_MEMBER(bool, IsRecording)
 
+  /// @brief If the recorded blocks are handed to [m_TrialWriter] (protected by
+  /// [m_LiveDataMutex]). It is cleared before the writer is drained, while
+  /// [m_IsRecording] stays set until the trial is complete
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsWritingTrial)
+
   /// @brief Has failed to start the data streaming. This is always false unless
   /// the it actually failed to start to stream
   DECLARE_PROTECTED_MEMBER(bool, HasFailedToStartDataStreaming)
@@ -84,6 +94,24 @@ protected:
   DECLARE_PROTECTED_MEMBER_NOGET(std::unique_ptr<data::TimeSeries>,
                                  TrialTimeSeries)
 
+  /// @brief The time between two samples of the device, used to know how many
+  /// samples to expect and to size the live data (zero if the device has no
+  /// fixed rate)
+  DECLARE_PROTECTED_MEMBER(std::chrono::microseconds, SamplePeriod)
+
+  /// @brief The duration of live data kept by the collector
+  DECLARE_PROTECTED_MEMBER(std::chrono::milliseconds, LiveDataTimeWindow)
+
+  /// @brief The duration of data before [startRecording] that is put at the
+  /// beginning of the trial
+  DECLARE_PROTECTED_MEMBER(std::chrono::milliseconds, PreTriggerDuration)
+
+  /// @brief The writer that appends the recorded data to [m_TrialTimeSeries]
+  /// outside of the acquisition thread (declared after the trial so it stops
+  /// before the trial is destroyed)
+  DECLARE_PROTECTED_MEMBER_NOGET(std::unique_ptr<data::TrialWriter>,
+                                 TrialWriter)
+
 public:
   /// @brief Set the zero level
   /// @param duration The duration to set the zero level
@@ -92,8 +120,34 @@ public:
   /// @brief Reset the live data
   void resetLiveData();
 
+  /// @brief Set the duration of live data to keep. The live buffer is sized
+  /// from the sample rate of the device (or to [DEFAULT_LIVE_DATA_SAMPLE_COUNT]
+  /// if it is unknown). This can be called while streaming, the most recent
+  /// data are kept
+  /// @param window The duration of live data to keep
+  void setLiveDataTimeWindow(const std::chrono::milliseconds &window);
+
+  /// @brief Set the duration of data before [startRecording] to put at the
+  /// beginning of the trial. The live data double as the pre-trigger buffer,
+  /// so they are enlarged if they are shorter than [duration]
+  /// @param duration The duration of data to keep before the trigger (zero to
+  /// start the trial at the trigger)
+  void setPreTriggerDuration(const std::chrono::milliseconds &duration);
+
+  /// @brief Get the number of samples the live data can hold
+  /// @return The number of samples the live data can hold
+  size_t getLiveDataCapacity() const;
+
+  /// @brief The duration of live data kept by default
+  static constexpr std::chrono::milliseconds DEFAULT_LIVE_DATA_TIME_WINDOW =
+      std::chrono::milliseconds(500);
+
+  /// @brief The number of samples kept when the sample rate is unknown
+  static constexpr size_t DEFAULT_LIVE_DATA_SAMPLE_COUNT = 1000;
+
   /// @brief Get the live data in a serialized form. This uses a mutex to ensure
-  /// that the data is not modified while being serialized
+  /// that the data is not modified while being serialized. Only the last
+  /// [m_LiveDataTimeWindow] is serialized, even if a longer pre-trigger is kept
   /// @return The live data in a serialized form
   nlohmann::json getSerializedLiveData() const;
 
@@ -102,19 +156,89 @@ public:
   /// @return The trial data
   const data::TimeSeries &getTrialData() const;
 
+  /// @brief Get the state of the trial writer (queue depth and dropped data),
+  /// to judge if the recording keeps up with the acquisition
+  /// @return The state of the trial writer
+  data::TrialWriter::Metrics getTrialWriterMetrics() const;
+
+  /// @brief Get the accounting of the samples since the data streaming started
+  /// (expected, received and dropped samples, and the gaps)
+  /// @return The statistics of the live data
+  data::AcquisitionStatistics getAcquisitionStatistics() const;
+
+  /// @brief Get the accounting of the samples of the current (or last) trial.
+  /// The gap positions are indices in the trial data
+  /// @return The statistics of the trial data
+  data::AcquisitionStatistics getTrialAcquisitionStatistics() const;
+
+  /// @brief Get the fit between the sample index of the device and the host
+  /// clock since the data streaming started
+  /// @return The clock synchronizer of the live data
+  data::ClockSynchronizer getClockSynchronizer() const;
+
+  /// @brief Get the mapping of the live data samples to corrected absolute
+  /// time stamps, with the drift statistics (this assumes the live data have
+  /// no gap)
+  /// @return The serialized clock synchronization of the live data
+  nlohmann::json getSerializedLiveClock() const;
+
+  /// @brief Get the mapping of the trial data samples to corrected absolute
+  /// time stamps, with the drift statistics. The fit is the one at the end of
+  /// the trial
+  /// @return The serialized clock synchronization of the trial data
+  nlohmann::json getSerializedTrialClock() const;
+
   /// @brief Set the callback function to call when data is collected
   /// @param callback The callback function
   utils::StimwalkerEvent<data::DataPoint> onNewData;
 
+  /// @brief Event called with every sample added by a single [addDataPoints]
+  /// call (i.e. a whole block read from the device). The block is a view of
+  /// the live data, it is only valid during the callback and must be copied
+  /// to be kept (so this event cannot be given an executor). The live data
+  /// can be read from the callback, but not reset or resized
+  utils::StimwalkerEvent<data::DataBlock> onNewDataBlock;
+
 protected:
   /// @brief Add a vector of data points to the data collector. This method is
   /// strictly equivalent to calling [addDataPoint] for each data point in the
   /// vector, except that the notification is done only once at the end. It is
-  /// called with the last data point in the vector
+  /// called with the last data point in the vector, and [onNewDataBlock] is
+  /// called with all of them
   /// @param dataPoints The data points to add
   virtual void
   addDataPoints(const std::vector<std::vector<double>> &dataPoints);
 
+  /// @brief Get the number of samples covering a duration, rounded up
+  /// @param duration The duration to cover
+  /// @return The number of samples (zero if the sample rate is unknown)
+  size_t getSampleCount(const std::chrono::milliseconds &duration) const;
+
+  /// @brief Set the time between two samples of the device. The live data are
+  /// resized accordingly
+  /// @param samplePeriod The time between two samples (zero if unknown)
+  void setSamplePeriod(const std::chrono::microseconds &samplePeriod);
+
+  /// @brief Record samples the device should have provided but that never made
+  /// it to the data (failed reads, empty frames, etc.). The time stamps of the
+  /// data added next jump over them
+  /// @param count The number of samples lost
+  /// @param reason Why the samples were lost
+  /// @param offset The number of samples of the next [addDataPoints] call that
+  /// come before the lost ones (so the losses inside a block are reported
+  /// before the block is added in one go)
+  void reportDroppedSamples(size_t count,
+                            data::AcquisitionStatistics::GapReason reason,
+                            size_t offset = 0);
+
+  /// @brief Record that the acquisition could not keep up with its schedule
+  void reportTimerOverrun();
+
+  /// @brief The samples lost before or inside the next block added, as pairs
+  /// of the index in the block of the sample following the loss and the
+  /// number of samples lost
+  std::vector<std::pair<size_t, size_t>> m_PendingGaps;
+
   /// @brief This method is useless and only serves as a reminder that the
   /// inherited class should call [addDataPoint] when new data are ready
   virtual void handleNewData(const data::DataPoint &data) = 0;
@@ -122,6 +246,35 @@ protected:
 private:
   /// @brief Mutex for adding/reading the data
   DECLARE_PRIVATE_MEMBER_NOGET(std::mutex, LiveDataMutex);
+
+  /// @brief Mutex keeping the live data in place while [onNewDataBlock] views
+  /// them (i.e. no reset or resize). It is taken before [m_LiveDataMutex]
+  DECLARE_PRIVATE_MEMBER_NOGET(std::mutex, LiveDataStorageMutex);
+
+  /// @brief The accounting of the samples since the streaming started
+  DECLARE_PRIVATE_MEMBER_NOGET(data::AcquisitionStatistics,
+                               LiveAcquisitionStatistics);
+
+  /// @brief The accounting of the samples of the trial
+  DECLARE_PRIVATE_MEMBER_NOGET(data::AcquisitionStatistics,
+                               TrialAcquisitionStatistics);
+
+  /// @brief The fit of the device clock since the streaming started
+  DECLARE_PRIVATE_MEMBER_NOGET(data::ClockSynchronizer, ClockSynchronizer);
+
+  /// @brief The fit of the device clock at the end of the last trial
+  DECLARE_PRIVATE_MEMBER_NOGET(data::ClockSynchronizer,
+                               TrialClockSynchronizer);
+
+  /// @brief The index (since the streaming started) of the first sample of
+  /// the trial
+  DECLARE_PRIVATE_MEMBER_NOGET(size_t, TrialFirstSampleIndex);
+
+  /// @brief The samples missing from the trial before the next block handed
+  /// to [m_TrialWriter], because the blocks since the last one it accepted
+  /// were dropped (the live data did receive them, so they are not in
+  /// [m_PendingGaps])
+  DECLARE_PRIVATE_MEMBER_NOGET(size_t, TrialOverflowSampleCount);
 };
 
 } // namespace STIMWALKER_NAMESPACE::devices
@@ -85,6 +85,13 @@ public:
 
     std::string deviceName() const override;
 
+    /// @brief Read exactly [buffer.size()] bytes. Contrary to the command
+    /// device, a partial block would misalign all the following frames, so
+    /// this waits for the rest of the block
+    /// @param buffer The buffer to fill
+    /// @return True if the whole block was read, false otherwise
+    bool read(std::vector<char> &buffer) override;
+
   protected:
     DeviceResponses parseAsyncSendCommand(const DeviceCommands &command,
                                           const std::any &data) override;
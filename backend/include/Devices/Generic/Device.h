@@ -3,9 +3,11 @@
 
 #include "stimwalkerConfig.h"
 
+#include "Data/EventMarkerRecorder.h"
 #include "Utils/CppMacros.h"
 #include <any>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 namespace STIMWALKER_NAMESPACE::devices {
@@ -130,6 +132,23 @@ protected:
   /// it actually failed to connect
   DECLARE_PROTECTED_MEMBER(bool, HasFailedToConnect)
 
+public:
+  /// @brief Set the channel the device records its events to (e.g. the
+  /// stimulations), so they can be aligned with the data
+  /// @param eventMarkers The channel of the session (nullptr to record nothing)
+  void setEventMarkers(std::shared_ptr<data::EventMarkerRecorder> eventMarkers);
+
+protected:
+  /// @brief Record that an event happens now. This does nothing if the device
+  /// is not part of a session, and never blocks
+  /// @param type The kind of event
+  /// @param payload A value that depends on [type]
+  void addEventMarker(data::EventMarkerType type, std::int64_t payload = 0);
+
+  /// @brief The channel the events of the device are recorded to
+  DECLARE_PROTECTED_MEMBER_NOGET(std::shared_ptr<data::EventMarkerRecorder>,
+                                 EventMarkers)
+
   /// Send methods
 public:
   /// @brief Send a command to the device
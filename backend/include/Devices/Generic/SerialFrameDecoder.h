@@ -0,0 +1,66 @@
+#ifndef __STIMWALKER_DEVICES_GENERIC_SERIAL_FRAME_DECODER_H__
+#define __STIMWALKER_DEVICES_GENERIC_SERIAL_FRAME_DECODER_H__
+
+#include "stimwalkerConfig.h"
+
+#include "Utils/ByteRingBuffer.h"
+
+namespace STIMWALKER_NAMESPACE::devices {
+
+/// @brief Splits the bytes received from a serial port into the frames of a
+/// protocol. A [SerialPortDevice] calls it every time bytes arrive, until it
+/// asks for more
+class SerialFrameDecoder {
+public:
+  /// @brief What the decoder found at the front of the received bytes
+  enum class Status {
+    /// @brief The bytes do not form a full frame yet
+    INCOMPLETE,
+
+    /// @brief The first [length] bytes are a frame
+    FRAME,
+
+    /// @brief The first [length] bytes cannot be part of a frame (noise, a
+    /// corrupted frame, ...) and must be dropped
+    SKIP,
+  };
+
+  /// @brief Destructor
+  virtual ~SerialFrameDecoder() = default;
+
+  /// @brief Look at the front of the received bytes. The bytes are not
+  /// consumed, the caller does it according to the returned status
+  /// @param buffer The bytes received and not consumed yet (never empty)
+  /// @param length The number of bytes of the frame or to skip
+  /// @return What the decoder found
+  virtual Status decode(const utils::ByteRingBuffer &buffer,
+                        size_t &length) = 0;
+
+  /// @brief Forget any state, the next byte starts a new frame (e.g. after a
+  /// read timeout)
+  virtual void reset() {}
+};
+
+/// @brief Frames that end with a delimiter (e.g. a text protocol with a frame
+/// per line). The delimiter is part of the frame
+class DelimitedFrameDecoder : public SerialFrameDecoder {
+public:
+  /// @brief Constructor
+  /// @param delimiter The byte ending each frame
+  DelimitedFrameDecoder(char delimiter = '\n');
+
+  Status decode(const utils::ByteRingBuffer &buffer, size_t &length) override;
+
+  void reset() override;
+
+protected:
+  /// @brief The byte ending each frame
+  char m_Delimiter;
+
+  /// @brief How far the previous calls already looked for the delimiter
+  size_t m_SearchedLength;
+};
+
+} // namespace STIMWALKER_NAMESPACE::devices
+
+#endif // __STIMWALKER_DEVICES_GENERIC_SERIAL_FRAME_DECODER_H__
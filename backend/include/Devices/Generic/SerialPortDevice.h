@@ -1,11 +1,44 @@
 #ifndef __STIMWALKER_DEVICES_GENERIC_SERIAL_PORT_DEVICE_H__
 #define __STIMWALKER_DEVICES_GENERIC_SERIAL_PORT_DEVICE_H__
 
+#include <memory>
+#include <mutex>
+#include <thread>
+
 #include "Devices/Generic/AsyncDevice.h"
+#include "Devices/Generic/SerialFrameDecoder.h"
+#include "Utils/ByteRingBuffer.h"
 
 namespace STIMWALKER_NAMESPACE::devices {
 
+/// @brief The line settings of a serial port
+struct SerialPortSettings {
+  /// @brief The speed of the line, in bits per second
+  unsigned int baudRate = 9600;
+
+  /// @brief The number of bits of each character
+  unsigned int characterSize = 8;
+
+  /// @brief The parity check
+  asio::serial_port_base::parity::type parity =
+      asio::serial_port_base::parity::none;
+
+  /// @brief The number of stop bits
+  asio::serial_port_base::stop_bits::type stopBits =
+      asio::serial_port_base::stop_bits::one;
+
+  /// @brief The flow control
+  asio::serial_port_base::flow_control::type flowControl =
+      asio::serial_port_base::flow_control::none;
+};
+
 /// @brief A class representing a Serial port device
+/// @details Once connected, a dedicated thread runs the I/O of the port. The
+/// bytes are received in a ring buffer allocated once, split into frames by
+/// the [FrameDecoder] of the device and handed to [handleReceivedFrame]. A
+/// partial frame left for longer than [ReadTimeout] is dropped so the decoding
+/// recovers from a truncated frame. The writes are queued and the bytes
+/// queued while a write is in flight are sent together with the next one.
 /// @note This class is only available on Windows and Linux
 class SerialPortDevice : public AsyncDevice {
 
@@ -13,9 +46,12 @@ public:
   /// @brief Constructor
   /// @param port The port name of the device
   /// @param keepAliveInterval The interval to keep the device alive
+  /// @param settings The line settings of the port
   SerialPortDevice(const std::string &port,
-                   const std::chrono::microseconds &keepAliveInterval);
+                   const std::chrono::microseconds &keepAliveInterval,
+                   const SerialPortSettings &settings = SerialPortSettings());
   SerialPortDevice(const SerialPortDevice &other) = delete;
+  ~SerialPortDevice() override;
 
 protected:
   /// Protected members with Get accessors
@@ -34,14 +70,101 @@ protected:
   DECLARE_PROTECTED_MEMBER_NOGET(std::unique_ptr<asio::io_context>,
                                  SerialPortContext)
 
+  /// @brief The line settings applied when connecting
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(SerialPortSettings, SerialPortSettings)
+
+  /// @brief How long a partial frame can wait for the rest of its bytes
+  /// (zero to wait forever). It applies from the next connection
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(std::chrono::milliseconds, ReadTimeout)
+
+  /// @brief The number of write operations done, each of them sending all
+  /// the bytes queued meanwhile
+  DECLARE_PROTECTED_MEMBER(size_t, WriteOperationCount)
+
+  /// @brief The decoder splitting the received bytes into frames (nullptr to
+  /// hand the bytes as they come)
+  DECLARE_PROTECTED_MEMBER_NOGET(std::unique_ptr<SerialFrameDecoder>,
+                                 FrameDecoder)
+
+  /// @brief The bytes received and not consumed by the decoder yet
+  DECLARE_PROTECTED_MEMBER_NOGET(utils::ByteRingBuffer, ReceivedBytes)
+
+  /// @brief The timer dropping a partial frame after [ReadTimeout]
+  DECLARE_PROTECTED_MEMBER_NOGET(std::unique_ptr<asio::steady_timer>,
+                                 ReadTimeoutTimer)
+
+  /// @brief The bytes waiting for the write in flight to complete
+  DECLARE_PROTECTED_MEMBER_NOGET(std::string, WriteQueue)
+
+  /// @brief The bytes of the write in flight
+  DECLARE_PROTECTED_MEMBER_NOGET(std::string, BytesBeingWritten)
+
+  /// @brief If a write is in flight
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsWriting)
+
+  /// @brief The mutex protecting the write queue
+  DECLARE_PROTECTED_MEMBER_NOGET(std::mutex, WriteQueueMutex)
+
+  /// @brief The thread running the I/O of the port
+  DECLARE_PROTECTED_MEMBER_NOGET(std::thread, SerialPortWorker)
+
+  /// @brief Keep the I/O thread running until it is asked to stop (so the
+  /// port can always be closed from it)
+  DECLARE_PROTECTED_MEMBER_NOGET(
+      std::unique_ptr<
+          asio::executor_work_guard<asio::io_context::executor_type>>,
+      SerialPortWorkGuard)
+
   /// Methods
 public:
   bool disconnect() override;
 
 protected:
+  /// @brief Open the port, apply the line settings and start the I/O thread
   bool handleConnect() override;
   bool handleDisconnect() override;
 
+  /// @brief Queue bytes to write to the port. This can be called from any
+  /// thread and does not wait for the bytes to be sent. Throws a
+  /// [DeviceException] if the port is not open
+  /// @param bytes The bytes to write
+  virtual void writeToDevice(const std::string &bytes);
+
+  /// @brief Add bytes received from the port and hand the full frames to
+  /// [handleReceivedFrame]. This is called by the I/O thread
+  /// @param data The bytes received
+  /// @param size The number of bytes received
+  void handleReceivedBytes(const char *data, size_t size);
+
+  /// @brief Handle a frame received from the port. This is called by the I/O
+  /// thread, so it should not block
+  /// @param frame The bytes of the frame
+  virtual void handleReceivedFrame(const std::string &frame);
+
+  /// @brief Handle a partial frame dropped after [ReadTimeout]. This is called
+  /// by the I/O thread
+  /// @param droppedBytes The bytes of the partial frame
+  virtual void handleReadTimeout(const std::string &droppedBytes);
+
+  /// @brief Start the I/O thread of the port
+  void startSerialPortWorker();
+
+  /// @brief Close the port and stop the I/O thread
+  void stopSerialPortWorker();
+
+  /// @brief Close the port, which aborts its pending operations. This must be
+  /// called by the I/O thread, or once it is stopped
+  void closeSerialPort();
+
+  /// @brief Split the received bytes into frames
+  void decodeReceivedBytes();
+
+  /// @brief Receive the next bytes (asynchronously)
+  void readNext();
+
+  /// @brief Write the queued bytes (asynchronously)
+  void writeNext();
+
   /// @brief Set the "RTS" mode of the communication. [isFast] to true is
   /// faster but less reliable.
   /// @param isFast True to enable fast mode, false to disable it
@@ -0,0 +1,113 @@
+#ifndef __STIMWALKER_DEVICES_GENERIC_STIMULATION_PLAN_H__
+#define __STIMWALKER_DEVICES_GENERIC_STIMULATION_PLAN_H__
+
+#include "stimwalkerConfig.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "Devices/Generic/StimulationRule.h"
+#include "Utils/CppMacros.h"
+
+namespace STIMWALKER_NAMESPACE::devices {
+
+/// @brief A condition reduced to an open interval of one of the inputs of a
+/// sample. The four comparisons (and the unknown inputs, which are negative)
+/// are folded into the bounds, so checking a condition is two comparisons
+/// and no branch
+struct CompiledCondition {
+  /// @brief The inputs a condition can look at, in the order they are given to
+  /// [isMet]
+  enum Source : std::uint8_t {
+    /// @brief The percentage of the stride of the left leg (-1 if unknown)
+    LEFT_PERCENTAGE = 0,
+
+    /// @brief The percentage of the stride of the right leg (-1 if unknown)
+    RIGHT_PERCENTAGE = 1,
+
+    /// @brief The time since the rule started stimulating (us, -1 if it is
+    /// not stimulating)
+    STIMULATING_FOR = 2,
+
+    /// @brief Always zero, for the conditions that are always (or never) met
+    ZERO = 3,
+
+    SOURCE_COUNT = 4,
+  };
+
+  /// @brief The input checked
+  Source source;
+
+  /// @brief The value of the input must be strictly above this bound
+  double lower;
+
+  /// @brief The value of the input must be strictly below this bound
+  double upper;
+
+  /// @brief Check the condition
+  /// @param inputs The [SOURCE_COUNT] inputs of the sample
+  /// @return True if the condition is met
+  bool isMet(const double *inputs) const {
+    double value = inputs[source];
+    return (value > lower) & (value < upper);
+  }
+};
+
+/// @brief A rule of a [StimulationPlan]. A rule without a continue condition
+/// gets one that is always met, and a rule with one gets an end condition
+/// that is never met, so the decision to stop is always
+/// [(stopsWhenStartIsLost && !start) || !keepGoing || end]
+struct CompiledRule {
+  /// @brief When to start stimulating
+  CompiledCondition start;
+
+  /// @brief While to keep stimulating
+  CompiledCondition keepGoing;
+
+  /// @brief When to stop stimulating
+  CompiledCondition end;
+
+  /// @brief If the rule stops when its start condition is no longer met (the
+  /// rules with a continue condition)
+  bool stopsWhenStartIsLost;
+};
+
+/// @brief A set of stimulation rules compiled, once at load time, into a flat
+/// array of [CompiledRule]. The type of each condition (comparison, side,
+/// gait percentage or duration) is resolved by the compilation, so
+/// evaluating the rules of a sample is a tight loop over plain data
+class StimulationPlan {
+public:
+  /// @brief Compile a condition
+  /// @param condition The condition
+  /// @return The compiled condition
+  static CompiledCondition compile(const StimulationCondition &condition);
+
+  /// @brief Compile a rule
+  /// @param rule The rule
+  /// @return The compiled rule
+  static CompiledRule compile(const StimulationRule &rule);
+
+  /// @brief Compile and add a rule at the end of the plan
+  /// @param rule The rule to add
+  void add(const StimulationRule &rule);
+
+  /// @brief Remove all the rules
+  void clear();
+
+  /// @brief Get the number of rules
+  /// @return The number of rules
+  size_t size() const;
+
+  /// @brief Get the compiled rules, in the order they were added
+  /// @return The compiled rules
+  const std::vector<CompiledRule> &getRules() const;
+
+protected:
+  /// @brief The compiled rules
+  std::vector<CompiledRule> m_Rules;
+};
+
+} // namespace STIMWALKER_NAMESPACE::devices
+
+#endif // __STIMWALKER_DEVICES_GENERIC_STIMULATION_PLAN_H__
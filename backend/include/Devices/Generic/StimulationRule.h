@@ -0,0 +1,169 @@
+#ifndef __STIMWALKER_DEVICES_GENERIC_STIMULATION_RULE_H__
+#define __STIMWALKER_DEVICES_GENERIC_STIMULATION_RULE_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Devices/Exceptions.h"
+#include "Utils/CppMacros.h"
+
+namespace STIMWALKER_NAMESPACE::devices {
+
+/// @brief How the current value is compared to the threshold of a condition
+enum class StimulationComparison {
+  GREATER_OR_EQUAL = 0,
+  GREATER = 1,
+  LESS_OR_EQUAL = 2,
+  LESS = 3,
+};
+
+/// @brief The leg a condition on the gait looks at
+enum class StimulationSide {
+  NONE = 0,
+  LEFT = 1,
+  RIGHT = 2,
+};
+
+/// @brief A condition of a stimulation rule. It compares either the
+/// percentage of the stride of a leg or the time since the rule started
+/// stimulating to a threshold. If both are given, the percentage is used
+class StimulationCondition {
+public:
+  /// @brief Constructor of a condition on the percentage of the stride
+  /// @param comparison How the percentage is compared to [gaitPercentage]
+  /// @param side The leg of the stride
+  /// @param gaitPercentage The threshold, in [0; 1]
+  static StimulationCondition onGaitPercentage(StimulationComparison comparison,
+                                               StimulationSide side,
+                                               double gaitPercentage);
+
+  /// @brief Constructor of a condition on the time since the rule started
+  /// stimulating
+  /// @param comparison How the time is compared to [duration]
+  /// @param duration The threshold
+  static StimulationCondition
+  onDuration(StimulationComparison comparison,
+             const std::chrono::microseconds &duration);
+
+  /// @brief Constructor from the JSON schema of the Python scheduler, e.g.
+  /// {"side": "left", "comparison": "from", "gait_event": "toe_off"}
+  /// @param json The condition in serialized form
+  /// @throw InvalidStimulationRuleException if the condition is not valid
+  StimulationCondition(const nlohmann::json &json);
+
+  /// @brief Check the condition
+  /// @param leftPercentage The percentage of the stride of the left leg (-1
+  /// if unknown)
+  /// @param rightPercentage The percentage of the stride of the right leg (-1
+  /// if unknown)
+  /// @param stimulatingFor The time since the rule started stimulating (-1 if
+  /// it is not stimulating)
+  /// @return True if the condition is met. A condition on an unknown value is
+  /// never met
+  bool isMet(double leftPercentage, double rightPercentage,
+             const std::chrono::microseconds &stimulatingFor) const;
+
+  /// @brief Convert the condition to JSON. The gait events are written as
+  /// such when the percentage is the one of an event
+  /// @return The JSON object
+  nlohmann::json serialize() const;
+
+protected:
+  /// @brief Constructor
+  StimulationCondition(StimulationComparison comparison, StimulationSide side,
+                       double gaitPercentage,
+                       const std::chrono::microseconds &duration);
+
+  /// @brief How the value is compared to the threshold
+  DECLARE_PROTECTED_MEMBER(StimulationComparison, Comparison)
+
+  /// @brief The leg of the stride (NONE if the condition is on the duration)
+  DECLARE_PROTECTED_MEMBER(StimulationSide, Side)
+
+  /// @brief The threshold on the percentage of the stride (-1 if the
+  /// condition is on the duration)
+  DECLARE_PROTECTED_MEMBER(double, GaitPercentage)
+
+  /// @brief The threshold on the time since the rule started stimulating
+  /// (negative if there is none)
+  DECLARE_PROTECTED_MEMBER(std::chrono::microseconds, Duration)
+};
+
+/// @brief A rule of the stimulation scheduler, with the same JSON schema as
+/// the Python AutomaticStimulationRule. The rule starts stimulating its
+/// channels when its start condition becomes met, and stops them when the
+/// start or continue condition is no longer met (or, if there is no continue
+/// condition, when the end condition is met)
+class StimulationRule {
+public:
+  /// @brief Constructor
+  /// @param name The name of the rule
+  /// @param channels The channels of the stimulator to stimulate
+  /// @param amplitudes The amplitude of each of [channels] (mA)
+  /// @param start When to start stimulating
+  /// @param continueCondition While to keep stimulating
+  /// @param end When to stop stimulating (only used without
+  /// [continueCondition])
+  /// @throw InvalidStimulationRuleException if the rule is not valid
+  StimulationRule(const std::string &name, const std::vector<size_t> &channels,
+                  const std::vector<double> &amplitudes,
+                  const StimulationCondition &start,
+                  const std::optional<StimulationCondition> &continueCondition,
+                  const std::optional<StimulationCondition> &end =
+                      std::nullopt);
+
+  /// @brief Constructor from the JSON schema of the Python scheduler
+  /// @param json The rule in serialized form
+  /// @throw InvalidStimulationRuleException if the rule is not valid
+  StimulationRule(const nlohmann::json &json);
+
+  /// @brief Read a list of rules, such as the
+  /// default_stimulations_schedules_rules.json of the Python scheduler
+  /// @param json The list of rules in serialized form
+  /// @return The rules
+  /// @throw InvalidStimulationRuleException if any of the rules is not valid
+  static std::vector<StimulationRule> fromJsonList(const nlohmann::json &json);
+
+  /// @brief Read a list of rules from a file
+  /// @param path The path of the JSON file
+  /// @return The rules
+  /// @throw InvalidStimulationRuleException if the file cannot be read or any
+  /// of the rules is not valid
+  static std::vector<StimulationRule> fromFile(const std::string &path);
+
+  /// @brief Convert the rule to JSON
+  /// @return The JSON object
+  nlohmann::json serialize() const;
+
+protected:
+  /// @brief Check the rule is complete
+  /// @throw InvalidStimulationRuleException if the rule is not valid
+  void validate() const;
+
+  /// @brief The name of the rule
+  DECLARE_PROTECTED_MEMBER(std::string, Name)
+
+  /// @brief The channels of the stimulator to stimulate
+  DECLARE_PROTECTED_MEMBER(std::vector<size_t>, Channels)
+
+  /// @brief The amplitude of each of the channels (mA)
+  DECLARE_PROTECTED_MEMBER(std::vector<double>, Amplitudes)
+
+  /// @brief When to start stimulating
+  DECLARE_PROTECTED_MEMBER(std::optional<StimulationCondition>, Start)
+
+  /// @brief While to keep stimulating
+  DECLARE_PROTECTED_MEMBER(std::optional<StimulationCondition>, Continue)
+
+  /// @brief When to stop stimulating
+  DECLARE_PROTECTED_MEMBER(std::optional<StimulationCondition>, End)
+};
+
+} // namespace STIMWALKER_NAMESPACE::devices
+
+#endif // __STIMWALKER_DEVICES_GENERIC_STIMULATION_RULE_H__
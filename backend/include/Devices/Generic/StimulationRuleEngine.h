@@ -0,0 +1,201 @@
+#ifndef __STIMWALKER_DEVICES_GENERIC_STIMULATION_RULE_ENGINE_H__
+#define __STIMWALKER_DEVICES_GENERIC_STIMULATION_RULE_ENGINE_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "Data/GaitPhaseEstimator.h"
+#include "Data/TimingHistogram.h"
+#include "Devices/Generic/StimulationPlan.h"
+#include "Devices/Generic/StimulationRule.h"
+#include "Utils/CppMacros.h"
+#include "Utils/StimwalkerEvent.h"
+
+namespace STIMWALKER_NAMESPACE::devices {
+class DataCollector;
+class Stimulator;
+
+/// @brief A rule starting or stopping its stimulation
+struct StimulationDecision {
+  /// @brief The time stamp of the sample that triggered the decision
+  std::chrono::microseconds timeStamp;
+
+  /// @brief The index of the rule in the engine
+  size_t ruleIndex;
+
+  /// @brief True if the rule started stimulating, false if it stopped
+  bool isStarting;
+};
+
+/// @brief Evaluate stimulation rules (the ones of the Python scheduler) on the
+/// data of a collector, and drive a stimulator accordingly. The percentage of
+/// the stride of each leg is estimated from its hip angle, and the rules are
+/// evaluated on every sample of every block, from the thread notifying the
+/// block. The rules are compiled into a [StimulationPlan] when they are added,
+/// so the work of a block is bounded (a constant cost per sample and per
+/// rule, and no allocation unless a decision is published), and the
+/// stimulator is called at most once per block, with the channels that
+/// changed.
+/// @note Once stopped by its continue (or end) condition, a rule only starts
+/// again after its start condition stopped being met, so a rule stimulating
+/// for a duration does it once per stride
+class StimulationRuleEngine {
+public:
+  /// @brief Constructor
+  /// @param leftHipChannel The channel of the left hip angle in the blocks
+  /// @param rightHipChannel The channel of the right hip angle in the blocks
+  StimulationRuleEngine(size_t leftHipChannel, size_t rightHipChannel);
+
+  /// @brief Destructor. The engine is detached from its collector
+  ~StimulationRuleEngine();
+  StimulationRuleEngine(const StimulationRuleEngine &) = delete;
+  StimulationRuleEngine &operator=(const StimulationRuleEngine &) = delete;
+
+  /// @brief Add a rule. This can be called while the engine is attached
+  /// @param rule The rule to add
+  /// @return The index of the rule
+  size_t addRule(const StimulationRule &rule);
+
+  /// @brief Add the rules of a list
+  /// @param rules The rules to add
+  void addRules(const std::vector<StimulationRule> &rules);
+
+  /// @brief Remove all the rules. The channels of the rules that were
+  /// stimulating are stopped
+  void clearRules();
+
+  /// @brief Get the number of rules
+  /// @return The number of rules
+  size_t getRuleCount() const;
+
+  /// @brief Get a copy of a rule
+  /// @param index The index of the rule
+  /// @return The rule
+  StimulationRule getRule(size_t index) const;
+
+  /// @brief Get if a rule is stimulating
+  /// @param index The index of the rule
+  /// @return True if the rule is stimulating
+  bool isStimulating(size_t index) const;
+
+  /// @brief Set the stimulator driven by the rules
+  /// @param stimulator The stimulator (it must outlive the engine, or be
+  /// replaced before being destroyed), or nullptr to only publish the
+  /// decisions
+  void setStimulator(Stimulator *stimulator);
+
+  /// @brief Evaluate the rules on the blocks of [collector]. The engine is
+  /// detached from its previous collector, and starts from a fresh gait
+  /// estimation
+  /// @param collector The collector (it must outlive the engine, or [detach]
+  /// must be called before it is destroyed)
+  /// @return True if the engine is attached, false if the collector does not
+  /// have the hip channels
+  bool attach(DataCollector &collector);
+
+  /// @brief Stop evaluating the rules. The channels of the rules that were
+  /// stimulating are stopped
+  void detach();
+
+  /// @brief Get if the engine is attached to a collector
+  /// @return True if the engine is attached
+  bool isAttached() const;
+
+  /// @brief Evaluate the rules on all the samples of a block. This is what is
+  /// called on the blocks of the attached collector
+  /// @param block The block, with the hip angles
+  void processBlock(const data::DataBlock &block);
+
+  /// @brief Get the histogram of the time spent in [processBlock]
+  /// @return A copy of the histogram
+  data::TimingHistogram getProcessingTimes() const;
+
+  /// @brief Event called for each rule that starts or stops stimulating, from
+  /// the thread that processes the block (after the stimulator was updated)
+  utils::StimwalkerEvent<StimulationDecision> onStimulationDecision;
+
+protected:
+  /// @brief The state of a rule
+  struct RuleState {
+    /// @brief If the rule is stimulating
+    bool isStimulating = false;
+
+    /// @brief If the start condition was not met since the rule stopped
+    bool isArmed = true;
+
+    /// @brief When the rule started stimulating
+    std::chrono::microseconds startedAt = std::chrono::microseconds(0);
+  };
+
+  /// @brief Stop the rules that are stimulating. [m_Mutex] must be locked
+  /// @param timeStamp The time stamp of the decisions
+  void stopAllRules(const std::chrono::microseconds &timeStamp);
+
+  /// @brief Queue the change of the channels of a rule to the stimulator.
+  /// [m_Mutex] must be locked
+  /// @param index The index of the rule
+  /// @param isStarting If the channels start (or stop) stimulating
+  void queueChannels(size_t index, bool isStarting);
+
+  /// @brief Send the queued changes to the stimulator. [m_Mutex] must be
+  /// locked
+  void sendChangesToStimulator();
+
+  /// @brief Release [lock] and publish the queued decisions
+  /// @param lock The lock on [m_Mutex]
+  void publishDecisions(std::unique_lock<std::mutex> &lock);
+
+  /// @brief The rules
+  std::vector<StimulationRule> m_Rules;
+
+  /// @brief The rules compiled for the evaluation
+  DECLARE_PROTECTED_MEMBER_NOGET(StimulationPlan, Plan)
+
+  /// @brief The state of each rule
+  std::vector<RuleState> m_RuleStates;
+
+  /// @brief The estimation of the gait of the left leg
+  DECLARE_PROTECTED_MEMBER_NOGET(data::GaitPhaseEstimator, LeftGait)
+
+  /// @brief The estimation of the gait of the right leg
+  DECLARE_PROTECTED_MEMBER_NOGET(data::GaitPhaseEstimator, RightGait)
+
+  /// @brief The stimulator driven by the rules (nullptr if none)
+  DECLARE_PROTECTED_MEMBER_NOGET(Stimulator *, Stimulator)
+
+  /// @brief The collector the engine is attached to (nullptr if none)
+  DECLARE_PROTECTED_MEMBER_NOGET(DataCollector *, Collector)
+
+  /// @brief The id of the listener of the blocks of [m_Collector]
+  DECLARE_PROTECTED_MEMBER_NOGET(size_t, ListenerId)
+
+  /// @brief The time stamp of the last sample processed
+  DECLARE_PROTECTED_MEMBER_NOGET(std::chrono::microseconds, LastTimeStamp)
+
+  /// @brief The new amplitude of each channel of the stimulator (NaN if it
+  /// does not change)
+  DECLARE_PROTECTED_MEMBER_NOGET(std::vector<double>, PendingAmplitudes)
+
+  /// @brief The channels and amplitudes sent to the stimulator (kept to reuse
+  /// their memory)
+  DECLARE_PROTECTED_MEMBER_NOGET(std::vector<size_t>, ChangedChannels)
+  DECLARE_PROTECTED_MEMBER_NOGET(std::vector<double>, ChangedAmplitudes)
+
+  /// @brief The decisions waiting to be published
+  DECLARE_PROTECTED_MEMBER_NOGET(std::vector<StimulationDecision>,
+                                 PendingDecisions)
+
+  /// @brief The time spent in [processBlock]
+  DECLARE_PROTECTED_MEMBER_NOGET(data::TimingHistogram, ProcessingTimes)
+
+  /// @brief The mutex protecting the rules and their states. It is held while
+  /// calling the stimulator, so the changes reach it in order
+  mutable std::mutex m_Mutex;
+};
+
+} // namespace STIMWALKER_NAMESPACE::devices
+
+#endif // __STIMWALKER_DEVICES_GENERIC_STIMULATION_RULE_ENGINE_H__
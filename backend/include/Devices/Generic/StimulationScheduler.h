@@ -0,0 +1,127 @@
+#ifndef __STIMWALKER_DEVICES_GENERIC_STIMULATION_SCHEDULER_H__
+#define __STIMWALKER_DEVICES_GENERIC_STIMULATION_SCHEDULER_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "Data/TimingHistogram.h"
+#include "Utils/CppMacros.h"
+
+namespace STIMWALKER_NAMESPACE::devices {
+class Stimulator;
+
+/// @brief A dedicated thread that fires stimulator actions at requested
+/// times. The timers of the devices only have a millisecond granularity, so
+/// instead the worker sleeps until shortly before the deadline (on an absolute
+/// monotonic timer, a timerfd on Linux) and busy-waits the last
+/// [SpinDuration]. Each firing records the achieved minus the requested time
+/// in the [TimingErrors] histogram.
+/// @note The actions run on the worker, one at a time, so they should be short
+/// (e.g. [MagstimRapidDevice::trigger] which only writes to the serial port)
+class StimulationScheduler {
+public:
+  /// @brief Constructor. The worker thread is started right away
+  /// @param spinDuration How long the worker busy-waits before a deadline. It
+  /// should cover the wake-up latency of the system
+  StimulationScheduler(const std::chrono::microseconds &spinDuration =
+                           std::chrono::microseconds(200));
+
+  /// @brief Destructor. The pending actions are dropped, not fired
+  ~StimulationScheduler();
+  StimulationScheduler(const StimulationScheduler &) = delete;
+  StimulationScheduler &operator=(const StimulationScheduler &) = delete;
+
+  /// @brief Queue an action to fire at [deadline]. This can be called from any
+  /// thread. A deadline in the past fires as soon as possible. Actions of the
+  /// same deadline fire in the order they were scheduled
+  /// @param deadline When the action should fire
+  /// @param action The action to fire (it must outlive the firing)
+  /// @return The id of the request, to [cancel] it
+  size_t schedule(const std::chrono::steady_clock::time_point &deadline,
+                  std::function<void()> action);
+
+  /// @brief Queue a stimulation of [stimulator] at [deadline]
+  /// @param deadline When the stimulation should happen
+  /// @param stimulator The stimulator (it must outlive the firing)
+  /// @return The id of the request, to [cancel] it
+  size_t schedule(const std::chrono::steady_clock::time_point &deadline,
+                  Stimulator &stimulator);
+
+  /// @brief Remove a request from the queue. A request that is about to fire
+  /// (in its final spin) can no longer be cancelled
+  /// @param id The id returned by [schedule]
+  /// @return True if the request was removed, false if it was not pending
+  bool cancel(size_t id);
+
+  /// @brief Get the number of requests waiting to fire
+  /// @return The number of pending requests
+  size_t getPendingCount() const;
+
+  /// @brief Get the histogram of the timing errors of the fired requests
+  /// @return A copy of the histogram
+  data::TimingHistogram getTimingErrors() const;
+
+  /// @brief Forget the timing errors recorded so far
+  void resetTimingErrors();
+
+protected:
+  /// @brief The loop of the worker thread
+  void workerLoop();
+
+  /// @brief Sleep until [wakeUp], or until [wakeWorker] is called. [lock] is
+  /// released while sleeping
+  /// @param lock The lock on [m_Mutex]
+  /// @param wakeUp When to wake up
+  void sleepUntil(std::unique_lock<std::mutex> &lock,
+                  const std::chrono::steady_clock::time_point &wakeUp);
+
+  /// @brief Sleep until [wakeWorker] is called. [lock] is released while
+  /// sleeping
+  /// @param lock The lock on [m_Mutex]
+  void sleep(std::unique_lock<std::mutex> &lock);
+
+  /// @brief Interrupt the sleep of the worker so it looks at the queue again
+  void wakeWorker();
+
+  /// @brief The requests waiting to fire, sorted by deadline then by id
+  std::map<std::pair<std::chrono::steady_clock::time_point, size_t>,
+           std::function<void()>>
+      m_Requests;
+
+  /// @brief The id of the next request
+  DECLARE_PROTECTED_MEMBER_NOGET(size_t, NextRequestId)
+
+  /// @brief How long the worker busy-waits before a deadline
+  DECLARE_PROTECTED_MEMBER(std::chrono::microseconds, SpinDuration)
+
+  /// @brief The timing errors of the fired requests
+  DECLARE_PROTECTED_MEMBER_NOGET(data::TimingHistogram, TimingErrors)
+
+  /// @brief If the worker should keep running
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsRunning)
+
+  /// @brief The mutex protecting the requests and the timing errors
+  mutable std::mutex m_Mutex;
+
+  /// @brief Used to wake the worker where timerfd is not available
+  DECLARE_PROTECTED_MEMBER_NOGET(std::condition_variable, Condition)
+
+  /// @brief The absolute timer the worker sleeps on (Linux only)
+  DECLARE_PROTECTED_MEMBER_NOGET(int, TimerFileDescriptor)
+
+  /// @brief The event that interrupts the sleep of the worker (Linux only)
+  DECLARE_PROTECTED_MEMBER_NOGET(int, WakeUpFileDescriptor)
+
+  /// @brief The worker thread
+  DECLARE_PROTECTED_MEMBER_NOGET(std::thread, Worker)
+};
+
+} // namespace STIMWALKER_NAMESPACE::devices
+
+#endif // __STIMWALKER_DEVICES_GENERIC_STIMULATION_SCHEDULER_H__
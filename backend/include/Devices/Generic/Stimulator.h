@@ -18,6 +18,15 @@ public:
   /// @brief Perform a stimulation
   virtual void stimulate() = 0;
 
+  /// @brief Change the amplitude of some channels. A channel with a non-zero
+  /// amplitude starts (or keeps) stimulating, a channel with a zero amplitude
+  /// stops. The other channels are left as they are. This is called from the
+  /// acquisition threads, so it is expected to return quickly
+  /// @param channels The channels to change
+  /// @param amplitudes The new amplitude of each of [channels] (mA)
+  virtual void setChannelAmplitudes(const std::vector<size_t> &channels,
+                                    const std::vector<double> &amplitudes) = 0;
+
   /// @brief Get the number of channels in the stimulator
   /// @return The number of channels in the stimulator
   DECLARE_PROTECTED_MEMBER(int, StimulatorChannelCount)
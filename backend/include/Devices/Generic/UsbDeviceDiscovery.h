@@ -0,0 +1,135 @@
+#ifndef __STIMWALKER_DEVICES_GENERIC_USB_DEVICE_DISCOVERY_H__
+#define __STIMWALKER_DEVICES_GENERIC_USB_DEVICE_DISCOVERY_H__
+
+#include "stimwalkerConfig.h"
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Utils/CppMacros.h"
+
+namespace STIMWALKER_NAMESPACE::devices {
+
+/// @brief An index of the USB serial ports connected to the system, by vendor
+/// and product ID. The ports are scanned once, then the index is kept up to
+/// date from the hotplug events (an inotify watch on the dev folder on Linux),
+/// so a lookup does not touch the file system. Where no watch is available, a
+/// lookup that misses rescans the ports. A port that appears before its IDs
+/// can be read is tried again at each lookup, until [PendingPortTimeout] has
+/// passed; it is then only found by the next scan.
+/// @note The roots can be changed so the discovery can be tested against a
+/// fake file system
+class UsbDeviceDiscovery {
+public:
+  /// @brief A USB serial port
+  struct UsbPort {
+    /// @brief The path of the port (e.g. /dev/ttyUSB0 or COM3)
+    std::string port;
+
+    /// @brief The vendor ID, in upper case hexadecimal
+    std::string vid;
+
+    /// @brief The product ID, in upper case hexadecimal
+    std::string pid;
+  };
+
+  /// @brief Get the discovery of the ports of the system
+  static UsbDeviceDiscovery &getInstance();
+
+  /// @brief Constructor
+  /// @param devRoot The folder of the device files (/dev)
+  /// @param sysRoot The root of the sysfs (/sys), where the IDs are read
+  UsbDeviceDiscovery(const std::string &devRoot = "/dev",
+                     const std::string &sysRoot = "/sys");
+  ~UsbDeviceDiscovery();
+  UsbDeviceDiscovery(const UsbDeviceDiscovery &) = delete;
+  UsbDeviceDiscovery &operator=(const UsbDeviceDiscovery &) = delete;
+
+  /// @brief Find a port of a device. The IDs are not case sensitive. If
+  /// several ports match, the first in alphabetical order is returned
+  /// @param vid The vendor ID of the device
+  /// @param pid The product ID of the device
+  /// @return The port, if a device matches
+  std::optional<UsbPort> find(const std::string &vid, const std::string &pid);
+
+  /// @brief Get all the ports currently connected
+  /// @return The ports, in alphabetical order
+  std::vector<UsbPort> getPorts();
+
+  /// @brief Forget the index and scan all the ports again
+  void refresh();
+
+  /// @brief Get if the index is kept up to date from the hotplug events
+  /// @return True if the hotplug events are watched
+  bool isWatching() const;
+
+protected:
+  /// @brief Make sure the index is built and apply the pending hotplug
+  /// events. [m_Mutex] must be held
+  void update();
+
+  /// @brief Build the index from all the ports. [m_Mutex] must be held
+  void scan();
+
+  /// @brief Add a port to the index if it is a USB serial port with IDs. A
+  /// port whose IDs cannot be read yet is kept in [m_PendingNames] (with when
+  /// it was first tried). [m_Mutex] must be held
+  /// @param name The name of the port in the dev folder (e.g. ttyUSB0)
+  void addPort(const std::string &name);
+
+  /// @brief Add a port to the index. [m_Mutex] must be held
+  /// @param name The name of the port
+  /// @param port The port
+  void insertPort(const std::string &name, const UsbPort &port);
+
+  /// @brief Remove a port from the index. [m_Mutex] must be held
+  /// @param name The name of the port in the dev folder (e.g. ttyUSB0)
+  void removePort(const std::string &name);
+
+  /// @brief Get the key of the index for a pair of IDs
+  static std::string key(const std::string &vid, const std::string &pid);
+
+  /// @brief The folder of the device files
+  DECLARE_PROTECTED_MEMBER(std::string, DevRoot)
+
+  /// @brief The root of the sysfs
+  DECLARE_PROTECTED_MEMBER(std::string, SysRoot)
+
+  /// @brief The number of full scans done (each lookup is otherwise served
+  /// from the index)
+  DECLARE_PROTECTED_MEMBER(size_t, ScanCount)
+
+  /// @brief If the index was built
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsIndexed)
+
+  /// @brief The inotify watch of the dev folder (Linux only, -1 if none)
+  DECLARE_PROTECTED_MEMBER_NOGET(int, WatchFileDescriptor)
+
+  /// @brief How long a port whose IDs cannot be read is tried again (5 s by
+  /// default)
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(std::chrono::milliseconds,
+                                       PendingPortTimeout)
+
+  /// @brief The ports by name
+  std::unordered_map<std::string, UsbPort> m_PortsByName;
+
+  /// @brief The sorted names of the ports by "VID:PID"
+  std::unordered_map<std::string, std::vector<std::string>> m_NamesByIds;
+
+  /// @brief The names of the ports created before their sysfs entry was
+  /// ready, with when they were first tried. They are tried again at each
+  /// update until [m_PendingPortTimeout] has passed
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+      m_PendingNames;
+
+  /// @brief The mutex protecting the index
+  mutable std::mutex m_Mutex;
+};
+
+} // namespace STIMWALKER_NAMESPACE::devices
+
+#endif // __STIMWALKER_DEVICES_GENERIC_USB_DEVICE_DISCOVERY_H__
@@ -5,9 +5,15 @@
 #include "Devices/Generic/DataCollector.h"
 #include "Devices/Generic/DelsysBaseDevice.h"
 #include "Devices/Generic/Device.h"
+#include "Devices/Generic/SerialFrameDecoder.h"
 #include "Devices/Generic/SerialPortDevice.h"
+#include "Devices/Generic/StimulationPlan.h"
+#include "Devices/Generic/StimulationRule.h"
+#include "Devices/Generic/StimulationRuleEngine.h"
+#include "Devices/Generic/StimulationScheduler.h"
 #include "Devices/Generic/Stimulator.h"
 #include "Devices/Generic/TcpDevice.h"
 #include "Devices/Generic/UsbDevice.h"
+#include "Devices/Generic/UsbDeviceDiscovery.h"
 
 #endif // __STIMWALKER_DEVICES_GENERIC_ALL_H__
\ No newline at end of file
@@ -3,7 +3,9 @@
 
 #include "stimwalkerConfig.h"
 
+#include "Data/DataCheckTimings.h"
 #include "Data/TimeSeries.h"
+#include "Data/TimingHistogram.h"
 #include "Server/TcpServer.h"
 #include "Utils/CppMacros.h"
 #include <asio.hpp>
@@ -45,6 +47,14 @@ public:
   /// @return True if the device is added, false otherwise
   bool addMagstimDevice();
 
+  /// @brief Add the Lokomat device
+  /// @return True if the device is added, false otherwise
+  bool addLokomatDevice();
+
+  /// @brief Add the RehaStim device
+  /// @return True if the device is added, false otherwise
+  bool addRehastimDevice();
+
   /// @brief Remove the Delsys Analog device
   /// @return True if the device is removed, false otherwise
   bool removeDelsysAnalogDevice();
@@ -57,6 +67,14 @@ public:
   /// @return True if the device is removed, false otherwise
   bool removeMagstimDevice();
 
+  /// @brief Remove the Lokomat device
+  /// @return True if the device is removed, false otherwise
+  bool removeLokomatDevice();
+
+  /// @brief Remove the RehaStim device
+  /// @return True if the device is removed, false otherwise
+  bool removeRehastimDevice();
+
   /// @brief Start recording data
   /// @return True if the recording is started, false otherwise
   bool startRecording();
@@ -65,10 +83,62 @@ public:
   /// @return True if the recording is stopped, false otherwise
   bool stopRecording();
 
+  /// @brief Start recording the timing spans on the server
+  /// @return True if the tracing is started, false otherwise
+  bool startTracing();
+
+  /// @brief Stop recording the timing spans on the server. The server saves
+  /// the trace to its trace file
+  /// @return True if the tracing is stopped, false otherwise
+  bool stopTracing();
+
+  /// @brief Start evaluating the stimulation rules of the server on the data
+  /// of the Lokomat
+  /// @return True if the rules are started, false otherwise
+  bool startStimulationRules();
+
+  /// @brief Stop evaluating the stimulation rules of the server
+  /// @return True if the rules are stopped, false otherwise
+  bool stopStimulationRules();
+
+  /// @brief Set the duration of live data the server keeps (and sends) for
+  /// each device
+  /// @param window The duration of live data
+  /// @return True if the server accepted the duration, false otherwise
+  bool setLiveDataTimeWindow(const std::chrono::milliseconds &window);
+
+  /// @brief Set the duration of data before the start of the recording that
+  /// the server puts at the beginning of the trials
+  /// @param duration The duration of data before the trigger (zero to start
+  /// the trials at the trigger)
+  /// @return True if the server accepted the duration, false otherwise
+  bool setPreTriggerDuration(const std::chrono::milliseconds &duration);
+
   /// @brief Get the data from the previously recorded trial on the server
   /// @return True if the data is received, false otherwise
   std::map<std::string, data::TimeSeries> getLastTrialData();
 
+  /// @brief Get the whole timing of the data checks of the devices on the
+  /// server (the live data only hold their summary)
+  /// @return The timing of the data checks of each data collector (empty if
+  /// it could not be received)
+  std::map<std::string, data::DataCheckTimings> getDataCheckTimings();
+
+  /// @brief Get the number of live data updates received from the server
+  /// @return The number of updates
+  size_t getLiveDataUpdateCount() const;
+
+  /// @brief Get the number of bytes of live data received from the server
+  /// (the headers included)
+  /// @return The number of bytes
+  size_t getLiveDataByteCount() const;
+
+  /// @brief Get the latencies of the live data updates, from the server
+  /// sending an update to the client having parsed it. The server stamps the
+  /// updates to the millisecond, so are the latencies
+  /// @return The latencies
+  data::TimingHistogram getLiveDataLatencies() const;
+
 protected:
   /// @brief The data received from the server
   DECLARE_PROTECTED_MEMBER(data::TimeSeries, Data);
@@ -95,11 +165,31 @@ protected:
   /// @brief Receive and update the live data
   void updateLiveData();
 
+  /// @brief The number of live data updates received
+  size_t m_LiveDataUpdateCount;
+
+  /// @brief The number of bytes of live data received
+  size_t m_LiveDataByteCount;
+
+  /// @brief The latencies of the live data updates
+  data::TimingHistogram m_LiveDataLatencies;
+
+  /// @brief The mutex of the statistics of the live data
+  mutable std::mutex m_LiveDataMutex;
+
   /// @brief The Send a command to the server and wait for the confirmation
   /// @param command The command to send
   /// @return The acknowledgment from the server
   TcpServerResponse sendCommand(TcpServerCommand command);
 
+  /// @brief The Send a command followed by its argument to the server and wait
+  /// for the confirmation
+  /// @param command The command to send
+  /// @param argument The argument of the command
+  /// @return The acknowledgment from the server
+  TcpServerResponse sendCommand(TcpServerCommand command,
+                                std::uint32_t argument);
+
   /// @brief The Send a command to the server and wait for the confirmation
   /// @param command The command to send
   /// @return The response from the server
@@ -114,6 +204,14 @@ protected:
   /// @return The response from the server
   std::vector<char> waitForResponse(asio::ip::tcp::socket &socket);
 
+  /// @brief Wait for a response from the server
+  /// @param socket The socket to wait for the response
+  /// @param sentAt Where to put the time the server sent the response
+  /// @return The response from the server
+  std::vector<char>
+  waitForResponse(asio::ip::tcp::socket &socket,
+                  std::chrono::system_clock::time_point &sentAt);
+
   /// @brief Close the sockets
   void closeSockets();
 
@@ -122,6 +220,11 @@ protected:
   /// @return The corresponding packet
   std::array<char, 8> constructCommandPacket(TcpServerCommand command);
 
+  /// @brief Construct the packet of the argument of a command
+  /// @param argument The argument to send
+  /// @return The corresponding packet
+  std::array<char, 8> constructArgumentPacket(std::uint32_t argument);
+
   /// @brief Parse a response packet from the server
   /// @param buffer The buffer to parse
   /// @return The response from the server
@@ -4,6 +4,7 @@
 #include "stimwalkerConfig.h"
 
 #include "Devices/Devices.h"
+#include "Devices/Generic/StimulationRuleEngine.h"
 #include "Utils/CppMacros.h"
 #include <asio.hpp>
 #include <mutex>
@@ -17,14 +18,25 @@ enum class TcpServerCommand : std::uint32_t {
   CONNECT_DELSYS_ANALOG = 10,
   CONNECT_DELSYS_EMG = 11,
   CONNECT_MAGSTIM = 12,
+  CONNECT_LOKOMAT = 13,
+  CONNECT_REHASTIM = 14,
   ZERO_DELSYS_ANALOG = 40,
   ZERO_DELSYS_EMG = 41,
   DISCONNECT_DELSYS_ANALOG = 20,
   DISCONNECT_DELSYS_EMG = 21,
   DISCONNECT_MAGSTIM = 22,
+  DISCONNECT_LOKOMAT = 23,
+  DISCONNECT_REHASTIM = 24,
   START_RECORDING = 30,
   STOP_RECORDING = 31,
   GET_LAST_TRIAL_DATA = 32,
+  GET_DATA_CHECK_TIMINGS = 33,
+  START_TRACING = 50,
+  STOP_TRACING = 51,
+  SET_LIVE_DATA_TIME_WINDOW = 60,
+  SET_PRE_TRIGGER_DURATION = 61,
+  START_STIMULATION_RULES = 70,
+  STOP_STIMULATION_RULES = 71,
   FAILED = 100,
 };
 
@@ -124,11 +136,24 @@ protected:
   /// @return The packet to send
   std::array<char, 16> constructResponsePacket(TcpServerResponse response);
 
+  /// @brief Send data on the response socket, after a packet holding their
+  /// size
+  /// @param data The data to send
+  /// @return The number of bytes of data sent
+  size_t sendResponseData(const nlohmann::json &data);
+
   /// @brief Parse a packet from the client to get the command
   /// @param buffer The buffer to parse
   /// @return The command sent by the client
   TcpServerCommand parseCommandPacket(const std::array<char, 8> &buffer);
 
+  /// @brief Read the argument of the command being handled. The argument is
+  /// sent right after the command, in a packet of the same layout (the
+  /// version followed by the value)
+  /// @param argument The value sent by the client
+  /// @return True if the argument was read, false otherwise
+  bool readCommandArgument(std::uint32_t &argument);
+
   // -------------------------- //
   // --- TCP SERVER METHODS --- //
   // -------------------------- //
@@ -201,6 +226,31 @@ protected:
   /// @brief Handle the sending of the live data to the client
   void handleSendLiveData();
 
+  /// @brief Load the rules of [StimulationRulesPath] and evaluate them on the
+  /// data of the Lokomat, driving the connected stimulator (if any). The
+  /// decisions are added to the event markers
+  /// @return True if the rules are running, false otherwise
+  bool startStimulationRules();
+
+  /// @brief Stop evaluating the stimulation rules. The stimulations they
+  /// started are stopped
+  /// @return True if the rules were running, false otherwise
+  bool stopStimulationRules();
+
+  /// @brief The file of the stimulation rules (the JSON schema of the Python
+  /// scheduler), read by [startStimulationRules]. It defaults to the
+  /// STIMWALKER_STIMULATION_RULES_FILE environment variable
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(std::string, StimulationRulesPath);
+
+  /// @brief The serial port of the RehaStim, used when it is connected. It
+  /// defaults to the STIMWALKER_REHASTIM_PORT environment variable
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(std::string, RehastimPort);
+
+  /// @brief The stimulation rules evaluated on the data of the Lokomat. It
+  /// must be declared after [m_Devices] so it is detached first
+  DECLARE_PROTECTED_MEMBER_NOGET(devices::StimulationRuleEngine,
+                                 StimulationRules);
+
 private:
   /// @brief The asio contexts used for async methods of the server
   DECLARE_PRIVATE_MEMBER_NOGET(asio::io_context, Context);
@@ -228,7 +278,7 @@ public:
   TcpServerMock(
       int commandPort = 5000, int responsePort = 5001, int liveDataPort = 5002,
       std::chrono::milliseconds timeoutPeriod = std::chrono::milliseconds(5000))
-      : TcpServer(commandPort, responsePort) {
+      : TcpServer(commandPort, responsePort, liveDataPort) {
     m_TimeoutPeriod = timeoutPeriod;
   };
 
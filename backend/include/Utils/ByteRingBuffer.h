@@ -0,0 +1,164 @@
+#ifndef __STIMWALKER_UTILS_BYTE_RING_BUFFER_H__
+#define __STIMWALKER_UTILS_BYTE_RING_BUFFER_H__
+
+#include "stimwalkerConfig.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace STIMWALKER_NAMESPACE::utils {
+
+/// @brief A fixed capacity FIFO of bytes, allocated once. The bytes can be
+/// received directly in the buffer (see [writableRegion]) so a reader does not
+/// copy them, and parsed in place before being consumed.
+/// @note This class is not thread safe, the owner must protect it
+class ByteRingBuffer {
+public:
+  /// @brief The value returned by [find] when the byte is not found
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  /// @brief Constructor
+  /// @param capacity The maximum number of bytes held
+  ByteRingBuffer(size_t capacity);
+
+  /// @brief Get the number of bytes held
+  /// @return The number of bytes
+  size_t size() const;
+
+  /// @brief Get the maximum number of bytes held
+  /// @return The capacity
+  size_t capacity() const;
+
+  /// @brief Get if the buffer holds no byte
+  /// @return True if the buffer is empty
+  bool empty() const;
+
+  /// @brief Get if the buffer cannot take any more byte
+  /// @return True if the buffer is full
+  bool full() const;
+
+  /// @brief Get a byte held, from the oldest one
+  /// @param index The index of the byte (0 is the oldest)
+  /// @return The byte
+  char operator[](size_t index) const;
+
+  /// @brief Copy bytes at the end of the buffer
+  /// @param data The bytes to copy
+  /// @param size The number of bytes to copy
+  /// @return The number of bytes copied (less than [size] if the buffer is
+  /// full)
+  size_t write(const char *data, size_t size);
+
+  /// @brief Get the largest contiguous free region after the last byte, to
+  /// receive bytes directly in the buffer. Call [commitWrite] once filled.
+  /// Consuming bytes meanwhile does not move the region
+  /// @return The start and the size of the region (zero if the buffer is
+  /// full)
+  std::pair<char *, size_t> writableRegion();
+
+  /// @brief Add bytes written in the region returned by [writableRegion]
+  /// @param size The number of bytes written
+  void commitWrite(size_t size);
+
+  /// @brief Get the largest contiguous run of the bytes held from [offset], to
+  /// parse them in place
+  /// @param offset The index of the first byte
+  /// @return The start and the size of the run (zero if [offset] is past the
+  /// last byte)
+  std::pair<const char *, size_t> readableRegion(size_t offset = 0) const;
+
+  /// @brief Copy bytes without consuming them
+  /// @param offset The index of the first byte
+  /// @param count The number of bytes
+  /// @return The bytes
+  std::string peek(size_t offset, size_t count) const;
+
+  /// @brief Copy the oldest bytes and consume them
+  /// @param count The number of bytes
+  /// @return The bytes
+  std::string read(size_t count);
+
+  /// @brief Drop the oldest bytes
+  /// @param count The number of bytes to drop
+  void consume(size_t count);
+
+  /// @brief Drop all the bytes
+  void clear();
+
+  /// @brief Find a byte
+  /// @param value The byte to find
+  /// @param from The index to start from
+  /// @return The index of the first match from [from], or [npos]
+  size_t find(char value, size_t from = 0) const;
+
+protected:
+  /// @brief Get the position in [m_Data] of a byte held
+  /// @param index The index of the byte (0 is the oldest)
+  /// @return The position of the byte. A subtraction replaces the modulo, as
+  /// [index] never exceeds the capacity
+  size_t wrap(size_t index) const;
+
+  /// @brief The storage of the bytes
+  std::vector<char> m_Data;
+
+  /// @brief The position of the oldest byte in [m_Data]
+  size_t m_Head;
+
+  /// @brief The number of bytes held
+  size_t m_Size;
+};
+
+// The accessors used for every frame are defined here so the decoders of the
+// serial ports can inline them
+
+inline size_t ByteRingBuffer::size() const { return m_Size; }
+
+inline size_t ByteRingBuffer::capacity() const { return m_Data.size(); }
+
+inline bool ByteRingBuffer::empty() const { return m_Size == 0; }
+
+inline bool ByteRingBuffer::full() const { return m_Size == m_Data.size(); }
+
+inline size_t ByteRingBuffer::wrap(size_t index) const {
+  size_t position = m_Head + index;
+  return position >= m_Data.size() ? position - m_Data.size() : position;
+}
+
+inline std::pair<char *, size_t> ByteRingBuffer::writableRegion() {
+  if (full()) {
+    return {m_Data.data(), 0};
+  }
+
+  size_t tail = wrap(m_Size);
+  // The free space is either after the tail up to the end of the storage, or
+  // between the tail and the head when the bytes wrap around
+  size_t end = tail < m_Head ? m_Head : m_Data.size();
+  return {m_Data.data() + tail, end - tail};
+}
+
+inline void ByteRingBuffer::commitWrite(size_t size) {
+  m_Size = std::min(m_Size + size, m_Data.size());
+}
+
+inline std::pair<const char *, size_t>
+ByteRingBuffer::readableRegion(size_t offset) const {
+  if (offset >= m_Size) {
+    return {m_Data.data(), 0};
+  }
+
+  size_t start = wrap(offset);
+  return {m_Data.data() + start,
+          std::min(m_Size - offset, m_Data.size() - start)};
+}
+
+inline void ByteRingBuffer::consume(size_t count) {
+  count = std::min(count, m_Size);
+  m_Head = wrap(count);
+  m_Size -= count;
+}
+
+} // namespace STIMWALKER_NAMESPACE::utils
+
+#endif // __STIMWALKER_UTILS_BYTE_RING_BUFFER_H__
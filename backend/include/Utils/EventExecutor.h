@@ -0,0 +1,64 @@
+#ifndef __STIMWALKER_UTILS_EVENT_EXECUTOR_H__
+#define __STIMWALKER_UTILS_EVENT_EXECUTOR_H__
+
+#include "stimwalkerConfig.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "Utils/CppMacros.h"
+#include "Utils/MpscQueue.h"
+
+namespace STIMWALKER_NAMESPACE::utils {
+
+/// @brief A worker thread that runs the tasks posted to it in order. It is
+/// used by [StimwalkerEvent] to dispatch the callbacks outside of the thread
+/// that notifies (e.g. the acquisition threads)
+class EventExecutor {
+public:
+  /// @brief Constructor. The worker thread is started right away
+  EventExecutor();
+
+  /// @brief Destructor. The pending tasks are run before the worker stops
+  ~EventExecutor();
+  EventExecutor(const EventExecutor &) = delete;
+  EventExecutor &operator=(const EventExecutor &) = delete;
+
+  /// @brief Queue a task to run on the worker thread. This can be called from
+  /// any thread
+  /// @param task The task to run
+  void post(std::function<void()> task);
+
+  /// @brief Block until every task posted so far is done. This returns
+  /// immediately when called from the worker thread
+  void waitUntilIdle();
+
+  /// @brief Get the (approximate) number of tasks waiting to run
+  /// @return The number of tasks waiting to run
+  size_t getPendingTaskCount() const;
+
+protected:
+  /// @brief The loop of the worker thread
+  void workerLoop();
+
+  /// @brief The tasks waiting to run
+  MpscQueue<std::function<void()>> m_Tasks;
+
+  /// @brief The worker thread
+  DECLARE_PROTECTED_MEMBER_NOGET(std::thread, Worker)
+
+  /// @brief If the worker should keep running
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsRunning)
+
+  /// @brief The mutex protecting the wake-up condition of the worker
+  DECLARE_PROTECTED_MEMBER_NOGET(std::mutex, Mutex)
+
+  /// @brief Used to wake the worker when a task is posted
+  DECLARE_PROTECTED_MEMBER_NOGET(std::condition_variable, Condition)
+};
+
+} // namespace STIMWALKER_NAMESPACE::utils
+
+#endif // __STIMWALKER_UTILS_EVENT_EXECUTOR_H__
@@ -3,10 +3,21 @@
 
 #include "stimwalkerConfig.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <future>
 #include <mutex>
+#include <thread>
 
+#include "Utils/MpscQueue.h"
 #include "Utils/StimwalkerEvent.h"
+#include "Utils/StringFormat.h"
+
+#ifndef STIMWALKER_MIN_LOG_LEVEL
+#define STIMWALKER_MIN_LOG_LEVEL 0
+#endif
 
 namespace STIMWALKER_NAMESPACE::utils {
 
@@ -24,12 +35,76 @@ public:
   void warning(const std::string &message);
   void fatal(const std::string &message);
 
+  /// @brief Log a message at the DEBUG, INFO, WARNING, or FATAL level, where
+  /// each "{}" of [format] is replaced by the next argument (see
+  /// [utils::format]). The message is only formatted if the level is enabled
+  /// @param format The pattern of the message
+  /// @param value The argument for the first "{}"
+  /// @param args The arguments for the following "{}"
+  template <typename T, typename... Args>
+  void debug(std::string_view format, const T &value, const Args &...args) {
+    logFormatted(DEBUG, format, value, args...);
+  }
+  template <typename T, typename... Args>
+  void info(std::string_view format, const T &value, const Args &...args) {
+    logFormatted(INFO, format, value, args...);
+  }
+  template <typename T, typename... Args>
+  void warning(std::string_view format, const T &value, const Args &...args) {
+    logFormatted(WARNING, format, value, args...);
+  }
+  template <typename T, typename... Args>
+  void fatal(std::string_view format, const T &value, const Args &...args) {
+    logFormatted(FATAL, format, value, args...);
+  }
+
+  /// @brief Get if a message of [level] would currently be logged
+  /// @param level The level to test
+  /// @return True if the message would be logged
+  bool isLevelEnabled(Level level) const {
+    return level >= m_LogLevel.load(std::memory_order_relaxed);
+  }
+
   // Set the minimum log level. Messages below this level will not be logged.
   void setLogLevel(Level level);
 
+  // Get the minimum log level
+  Level getLogLevel() const;
+
   // Set the log file to write logs to a file
   void setLogFile(const std::string &filename);
 
+  /// @brief Set if the logs are written by a background thread. When
+  /// asynchronous, [log] only pushes the record to a lock-free queue and the
+  /// writer thread batches the console and file writes
+  /// @param isAsynchronous True to use the background writer
+  void setIsAsynchronous(bool isAsynchronous);
+
+  /// @brief Get if the logs are written by a background thread
+  /// @return True if the logs are written by a background thread
+  bool getIsAsynchronous() const;
+
+  /// @brief Set when the background writer flushes the pending records. It
+  /// wakes up every [interval], as soon as [maxBatchSize] records are pending,
+  /// or as soon as a record of at least [flushLevel] is pushed
+  /// @param interval The maximum time a record waits in the queue
+  /// @param maxBatchSize The number of pending records that triggers a flush
+  /// @param flushLevel The level that triggers an immediate flush
+  void setFlushPolicy(const std::chrono::milliseconds &interval,
+                      size_t maxBatchSize, Level flushLevel);
+
+  /// @brief Get the number of pending records that wakes the writer
+  /// @return The number of pending records that wakes the writer
+  size_t getFlushBatchSize() const;
+
+  /// @brief Get the minimum level that wakes the writer right away
+  /// @return The minimum level that wakes the writer right away
+  Level getFlushLevel() const;
+
+  /// @brief Block until every record logged so far is written. This does
+  /// nothing in synchronous mode
+  void flush();
+
   // Set a event to get a callback when a new log is added
   StimwalkerEvent<std::string> onNewLog;
 
@@ -38,18 +113,65 @@ protected:
   Logger();
   ~Logger();
 
+  /// @brief A log message waiting to be written by the background writer. A
+  /// record with a [flushed] promise is a marker pushed by [flush]: it is
+  /// resolved once every record before it is written
+  struct LogRecord {
+    std::chrono::system_clock::time_point time;
+    Level level = INFO;
+    std::string message;
+    std::promise<void> *flushed = nullptr;
+  };
+
   // Log a message if it meets the minimum log level
   void log(const std::string &message, Level level);
 
+  /// @brief Format and log a message if it meets the minimum log level
+  template <typename... Args>
+  void logFormatted(Level level, std::string_view format,
+                    const Args &...args) {
+    if (!isLevelEnabled(level)) {
+      return;
+    }
+    log(utils::format(format, args...), level);
+  }
+
+  /// @brief Prepare the actual line to print for a record
+  /// @param record The record to format
+  /// @return The line to print (without the end of line)
+  std::string formatRecord(const LogRecord &record);
+
+  /// @brief The loop of the background writer thread
+  void writerLoop();
+
+  /// @brief Write all the pending records. The caller must hold [m_Mutex]
+  /// since it is the single consumer of [m_Queue]
+  void drainQueue();
+
+  /// @brief Wake the background writer before its flush interval elapses
+  void wakeWriter();
+
+  /// @brief Stop the background writer after writing all the pending records
+  void stopWriter();
+
   // Function to convert log level to a string label
   std::string getLabel(Level level);
 
   // Function to get current time as a string
   std::string getCurrentTime();
 
+  /// @brief Get a time as a string ([YYYY-MM-DD HH:MM:SS.MMM])
+  /// @param time The time to format
+  /// @return The formatted time
+  std::string formatTime(const std::chrono::system_clock::time_point &time);
+
   // Logger state
   DECLARE_PROTECTED_MEMBER_WITH_SETTER(bool, ShouldPrintToConsole)
 
+  /// @brief If a FATAL message should block the caller until it is written
+  /// when the logger is asynchronous
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(bool, ShouldFlushFatalSynchronously)
+
   /// @brief The mutex to lock the logger
   DECLARE_PROTECTED_MEMBER_NOGET(std::mutex, Mutex)
 
@@ -57,9 +179,70 @@ protected:
   DECLARE_PROTECTED_MEMBER_NOGET(std::ofstream, File)
 
   /// @brief The minimum log level that will be displayed
-  DECLARE_PROTECTED_MEMBER(Level, LogLevel)
+  std::atomic<Level> m_LogLevel;
+
+  /// ASYNCHRONOUS WRITER
+
+  /// @brief If the records are sent to the background writer
+  std::atomic<bool> m_IsAsynchronous;
+
+  /// @brief The records waiting to be written
+  MpscQueue<LogRecord> m_Queue;
+
+  /// @brief The maximum time a record waits in the queue
+  DECLARE_PROTECTED_MEMBER(std::chrono::milliseconds, FlushInterval)
+
+  /// @brief The number of pending records that wakes the writer (read by
+  /// [log] without holding [m_WriterMutex])
+  std::atomic<size_t> m_FlushBatchSize;
+
+  /// @brief The minimum level that wakes the writer right away (read by [log]
+  /// without holding [m_WriterMutex])
+  std::atomic<Level> m_FlushLevel;
+
+  /// @brief The background writer thread
+  DECLARE_PROTECTED_MEMBER_NOGET(std::thread, Writer)
+
+  /// @brief The id of the background writer thread, set by the writer itself
+  /// so [flush] can compare it while [m_Writer] is reassigned
+  std::atomic<std::thread::id> m_WriterId;
+
+  /// @brief If the background writer should keep running
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsWriterRunning)
+
+  /// @brief If the background writer was explicitly woken up
+  DECLARE_PROTECTED_MEMBER_NOGET(bool, IsWakeRequested)
+
+  /// @brief The mutex protecting the writer wake-up conditions
+  DECLARE_PROTECTED_MEMBER_NOGET(std::mutex, WriterMutex)
+
+  /// @brief Used to wake the background writer
+  DECLARE_PROTECTED_MEMBER_NOGET(std::condition_variable, WriterCondition)
 };
 
 } // namespace STIMWALKER_NAMESPACE::utils
 
-#endif // __STIMWALKER_UTILS_LOGGER_H__
\ No newline at end of file
+/// @brief Log a message through the Logger singleton without evaluating any of
+/// the arguments if the level is disabled. Levels below
+/// [STIMWALKER_MIN_LOG_LEVEL] are compiled out entirely. The arguments are the
+/// same as the Logger methods (a message, or a "{}" pattern and its values)
+#define STIMWALKER_LOG(level, method, ...)                                     \
+  do {                                                                         \
+    if constexpr (STIMWALKER_NAMESPACE::utils::Logger::level >=                \
+                  STIMWALKER_MIN_LOG_LEVEL) {                                  \
+      auto &stimwalkerMacroLogger =                                            \
+          STIMWALKER_NAMESPACE::utils::Logger::getInstance();                  \
+      if (stimwalkerMacroLogger.isLevelEnabled(                                \
+              STIMWALKER_NAMESPACE::utils::Logger::level)) {                   \
+        stimwalkerMacroLogger.method(__VA_ARGS__);                             \
+      }                                                                        \
+    }                                                                          \
+  } while (false)
+
+#define STIMWALKER_LOG_DEBUG(...) STIMWALKER_LOG(DEBUG, debug, __VA_ARGS__)
+#define STIMWALKER_LOG_INFO(...) STIMWALKER_LOG(INFO, info, __VA_ARGS__)
+#define STIMWALKER_LOG_WARNING(...)                                            \
+  STIMWALKER_LOG(WARNING, warning, __VA_ARGS__)
+#define STIMWALKER_LOG_FATAL(...) STIMWALKER_LOG(FATAL, fatal, __VA_ARGS__)
+
+#endif // __STIMWALKER_UTILS_LOGGER_H__
@@ -0,0 +1,90 @@
+#ifndef __STIMWALKER_UTILS_MPSC_QUEUE_H__
+#define __STIMWALKER_UTILS_MPSC_QUEUE_H__
+
+#include "stimwalkerConfig.h"
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace STIMWALKER_NAMESPACE::utils {
+
+/// @brief Unbounded lock-free multiple producers, single consumer queue. Any
+/// thread can [push] without taking a lock (a single atomic exchange), while
+/// only one thread at a time is allowed to [pop]
+/// @note This is the intrusive node-based algorithm from D. Vyukov. [T] must be
+/// default constructible
+template <typename T> class MpscQueue {
+  struct Node {
+    Node() : m_Next(nullptr), m_Value() {}
+    Node(T &&value) : m_Next(nullptr), m_Value(std::move(value)) {}
+
+    std::atomic<Node *> m_Next;
+    T m_Value;
+  };
+
+public:
+  MpscQueue() : m_Head(new Node()), m_Size(0) {
+    m_Tail = m_Head.load(std::memory_order_relaxed);
+  }
+  MpscQueue(const MpscQueue &other) = delete;
+  MpscQueue &operator=(const MpscQueue &other) = delete;
+
+  ~MpscQueue() {
+    T value;
+    while (pop(value)) {
+    }
+    delete m_Tail;
+  }
+
+  /// @brief Add a new value to the queue. This can be called from any thread
+  /// @param value The value to add
+  void push(T value) {
+    Node *node = new Node(std::move(value));
+    // Count before publishing so the consumer never sees a negative size
+    m_Size.fetch_add(1, std::memory_order_relaxed);
+    Node *previous = m_Head.exchange(node, std::memory_order_acq_rel);
+    previous->m_Next.store(node, std::memory_order_release);
+  }
+
+  /// @brief Get the oldest value of the queue. This must only be called from
+  /// the consumer thread
+  /// @param value The value to fill
+  /// @return True if a value was popped, false if the queue was empty
+  bool pop(T &value) {
+    Node *tail = m_Tail;
+    Node *next = tail->m_Next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+
+    value = std::move(next->m_Value);
+    m_Tail = next;
+    delete tail;
+    m_Size.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /// @brief Get an approximation of the number of elements in the queue. This
+  /// is exact only when no other thread is pushing or popping
+  /// @return The number of elements in the queue
+  size_t size() const { return m_Size.load(std::memory_order_relaxed); }
+
+  /// @brief Get if the queue is (approximately) empty
+  /// @return True if the queue is empty
+  bool empty() const { return size() == 0; }
+
+private:
+  /// @brief The last pushed node (producers side)
+  std::atomic<Node *> m_Head;
+
+  /// @brief The last consumed node (consumer side)
+  Node *m_Tail;
+
+  /// @brief The approximate number of elements in the queue
+  std::atomic<size_t> m_Size;
+};
+
+} // namespace STIMWALKER_NAMESPACE::utils
+
+#endif // __STIMWALKER_UTILS_MPSC_QUEUE_H__
@@ -1,7 +1,9 @@
 #ifndef __STIMWALKER_UTILS_ROLLING_VECTOR_H__
 #define __STIMWALKER_UTILS_ROLLING_VECTOR_H__
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 
 #include "Utils/CppMacros.h"
@@ -78,6 +80,36 @@ public:
     clear();
   }
 
+  /// @brief Change the maximum size of the vector, keeping the most recent
+  /// values that fit in it (contrary to [setMaxSize] which clears the vector).
+  /// The values kept are then the only ones counted by [size]
+  /// @param size The new maximum size of the buffer
+  void resize(size_t size) {
+    if (size == 0) {
+      throw std::invalid_argument("The size of a RollingVector cannot be 0");
+    }
+
+    size_t count = m_MaxSize == size_t(-1)
+                       ? m_Data.size()
+                       : (m_IsFull ? m_MaxSize : m_CurrentIndex);
+    size_t kept = std::min(count, size);
+
+    std::vector<T> data;
+    data.reserve(size == size_t(-1) ? kept : size);
+    for (size_t i = count - kept; i < count; i++) {
+      data.push_back(std::move((*this)[i]));
+    }
+    if (size != size_t(-1)) {
+      data.resize(size);
+    }
+
+    m_Data = std::move(data);
+    m_MaxSize = size;
+    m_CurrentIndex = kept % size;
+    m_UnwrapIndex = kept;
+    m_IsFull = kept == size;
+  }
+
   /// @brief Add a new value to the vector, if the vector is full, the oldest
   /// value is replaced
   /// @param value The value to add
@@ -97,6 +129,44 @@ public:
     }
   }
 
+  /// @brief Append the last [count] values of [other]. The values are copied
+  /// by contiguous blocks (at most two, as [other] may have rolled) when this
+  /// vector has no limit, and one by one otherwise
+  /// @param other The vector to copy the values from
+  /// @param count The number of values to copy (capped to the values [other]
+  /// holds)
+  void appendTail(const RollingVector &other, size_t count) {
+    size_t otherCount = other.m_MaxSize == size_t(-1)
+                            ? other.m_Data.size()
+                            : (other.m_IsFull ? other.m_MaxSize
+                                              : other.m_CurrentIndex);
+    count = std::min(count, otherCount);
+    if (count == 0) {
+      return;
+    }
+
+    if (m_MaxSize != size_t(-1)) {
+      for (size_t i = otherCount - count; i < otherCount; i++) {
+        push_back(other[i]);
+      }
+      return;
+    }
+
+    // Where the first value to copy is stored in [other]
+    size_t first = other.m_IsFull
+                       ? (otherCount - count + other.m_CurrentIndex) %
+                             other.m_MaxSize
+                       : otherCount - count;
+    size_t firstBlock = std::min(count, other.m_Data.size() - first);
+    m_Data.insert(m_Data.end(), other.m_Data.begin() + first,
+                  other.m_Data.begin() + first + firstBlock);
+    m_Data.insert(m_Data.end(), other.m_Data.begin(),
+                  other.m_Data.begin() + (count - firstBlock));
+
+    m_CurrentIndex = (m_CurrentIndex + count) % m_MaxSize;
+    m_UnwrapIndex += count;
+  }
+
   // Iterators for range-based for loops.
   RollingVector::Iterator begin() const {
     return RollingVector::Iterator(this, 0);
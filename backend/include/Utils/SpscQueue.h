@@ -0,0 +1,94 @@
+#ifndef __STIMWALKER_UTILS_SPSC_QUEUE_H__
+#define __STIMWALKER_UTILS_SPSC_QUEUE_H__
+
+#include "stimwalkerConfig.h"
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace STIMWALKER_NAMESPACE::utils {
+
+/// @brief Bounded lock-free single producer, single consumer queue. The slots
+/// are allocated once, so pushing never allocates and fails instead of growing
+/// when the queue is full
+/// @note [T] must be default constructible and movable. A popped slot keeps its
+/// moved-from value, so types such as std::vector can be recycled
+template <typename T> class SpscQueue {
+public:
+  /// @brief Constructor
+  /// @param capacity The maximum number of elements in the queue
+  SpscQueue(size_t capacity)
+      : m_Slots(capacity + 1), m_Head(0), m_Tail(0) {}
+  SpscQueue(const SpscQueue &other) = delete;
+  SpscQueue &operator=(const SpscQueue &other) = delete;
+
+  /// @brief Add a value to the queue. This must only be called from the
+  /// producer thread
+  /// @param value The value to add
+  /// @return True if the value was added, false if the queue is full
+  bool tryPush(T &&value) {
+    size_t head = m_Head.load(std::memory_order_relaxed);
+    size_t next = increment(head);
+    if (next == m_Tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    m_Slots[head] = std::move(value);
+    m_Head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Get the oldest value of the queue. This must only be called from
+  /// the consumer thread
+  /// @param value The value to fill
+  /// @return True if a value was popped, false if the queue was empty
+  bool tryPop(T &value) {
+    size_t tail = m_Tail.load(std::memory_order_relaxed);
+    if (tail == m_Head.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    value = std::move(m_Slots[tail]);
+    m_Tail.store(increment(tail), std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Get the number of elements in the queue. This is exact from the
+  /// producer or consumer thread, and an approximation from any other thread
+  /// @return The number of elements in the queue
+  size_t size() const {
+    size_t head = m_Head.load(std::memory_order_acquire);
+    size_t tail = m_Tail.load(std::memory_order_acquire);
+    return head >= tail ? head - tail : head + m_Slots.size() - tail;
+  }
+
+  /// @brief Get if the queue is empty
+  /// @return True if the queue is empty
+  bool empty() const { return size() == 0; }
+
+  /// @brief Get the maximum number of elements in the queue
+  /// @return The maximum number of elements in the queue
+  size_t capacity() const { return m_Slots.size() - 1; }
+
+protected:
+  /// @brief Get the slot after [index]
+  size_t increment(size_t index) const {
+    return index + 1 == m_Slots.size() ? 0 : index + 1;
+  }
+
+  /// @brief The slots of the queue (one is always left empty to tell a full
+  /// queue from an empty one)
+  std::vector<T> m_Slots;
+
+  /// @brief The next slot to write (producer side)
+  std::atomic<size_t> m_Head;
+
+  /// @brief The next slot to read (consumer side)
+  std::atomic<size_t> m_Tail;
+};
+
+} // namespace STIMWALKER_NAMESPACE::utils
+
+#endif // __STIMWALKER_UTILS_SPSC_QUEUE_H__
@@ -1,56 +1,257 @@
 #ifndef __STIMWALKER_UTILS_STIMWALKER_EVENT_H__
 #define __STIMWALKER_UTILS_STIMWALKER_EVENT_H__
 
+#include "stimwalkerConfig.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <functional>
-#include <map>
+#include <memory>
 #include <mutex>
+#include <type_traits>
+#include <vector>
 
-#include "Utils/CppMacros.h"
+#include "Utils/EventExecutor.h"
 
 namespace STIMWALKER_NAMESPACE::utils {
 
+namespace details {
+/// @brief The listeners the current thread is dispatching. A callback cannot
+/// wait for the notification that is running it to finish
+inline thread_local std::vector<const void *> dispatchingListeners;
+
+/// @brief If the data of an event only points to memory of the notifier (it
+/// declares [IS_VIEW]), so it cannot be copied to be notified later
+template <typename T, typename = void> struct isView : std::false_type {};
+template <typename T>
+struct isView<T, std::void_t<decltype(T::IS_VIEW)>>
+    : std::bool_constant<T::IS_VIEW> {};
+} // namespace details
+
+/// @brief An event that calls its listeners when notified. The listeners are
+/// kept in an immutable list that is swapped atomically when a listener is
+/// added or removed, so [notifyListeners] never takes a lock and a callback can
+/// freely add or remove listeners (or read data protected by the notifier).
+/// The running notifications are counted, so removing a listener can wait for
+/// every notification that may still see it
 template <typename T> class StimwalkerEvent {
+  using Callback = std::function<void(const T &)>;
+  using CallbackList = std::vector<std::pair<size_t, Callback>>;
+
+  /// @brief The listeners and the count of the notifications using them. They
+  /// are shared with the notifications posted to an executor, which can
+  /// outlive the event
+  struct Listeners {
+    ~Listeners() {
+      delete callbacks.load();
+      for (auto list : retired) {
+        delete list;
+      }
+    }
+
+    /// @brief Register a running notification
+    void enter() { readers.fetch_add(1); }
+
+    /// @brief Unregister a running notification
+    void leave() {
+      readers.fetch_sub(1);
+      if (waiters.load() > 0) {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        readersDone.notify_all();
+      }
+    }
+
+    /// @brief Get how many notifications the current thread is running
+    size_t ownReaders() const {
+      return std::count(details::dispatchingListeners.begin(),
+                        details::dispatchingListeners.end(),
+                        static_cast<const void *>(this));
+    }
+
+    /// @brief Wait for the notifications of the other threads to finish. Once
+    /// this returns, every notification still running loaded the current list
+    void waitForReaders() {
+      size_t own = ownReaders();
+      waiters.fetch_add(1);
+      {
+        std::unique_lock<std::mutex> lock(waitMutex);
+        readersDone.wait(lock, [this, own]() { return readers <= own; });
+      }
+      waiters.fetch_sub(1);
+    }
+
+    /// @brief The current listeners (never modified, only replaced)
+    std::atomic<const CallbackList *> callbacks{new CallbackList()};
+
+    /// @brief The replaced lists that a notification may still use
+    std::vector<const CallbackList *> retired;
+
+    /// @brief The mutex serializing the modifications of the listeners
+    std::mutex mutex;
+
+    /// @brief The number of running notifications
+    std::atomic<size_t> readers{0};
+
+    /// @brief The number of removals waiting for the notifications to finish
+    std::atomic<size_t> waiters{0};
+
+    /// @brief The mutex protecting the wake-up condition of the waiters
+    std::mutex waitMutex;
+
+    /// @brief Used to wake the waiters when a notification finishes
+    std::condition_variable readersDone;
+  };
+
 public:
+  StimwalkerEvent()
+      : m_Listeners(std::make_shared<Listeners>()), m_HasExecutor(false),
+        m_NextId(0) {}
+  StimwalkerEvent(const StimwalkerEvent &) = delete;
+  StimwalkerEvent &operator=(const StimwalkerEvent &) = delete;
+
   ///
   /// @brief Listen to the callback. This method returns an id that can be used
   /// to refer to the callback later on (e.g. to remove it)
   /// @param callback The callback to call when the event is triggered
   /// @return The id of the callback
-  size_t listen(std::function<void(const T &)> callback) {
-    std::lock_guard<std::mutex> lock(m_Mutex);
+  size_t listen(Callback callback) {
+    std::lock_guard<std::mutex> lock(m_Listeners->mutex);
 
-    static size_t id = 0;
-    size_t newId = id;
-    m_Callbacks[newId] = callback;
-    id++;
+    auto callbacks = new CallbackList(*m_Listeners->callbacks.load());
+    size_t newId = m_NextId++;
+    callbacks->emplace_back(newId, std::move(callback));
+    m_Listeners->retired.push_back(m_Listeners->callbacks.exchange(callbacks));
     return newId;
   }
 
   ///
   /// @brief Remove the callback associated with the given id. This must be
-  /// called otherwise the callback will be kept in memory
+  /// called otherwise the callback will be kept in memory. Once this returns,
+  /// the callback is not running anymore and will not be called again (unless
+  /// it is called from a callback of this event on the same thread, which
+  /// cannot wait for itself)
   /// @param id The id of the callback to remove
   void clear(size_t id) {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    m_Callbacks.erase(id);
+    std::vector<const CallbackList *> retired;
+    {
+      std::lock_guard<std::mutex> lock(m_Listeners->mutex);
+
+      auto callbacks = new CallbackList(*m_Listeners->callbacks.load());
+      callbacks->erase(std::remove_if(callbacks->begin(), callbacks->end(),
+                                      [id](const auto &callback) {
+                                        return callback.first == id;
+                                      }),
+                       callbacks->end());
+      m_Listeners->retired.push_back(
+          m_Listeners->callbacks.exchange(callbacks));
+      retired.swap(m_Listeners->retired);
+    }
+
+    // The notifications of this thread (if called from a callback) may still
+    // use the replaced lists, they are freed by a later removal
+    m_Listeners->waitForReaders();
+    if (m_Listeners->ownReaders() > 0) {
+      std::lock_guard<std::mutex> lock(m_Listeners->mutex);
+      m_Listeners->retired.insert(m_Listeners->retired.end(), retired.begin(),
+                                  retired.end());
+      return;
+    }
+    for (auto list : retired) {
+      delete list;
+    }
   }
 
   ///
-  /// @brief Notify all the listeners that the event has been triggered
+  /// @brief Notify all the listeners that the event has been triggered. If an
+  /// executor is set, the data is copied and the listeners are called from the
+  /// executor thread, otherwise they are called right away from this thread
   /// @param data The data to pass to the listeners
   void notifyListeners(const T &data) {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    for (const auto &[_, callback] : m_Callbacks) {
-      callback(data);
+    if (m_HasExecutor.load(std::memory_order_acquire)) {
+      auto executor = std::atomic_load(&m_Executor);
+      if (executor != nullptr) {
+        if (getListenerCount() == 0) {
+          return;
+        }
+        executor->post([listeners = m_Listeners,
+                        data = std::decay_t<T>(data)]() {
+          dispatch(*listeners, data);
+        });
+        return;
+      }
     }
+    dispatch(*m_Listeners, data);
+  }
+
+  ///
+  /// @brief Set the executor that calls the listeners. The data of each
+  /// notification is then copied, so events holding non-owning data must stay
+  /// synchronous (this does not compile for them)
+  /// @param executor The executor to use, or nullptr to call the listeners
+  /// directly from the notifying thread
+  void setExecutor(std::shared_ptr<EventExecutor> executor) {
+    static_assert(!details::isView<T>::value,
+                  "The data of this event is only valid during the "
+                  "notification, it cannot be given an executor");
+    m_HasExecutor.store(executor != nullptr, std::memory_order_release);
+    std::atomic_store(&m_Executor, std::move(executor));
+  }
+
+  ///
+  /// @brief Get the executor that calls the listeners
+  /// @return The executor, or nullptr if the listeners are called directly
+  std::shared_ptr<EventExecutor> getExecutor() const {
+    return std::atomic_load(&m_Executor);
+  }
+
+  ///
+  /// @brief Get the number of listeners
+  /// @return The number of listeners
+  size_t getListenerCount() const {
+    m_Listeners->enter();
+    size_t count = m_Listeners->callbacks.load()->size();
+    m_Listeners->leave();
+    return count;
   }
 
 protected:
-  std::map<size_t, std::function<void(const T &)>> m_Callbacks;
+  /// @brief Call all the current callbacks of [listeners] with [data]
+  static void dispatch(Listeners &listeners, const T &data) {
+    struct DispatchGuard {
+      DispatchGuard(Listeners &listeners) : listeners(listeners) {
+        listeners.enter();
+        details::dispatchingListeners.push_back(&listeners);
+      }
+      ~DispatchGuard() {
+        details::dispatchingListeners.pop_back();
+        listeners.leave();
+      }
+      Listeners &listeners;
+    } guard(listeners);
+
+    for (const auto &[_, callback] : *listeners.callbacks.load()) {
+      callback(data);
+    }
+  }
+
+  /// @brief The listeners, shared with the notifications posted to the
+  /// executor
+  std::shared_ptr<Listeners> m_Listeners;
+
+  /// @brief The executor that calls the listeners (nullptr to call them from
+  /// the notifying thread)
+  std::shared_ptr<EventExecutor> m_Executor;
+
+  /// @brief If [m_Executor] is set, so the synchronous notifications do not
+  /// have to load it
+  std::atomic<bool> m_HasExecutor;
 
-  DECLARE_PROTECTED_MEMBER_NOGET(std::mutex, Mutex)
+  /// @brief The id of the next listener (protected by the mutex of
+  /// [m_Listeners])
+  size_t m_NextId;
 };
 
 } // namespace STIMWALKER_NAMESPACE::utils
 
-#endif // __STIMWALKER_UTILS_STIMWALKER_EVENT_H__
\ No newline at end of file
+#endif // __STIMWALKER_UTILS_STIMWALKER_EVENT_H__
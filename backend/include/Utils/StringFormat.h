@@ -0,0 +1,122 @@
+#ifndef __STIMWALKER_UTILS_STRING_FORMAT_H__
+#define __STIMWALKER_UTILS_STRING_FORMAT_H__
+
+#include "stimwalkerConfig.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace STIMWALKER_NAMESPACE::utils {
+
+namespace details {
+
+inline void appendArgument(std::string &out, std::string_view value) {
+  out.append(value);
+}
+inline void appendArgument(std::string &out, const std::string &value) {
+  out.append(value);
+}
+inline void appendArgument(std::string &out, const char *value) {
+  out.append(value == nullptr ? "(null)" : value);
+}
+inline void appendArgument(std::string &out, char value) {
+  out.push_back(value);
+}
+inline void appendArgument(std::string &out, bool value) {
+  out.append(value ? "true" : "false");
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral_v<T>> appendArgument(std::string &out,
+                                                        T value) {
+  char buffer[24];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out.append(buffer, result.ptr);
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point_v<T>> appendArgument(std::string &out,
+                                                              T value) {
+  char buffer[32];
+  int written = std::snprintf(buffer, sizeof(buffer), "%g",
+                              static_cast<double>(value));
+  if (written > 0) {
+    out.append(buffer, static_cast<size_t>(written));
+  }
+}
+
+template <typename Rep, typename Period>
+void appendArgument(std::string &out,
+                    const std::chrono::duration<Rep, Period> &value) {
+  appendArgument(out, value.count());
+}
+
+/// @brief Append [pattern] to [out], unescaping the "{{" and "}}" sequences
+inline void appendPattern(std::string &out, std::string_view pattern) {
+  for (size_t i = 0; i < pattern.size(); i++) {
+    out.push_back(pattern[i]);
+    if ((pattern[i] == '{' || pattern[i] == '}') && i + 1 < pattern.size() &&
+        pattern[i + 1] == pattern[i]) {
+      i++;
+    }
+  }
+}
+
+} // namespace details
+
+/// @brief Append [pattern] to [out] without any argument to substitute
+/// @param out The string to append to
+/// @param pattern The pattern to append
+inline void formatTo(std::string &out, std::string_view pattern) {
+  details::appendPattern(out, pattern);
+}
+
+/// @brief Append [pattern] to [out], replacing each "{}" by the next argument.
+/// The arguments are written straight into [out] so no intermediate string is
+/// created for numbers. Use "{{" and "}}" for literal braces. Extra arguments
+/// are ignored and missing ones leave the "{}" in place
+/// @param out The string to append to
+/// @param pattern The pattern to format
+/// @param value The argument for the first "{}"
+/// @param args The arguments for the following "{}"
+template <typename T, typename... Args>
+void formatTo(std::string &out, std::string_view pattern, const T &value,
+              const Args &...args) {
+  for (size_t i = 0; i < pattern.size(); i++) {
+    char current = pattern[i];
+    bool hasNext = i + 1 < pattern.size();
+    if (hasNext && (current == '{' || current == '}') &&
+        pattern[i + 1] == current) {
+      // Escaped brace
+      out.push_back(current);
+      i++;
+    } else if (hasNext && current == '{' && pattern[i + 1] == '}') {
+      details::appendArgument(out, value);
+      formatTo(out, pattern.substr(i + 2), args...);
+      return;
+    } else {
+      out.push_back(current);
+    }
+  }
+}
+
+/// @brief Format [pattern], replacing each "{}" by the next argument (see
+/// [formatTo])
+/// @param pattern The pattern to format
+/// @param args The arguments to substitute
+/// @return The formatted string
+template <typename... Args>
+std::string format(std::string_view pattern, const Args &...args) {
+  std::string out;
+  out.reserve(pattern.size() + 16 * sizeof...(Args));
+  formatTo(out, pattern, args...);
+  return out;
+}
+
+} // namespace STIMWALKER_NAMESPACE::utils
+
+#endif // __STIMWALKER_UTILS_STRING_FORMAT_H__
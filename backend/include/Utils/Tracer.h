@@ -0,0 +1,157 @@
+#ifndef __STIMWALKER_UTILS_TRACER_H__
+#define __STIMWALKER_UTILS_TRACER_H__
+
+#include "stimwalkerConfig.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Utils/CppMacros.h"
+
+namespace STIMWALKER_NAMESPACE::utils {
+
+/// @brief Opt-in recorder of timed spans, saved in the Chrome trace event
+/// format (which can be opened in Perfetto or chrome://tracing). Each thread
+/// records in its own preallocated buffer so recording never takes a lock, and
+/// when the tracer is disabled a span only costs an atomic load.
+/// @note The tracer is started at launch if the STIMWALKER_TRACE_FILE
+/// environment variable is set; the trace is then saved to that file when the
+/// tracer is stopped (or when the program exits)
+class Tracer {
+public:
+  /// @brief A completed span
+  struct TraceEvent {
+    const char *name;
+    const char *category;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::duration duration;
+  };
+
+  /// @brief Get the singleton instance of the Tracer
+  static Tracer &getInstance();
+
+  /// @brief Start recording. The events of the previous recording are
+  /// discarded
+  void start();
+
+  /// @brief Stop recording. The recorded events are kept until the next
+  /// [start]. If an output path is set, the trace is saved to it
+  void stop();
+
+  /// @brief Get if the spans are currently recorded
+  /// @return True if the spans are recorded
+  bool isEnabled() const { return m_IsEnabled.load(std::memory_order_relaxed); }
+
+  /// @brief Record a completed span in the buffer of the calling thread. If
+  /// this buffer is full, the event is dropped
+  /// @param name The name of the span (must outlive the tracer, usually a
+  /// literal)
+  /// @param category The category of the span (same lifetime as [name])
+  /// @param start When the span started
+  /// @param end When the span ended
+  void record(const char *name, const char *category,
+              const std::chrono::steady_clock::time_point &start,
+              const std::chrono::steady_clock::time_point &end);
+
+  /// @brief Get all the events of the current recording. This can be called
+  /// while recording, the events recorded meanwhile may be missing
+  /// @return The events, grouped by thread
+  std::vector<std::pair<size_t, std::vector<TraceEvent>>> getEvents() const;
+
+  /// @brief Get the number of events of the current recording
+  /// @return The number of events
+  size_t getEventCount() const;
+
+  /// @brief Get the number of events dropped because a thread buffer was full
+  /// @return The number of dropped events
+  size_t getDroppedEventCount() const;
+
+  /// @brief Get the current recording in the Chrome trace event format
+  /// @return The JSON string of the trace
+  std::string serialize() const;
+
+  /// @brief Save the current recording in the Chrome trace event format
+  /// @param path The path of the file to write
+  /// @return True if the file was written, false otherwise
+  bool save(const std::string &path) const;
+
+protected:
+  /// @brief The events of a single thread. Only the owner thread writes in
+  /// it, the count is published so other threads can read the written events
+  struct ThreadBuffer {
+    size_t threadId = 0;
+    std::vector<TraceEvent> events;
+    std::atomic<size_t> count = 0;
+    std::atomic<size_t> dropped = 0;
+    std::atomic<size_t> generation = 0;
+  };
+
+  // Private constructor and destructor to prevent direct instantiation
+  Tracer();
+  ~Tracer();
+
+  /// @brief Get the buffer of the calling thread, registering it if needed
+  /// @return The buffer of the calling thread
+  ThreadBuffer &getThreadBuffer();
+
+  /// @brief Get if [buffer] holds events of the current recording
+  bool isCurrent(const ThreadBuffer &buffer) const;
+
+  /// @brief The path where [stop] saves the trace (empty to not save)
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(std::string, OutputPath)
+
+  /// @brief The maximum number of events recorded by each thread
+  DECLARE_PROTECTED_MEMBER_WITH_SETTER(size_t, EventsPerThread)
+
+  /// @brief If the spans are currently recorded
+  std::atomic<bool> m_IsEnabled;
+
+  /// @brief The id of the current recording, so stale buffers are reset
+  std::atomic<size_t> m_Generation;
+
+  /// @brief The time of the start of the recording (the zero of the trace)
+  std::atomic<std::chrono::steady_clock::rep> m_Origin;
+
+  /// @brief The buffers of all the threads that recorded something
+  DECLARE_PROTECTED_MEMBER_NOGET(std::vector<std::shared_ptr<ThreadBuffer>>,
+                                 Buffers)
+
+  /// @brief The mutex protecting the registration of the buffers
+  DECLARE_PROTECTED_MEMBER_NOGET(std::mutex, BuffersMutex)
+};
+
+/// @brief Record the lifetime of the object as a span, if the tracer is enabled
+/// when it is constructed
+class ScopedTrace {
+public:
+  /// @brief Constructor
+  /// @param name The name of the span (must be a literal or outlive the tracer)
+  /// @param category The category of the span
+  ScopedTrace(const char *name, const char *category = "stimwalker");
+  ~ScopedTrace();
+  ScopedTrace(const ScopedTrace &) = delete;
+  ScopedTrace &operator=(const ScopedTrace &) = delete;
+
+protected:
+  const char *m_Name;
+  const char *m_Category;
+  bool m_IsRecording;
+  std::chrono::steady_clock::time_point m_Start;
+};
+
+} // namespace STIMWALKER_NAMESPACE::utils
+
+#define STIMWALKER_TRACE_CONCAT_INNER(a, b) a##b
+#define STIMWALKER_TRACE_CONCAT(a, b) STIMWALKER_TRACE_CONCAT_INNER(a, b)
+
+/// @brief Record the rest of the current scope as a span of [name] in
+/// [category]
+#define STIMWALKER_TRACE_SCOPE(name, category)                                 \
+  STIMWALKER_NAMESPACE::utils::ScopedTrace STIMWALKER_TRACE_CONCAT(            \
+      stimwalkerTraceScope, __LINE__)(name, category)
+
+#endif // __STIMWALKER_UTILS_TRACER_H__
@@ -1,8 +1,14 @@
 #ifndef __STIMWALKER_UTILS_ALL_H__
 #define __STIMWALKER_UTILS_ALL_H__
 
+#include "Utils/ByteRingBuffer.h"
 #include "Utils/CppMacros.h"
+#include "Utils/EventExecutor.h"
 #include "Utils/Logger.h"
+#include "Utils/MpscQueue.h"
+#include "Utils/SpscQueue.h"
 #include "Utils/StimwalkerEvent.h"
+#include "Utils/StringFormat.h"
+#include "Utils/Tracer.h"
 
 #endif // __STIMWALKER_UTILS_ALL_H__
@@ -0,0 +1,333 @@
+#include "stimwalker.h"
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+using namespace STIMWALKER_NAMESPACE;
+using namespace STIMWALKER_NAMESPACE::devices::DelsysBaseDeviceMock;
+
+// Measure the closed-loop latency, from a block of samples arriving on the
+// data socket of a (mock) Delsys EMG to the stimulation command it triggers
+// leaving the process. The blocks go through the DataCollector as in the
+// server (live data, trial, onNewDataBlock), then a threshold detector looks
+// for crossings on the EMG channels and commands a mock stimulator. The path
+// is time stamped at each stage:
+//   arrival: the block is on the socket (the time the mock makes it due)
+//   notified: the detector receives the block from onNewDataBlock
+//   detected: the detector found a crossing in the block
+//   sent: the stimulator returned from the command
+// and the latencies are reported under different background loads.
+// Usage: bench_closed_loop [seconds per scenario]
+
+// The Delsys EMG (as set in DelsysEmgDevice.cpp)
+const size_t EMG_CHANNEL_COUNT(16);
+const std::chrono::microseconds EMG_SAMPLE_PERIOD(500);
+const size_t EMG_SAMPLE_COUNT(27);
+
+// The detector, on every EMG channel (the mock sends a sine wave of amplitude
+// 1 at 1 Hz, so each channel starts and stops once per second)
+const double DETECTION_THRESHOLD(0.5);
+const double DETECTION_HYSTERESIS(0.1);
+const double STIMULATION_AMPLITUDE(20.0);
+
+// The background loads. The live data are pulled at the rate of the server
+const std::chrono::milliseconds LIVE_DATA_INTERVAL(100);
+const std::chrono::microseconds LOG_INTERVAL(500);
+
+const std::chrono::seconds DEFAULT_SCENARIO_DURATION(5);
+
+// The mock makes the blocks due from the connection, so the first blocks are
+// read late (streaming starts after). They are not measured
+const std::chrono::milliseconds WARM_UP_DURATION(500);
+
+// The data socket of the mock, which remembers when the last block read was
+// due. The mock sleeps until a block is due, so a block read late was
+// already waiting on the socket from that time
+class InstrumentedDataSocket : public DataTcpDeviceMock {
+public:
+  InstrumentedDataSocket()
+      : DataTcpDeviceMock(EMG_CHANNEL_COUNT, EMG_SAMPLE_PERIOD,
+                          EMG_SAMPLE_COUNT, "localhost", 50043),
+        m_BlockCounter(0) {}
+
+  bool read(std::vector<char> &buffer) override {
+    auto arrival = m_SteadyStartTime +
+                   EMG_SAMPLE_PERIOD * EMG_SAMPLE_COUNT * m_BlockCounter;
+    m_BlockCounter++;
+    bool isRead = DataTcpDeviceMock::read(buffer);
+    m_LastArrival = arrival;
+    return isRead;
+  }
+
+  std::chrono::steady_clock::time_point getLastArrival() const {
+    return m_LastArrival;
+  }
+
+protected:
+  bool handleConnect() override {
+    m_BlockCounter = 0;
+    m_SteadyStartTime = std::chrono::steady_clock::now();
+    return DataTcpDeviceMock::handleConnect();
+  }
+
+  std::chrono::steady_clock::time_point m_SteadyStartTime;
+  size_t m_BlockCounter;
+  std::atomic<std::chrono::steady_clock::time_point> m_LastArrival;
+};
+
+class InstrumentedDelsysEmg : public devices::DelsysEmgDevice {
+public:
+  InstrumentedDelsysEmg() : InstrumentedDelsysEmg(new InstrumentedDataSocket) {}
+
+  std::chrono::steady_clock::time_point getLastArrival() const {
+    return m_Socket->getLastArrival();
+  }
+
+protected:
+  InstrumentedDelsysEmg(InstrumentedDataSocket *socket)
+      : DelsysEmgDevice(std::unique_ptr<DataTcpDevice>(socket),
+                        std::make_shared<CommandTcpDeviceMock>("localhost",
+                                                               50040)),
+        m_Socket(socket) {}
+
+  InstrumentedDataSocket *m_Socket;
+};
+
+// Stand in for a stimulator. The command leaves the process when it returns
+// (a real device would write the frame on its serial port)
+class MockStimulator : public devices::Stimulator {
+public:
+  MockStimulator() { m_Frame.reserve(EMG_CHANNEL_COUNT * 3); }
+
+  void stimulate() override {}
+
+  void setChannelAmplitudes(const std::vector<size_t> &channels,
+                            const std::vector<double> &amplitudes) override {
+    m_Frame.clear();
+    for (size_t i = 0; i < channels.size(); i++) {
+      m_Frame.push_back(static_cast<char>(channels[i]));
+      m_Frame.push_back(static_cast<char>(amplitudes[i]));
+    }
+    m_Frame.push_back(static_cast<char>(m_Frame.size()));
+    m_CommandCount++;
+  }
+
+  size_t getCommandCount() const { return m_CommandCount; }
+
+protected:
+  void HandleStimulation(const devices::DataPoint &) override {}
+
+  std::vector<char> m_Frame;
+  size_t m_CommandCount = 0;
+};
+
+struct Latencies {
+  data::TimingHistogram arrivalToNotified =
+      data::TimingHistogram(std::chrono::microseconds(2), 50000);
+  data::TimingHistogram commandArrivalToNotified =
+      data::TimingHistogram(std::chrono::microseconds(2), 50000);
+  data::TimingHistogram notifiedToDetected =
+      data::TimingHistogram(std::chrono::microseconds(1), 20000);
+  data::TimingHistogram detectedToSent =
+      data::TimingHistogram(std::chrono::microseconds(1), 20000);
+  data::TimingHistogram arrivalToSent =
+      data::TimingHistogram(std::chrono::microseconds(2), 50000);
+};
+
+// Start stimulating a channel when its EMG goes over the threshold, stop when
+// it goes back under it (with some hysteresis)
+class ThresholdDetector {
+public:
+  ThresholdDetector(const InstrumentedDelsysEmg &emg,
+                    devices::Stimulator &stimulator, Latencies &latencies)
+      : m_Emg(emg), m_Stimulator(stimulator), m_Latencies(latencies),
+        m_IsAbove(EMG_CHANNEL_COUNT, false), m_Channel(1), m_Amplitude(1),
+        m_MeasureFrom(std::chrono::steady_clock::time_point::max()) {}
+
+  void measureFrom(const std::chrono::steady_clock::time_point &time) {
+    m_MeasureFrom = time;
+  }
+
+  void processBlock(const data::DataBlock &block) {
+    auto notified = std::chrono::steady_clock::now();
+    auto arrival = m_Emg.getLastArrival();
+    bool isMeasured = arrival >= m_MeasureFrom.load();
+    if (isMeasured) {
+      m_Latencies.arrivalToNotified.add(notified - arrival);
+    }
+
+    for (size_t i = 0; i < block.size(); i++) {
+      for (size_t channel = 0; channel < EMG_CHANNEL_COUNT; channel++) {
+        double value = block.value(i, channel);
+        bool isAbove = m_IsAbove[channel]
+                           ? value > DETECTION_THRESHOLD - DETECTION_HYSTERESIS
+                           : value > DETECTION_THRESHOLD;
+        if (isAbove == m_IsAbove[channel]) {
+          continue;
+        }
+        m_IsAbove[channel] = isAbove;
+
+        auto detected = std::chrono::steady_clock::now();
+        m_Channel[0] = channel;
+        m_Amplitude[0] = isAbove ? STIMULATION_AMPLITUDE : 0.0;
+        m_Stimulator.setChannelAmplitudes(m_Channel, m_Amplitude);
+        auto sent = std::chrono::steady_clock::now();
+        if (!isMeasured) {
+          continue;
+        }
+
+        m_Latencies.commandArrivalToNotified.add(notified - arrival);
+        m_Latencies.notifiedToDetected.add(detected - notified);
+        m_Latencies.detectedToSent.add(sent - detected);
+        m_Latencies.arrivalToSent.add(sent - arrival);
+      }
+    }
+  }
+
+protected:
+  const InstrumentedDelsysEmg &m_Emg;
+  devices::Stimulator &m_Stimulator;
+  Latencies &m_Latencies;
+  std::vector<bool> m_IsAbove;
+  std::vector<size_t> m_Channel;
+  std::vector<double> m_Amplitude;
+  std::atomic<std::chrono::steady_clock::time_point> m_MeasureFrom;
+};
+
+struct Scenario {
+  std::string name;
+  size_t liveClientCount;
+  bool isRecording;
+  bool isLogging;
+};
+
+void report(utils::Logger &logger, const Scenario &scenario,
+            const Latencies &latencies, size_t commandCount,
+            size_t liveDataBytes, std::chrono::seconds duration) {
+  auto toUs = [](const std::chrono::nanoseconds &value) {
+    return static_cast<double>(value.count()) / 1e3;
+  };
+  auto percentiles = [&toUs](const data::TimingHistogram &histogram) {
+    return utils::format(
+        "p50 {} us, p95 {} us, p99 {} us, max {} us",
+        toUs(histogram.quantile(0.5)), toUs(histogram.quantile(0.95)),
+        toUs(histogram.quantile(0.99)), toUs(histogram.getMax()));
+  };
+
+  logger.info("{}: {} blocks, {} commands, {} kB/s of live data",
+              scenario.name, latencies.arrivalToNotified.size(), commandCount,
+              static_cast<double>(liveDataBytes) / 1e3 /
+                  static_cast<double>(duration.count()));
+  logger.info("  arrival -> sent: {}", percentiles(latencies.arrivalToSent));
+  logger.info("    arrival -> notified: {}",
+              percentiles(latencies.commandArrivalToNotified));
+  logger.info("    notified -> detected: {}",
+              percentiles(latencies.notifiedToDetected));
+  logger.info("    detected -> sent: {}",
+              percentiles(latencies.detectedToSent));
+  logger.info("  arrival -> notified (every block): {}",
+              percentiles(latencies.arrivalToNotified));
+}
+
+void runScenario(utils::Logger &logger, const Scenario &scenario,
+                 std::chrono::seconds duration) {
+  devices::Devices devices;
+  auto emg = std::make_unique<InstrumentedDelsysEmg>();
+  const auto &emgRef = *emg;
+  auto emgId = devices.add(std::move(emg));
+
+  Latencies latencies;
+  MockStimulator stimulator;
+  ThresholdDetector detector(emgRef, stimulator, latencies);
+  devices.getDataCollector(emgId).onNewDataBlock.listen(
+      [&detector](const data::DataBlock &block) {
+        detector.processBlock(block);
+      });
+
+  if (!devices.connect() || !devices.startDataStreaming()) {
+    logger.fatal("{}: could not start the mock EMG", scenario.name);
+    return;
+  }
+  detector.measureFrom(std::chrono::steady_clock::now() + WARM_UP_DURATION);
+  if (scenario.isRecording) {
+    devices.startRecording();
+  }
+
+  // The background loads
+  std::atomic<bool> isRunning(true);
+  std::atomic<size_t> liveDataBytes(0);
+  std::vector<std::thread> loads;
+  for (size_t i = 0; i < scenario.liveClientCount; i++) {
+    loads.emplace_back([&]() {
+      auto next = std::chrono::steady_clock::now();
+      while (isRunning) {
+        next += LIVE_DATA_INTERVAL;
+        liveDataBytes += devices.getLiveDataSerialized().dump().size();
+        std::this_thread::sleep_until(next);
+      }
+    });
+  }
+  if (scenario.isLogging) {
+    // The records are printed when written, so the queue is emptied first
+    logger.flush();
+    logger.setShouldPrintToConsole(false);
+    loads.emplace_back([&]() {
+      auto next = std::chrono::steady_clock::now();
+      size_t messageCount = 0;
+      while (isRunning) {
+        next += LOG_INTERVAL;
+        STIMWALKER_LOG_INFO("Background message {} of the closed-loop bench",
+                            messageCount++);
+        std::this_thread::sleep_until(next);
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(WARM_UP_DURATION + duration);
+  isRunning = false;
+  for (auto &load : loads) {
+    load.join();
+  }
+  if (scenario.isLogging) {
+    logger.flush();
+    logger.setShouldPrintToConsole(true);
+  }
+
+  if (scenario.isRecording) {
+    devices.stopRecording();
+  }
+  devices.stopDataStreaming();
+  devices.disconnect();
+
+  report(logger, scenario, latencies, stimulator.getCommandCount(),
+         liveDataBytes, duration);
+}
+
+int main(int argc, char **argv) {
+  auto &logger = utils::Logger::getInstance();
+  logger.setLogFile(
+      (std::filesystem::temp_directory_path() / "bench_closed_loop.log")
+          .string());
+  logger.setLogLevel(utils::Logger::INFO);
+  logger.setIsAsynchronous(true);
+
+  auto duration = argc > 1 ? std::chrono::seconds(std::stoi(argv[1]))
+                           : DEFAULT_SCENARIO_DURATION;
+
+  std::vector<Scenario> scenarios = {
+      {"Idle", 0, false, false},
+      {"1 live client", 1, false, false},
+      {"4 live clients", 4, false, false},
+      {"16 live clients", 16, false, false},
+      {"Recording a trial", 0, true, false},
+      {"Logging", 0, false, true},
+      {"4 live clients, recording and logging", 4, true, true},
+  };
+  for (const auto &scenario : scenarios) {
+    runScenario(logger, scenario, duration);
+  }
+
+  logger.flush();
+  return EXIT_SUCCESS;
+}
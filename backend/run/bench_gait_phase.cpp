@@ -0,0 +1,239 @@
+#include "stimwalker.h"
+
+#include <cmath>
+#include <functional>
+
+using namespace STIMWALKER_NAMESPACE;
+
+// Compare the online gait phase estimator to the block based estimation of
+// the Python scheduler (DataAnalyser.percentage_of_stride), on synthetic hip
+// angles of known phase. Both are given the same 1 kHz stream, in blocks of
+// 10 samples, and evaluated when each block arrives.
+
+const size_t SAMPLE_COUNT_PER_BLOCK(10);
+const std::chrono::microseconds SAMPLE_PERIOD(1000);
+const double DURATION_IN_SECONDS(120.0);
+
+// A port of DataAnalyser.percentage_of_stride, from the means of the hip
+// angle over the last two blocks. It expects a sine-like hip angle in [-1; 1]
+double pythonPercentageOfStride(double previousHip, double currentHip) {
+  if (currentHip >= 0 && currentHip > previousHip) {
+    return 0 + 0.25 * currentHip;
+  } else if (currentHip >= 0 && currentHip < previousHip) {
+    return 0.25 + 0.25 * (1 - currentHip);
+  } else if (currentHip < 0 && currentHip < previousHip) {
+    return 0.5 + 0.25 * std::abs(previousHip);
+  } else if (currentHip < 0 && currentHip > previousHip) {
+    return 0.75 + 0.25 * (1 - std::abs(previousHip));
+  }
+  return -1;
+}
+
+// The distance between two percentages of the stride, which wrap at 1
+double phaseDistance(double first, double second) {
+  double distance = std::abs(first - second);
+  return std::min(distance, 1.0 - distance);
+}
+
+struct Results {
+  data::TimingHistogram phaseErrors =
+      data::TimingHistogram(std::chrono::microseconds(1000), 2000);
+  data::TimingHistogram heelStrikeLatencies =
+      data::TimingHistogram(std::chrono::microseconds(1000), 4000);
+  size_t missedHeelStrikes = 0;
+  size_t invalidEstimates = 0;
+  double nanosecondsPerSample = 0;
+};
+
+// The phase errors are stored as a time (the error times the true stride
+// duration), so they share the histogram with the latencies
+void report(utils::Logger &logger, const std::string &name,
+            const Results &results) {
+  auto toMs = [](const std::chrono::nanoseconds &value) {
+    return static_cast<double>(value.count()) / 1e6;
+  };
+  logger.info(
+      "  {}: phase error median {} ms, p95 {} ms | heel strike latency median "
+      "{} ms, p95 {} ms, missed {} | {} estimates out of [0; 1] | {} "
+      "ns/sample",
+      name, toMs(results.phaseErrors.quantile(0.5)),
+      toMs(results.phaseErrors.quantile(0.95)),
+      toMs(results.heelStrikeLatencies.quantile(0.5)),
+      toMs(results.heelStrikeLatencies.quantile(0.95)),
+      results.missedHeelStrikes, results.invalidEstimates,
+      results.nanosecondsPerSample);
+}
+
+// Run both estimations on [sampleCount] samples of [generator], which returns
+// the hip angle and the true percentage of the stride of a time (s)
+void runScenario(
+    utils::Logger &logger, const std::string &name, double strideDuration,
+    data::GaitPhaseEstimator &estimator,
+    const std::function<std::pair<double, double>(double)> &generator) {
+  size_t sampleCount = static_cast<size_t>(DURATION_IN_SECONDS * 1000.0);
+  sampleCount -= sampleCount % SAMPLE_COUNT_PER_BLOCK;
+
+  std::vector<std::chrono::microseconds> timeStamps(sampleCount);
+  std::vector<double> hips(sampleCount);
+  std::vector<double> truths(sampleCount);
+  for (size_t i = 0; i < sampleCount; i++) {
+    timeStamps[i] = SAMPLE_PERIOD * i;
+    auto [hip, truth] = generator(static_cast<double>(i) * 1e-3);
+    hips[i] = hip;
+    truths[i] = truth;
+  }
+  auto strideNs = static_cast<double>(strideDuration * 1e9);
+  auto toError = [strideNs](double distance) {
+    return std::chrono::nanoseconds(static_cast<int64_t>(distance * strideNs));
+  };
+
+  // The true heel strikes (the true percentage wraps)
+  std::vector<size_t> heelStrikes;
+  for (size_t i = 1; i < sampleCount; i++) {
+    if (truths[i] < truths[i - 1]) {
+      heelStrikes.push_back(i);
+    }
+  }
+
+  // Match each true heel strike to the first detection in the next half
+  // stride
+  auto matchHeelStrikes = [&](const std::vector<size_t> &detections,
+                              Results &results) {
+    size_t next = 0;
+    for (auto truth : heelStrikes) {
+      while (next < detections.size() &&
+             detections[next] + strideDuration * 500 < truth) {
+        next++;
+      }
+      if (next < detections.size() &&
+          detections[next] < truth + strideDuration * 500) {
+        results.heelStrikeLatencies.add(
+            std::chrono::milliseconds(detections[next]) -
+            std::chrono::milliseconds(truth));
+        next++;
+      } else {
+        results.missedHeelStrikes++;
+      }
+    }
+  };
+
+  // The online estimator, sample by sample
+  Results online;
+  std::vector<size_t> onlineHeelStrikes;
+  std::vector<double> onlinePercentages(sampleCount);
+  estimator.reset();
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < sampleCount; i += SAMPLE_COUNT_PER_BLOCK) {
+    estimator.addBlock(data::DataBlock(&timeStamps[i], &hips[i],
+                                       SAMPLE_COUNT_PER_BLOCK, 1));
+    onlinePercentages[i + SAMPLE_COUNT_PER_BLOCK - 1] =
+        estimator.getPercentage();
+  }
+  online.nanosecondsPerSample =
+      static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count()) /
+      static_cast<double>(sampleCount);
+
+  estimator.reset();
+  auto listenerId = estimator.onNewGaitPhase.listen(
+      [&](const data::GaitPhase &phase) {
+        if (phase.event == data::GaitEvent::HEEL_STRIKE) {
+          onlineHeelStrikes.push_back(
+              static_cast<size_t>(phase.timeStamp / SAMPLE_PERIOD));
+        }
+      });
+  for (size_t i = 0; i < sampleCount; i += SAMPLE_COUNT_PER_BLOCK) {
+    estimator.addBlock(data::DataBlock(&timeStamps[i], &hips[i],
+                                       SAMPLE_COUNT_PER_BLOCK, 1));
+  }
+  estimator.onNewGaitPhase.clear(listenerId);
+
+  // The Python estimation, once per block
+  Results python;
+  std::vector<size_t> pythonHeelStrikes;
+  std::vector<double> pythonPercentages(sampleCount, -1.0);
+  start = std::chrono::steady_clock::now();
+  double previousMean = 0;
+  double previousPercentage = -1;
+  for (size_t i = 0; i < sampleCount; i += SAMPLE_COUNT_PER_BLOCK) {
+    double mean = 0;
+    for (size_t j = 0; j < SAMPLE_COUNT_PER_BLOCK; j++) {
+      mean += hips[i + j];
+    }
+    mean /= static_cast<double>(SAMPLE_COUNT_PER_BLOCK);
+    if (i > 0) {
+      double percentage = pythonPercentageOfStride(previousMean, mean);
+      pythonPercentages[i + SAMPLE_COUNT_PER_BLOCK - 1] = percentage;
+      if (previousPercentage > 0.75 && percentage >= 0 && percentage < 0.25) {
+        pythonHeelStrikes.push_back(i + SAMPLE_COUNT_PER_BLOCK - 1);
+      }
+      previousPercentage = percentage;
+    }
+    previousMean = mean;
+  }
+  python.nanosecondsPerSample =
+      static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count()) /
+      static_cast<double>(sampleCount);
+
+  // The errors are measured when each block arrives, once the estimations
+  // settled (after 5 strides)
+  size_t settled = static_cast<size_t>(5 * strideDuration * 1000);
+  for (size_t i = SAMPLE_COUNT_PER_BLOCK - 1; i < sampleCount;
+       i += SAMPLE_COUNT_PER_BLOCK) {
+    if (i < settled) {
+      continue;
+    }
+    for (auto [percentages, results] :
+         {std::make_pair(&onlinePercentages, &online),
+          std::make_pair(&pythonPercentages, &python)}) {
+      double percentage = (*percentages)[i];
+      if (percentage < 0 || percentage > 1) {
+        results->invalidEstimates++;
+        continue;
+      }
+      results->phaseErrors.add(toError(phaseDistance(percentage, truths[i])));
+    }
+  }
+  matchHeelStrikes(onlineHeelStrikes, online);
+  matchHeelStrikes(pythonHeelStrikes, python);
+
+  logger.info("{} ({} strides of {} s)", name, heelStrikes.size(),
+              strideDuration);
+  report(logger, "Online estimator", online);
+  report(logger, "Python blocks (ported)", python);
+}
+
+int main() {
+  auto &logger = utils::Logger::getInstance();
+  logger.setLogLevel(utils::Logger::INFO);
+
+  // The fake data of the Python NI-DAQ mock: a sine of 1 s
+  {
+    data::GaitPhaseEstimator estimator(0, 0.25, 0.6, 0.05);
+    runScenario(logger, "Sine hip angle (Python mock)", 1.0, estimator,
+                [](double time) {
+                  return std::make_pair(std::sin(2 * M_PI * time),
+                                        std::fmod(time, 1.0));
+                });
+  }
+
+  // The normative gait of the Lokomat simulator, with its noise
+  {
+    devices::LokomatSimulatorTask lokomat(SAMPLE_PERIOD, 1);
+    std::vector<double> frame(lokomat.getChannelCount());
+    double strideDuration =
+        std::chrono::duration<double>(lokomat.getStrideDuration()).count();
+
+    data::GaitPhaseEstimator estimator(0);
+    runScenario(logger, "Normative gait (Lokomat simulator)", strideDuration,
+                estimator, [&](double time) {
+                  lokomat.generateFrame(frame.data(), time);
+                  return std::make_pair(frame[0], frame[15]);
+                });
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+#include "stimwalker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif // _WIN32
+
+using namespace STIMWALKER_NAMESPACE;
+
+// Measure the time from a call to trigger a Magstim Rapid to the fire command
+// reaching the stimulator. The stimulator is a stand-in on the master side of
+// a pseudo-terminal, so the device writes to an actual serial port. The
+// median must stay under [MAX_MEDIAN_LATENCY], which needs a quiet machine
+// (the unit tests only check that every fire command arrives).
+
+const size_t TRIGGER_COUNT(200);
+const std::chrono::milliseconds TRIGGER_INTERVAL(2);
+const std::chrono::microseconds MAX_MEDIAN_LATENCY(2000);
+
+#ifndef _WIN32
+// Answer every command with a status (and a temperature for [F]) and keep
+// when each fire command was fully received
+class PtyStimulator {
+public:
+  PtyStimulator() {
+    m_Master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(m_Master);
+    unlockpt(m_Master);
+    port = ptsname(m_Master);
+    m_Worker = std::thread([this]() { run(); });
+  }
+  ~PtyStimulator() {
+    m_ShouldStop = true;
+    m_Worker.join();
+    close(m_Master);
+  }
+
+  std::string port;
+  std::vector<std::chrono::high_resolution_clock::time_point> fireTimes;
+  std::mutex mutex;
+
+protected:
+  void run() {
+    std::string received;
+    while (!m_ShouldStop) {
+      pollfd descriptor{m_Master, POLLIN, 0};
+      if (poll(&descriptor, 1, 10) <= 0 || !(descriptor.revents & POLLIN)) {
+        continue;
+      }
+      char buffer[64];
+      auto byteCount = read(m_Master, buffer, sizeof(buffer));
+      if (byteCount <= 0) {
+        continue;
+      }
+      auto now = std::chrono::high_resolution_clock::now();
+      received.append(buffer, byteCount);
+
+      // The power command has three digits of data, the others none
+      while (received.size() >= 2) {
+        size_t length = received[0] == '@' ? 5 : 3;
+        if (received.size() < length) {
+          break;
+        }
+        auto command = received.substr(0, length - 1);
+        received.erase(0, length);
+        if (command == "EH") {
+          std::lock_guard<std::mutex> lock(mutex);
+          fireTimes.push_back(now);
+        }
+        answer(command);
+      }
+    }
+  }
+
+  void answer(const std::string &command) {
+    if (command == "EB") {
+      m_IsArmed = true;
+    } else if (command == "EA") {
+      m_IsArmed = false;
+    }
+
+    std::string response(1, command[0]);
+    response += static_cast<char>(m_IsArmed ? 0x8E : 0x89);
+    if (command[0] == 'F') {
+      response += "375000";
+    }
+    response += crc(response);
+    ::write(m_Master, response.data(), response.size());
+  }
+
+  static std::string crc(const std::string &data) {
+    int sum = 0;
+    for (const auto &c : data) {
+      sum += c;
+    }
+    return std::string(1, static_cast<char>(~sum & 0xff));
+  }
+
+  int m_Master;
+  std::thread m_Worker;
+  std::atomic<bool> m_ShouldStop = false;
+  bool m_IsArmed = false;
+};
+#endif // _WIN32
+
+int main() {
+  auto &logger = utils::Logger::getInstance();
+  logger.setLogLevel(utils::Logger::INFO);
+
+#ifdef _WIN32
+  logger.fatal("This benchmark needs a pseudo-terminal");
+  return EXIT_FAILURE;
+#else
+  auto stimulator = PtyStimulator();
+  auto magstim = devices::MagstimRapidDevice(stimulator.port);
+  if (!magstim.connect() ||
+      magstim.send(devices::MagstimRapidCommands::ARM).getValue() !=
+          devices::DeviceResponses::OK) {
+    logger.fatal("Could not arm the stand-in stimulator");
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::chrono::high_resolution_clock::time_point> callTimes;
+  for (size_t i = 0; i < TRIGGER_COUNT; i++) {
+    callTimes.push_back(std::chrono::high_resolution_clock::now());
+    magstim.trigger();
+    std::this_thread::sleep_for(TRIGGER_INTERVAL);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  magstim.disconnect();
+
+  std::vector<std::chrono::microseconds> latencies;
+  {
+    std::lock_guard<std::mutex> lock(stimulator.mutex);
+    if (stimulator.fireTimes.size() != callTimes.size()) {
+      logger.fatal("{} fire commands reached the stimulator out of {}",
+                   stimulator.fireTimes.size(), callTimes.size());
+      return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < callTimes.size(); i++) {
+      latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+          stimulator.fireTimes[i] - callTimes[i]));
+    }
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto median = latencies[latencies.size() / 2];
+  logger.info("{} triggers, every {} ms: latency median {} us, p99 {} us, "
+              "max {} us",
+              TRIGGER_COUNT, TRIGGER_INTERVAL.count(), median.count(),
+              latencies[latencies.size() * 99 / 100].count(),
+              latencies.back().count());
+
+  if (median >= MAX_MEDIAN_LATENCY) {
+    logger.fatal("The fire commands are too slow (median latency over {} us)",
+                 MAX_MEDIAN_LATENCY.count());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+#endif // _WIN32
+}
@@ -0,0 +1,184 @@
+#include "stimwalker.h"
+
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+
+using namespace STIMWALKER_NAMESPACE;
+
+// Measure the framing of the ScienceMode2 protocol. The streaming decoder of
+// the RehaStim device (over the ring buffer of the serial port) is compared to
+// the framing of run/scienceMode2/ScienceMode2.cpp, which looks for the start
+// and stop bytes from the front of a fixed buffer every time bytes arrive and
+// shifts the buffer down after each frame. Both are given the same stream, in
+// chunks of the sizes a read of the port returns.
+
+const size_t FRAME_COUNT(200000);
+
+// Each time is the best of a few repetitions, to leave out the preemptions
+const size_t REPETITION_COUNT(5);
+
+using Command = devices::RehastimProtocolCommand;
+
+// The framing of ScienceMode2::getFrame, with the buffer shifted down by
+// ScienceMode2::adjustBuffer
+class ShiftingDecoder {
+public:
+  // Add bytes and decode the full frames
+  // @return The number of frames decoded
+  size_t feed(const char *data, size_t size) {
+    size_t frameCount = 0;
+    std::memcpy(m_Buffer + m_Length, data, size);
+    m_Length += size;
+
+    while (true) {
+      // The first start byte
+      size_t first = 0;
+      while (first < m_Length &&
+             static_cast<std::uint8_t>(m_Buffer[first]) != 0xF0) {
+        first++;
+      }
+      if (first == m_Length) {
+        m_Length = 0;
+        return frameCount;
+      }
+
+      // The stop byte, jumping over the stuffed bytes
+      size_t last = first + 1;
+      while (last < m_Length &&
+             static_cast<std::uint8_t>(m_Buffer[last]) != 0x0F) {
+        last += static_cast<std::uint8_t>(m_Buffer[last]) == 0x81 ? 2 : 1;
+      }
+      if (last >= m_Length) {
+        shift(first);
+        return frameCount;
+      }
+
+      size_t length = static_cast<std::uint8_t>(m_Buffer[first + 4]) ^ 0x55;
+      if (length == last - (first + 5)) {
+        size_t unstuffedLength = 0;
+        bool isStuffed = false;
+        for (size_t i = first + 5; i < last; i++) {
+          if (static_cast<std::uint8_t>(m_Buffer[i]) == 0x81) {
+            isStuffed = true;
+            continue;
+          }
+          m_Payload[unstuffedLength++] =
+              isStuffed ? static_cast<char>(m_Buffer[i] ^ 0x55) : m_Buffer[i];
+          isStuffed = false;
+        }
+        auto crc = devices::RehastimDevice::computeCrc(m_Buffer + first + 5,
+                                                       length);
+        if ((static_cast<std::uint8_t>(m_Buffer[first + 2]) ^ 0x55) == crc) {
+          frameCount++;
+        }
+      }
+      shift(last + 1);
+    }
+  }
+
+protected:
+  void shift(size_t count) {
+    for (size_t i = count; i < m_Length; i++) {
+      m_Buffer[i - count] = m_Buffer[i];
+    }
+    m_Length -= count;
+  }
+
+  char m_Buffer[8192];
+  size_t m_Length = 0;
+  char m_Payload[256];
+};
+
+// Feed [stream] to [feed] in chunks of [chunkSize] bytes
+// @return The time per frame (ns)
+double measure(const std::string &stream, size_t chunkSize,
+               const std::function<size_t(const char *, size_t)> &feed,
+               size_t &frameCount) {
+  double best = std::numeric_limits<double>::max();
+  for (size_t repetition = 0; repetition < REPETITION_COUNT; repetition++) {
+    frameCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t sent = 0; sent < stream.size(); sent += chunkSize) {
+      frameCount += feed(stream.data() + sent,
+                         std::min(chunkSize, stream.size() - sent));
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    best = std::min(best, static_cast<double>(elapsed) /
+                              static_cast<double>(FRAME_COUNT));
+  }
+  return best;
+}
+
+int main() {
+  auto &logger = utils::Logger::getInstance();
+  logger.setLogLevel(utils::Logger::INFO);
+
+  // What the stimulator sends during a closed loop: mostly the
+  // acknowledgments of the updates, with some longer packets
+  std::mt19937 generator(42);
+  std::string stream;
+  for (size_t i = 0; i < FRAME_COUNT; i++) {
+    std::string data(1, '\0');
+    Command command = Command::START_CHANNEL_LIST_MODE_ACK;
+    if (i % 10 == 0) {
+      command = Command::GET_STIMULATION_MODE_ACK;
+      for (int j = 0; j < 32; j++) {
+        data += static_cast<char>(generator() % 256);
+      }
+    }
+    stream += devices::RehastimDevice::encodeFrame(
+        static_cast<std::uint8_t>(i), command, data);
+  }
+  logger.info("{} frames, {} bytes", FRAME_COUNT, stream.size());
+
+  for (size_t chunkSize : {1, 16, 256, 4096}) {
+    size_t shiftingCount;
+    ShiftingDecoder shifting;
+    double shiftingTime = measure(
+        stream, chunkSize,
+        [&shifting](const char *data, size_t size) {
+          return shifting.feed(data, size);
+        },
+        shiftingCount);
+
+    size_t streamingCount;
+    utils::ByteRingBuffer buffer(4096);
+    devices::RehastimFrameDecoder decoder;
+    double streamingTime = measure(
+        stream, chunkSize,
+        [&](const char *data, size_t size) {
+          // As SerialPortDevice::decodeReceivedBytes does
+          size_t frameCount = 0;
+          while (size > 0) {
+            auto written = buffer.write(data, size);
+            data += written;
+            size -= written;
+            while (!buffer.empty()) {
+              size_t length = 0;
+              auto status = decoder.decode(buffer, length);
+              if (status == devices::SerialFrameDecoder::Status::INCOMPLETE) {
+                break;
+              }
+              buffer.consume(length);
+              frameCount +=
+                  status == devices::SerialFrameDecoder::Status::FRAME ? 1 : 0;
+            }
+          }
+          return frameCount;
+        },
+        streamingCount);
+
+    logger.info("Chunks of {} bytes: shifting {} ns/frame ({} frames) | "
+                "streaming {} ns/frame ({} frames, {} MB/s)",
+                chunkSize, shiftingTime, shiftingCount, streamingTime,
+                streamingCount,
+                static_cast<double>(stream.size()) /
+                    (streamingTime * FRAME_COUNT) * 1000.0);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,315 @@
+#include "stimwalker.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace STIMWALKER_NAMESPACE;
+
+// Measure the whole stack of the server: mock Delsys devices streaming
+// through their data collectors, the TCP server sending the live data and
+// recording a trial, and the clients receiving and parsing the live data
+// then fetching the trial. A TcpServer serves a single client, so each client
+// has its own server (on its own ports) with its own devices, all of them in
+// this process. The recording lasts [seconds] and is reported as:
+//   the ingest rate of the devices (the samples of the trial per second)
+//   the live data received by each client (bytes and latency)
+//   the time of GET_LAST_TRIAL_DATA, as seen by each client
+//   the CPU time of each thread of the process during the recording
+//   the peak resident memory of the process
+// Usage: bench_server [seconds] [EMG devices] [analog devices] [clients]
+
+const std::chrono::seconds DEFAULT_DURATION(5);
+const size_t DEFAULT_EMG_COUNT(1);
+const size_t DEFAULT_ANALOG_COUNT(1);
+const size_t DEFAULT_CLIENT_COUNT(1);
+
+// The names the server gives to the devices the clients ask for
+const std::string EMG_DEVICE_NAME("DelsysEmgDevice");
+const std::string ANALOG_DEVICE_NAME("DelsysAnalogDevice");
+
+// The ports of the n-th server are the default ones plus n times this offset
+const int PORT_OFFSET(10);
+
+const std::chrono::milliseconds SERVER_TIMEOUT(5000);
+
+// The devices start streaming when added, give them time to settle before
+// recording
+const std::chrono::milliseconds WARM_UP_DURATION(500);
+
+// The number of threads reported, from the busiest
+const size_t REPORTED_THREAD_COUNT(8);
+
+// A mock device whose name is suffixed by its index (but the first), so
+// several of them can stream side by side in the same server
+template <typename T> class IndexedDevice : public T {
+public:
+  IndexedDevice(size_t index) : m_Index(index) {}
+
+  std::string deviceName() const override {
+    return withIndex(T::deviceName());
+  }
+
+  std::string dataCollectorName() const override {
+    return withIndex(T::dataCollectorName());
+  }
+
+protected:
+  std::string withIndex(const std::string &name) const {
+    return m_Index == 0 ? name : name + std::to_string(m_Index);
+  }
+
+  size_t m_Index;
+};
+
+// A mock server that adds [emgCount] EMG (or [analogCount] analog) devices
+// when a client asks for one
+class BenchServer : public server::TcpServerMock {
+public:
+  BenchServer(size_t index, size_t emgCount, size_t analogCount)
+      : TcpServerMock(5000 + PORT_OFFSET * static_cast<int>(index),
+                      5001 + PORT_OFFSET * static_cast<int>(index),
+                      5002 + PORT_OFFSET * static_cast<int>(index),
+                      SERVER_TIMEOUT),
+        m_EmgCount(emgCount), m_AnalogCount(analogCount) {}
+
+protected:
+  void makeAndAddDevice(const std::string &deviceName) override {
+    if (deviceName == EMG_DEVICE_NAME) {
+      addDevices<devices::DelsysEmgDeviceMock>(m_EmgCount);
+    } else if (deviceName == ANALOG_DEVICE_NAME) {
+      addDevices<devices::DelsysAnalogDeviceMock>(m_AnalogCount);
+    } else {
+      TcpServerMock::makeAndAddDevice(deviceName);
+    }
+  }
+
+  // The first device takes the name the server expects, so the client can
+  // remove them as usual
+  template <typename T> void addDevices(size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      auto device = std::make_unique<IndexedDevice<T>>(i);
+      auto name = device->deviceName();
+      m_ConnectedDeviceIds[name] = m_Devices.add(std::move(device));
+    }
+  }
+
+  size_t m_EmgCount;
+  size_t m_AnalogCount;
+};
+
+struct Session {
+  std::unique_ptr<BenchServer> server;
+  std::unique_ptr<server::TcpClient> client;
+  size_t liveDataUpdateCount = 0;
+  size_t liveDataByteCount = 0;
+  size_t trialSampleCount = 0;
+  std::chrono::nanoseconds trialDataTime = std::chrono::nanoseconds(0);
+};
+
+// The server listens from its own thread, so the first attempts of the
+// client may be refused
+bool connectWhenListening(server::TcpClient &client) {
+  auto timeout = std::chrono::steady_clock::now() + SERVER_TIMEOUT;
+  while (std::chrono::steady_clock::now() < timeout) {
+    try {
+      return client.connect();
+    } catch (const std::exception &) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  return false;
+}
+
+// Get the CPU time (user and system) of each thread of the process, by id
+std::map<int, std::chrono::milliseconds> threadCpuTimes() {
+  std::map<int, std::chrono::milliseconds> times;
+#ifdef __linux__
+  long ticksPerSecond = sysconf(_SC_CLK_TCK);
+  for (const auto &entry :
+       std::filesystem::directory_iterator("/proc/self/task")) {
+    std::ifstream file(entry.path() / "stat");
+    std::string stat;
+    std::getline(file, stat);
+
+    // The name of the thread is in parentheses and may hold spaces, the
+    // user and system times are the 12th and 13th fields after it
+    auto nameEnd = stat.rfind(')');
+    if (nameEnd == std::string::npos) {
+      continue;
+    }
+    std::istringstream fields(stat.substr(nameEnd + 1));
+    std::string field;
+    for (int i = 0; i < 11; i++) {
+      fields >> field;
+    }
+    unsigned long long userTicks = 0;
+    unsigned long long systemTicks = 0;
+    fields >> userTicks >> systemTicks;
+    times[std::stoi(entry.path().filename().string())] =
+        std::chrono::milliseconds((userTicks + systemTicks) * 1000 /
+                                  ticksPerSecond);
+  }
+#endif
+  return times;
+}
+
+// Get the peak resident memory of the process (kB)
+long peakResidentSetSize() {
+#ifdef __linux__
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+#else
+  return 0;
+#endif
+}
+
+void reportThreads(utils::Logger &logger,
+                   const std::map<int, std::chrono::milliseconds> &before,
+                   const std::map<int, std::chrono::milliseconds> &after,
+                   std::chrono::seconds duration) {
+  if (after.empty()) {
+    logger.info("The CPU time of the threads is only measured on Linux");
+    return;
+  }
+
+  std::vector<std::pair<std::chrono::milliseconds, int>> threads;
+  auto total = std::chrono::milliseconds(0);
+  for (const auto &[id, time] : after) {
+    auto previous = before.find(id);
+    auto elapsed =
+        time - (previous == before.end() ? std::chrono::milliseconds(0)
+                                         : previous->second);
+    threads.emplace_back(elapsed, id);
+    total += elapsed;
+  }
+  std::sort(threads.rbegin(), threads.rend());
+
+  auto toPercent = [&duration](const std::chrono::milliseconds &time) {
+    return static_cast<double>(time.count()) /
+           static_cast<double>(
+               std::chrono::duration_cast<std::chrono::milliseconds>(duration)
+                   .count()) *
+           100.0;
+  };
+  logger.info("CPU: {} threads, {} % of a core in total", threads.size(),
+              toPercent(total));
+  for (size_t i = 0; i < std::min(REPORTED_THREAD_COUNT, threads.size());
+       i++) {
+    logger.info("  thread {}: {} % ({} ms)", threads[i].second,
+                toPercent(threads[i].first), threads[i].first.count());
+  }
+}
+
+void reportSession(utils::Logger &logger, size_t index,
+                   const Session &session, std::chrono::seconds duration) {
+  auto toMs = [](const std::chrono::nanoseconds &value) {
+    return static_cast<double>(value.count()) / 1e6;
+  };
+  auto seconds = static_cast<double>(duration.count());
+  auto latencies = session.client->getLiveDataLatencies();
+
+  logger.info("Client {}: ingest {} samples/s, live data {} updates/s, {} "
+              "kB/s, latency p50 {} ms, p95 {} ms, max {} ms",
+              index, static_cast<double>(session.trialSampleCount) / seconds,
+              static_cast<double>(session.liveDataUpdateCount) / seconds,
+              static_cast<double>(session.liveDataByteCount) / 1e3 / seconds,
+              toMs(latencies.quantile(0.5)), toMs(latencies.quantile(0.95)),
+              toMs(latencies.getMax()));
+  logger.info("  GET_LAST_TRIAL_DATA: {} ms for {} samples",
+              toMs(session.trialDataTime), session.trialSampleCount);
+}
+
+int main(int argc, char **argv) {
+  auto &logger = utils::Logger::getInstance();
+  logger.setLogFile(
+      (std::filesystem::temp_directory_path() / "bench_server.log").string());
+  logger.setLogLevel(utils::Logger::INFO);
+  logger.setIsAsynchronous(true);
+
+  auto duration =
+      argc > 1 ? std::chrono::seconds(std::stoi(argv[1])) : DEFAULT_DURATION;
+  size_t emgCount = argc > 2 ? std::stoul(argv[2]) : DEFAULT_EMG_COUNT;
+  size_t analogCount = argc > 3 ? std::stoul(argv[3]) : DEFAULT_ANALOG_COUNT;
+  size_t clientCount = argc > 4 ? std::stoul(argv[4]) : DEFAULT_CLIENT_COUNT;
+  logger.info("{} s of recording, {} EMG and {} analog devices per server, {} "
+              "client(s)",
+              duration.count(), emgCount, analogCount, clientCount);
+
+  // The server logs every command, so the records only go to the file
+  logger.flush();
+  logger.setShouldPrintToConsole(false);
+
+  std::vector<Session> sessions(clientCount);
+  for (size_t i = 0; i < clientCount; i++) {
+    auto &session = sessions[i];
+    session.server = std::make_unique<BenchServer>(i, emgCount, analogCount);
+    session.server->startServer();
+    session.client = std::make_unique<server::TcpClient>(
+        "localhost", 5000 + PORT_OFFSET * static_cast<int>(i),
+        5001 + PORT_OFFSET * static_cast<int>(i),
+        5002 + PORT_OFFSET * static_cast<int>(i));
+    if (!connectWhenListening(*session.client) ||
+        (emgCount > 0 && !session.client->addDelsysEmgDevice()) ||
+        (analogCount > 0 && !session.client->addDelsysAnalogDevice())) {
+      logger.flush();
+      logger.setShouldPrintToConsole(true);
+      logger.fatal("Could not start the session of the client {}", i);
+      return EXIT_FAILURE;
+    }
+  }
+  std::this_thread::sleep_for(WARM_UP_DURATION);
+
+  // Record
+  auto cpuBefore = threadCpuTimes();
+  for (auto &session : sessions) {
+    session.liveDataUpdateCount = session.client->getLiveDataUpdateCount();
+    session.liveDataByteCount = session.client->getLiveDataByteCount();
+    session.client->startRecording();
+  }
+  std::this_thread::sleep_for(duration);
+  for (auto &session : sessions) {
+    session.client->stopRecording();
+    session.liveDataUpdateCount =
+        session.client->getLiveDataUpdateCount() - session.liveDataUpdateCount;
+    session.liveDataByteCount =
+        session.client->getLiveDataByteCount() - session.liveDataByteCount;
+  }
+  auto cpuAfter = threadCpuTimes();
+
+  // Fetch the trials
+  for (auto &session : sessions) {
+    auto start = std::chrono::steady_clock::now();
+    auto trial = session.client->getLastTrialData();
+    session.trialDataTime = std::chrono::steady_clock::now() - start;
+    for (const auto &[name, series] : trial) {
+      if (series.size() > 0) {
+        session.trialSampleCount += series.size() * series[0].size();
+      }
+    }
+  }
+
+  for (auto &session : sessions) {
+    session.client->disconnect();
+    session.server->stopServer();
+  }
+  logger.flush();
+  logger.setShouldPrintToConsole(true);
+
+  for (size_t i = 0; i < sessions.size(); i++) {
+    reportSession(logger, i, sessions[i], duration);
+  }
+  reportThreads(logger, cpuBefore, cpuAfter, duration);
+  logger.info("Peak resident memory: {} MB",
+              static_cast<double>(peakResidentSetSize()) / 1e3);
+
+  logger.flush();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+#include "stimwalker.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+using namespace STIMWALKER_NAMESPACE;
+
+// Measure the cost of evaluating stimulation rules on every sample of the
+// Lokomat (1 kHz, in blocks of 10 samples). The rule engine evaluates the
+// compiled plan, and is compared to the evaluation of the conditions as they
+// are loaded (StimulationCondition::isMet, with the same decisions).
+
+const size_t SAMPLE_COUNT_PER_BLOCK(10);
+const size_t SAMPLE_COUNT(20000);
+const size_t LEFT_HIP_CHANNEL(0);
+const size_t RIGHT_HIP_CHANNEL(2);
+
+// Each time is the best of a few repetitions, to leave out the preemptions
+const size_t REPETITION_COUNT(5);
+
+// Draw a rule with conditions of every kind
+devices::StimulationRule randomRule(std::mt19937 &generator, size_t index) {
+  std::uniform_int_distribution<int> comparisons(0, 3);
+  std::uniform_int_distribution<int> sides(1, 2);
+  std::uniform_int_distribution<int> kinds(0, 2);
+  std::uniform_real_distribution<double> percentages(0.0, 1.0);
+  std::uniform_int_distribution<int> durations(10, 500);
+  std::uniform_int_distribution<size_t> channels(0, 7);
+
+  auto condition = [&](bool canBeDuration) {
+    auto comparison =
+        static_cast<devices::StimulationComparison>(comparisons(generator));
+    if (canBeDuration && kinds(generator) == 0) {
+      return devices::StimulationCondition::onDuration(
+          comparison, std::chrono::milliseconds(durations(generator)));
+    }
+    return devices::StimulationCondition::onGaitPercentage(
+        comparison, static_cast<devices::StimulationSide>(sides(generator)),
+        percentages(generator));
+  };
+
+  auto start = condition(false);
+  if (kinds(generator) == 0) {
+    return devices::StimulationRule("Rule " + std::to_string(index),
+                                    {channels(generator)}, {20.0}, start,
+                                    std::nullopt, condition(true));
+  }
+  return devices::StimulationRule("Rule " + std::to_string(index),
+                                  {channels(generator)}, {20.0}, start,
+                                  condition(true));
+}
+
+// Evaluate [rules] the way the conditions are loaded, on the percentages of
+// each sample
+size_t evaluateInterpreted(
+    const std::vector<devices::StimulationRule> &rules,
+    const std::vector<std::chrono::microseconds> &timeStamps,
+    const std::vector<double> &lefts, const std::vector<double> &rights,
+    double &nanosecondsPerSample) {
+  struct State {
+    bool isStimulating = false;
+    bool isArmed = true;
+    std::chrono::microseconds startedAt = std::chrono::microseconds(0);
+  };
+  std::vector<State> states(rules.size());
+  size_t decisionCount = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < timeStamps.size(); i++) {
+    const auto &timeStamp = timeStamps[i];
+    for (size_t j = 0; j < rules.size(); j++) {
+      const auto &rule = rules[j];
+      auto &state = states[j];
+      auto stimulatingFor = state.isStimulating
+                                ? timeStamp - state.startedAt
+                                : std::chrono::microseconds(-1);
+      bool shouldStart =
+          rule.getStart()->isMet(lefts[i], rights[i], stimulatingFor);
+
+      if (state.isStimulating) {
+        bool shouldStop =
+            rule.getContinue()
+                ? !shouldStart || !rule.getContinue()->isMet(
+                                      lefts[i], rights[i], stimulatingFor)
+                : rule.getEnd()->isMet(lefts[i], rights[i], stimulatingFor);
+        if (shouldStop) {
+          state.isStimulating = false;
+          state.isArmed = !shouldStart;
+          decisionCount++;
+        }
+      } else if (!shouldStart) {
+        state.isArmed = true;
+      } else if (state.isArmed) {
+        state.isStimulating = true;
+        state.isArmed = false;
+        state.startedAt = timeStamp;
+        decisionCount++;
+      }
+    }
+  }
+  nanosecondsPerSample =
+      static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count()) /
+      static_cast<double>(timeStamps.size());
+  return decisionCount;
+}
+
+// Feed the samples to a rule engine with [rules]
+size_t evaluateEngine(const std::vector<devices::StimulationRule> &rules,
+                      const std::vector<std::chrono::microseconds> &timeStamps,
+                      const std::vector<double> &samples, size_t channelCount,
+                      double &nanosecondsPerSample) {
+  devices::StimulationRuleEngine engine(LEFT_HIP_CHANNEL, RIGHT_HIP_CHANNEL);
+  engine.addRules(rules);
+  size_t decisionCount = 0;
+  engine.onStimulationDecision.listen(
+      [&decisionCount](const devices::StimulationDecision &) {
+        decisionCount++;
+      });
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < timeStamps.size(); i += SAMPLE_COUNT_PER_BLOCK) {
+    engine.processBlock(data::DataBlock(&timeStamps[i],
+                                        &samples[i * channelCount],
+                                        SAMPLE_COUNT_PER_BLOCK, channelCount));
+  }
+  nanosecondsPerSample =
+      static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count()) /
+      static_cast<double>(timeStamps.size());
+  return decisionCount;
+}
+
+int main() {
+  auto &logger = utils::Logger::getInstance();
+  logger.setLogLevel(utils::Logger::INFO);
+
+  // The samples and the percentages of the stride the engine estimates
+  devices::LokomatSimulatorTask lokomat(std::chrono::microseconds(1000), 1);
+  size_t channelCount = lokomat.getChannelCount();
+  std::vector<std::chrono::microseconds> timeStamps(SAMPLE_COUNT);
+  std::vector<double> samples(SAMPLE_COUNT * channelCount);
+  std::vector<double> lefts(SAMPLE_COUNT);
+  std::vector<double> rights(SAMPLE_COUNT);
+  data::GaitPhaseEstimator leftGait(LEFT_HIP_CHANNEL);
+  data::GaitPhaseEstimator rightGait(RIGHT_HIP_CHANNEL);
+  for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+    timeStamps[i] = std::chrono::milliseconds(i);
+    double *frame = &samples[i * channelCount];
+    lokomat.generateFrame(frame, static_cast<double>(i) * 1e-3);
+    lefts[i] =
+        leftGait.addSample(timeStamps[i], frame[LEFT_HIP_CHANNEL]).percentage;
+    rights[i] =
+        rightGait.addSample(timeStamps[i], frame[RIGHT_HIP_CHANNEL]).percentage;
+  }
+
+  // The cost of the engine without rules (the gait estimation)
+  double baseline = std::numeric_limits<double>::max();
+  for (size_t i = 0; i < REPETITION_COUNT; i++) {
+    double time;
+    evaluateEngine({}, timeStamps, samples, channelCount, time);
+    baseline = std::min(baseline, time);
+  }
+  logger.info("Gait estimation of both legs: {} ns/sample", baseline);
+
+  std::mt19937 generator(42);
+  for (size_t ruleCount : {1, 10, 100, 500}) {
+    std::vector<devices::StimulationRule> rules;
+    for (size_t i = 0; i < ruleCount; i++) {
+      rules.push_back(randomRule(generator, i));
+    }
+
+    double interpreted = std::numeric_limits<double>::max();
+    double compiled = std::numeric_limits<double>::max();
+    size_t interpretedDecisions = 0;
+    size_t compiledDecisions = 0;
+    for (size_t i = 0; i < REPETITION_COUNT; i++) {
+      double time;
+      interpretedDecisions =
+          evaluateInterpreted(rules, timeStamps, lefts, rights, time);
+      interpreted = std::min(interpreted, time);
+      compiledDecisions =
+          evaluateEngine(rules, timeStamps, samples, channelCount, time);
+      compiled = std::min(compiled, time);
+    }
+
+    auto count = static_cast<double>(ruleCount);
+    logger.info("{} rule(s): interpreted {} ns/rule/sample | compiled {} "
+                "ns/rule/sample (engine {} us/block) | {} decisions{}",
+                ruleCount, interpreted / count, (compiled - baseline) / count,
+                compiled * SAMPLE_COUNT_PER_BLOCK / 1000.0, compiledDecisions,
+                compiledDecisions == interpretedDecisions
+                    ? ""
+                    : " (interpreted: " +
+                          std::to_string(interpretedDecisions) + ")");
+  }
+
+  return EXIT_SUCCESS;
+}
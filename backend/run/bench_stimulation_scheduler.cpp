@@ -0,0 +1,48 @@
+#include "stimwalker.h"
+
+#include <thread>
+
+using namespace STIMWALKER_NAMESPACE;
+
+// Measure how close to their deadline the stimulation scheduler fires its
+// requests. Requests are scheduled every few milliseconds (as the pulses of a
+// closed loop would be) and the time between each deadline and its firing is
+// reported. The median must stay under [MAX_MEDIAN_ERROR], which needs a
+// quiet machine (the unit tests only check that the requests fire in order).
+
+const size_t REQUEST_COUNT(500);
+const std::chrono::milliseconds REQUEST_INTERVAL(2);
+const std::chrono::microseconds MAX_MEDIAN_ERROR(100);
+
+int main() {
+  auto &logger = utils::Logger::getInstance();
+  logger.setLogLevel(utils::Logger::INFO);
+
+  auto scheduler = devices::StimulationScheduler();
+  size_t firedCount = 0;
+  auto start = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+  for (size_t i = 0; i < REQUEST_COUNT; i++) {
+    scheduler.schedule(start + REQUEST_INTERVAL * i,
+                       [&firedCount]() { firedCount++; });
+  }
+  std::this_thread::sleep_until(start + REQUEST_INTERVAL * REQUEST_COUNT +
+                                std::chrono::milliseconds(100));
+
+  auto toUs = [](const std::chrono::nanoseconds &value) {
+    return static_cast<double>(value.count()) / 1e3;
+  };
+  auto errors = scheduler.getTimingErrors();
+  logger.info("{} requests fired out of {}, every {} ms: timing error mean {} "
+              "us, median {} us, p99 {} us",
+              firedCount, REQUEST_COUNT, REQUEST_INTERVAL.count(),
+              toUs(errors.mean()), toUs(errors.quantile(0.5)),
+              toUs(errors.quantile(0.99)));
+
+  if (scheduler.getPendingCount() != 0 ||
+      errors.quantile(0.5) >= MAX_MEDIAN_ERROR) {
+    logger.fatal("The scheduler missed its deadlines (median error over {} us)",
+                 MAX_MEDIAN_ERROR.count());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
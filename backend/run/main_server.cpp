@@ -8,6 +8,7 @@ int main() {
   auto &logger = utils::Logger::getInstance();
   logger.setLogFile("stimwalker.log");
   logger.setLogLevel(utils::Logger::INFO);
+  logger.setIsAsynchronous(true);
   logger.info("------------------------------");
   logger.info("Starting the stimwalker server");
 
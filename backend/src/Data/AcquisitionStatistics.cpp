@@ -0,0 +1,108 @@
+#include "Data/AcquisitionStatistics.h"
+
+using namespace STIMWALKER_NAMESPACE::data;
+
+AcquisitionStatistics::AcquisitionStatistics(
+    const std::chrono::microseconds &samplePeriod) {
+  reset(samplePeriod);
+}
+
+AcquisitionStatistics::AcquisitionStatistics(const nlohmann::json &json)
+    : m_SamplePeriod(json["samplePeriod"].get<int64_t>()),
+      m_StartTime(std::chrono::steady_clock::now()),
+      m_ExpectedSampleCount(json["expected"].get<size_t>()),
+      m_ReceivedSampleCount(json["received"].get<size_t>()),
+      m_DroppedSampleCount(json["dropped"].get<size_t>()),
+      m_GapCount(json["gapCount"].get<size_t>()),
+      m_TimerOverrunCount(json["timerOverruns"].get<size_t>()) {
+  if (!json.contains("gaps")) {
+    return;
+  }
+  for (const auto &gap : json["gaps"]) {
+    m_Gaps.push_back(Gap{gap[0].get<size_t>(),
+                         std::chrono::microseconds(gap[1].get<int64_t>()),
+                         gap[2].get<size_t>(),
+                         static_cast<GapReason>(gap[3].get<int>())});
+  }
+}
+
+void AcquisitionStatistics::reset(
+    const std::chrono::microseconds &samplePeriod,
+    const std::chrono::steady_clock::time_point &startTime) {
+  m_SamplePeriod = samplePeriod;
+  m_StartTime = startTime;
+  m_ExpectedSampleCount = 0;
+  m_ReceivedSampleCount = 0;
+  m_DroppedSampleCount = 0;
+  m_GapCount = 0;
+  m_TimerOverrunCount = 0;
+  m_Gaps.clear();
+}
+
+void AcquisitionStatistics::addReceivedSamples(size_t count) {
+  m_ReceivedSampleCount += count;
+}
+
+void AcquisitionStatistics::addGap(size_t count, GapReason reason,
+                                   size_t offset) {
+  if (count == 0) {
+    return;
+  }
+  m_DroppedSampleCount += count;
+
+  size_t position = m_ReceivedSampleCount + offset;
+  if (!m_Gaps.empty() && m_Gaps.back().position == position &&
+      m_Gaps.back().reason == reason) {
+    m_Gaps.back().sampleCount += count;
+    return;
+  }
+
+  m_GapCount++;
+  if (m_Gaps.size() < MAX_GAP_COUNT) {
+    m_Gaps.push_back(Gap{position,
+                         std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - m_StartTime),
+                         count, reason});
+  }
+}
+
+void AcquisitionStatistics::addTimerOverrun() { m_TimerOverrunCount++; }
+
+void AcquisitionStatistics::updateExpectedSampleCount() {
+  if (m_SamplePeriod.count() <= 0) {
+    m_ExpectedSampleCount = 0;
+    return;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - m_StartTime;
+  m_ExpectedSampleCount = static_cast<size_t>(elapsed / m_SamplePeriod);
+}
+
+size_t AcquisitionStatistics::getUnaccountedSampleCount() const {
+  size_t accounted = m_ReceivedSampleCount + m_DroppedSampleCount;
+  return m_ExpectedSampleCount > accounted ? m_ExpectedSampleCount - accounted
+                                           : 0;
+}
+
+nlohmann::json AcquisitionStatistics::serialize() const {
+  auto json = serializeCounts();
+
+  // Each gap is [position, timeStamp, sampleCount, reason]
+  json["gaps"] = nlohmann::json::array();
+  for (const auto &gap : m_Gaps) {
+    json["gaps"].push_back({gap.position, gap.timeStamp.count(),
+                            gap.sampleCount, static_cast<int>(gap.reason)});
+  }
+  return json;
+}
+
+nlohmann::json AcquisitionStatistics::serializeCounts() const {
+  nlohmann::json json;
+  json["samplePeriod"] = m_SamplePeriod.count();
+  json["expected"] = m_ExpectedSampleCount;
+  json["received"] = m_ReceivedSampleCount;
+  json["dropped"] = m_DroppedSampleCount;
+  json["unaccounted"] = getUnaccountedSampleCount();
+  json["gapCount"] = m_GapCount;
+  json["timerOverruns"] = m_TimerOverrunCount;
+  return json;
+}
@@ -0,0 +1,149 @@
+#include "Data/ClockSynchronizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace STIMWALKER_NAMESPACE::data;
+
+namespace {
+// The number of blocks needed before the fitted period is trusted
+const size_t MIN_BLOCK_COUNT = 8;
+
+// Residuals further than this many scales from the fit are down-weighted
+const double HUBER_THRESHOLD = 3.0;
+
+// How fast the residual scale follows the jitter
+const double SCALE_ADAPTATION = 0.02;
+
+// The smallest residual scale (in microseconds), so a perfectly regular
+// stream does not turn every small deviation into an outlier
+const double MIN_RESIDUAL_SCALE = 1.0;
+} // namespace
+
+ClockSynchronizer::ClockSynchronizer(
+    const std::chrono::microseconds &samplePeriod, size_t blockWindow)
+    : m_Forgetting(1.0 - 1.0 / static_cast<double>(std::max(
+                                   blockWindow, static_cast<size_t>(2)))) {
+  reset(samplePeriod);
+}
+
+void ClockSynchronizer::reset(const std::chrono::microseconds &samplePeriod) {
+  m_SamplePeriod = samplePeriod;
+  m_BlockCount = 0;
+  m_OutlierCount = 0;
+  m_SteadyOrigin = std::chrono::steady_clock::now();
+  m_Origin = std::chrono::system_clock::now();
+  m_WeightSum = 0.0;
+  m_MeanIndex = 0.0;
+  m_MeanTime = 0.0;
+  m_IndexVariance = 0.0;
+  m_Covariance = 0.0;
+  m_ResidualScale = 0.0;
+}
+
+void ClockSynchronizer::addBlock(
+    size_t lastSampleIndex,
+    const std::chrono::steady_clock::time_point &arrivalTime) {
+  if (m_BlockCount == 0) {
+    // The first block is the zero of the fit
+    m_SteadyOrigin = arrivalTime;
+    m_Origin = std::chrono::system_clock::now() -
+               std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                   std::chrono::steady_clock::now() - arrivalTime);
+  }
+
+  double index = static_cast<double>(lastSampleIndex);
+  double time =
+      std::chrono::duration<double, std::micro>(arrivalTime - m_SteadyOrigin)
+          .count();
+
+  // Weight the block from its distance to the current fit
+  double weight = 1.0;
+  if (m_BlockCount > 0) {
+    double residual = std::abs(time - predict(index));
+    if (m_BlockCount < MIN_BLOCK_COUNT) {
+      // Not enough blocks to know what is normal yet
+      m_ResidualScale += (residual - m_ResidualScale) /
+                         static_cast<double>(m_BlockCount);
+    } else {
+      double scale = std::max(m_ResidualScale, MIN_RESIDUAL_SCALE);
+      double threshold = HUBER_THRESHOLD * scale;
+      if (residual > threshold) {
+        weight = threshold / residual;
+        m_OutlierCount++;
+      }
+      m_ResidualScale +=
+          SCALE_ADAPTATION * (std::min(residual, threshold) - m_ResidualScale);
+    }
+  }
+
+  // Exponentially weighted (West's) update of the means and the centered sums
+  m_WeightSum = m_Forgetting * m_WeightSum + weight;
+  double indexDelta = index - m_MeanIndex;
+  double timeDelta = time - m_MeanTime;
+  m_MeanIndex += weight / m_WeightSum * indexDelta;
+  m_MeanTime += weight / m_WeightSum * timeDelta;
+  m_IndexVariance = m_Forgetting * m_IndexVariance +
+                    weight * indexDelta * (index - m_MeanIndex);
+  m_Covariance =
+      m_Forgetting * m_Covariance + weight * indexDelta * (time - m_MeanTime);
+
+  m_BlockCount++;
+}
+
+std::chrono::system_clock::time_point
+ClockSynchronizer::getTime(double sampleIndex) const {
+  return m_Origin +
+         std::chrono::duration_cast<std::chrono::system_clock::duration>(
+             std::chrono::duration<double, std::micro>(predict(sampleIndex)));
+}
+
+double ClockSynchronizer::getEstimatedSamplePeriod() const {
+  if (isSynchronized()) {
+    return m_Covariance / m_IndexVariance;
+  }
+  return static_cast<double>(m_SamplePeriod.count());
+}
+
+double ClockSynchronizer::getDriftPpm() const {
+  if (!isSynchronized() || m_SamplePeriod.count() <= 0) {
+    return 0.0;
+  }
+  return (getEstimatedSamplePeriod() /
+              static_cast<double>(m_SamplePeriod.count()) -
+          1.0) *
+         1e6;
+}
+
+double ClockSynchronizer::getJitter() const {
+  // The mean absolute deviation of a normal distribution is 0.8 sigma
+  return m_ResidualScale * 1.25;
+}
+
+bool ClockSynchronizer::isSynchronized() const {
+  return m_BlockCount >= MIN_BLOCK_COUNT && m_IndexVariance > 0.0;
+}
+
+nlohmann::json ClockSynchronizer::serialize(size_t firstSampleIndex) const {
+  nlohmann::json json;
+  json["origin"] = std::chrono::duration_cast<std::chrono::microseconds>(
+                       m_Origin.time_since_epoch())
+                       .count();
+  json["offset"] = predict(static_cast<double>(firstSampleIndex));
+  json["period"] = getEstimatedSamplePeriod();
+  json["driftPpm"] = getDriftPpm();
+  json["jitter"] = getJitter();
+  json["isSynchronized"] = isSynchronized();
+  json["blockCount"] = m_BlockCount;
+  json["outlierCount"] = m_OutlierCount;
+  json["firstSampleIndex"] = firstSampleIndex;
+  return json;
+}
+
+double ClockSynchronizer::predict(double sampleIndex) const {
+  if (m_BlockCount == 0) {
+    return sampleIndex * static_cast<double>(m_SamplePeriod.count());
+  }
+  return m_MeanTime +
+         getEstimatedSamplePeriod() * (sampleIndex - m_MeanIndex);
+}
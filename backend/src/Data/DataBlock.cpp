@@ -0,0 +1,11 @@
+#include "Data/DataBlock.h"
+
+#include <vector>
+
+using namespace STIMWALKER_NAMESPACE::data;
+
+DataPoint DataBlock::dataPoint(size_t index) const {
+  const double *values = sample(index);
+  return DataPoint(timeStamp(index),
+                   std::vector<double>(values, values + m_ChannelCount));
+}
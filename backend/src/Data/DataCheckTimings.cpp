@@ -0,0 +1,51 @@
+#include "Data/DataCheckTimings.h"
+
+using namespace STIMWALKER_NAMESPACE::data;
+
+// None of the times can be negative (a timer never fires early), so the bins
+// start at zero. The checks of the devices take up to a few blocks of samples
+// (tens of ms), the worker idles at most one interval (up to 100 ms) and the
+// wake ups are late by at most a few ms when the machine is busy
+DataCheckTimings::DataCheckTimings()
+    : m_IdleTimes(std::chrono::microseconds(100), 1000,
+                  std::chrono::nanoseconds(0)),
+      m_Latenesses(std::chrono::microseconds(10), 1000,
+                   std::chrono::nanoseconds(0)),
+      m_Durations(std::chrono::microseconds(100), 1000,
+                  std::chrono::nanoseconds(0)) {}
+
+DataCheckTimings::DataCheckTimings(const nlohmann::json &json)
+    : m_IdleTimes(json["idleTimes"]), m_Latenesses(json["latenesses"]),
+      m_Durations(json["durations"]) {}
+
+void DataCheckTimings::add(const std::chrono::nanoseconds &idleTime,
+                           const std::chrono::nanoseconds &lateness,
+                           const std::chrono::nanoseconds &duration) {
+  m_IdleTimes.add(idleTime);
+  m_Latenesses.add(lateness);
+  m_Durations.add(duration);
+}
+
+void DataCheckTimings::clear() {
+  m_IdleTimes.clear();
+  m_Latenesses.clear();
+  m_Durations.clear();
+}
+
+size_t DataCheckTimings::size() const { return m_Durations.size(); }
+
+nlohmann::json DataCheckTimings::serialize() const {
+  nlohmann::json json = nlohmann::json::object();
+  json["idleTimes"] = m_IdleTimes.serialize();
+  json["latenesses"] = m_Latenesses.serialize();
+  json["durations"] = m_Durations.serialize();
+  return json;
+}
+
+nlohmann::json DataCheckTimings::serializeSummary() const {
+  nlohmann::json json = nlohmann::json::object();
+  json["idleTimes"] = m_IdleTimes.serializeSummary();
+  json["latenesses"] = m_Latenesses.serializeSummary();
+  json["durations"] = m_Durations.serializeSummary();
+  return json;
+}
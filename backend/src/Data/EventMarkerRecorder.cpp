@@ -0,0 +1,69 @@
+#include "Data/EventMarkerRecorder.h"
+
+using namespace STIMWALKER_NAMESPACE::data;
+
+EventMarkerRecorder::EventMarkerRecorder()
+    : m_Markers(std::chrono::system_clock::now()),
+      m_StopWatch(std::chrono::steady_clock::now()) {}
+
+void EventMarkerRecorder::add(EventMarkerType type, std::int64_t payload) {
+  addAt(std::chrono::steady_clock::now(), type, payload);
+}
+
+void EventMarkerRecorder::addAt(
+    const std::chrono::steady_clock::time_point &time,
+    EventMarkerType type, std::int64_t payload) {
+  m_Queue.push(PendingMarker{time, type, payload});
+}
+
+void EventMarkerRecorder::reset() {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  PendingMarker marker;
+  while (m_Queue.pop(marker)) {
+  }
+  m_Markers = EventMarkers(std::chrono::system_clock::now());
+  m_StopWatch = std::chrono::steady_clock::now();
+}
+
+size_t EventMarkerRecorder::size() const {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  flush();
+  return m_Markers.size();
+}
+
+EventMarkers EventMarkerRecorder::between(
+    const std::chrono::steady_clock::time_point &from,
+    const std::chrono::steady_clock::time_point &to) const {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  flush();
+  // The markers are floored to the microsecond, so one added just before [to]
+  // can have the same time stamp as [to]: the end of the range is moved to the
+  // next microsecond to keep it
+  return m_Markers.between(
+      m_Markers.getStartingTime() +
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+              from - m_StopWatch),
+      m_Markers.getStartingTime() +
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+              to - m_StopWatch + std::chrono::microseconds(1)));
+}
+
+EventMarkers EventMarkerRecorder::getMarkers() const {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  flush();
+  return m_Markers;
+}
+
+void EventMarkerRecorder::flush() const {
+  PendingMarker marker;
+  while (m_Queue.pop(marker)) {
+    // Markers stamped before the last reset belong to the previous session
+    if (marker.time < m_StopWatch) {
+      continue;
+    }
+    m_Markers.add(EventMarker{
+        std::chrono::duration_cast<std::chrono::microseconds>(marker.time -
+                                                              m_StopWatch),
+        marker.type, marker.payload});
+  }
+}
@@ -0,0 +1,92 @@
+#include "Data/EventMarkers.h"
+
+#include <algorithm>
+
+using namespace STIMWALKER_NAMESPACE::data;
+
+namespace {
+bool isEarlier(const EventMarker &marker,
+               const std::chrono::microseconds &timeStamp) {
+  return marker.timeStamp < timeStamp;
+}
+} // namespace
+
+EventMarkers::EventMarkers(
+    const std::chrono::system_clock::time_point &startingTime)
+    : m_StartingTime(startingTime) {}
+
+EventMarkers::EventMarkers(const nlohmann::json &json)
+    : m_StartingTime(std::chrono::system_clock::time_point(
+          std::chrono::system_clock::duration(
+              json["startingTime"].get<int64_t>()))) {
+  for (const auto &marker : json["markers"]) {
+    m_Markers.push_back(
+        EventMarker{std::chrono::microseconds(marker[0].get<int64_t>()),
+                    static_cast<EventMarkerType>(marker[1].get<int>()),
+                    marker[2].get<std::int64_t>()});
+  }
+}
+
+size_t EventMarkers::size() const { return m_Markers.size(); }
+
+const EventMarker &EventMarkers::operator[](size_t index) const {
+  return m_Markers.at(index);
+}
+
+void EventMarkers::add(const EventMarker &marker) {
+  if (m_Markers.empty() || !(marker.timeStamp < m_Markers.back().timeStamp)) {
+    m_Markers.push_back(marker);
+    return;
+  }
+
+  // Markers of the same time stamp stay in the order they were added
+  auto position = std::upper_bound(
+      m_Markers.begin(), m_Markers.end(), marker.timeStamp,
+      [](const std::chrono::microseconds &timeStamp, const EventMarker &other) {
+        return timeStamp < other.timeStamp;
+      });
+  m_Markers.insert(position, marker);
+}
+
+void EventMarkers::clear() { m_Markers.clear(); }
+
+EventMarkers
+EventMarkers::between(const std::chrono::system_clock::time_point &from,
+                      const std::chrono::system_clock::time_point &to) const {
+  EventMarkers markers(m_StartingTime);
+  if (!(from < to)) {
+    return markers;
+  }
+
+  auto first = std::lower_bound(
+      m_Markers.begin(), m_Markers.end(),
+      std::chrono::duration_cast<std::chrono::microseconds>(from -
+                                                            m_StartingTime),
+      isEarlier);
+  auto last = std::lower_bound(
+      first, m_Markers.end(),
+      std::chrono::duration_cast<std::chrono::microseconds>(to -
+                                                            m_StartingTime),
+      isEarlier);
+  markers.m_Markers.assign(first, last);
+  return markers;
+}
+
+std::chrono::system_clock::time_point
+EventMarkers::getTime(const EventMarker &marker) const {
+  return m_StartingTime +
+         std::chrono::duration_cast<std::chrono::system_clock::duration>(
+             marker.timeStamp);
+}
+
+nlohmann::json EventMarkers::serialize() const {
+  nlohmann::json json = nlohmann::json::object();
+  json["startingTime"] = m_StartingTime.time_since_epoch().count();
+  json["markers"] = nlohmann::json::array();
+  auto &jsonMarkers = json["markers"];
+  for (const auto &marker : m_Markers) {
+    jsonMarkers.push_back({marker.timeStamp.count(),
+                           static_cast<int>(marker.type), marker.payload});
+  }
+  return json;
+}
@@ -3,12 +3,12 @@
 using namespace STIMWALKER_NAMESPACE::data;
 
 FixedTimeSeries::FixedTimeSeries(const std::chrono::microseconds &deltaTime)
-    : m_DeltaTime(deltaTime), TimeSeries() {}
+    : TimeSeries(), m_DeltaTime(deltaTime), m_SkippedCount(0) {}
 
 FixedTimeSeries::FixedTimeSeries(
     const std::chrono::system_clock::time_point &startingTime,
     const std::chrono::microseconds &deltaTime)
-    : m_DeltaTime(deltaTime), TimeSeries(startingTime) {}
+    : TimeSeries(startingTime), m_DeltaTime(deltaTime), m_SkippedCount(0) {}
 
 void FixedTimeSeries::add(const std::chrono::microseconds &timeStamp,
                           const std::vector<double> &data) {
@@ -16,5 +16,22 @@ void FixedTimeSeries::add(const std::chrono::microseconds &timeStamp,
 }
 
 void FixedTimeSeries::add(const std::vector<double> &data) {
-  TimeSeries::add(m_DeltaTime * m_Data.size(), data);
+  // Follow the last data point, so the series can continue data that did not
+  // start at zero (e.g. seeded from another series). The lost data keep their
+  // slots
+  auto skipped = m_DeltaTime * static_cast<int64_t>(m_SkippedCount);
+  m_SkippedCount = 0;
+  TimeSeries::add(m_Data.size() == 0
+                      ? skipped
+                      : m_Data.back().getTimeStamp() + m_DeltaTime + skipped,
+                  data);
 }
+
+void FixedTimeSeries::addAcquiredAt(
+    [[maybe_unused]] const std::chrono::high_resolution_clock::time_point
+        &acquisitionTime,
+    const std::vector<double> &data) {
+  add(data);
+}
+
+void FixedTimeSeries::skip(size_t count) { m_SkippedCount += count; }
@@ -0,0 +1,176 @@
+#include "Data/GaitPhaseEstimator.h"
+
+#include <cmath>
+
+using namespace STIMWALKER_NAMESPACE::data;
+
+// The range of the stride durations accepted before one is known
+const std::chrono::microseconds MIN_STRIDE_DURATION(400000);
+const std::chrono::microseconds MAX_STRIDE_DURATION(4000000);
+
+// How fast the stride duration follows a change of the cadence (the weight of
+// a new stride in the average)
+const double STRIDE_DURATION_ADAPTATION_RATE(0.5);
+
+namespace {
+// If an event published at [last] is old enough (at least half a stride) for
+// the same event to happen again at [now]
+bool isNewEvent(const std::chrono::microseconds &last,
+                const std::chrono::microseconds &now,
+                const std::chrono::microseconds &strideDuration) {
+  return last == std::chrono::microseconds::min() ||
+         now - last > strideDuration / 2;
+}
+} // namespace
+
+GaitPhaseEstimator::GaitPhaseEstimator(size_t hipChannel,
+                                       double peakPercentage,
+                                       double toeOffPercentage,
+                                       double hysteresis)
+    : m_HipChannel(hipChannel), m_PeakPercentage(peakPercentage),
+      m_ToeOffPercentage(toeOffPercentage), m_Hysteresis(hysteresis) {
+  reset();
+}
+
+void GaitPhaseEstimator::reset() {
+  m_StrideDuration = std::chrono::microseconds(0);
+  m_StrideCount = 0;
+  m_LastPeakTime = std::chrono::microseconds(0);
+  m_IsSeekingPeak = true;
+  m_CandidateAngle = 0.0;
+  m_CandidateTime = std::chrono::microseconds(0);
+  m_IsFirstSample = true;
+  m_LastPhase = GaitPhase{std::chrono::microseconds(0), -1.0, GaitEvent::NONE};
+  m_LastHeelStrikeTime = std::chrono::microseconds::min();
+  m_LastToeOffTime = std::chrono::microseconds::min();
+}
+
+void GaitPhaseEstimator::addBlock(const DataBlock &block) {
+  bool hasListeners = onNewGaitPhase.getListenerCount() > 0;
+  for (size_t i = 0; i < block.size(); i++) {
+    auto phase = addSample(block.timeStamp(i), block.value(i, m_HipChannel));
+    if (hasListeners) {
+      onNewGaitPhase.notifyListeners(phase);
+    }
+  }
+}
+
+GaitPhase
+GaitPhaseEstimator::addSample(const std::chrono::microseconds &timeStamp,
+                              double hipAngle) {
+  if (m_IsFirstSample) {
+    m_IsFirstSample = false;
+    m_CandidateAngle = hipAngle;
+    m_CandidateTime = timeStamp;
+  }
+
+  // Follow the angle up to a maximum, then down to a minimum, and so on. An
+  // extremum is only confirmed once the angle moved away from it by more than
+  // the hysteresis
+  if (m_IsSeekingPeak) {
+    if (hipAngle >= m_CandidateAngle) {
+      m_CandidateAngle = hipAngle;
+      m_CandidateTime = timeStamp;
+    } else if (hipAngle < m_CandidateAngle - m_Hysteresis) {
+      handlePeak(m_CandidateTime);
+      m_IsSeekingPeak = false;
+      m_CandidateAngle = hipAngle;
+      m_CandidateTime = timeStamp;
+    }
+  } else {
+    if (hipAngle <= m_CandidateAngle) {
+      m_CandidateAngle = hipAngle;
+      m_CandidateTime = timeStamp;
+    } else if (hipAngle > m_CandidateAngle + m_Hysteresis) {
+      m_IsSeekingPeak = true;
+      m_CandidateAngle = hipAngle;
+      m_CandidateTime = timeStamp;
+    }
+  }
+
+  // Extrapolate from the last maximum. If no maximum came for two strides,
+  // the patient is not walking anymore
+  GaitPhase phase{timeStamp, -1.0, GaitEvent::NONE};
+  auto elapsed = timeStamp - m_LastPeakTime;
+  if (m_StrideDuration.count() > 0 && elapsed < 2 * m_StrideDuration) {
+    double strides = static_cast<double>(elapsed.count()) /
+                     static_cast<double>(m_StrideDuration.count());
+    phase.percentage = std::fmod(m_PeakPercentage + strides, 1.0);
+    if (phase.percentage < 0.0) {
+      phase.percentage += 1.0;
+    }
+  }
+
+  // A maximum detected later than expected moves the estimation back, maybe
+  // before a heel strike already published. The percentage is held instead,
+  // until the extrapolation catches up, so it never goes backward
+  double previous = m_LastPhase.percentage;
+  if (previous >= 0.0 && phase.percentage >= 0.0) {
+    double backward = std::fmod(previous - phase.percentage + 1.0, 1.0);
+    if (backward > 0.0 && backward < 0.5) {
+      phase.percentage = previous;
+    }
+  }
+
+  // The events are published when the percentage goes over them
+  if (previous >= 0.0 && phase.percentage >= 0.0) {
+    if (phase.percentage < previous &&
+        isNewEvent(m_LastHeelStrikeTime, timeStamp, m_StrideDuration)) {
+      phase.event = GaitEvent::HEEL_STRIKE;
+      m_LastHeelStrikeTime = timeStamp;
+    } else if (previous < m_ToeOffPercentage &&
+               phase.percentage >= m_ToeOffPercentage &&
+               isNewEvent(m_LastToeOffTime, timeStamp, m_StrideDuration)) {
+      phase.event = GaitEvent::TOE_OFF;
+      m_LastToeOffTime = timeStamp;
+    }
+  }
+
+  m_LastPhase = phase;
+  return phase;
+}
+
+double GaitPhaseEstimator::getPercentage() const {
+  return m_LastPhase.percentage;
+}
+
+bool GaitPhaseEstimator::isTracking() const {
+  return m_LastPhase.percentage >= 0.0;
+}
+
+void GaitPhaseEstimator::handlePeak(
+    const std::chrono::microseconds &timeStamp) {
+  if (m_StrideCount == 0) {
+    m_LastPeakTime = timeStamp;
+    m_StrideCount = 1;
+    return;
+  }
+
+  auto interval = timeStamp - m_LastPeakTime;
+  if (m_StrideDuration.count() == 0) {
+    if (interval < MIN_STRIDE_DURATION) {
+      // Most likely noise on the way to the actual maximum
+      return;
+    }
+    if (interval <= MAX_STRIDE_DURATION) {
+      m_StrideDuration = interval;
+    }
+    m_LastPeakTime = timeStamp;
+    m_StrideCount++;
+    return;
+  }
+
+  if (interval < m_StrideDuration / 2) {
+    return;
+  }
+  if (interval <= m_StrideDuration * 3 / 2) {
+    m_StrideDuration += std::chrono::microseconds(static_cast<int64_t>(
+        STRIDE_DURATION_ADAPTATION_RATE *
+        static_cast<double>((interval - m_StrideDuration).count())));
+  } else if (interval > MAX_STRIDE_DURATION) {
+    // The walk was interrupted, the cadence must be learnt again
+    m_StrideDuration = std::chrono::microseconds(0);
+  }
+  m_LastPeakTime = timeStamp;
+  m_StrideCount++;
+}
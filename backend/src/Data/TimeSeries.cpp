@@ -1,5 +1,7 @@
 #include "Data/TimeSeries.h"
 
+#include <algorithm>
+
 using namespace STIMWALKER_NAMESPACE;
 using namespace STIMWALKER_NAMESPACE::data;
 
@@ -21,6 +23,14 @@ void TimeSeries::setRollingVectorMaxSize(size_t maxSize) {
   m_Data.setMaxSize(maxSize);
 }
 
+void TimeSeries::resizeRollingVector(size_t maxSize) {
+  m_Data.resize(maxSize);
+}
+
+size_t TimeSeries::getRollingVectorMaxSize() const {
+  return m_Data.getMaxSize();
+}
+
 void TimeSeries::clear() { m_Data.clear(); }
 
 void TimeSeries::add(const std::chrono::microseconds &timeStamp,
@@ -35,13 +45,25 @@ void TimeSeries::add(const std::vector<double> &data) {
                 zeroLevelData(data))));
 }
 
+void TimeSeries::addAcquiredAt(
+    const std::chrono::high_resolution_clock::time_point &acquisitionTime,
+    const std::vector<double> &data) {
+  add(std::chrono::duration_cast<std::chrono::microseconds>(acquisitionTime -
+                                                            m_StopWatch),
+      data);
+}
+
 const DataPoint &TimeSeries::operator[](size_t index) const {
   return m_Data.at(index);
 }
 
 TimeSeries TimeSeries::tail(size_t n) const {
   TimeSeries data(m_StartingTime);
-  for (size_t i = m_Data.size() - n; i < m_Data.size(); i++) {
+
+  // A rolling vector only holds the last values it was given
+  size_t count = std::min(m_Data.size(), m_Data.getMaxSize());
+  n = std::min(n, count);
+  for (size_t i = count - n; i < count; i++) {
     data.m_Data.push_back(std::move(m_Data[i]));
   }
   return data;
@@ -62,6 +84,51 @@ TimeSeries::since(const std::chrono::system_clock::time_point &time) const {
   return data;
 }
 
+size_t TimeSeries::seedFrom(const TimeSeries &source,
+                            const std::chrono::microseconds &duration) {
+  m_Data.clear();
+  m_StartingTime = source.m_StartingTime;
+  m_StopWatch = source.m_StopWatch;
+
+  size_t count =
+      std::min(source.m_Data.size(), source.m_Data.getMaxSize());
+  if (count == 0 || duration.count() <= 0) {
+    return 0;
+  }
+
+  // The time stamps are sorted, so look for the first one in the window
+  auto firstTimeStamp = source.m_Data[count - 1].getTimeStamp() - duration;
+  size_t first = 0;
+  size_t last = count - 1;
+  while (first < last) {
+    size_t middle = first + (last - first) / 2;
+    if (source.m_Data[middle].getTimeStamp() < firstTimeStamp) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  size_t seedCount = count - first;
+  m_Data.appendTail(source.m_Data, seedCount);
+
+  // Bring the data from the zero level of [source] to the one of this series
+  if (source.m_ZeroLevel != m_ZeroLevel) {
+    for (size_t i = 0; i < seedCount; i++) {
+      std::vector<double> data(m_Data[i].getData());
+      for (size_t j = 0; j < data.size(); j++) {
+        if (j < source.m_ZeroLevel.size()) {
+          data[j] += source.m_ZeroLevel[j];
+        }
+        if (j < m_ZeroLevel.size()) {
+          data[j] -= m_ZeroLevel[j];
+        }
+      }
+      m_Data[i] = DataPoint(m_Data[i].getTimeStamp(), data);
+    }
+  }
+  return seedCount;
+}
+
 nlohmann::json TimeSeries::serialize() const {
   nlohmann::json json = nlohmann::json::object();
   json["startingTime"] = m_StartingTime.time_since_epoch().count();
@@ -115,6 +182,8 @@ TimeSeries::zeroLevelData(const std::vector<double> &data) const {
   return zeroLevelledData;
 }
 
+void TimeSeries::skip(size_t) {}
+
 void TimeSeries::reset() {
   m_Data.clear();
   m_StartingTime = std::chrono::system_clock::now();
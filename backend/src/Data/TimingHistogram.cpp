@@ -0,0 +1,113 @@
+#include "Data/TimingHistogram.h"
+
+#include <algorithm>
+
+using namespace STIMWALKER_NAMESPACE::data;
+
+TimingHistogram::TimingHistogram(const std::chrono::nanoseconds &binWidth,
+                                 size_t binCount)
+    : TimingHistogram(binWidth, binCount,
+                      -std::max(binWidth, std::chrono::nanoseconds(1)) *
+                          static_cast<std::int64_t>(
+                              std::max(binCount, size_t(1)) / 2)) {}
+
+TimingHistogram::TimingHistogram(const std::chrono::nanoseconds &binWidth,
+                                 size_t binCount,
+                                 const std::chrono::nanoseconds &offset)
+    : m_BinWidth(std::max(binWidth, std::chrono::nanoseconds(1))),
+      m_Offset(offset), m_Counts(std::max(binCount, size_t(1)), 0) {
+  clear();
+}
+
+TimingHistogram::TimingHistogram(const nlohmann::json &json)
+    : m_BinWidth(json["binWidth"].get<int64_t>()),
+      m_Offset(json["offset"].get<int64_t>()),
+      m_Counts(json["counts"].get<std::vector<size_t>>()),
+      m_Min(json["min"].get<int64_t>()), m_Max(json["max"].get<int64_t>()),
+      m_Sum(json["sum"].get<int64_t>()), m_Size(json["count"].get<size_t>()) {}
+
+void TimingHistogram::add(const std::chrono::nanoseconds &error) {
+  m_Counts[binIndex(error)]++;
+  m_Min = m_Size == 0 ? error : std::min(m_Min, error);
+  m_Max = m_Size == 0 ? error : std::max(m_Max, error);
+  m_Sum += error;
+  m_Size++;
+}
+
+void TimingHistogram::clear() {
+  std::fill(m_Counts.begin(), m_Counts.end(), 0);
+  m_Min = std::chrono::nanoseconds(0);
+  m_Max = std::chrono::nanoseconds(0);
+  m_Sum = std::chrono::nanoseconds(0);
+  m_Size = 0;
+}
+
+size_t TimingHistogram::size() const { return m_Size; }
+
+std::chrono::nanoseconds TimingHistogram::mean() const {
+  if (m_Size == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  return m_Sum / static_cast<std::int64_t>(m_Size);
+}
+
+std::chrono::nanoseconds TimingHistogram::quantile(double quantile) const {
+  if (m_Size == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  if (quantile <= 0.0) {
+    return m_Min;
+  }
+  if (quantile >= 1.0) {
+    return m_Max;
+  }
+
+  auto target = static_cast<size_t>(quantile * static_cast<double>(m_Size));
+  size_t cumulated = 0;
+  for (size_t i = 0; i < m_Counts.size(); i++) {
+    cumulated += m_Counts[i];
+    if (cumulated > target) {
+      auto center = m_Offset + m_BinWidth * static_cast<std::int64_t>(i) +
+                    m_BinWidth / 2;
+      // The edge bins also count the errors out of the range
+      return std::clamp(center, m_Min, m_Max);
+    }
+  }
+  return m_Max;
+}
+
+nlohmann::json TimingHistogram::serialize() const {
+  nlohmann::json json = nlohmann::json::object();
+  json["binWidth"] = m_BinWidth.count();
+  json["offset"] = m_Offset.count();
+  json["counts"] = m_Counts;
+  json["count"] = m_Size;
+  json["min"] = m_Min.count();
+  json["max"] = m_Max.count();
+  json["sum"] = m_Sum.count();
+  json["mean"] = mean().count();
+  json["median"] = quantile(0.5).count();
+  json["p99"] = quantile(0.99).count();
+  return json;
+}
+
+nlohmann::json TimingHistogram::serializeSummary() const {
+  nlohmann::json json = nlohmann::json::object();
+  json["count"] = m_Size;
+  json["mean"] = mean().count();
+  json["p99"] = quantile(0.99).count();
+  json["max"] = m_Max.count();
+  return json;
+}
+
+size_t TimingHistogram::binIndex(const std::chrono::nanoseconds &error) const {
+  // Floor division, so the bin [-width, 0) is just before the bin [0, width)
+  auto fromOffset = (error - m_Offset).count();
+  auto bin = fromOffset / m_BinWidth.count();
+  if (fromOffset < 0 && fromOffset % m_BinWidth.count() != 0) {
+    bin--;
+  }
+  auto index = std::clamp(bin, std::int64_t(0),
+                          static_cast<std::int64_t>(m_Counts.size()) - 1);
+  return static_cast<size_t>(index);
+}
@@ -0,0 +1,149 @@
+#include "Data/TrialWriter.h"
+
+using namespace STIMWALKER_NAMESPACE::data;
+
+TrialWriter::TrialWriter(size_t queueCapacity,
+                         const std::chrono::milliseconds &flushInterval)
+    : m_FlushInterval(flushInterval), m_PendingBlocks(queueCapacity),
+      m_FreeBlocks(queueCapacity), m_Trial(nullptr), m_IsRunning(false),
+      m_IsWakeRequested(false), m_MaxQueueDepth(0), m_WrittenBlockCount(0),
+      m_WrittenSampleCount(0), m_DroppedBlockCount(0), m_DroppedSampleCount(0),
+      m_BatchCount(0) {}
+
+TrialWriter::~TrialWriter() { stop(); }
+
+void TrialWriter::start(TimeSeries &trial) {
+  stop();
+
+  // Forget any block that missed the previous trial
+  Block block;
+  while (m_PendingBlocks.tryPop(block)) {
+  }
+
+  m_Trial = &trial;
+  m_MaxQueueDepth = 0;
+  m_WrittenBlockCount = 0;
+  m_WrittenSampleCount = 0;
+  m_DroppedBlockCount = 0;
+  m_DroppedSampleCount = 0;
+  m_BatchCount = 0;
+
+  m_IsWakeRequested = false;
+  m_IsRunning = true;
+  m_Writer = std::thread([this]() { writerLoop(); });
+}
+
+void TrialWriter::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_IsRunning = false;
+  }
+  m_Condition.notify_one();
+
+  if (m_Writer.joinable()) {
+    m_Writer.join();
+  }
+}
+
+bool TrialWriter::isRunning() const { return m_IsRunning; }
+
+bool TrialWriter::write(
+    const std::chrono::high_resolution_clock::time_point &acquisitionTime,
+    const std::vector<std::vector<double>> &samples,
+    const std::vector<std::pair<size_t, size_t>> &gaps) {
+  if (!m_IsRunning || samples.empty()) {
+    return false;
+  }
+
+  // Reuse the buffer of a written block if there is one
+  Block block;
+  m_FreeBlocks.tryPop(block);
+  block.acquisitionTime = acquisitionTime;
+  block.sampleCount = samples.size();
+  block.channelCount = samples.front().size();
+  block.values.clear();
+  for (const auto &sample : samples) {
+    block.values.insert(block.values.end(), sample.begin(), sample.end());
+  }
+  block.gaps.assign(gaps.begin(), gaps.end());
+
+  if (!m_PendingBlocks.tryPush(std::move(block))) {
+    m_DroppedBlockCount++;
+    m_DroppedSampleCount += samples.size();
+    return false;
+  }
+
+  size_t depth = m_PendingBlocks.size();
+  if (depth > m_MaxQueueDepth) {
+    m_MaxQueueDepth = depth;
+  }
+
+  // Only bother the writer early if it is falling behind
+  if (depth >= m_PendingBlocks.capacity() / 2) {
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      m_IsWakeRequested = true;
+    }
+    m_Condition.notify_one();
+  }
+  return true;
+}
+
+TrialWriter::Metrics TrialWriter::getMetrics() const {
+  Metrics metrics;
+  metrics.queueDepth = m_PendingBlocks.size();
+  metrics.maxQueueDepth = m_MaxQueueDepth;
+  metrics.queueCapacity = m_PendingBlocks.capacity();
+  metrics.writtenBlockCount = m_WrittenBlockCount;
+  metrics.writtenSampleCount = m_WrittenSampleCount;
+  metrics.droppedBlockCount = m_DroppedBlockCount;
+  metrics.droppedSampleCount = m_DroppedSampleCount;
+  metrics.batchCount = m_BatchCount;
+  return metrics;
+}
+
+void TrialWriter::writerLoop() {
+  while (true) {
+    bool isRunning;
+    {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      m_Condition.wait_for(lock, m_FlushInterval, [this]() {
+        return m_IsWakeRequested || !m_IsRunning;
+      });
+      m_IsWakeRequested = false;
+      isRunning = m_IsRunning;
+    }
+
+    writePendingBlocks();
+    if (!isRunning) {
+      return;
+    }
+  }
+}
+
+void TrialWriter::writePendingBlocks() {
+  Block block;
+  bool hasWritten = false;
+  std::vector<double> sample;
+  while (m_PendingBlocks.tryPop(block)) {
+    auto gap = block.gaps.begin();
+    for (size_t i = 0; i < block.sampleCount; i++) {
+      for (; gap != block.gaps.end() && gap->first == i; gap++) {
+        m_Trial->skip(gap->second);
+      }
+      auto first = block.values.begin() + i * block.channelCount;
+      sample.assign(first, first + block.channelCount);
+      m_Trial->addAcquiredAt(block.acquisitionTime, sample);
+    }
+    m_WrittenBlockCount++;
+    m_WrittenSampleCount += block.sampleCount;
+    hasWritten = true;
+
+    // Give the buffer back to the acquisition thread
+    m_FreeBlocks.tryPush(std::move(block));
+  }
+
+  if (hasWritten) {
+    m_BatchCount++;
+  }
+}
@@ -0,0 +1,155 @@
+#include "Devices/Concrete/LokomatDevice.h"
+
+#include <array>
+#include <cmath>
+#include <thread>
+
+using namespace STIMWALKER_NAMESPACE::devices;
+
+size_t LOKOMAT_CHANNEL_COUNT(25);
+size_t LOKOMAT_ACQUISITION_FREQUENCY(1000);
+std::chrono::microseconds
+    LOKOMAT_FRAME_RATE(1000 * 1000 * 1 / LOKOMAT_ACQUISITION_FREQUENCY);
+size_t LOKOMAT_SAMPLE_COUNT(10);
+
+LokomatDevice::LokomatDevice()
+    : NidaqDevice(LOKOMAT_CHANNEL_COUNT, LOKOMAT_FRAME_RATE,
+                  LOKOMAT_SAMPLE_COUNT) {}
+
+LokomatDevice::LokomatDevice(std::unique_ptr<AnalogInputTask> task)
+    : NidaqDevice(std::move(task), LOKOMAT_CHANNEL_COUNT, LOKOMAT_FRAME_RATE,
+                  LOKOMAT_SAMPLE_COUNT) {}
+
+std::string LokomatDevice::deviceName() const { return "LokomatDevice"; }
+
+std::string LokomatDevice::dataCollectorName() const {
+  return "LokomatDataCollector";
+}
+
+/// ------------ ///
+/// MOCK SECTION ///
+/// ------------ ///
+
+namespace {
+// Fourier series of the sagittal angles over the gait cycle (mean, then the
+// cosine and sine coefficients of each harmonic), fitted on normative data of
+// treadmill walking (deg)
+const std::array<double, 7> HIP_ANGLE_COEFFICIENTS = {
+    12.7, 19.5, -3.32, -1.41, -2.49, -0.4, 1.0};
+const std::array<double, 7> KNEE_ANGLE_COEFFICIENTS = {
+    22.7, -2.93, -21.23, -11.38, 7.54, -1.37, 3.92};
+
+// The value of a Fourier series at the phase [phase] of the cycle
+double fourierSeries(const std::array<double, 7> &coefficients,
+                     double phase) {
+  double value = coefficients[0];
+  for (size_t k = 1; k <= 3; k++) {
+    double angle = 2 * M_PI * k * phase;
+    value += coefficients[2 * k - 1] * std::cos(angle) +
+             coefficients[2 * k] * std::sin(angle);
+  }
+  return value;
+}
+
+// The derivative of a Fourier series with respect to the phase
+double fourierSeriesDerivative(const std::array<double, 7> &coefficients,
+                               double phase) {
+  double value = 0;
+  for (size_t k = 1; k <= 3; k++) {
+    double angle = 2 * M_PI * k * phase;
+    value += 2 * M_PI * k *
+             (-coefficients[2 * k - 1] * std::sin(angle) +
+              coefficients[2 * k] * std::cos(angle));
+  }
+  return value;
+}
+} // namespace
+
+LokomatSimulatorTask::LokomatSimulatorTask(std::chrono::microseconds deltaTime,
+                                           size_t sampleCount)
+    : AnalogInputTask(LOKOMAT_CHANNEL_COUNT, deltaTime, sampleCount),
+      m_StrideDuration(std::chrono::milliseconds(1400)), m_FrameCounter(0),
+      m_RandomGenerator(42) {}
+
+bool LokomatSimulatorTask::open() { return true; }
+
+bool LokomatSimulatorTask::start() {
+  m_FrameCounter = 0;
+  m_StartTime = std::chrono::high_resolution_clock::now();
+  return true;
+}
+
+bool LokomatSimulatorTask::read(std::vector<double> &buffer) {
+  // A block is available once its last frame is sampled
+  std::this_thread::sleep_until(m_StartTime +
+                                m_DeltaTime * (m_FrameCounter + m_SampleCount));
+
+  double deltaTime = std::chrono::duration<double>(m_DeltaTime).count();
+  for (size_t i = 0; i < m_SampleCount; i++) {
+    generateFrame(buffer.data() + i * m_ChannelCount,
+                  static_cast<double>(m_FrameCounter + i) * deltaTime);
+  }
+  m_FrameCounter += m_SampleCount;
+  return true;
+}
+
+void LokomatSimulatorTask::generateFrame(double *frame, double time) {
+  std::normal_distribution<double> angleNoise(0.0, 0.2);
+  std::normal_distribution<double> torqueNoise(0.0, 0.5);
+  std::normal_distribution<double> voltageNoise(0.0, 0.005);
+
+  double strideDuration =
+      std::chrono::duration<double>(m_StrideDuration).count();
+  double leftPhase = std::fmod(time / strideDuration, 1.0);
+  std::array<double, 2> phases = {leftPhase, std::fmod(leftPhase + 0.5, 1.0)};
+
+  for (size_t leg = 0; leg < 2; leg++) {
+    double phase = phases[leg];
+    double hipVelocity =
+        fourierSeriesDerivative(HIP_ANGLE_COEFFICIENTS, phase) / strideDuration;
+    double kneeVelocity =
+        fourierSeriesDerivative(KNEE_ANGLE_COEFFICIENTS, phase) /
+        strideDuration;
+
+    frame[2 * leg] = fourierSeries(HIP_ANGLE_COEFFICIENTS, phase) +
+                     angleNoise(m_RandomGenerator);
+    frame[2 * leg + 1] = fourierSeries(KNEE_ANGLE_COEFFICIENTS, phase) +
+                         angleNoise(m_RandomGenerator);
+
+    // The patient mostly follows the orthosis, the interaction torques resist
+    // the motion a little
+    frame[4 + 2 * leg] = -0.05 * hipVelocity + torqueNoise(m_RandomGenerator);
+    frame[4 + 2 * leg + 1] =
+        -0.03 * kneeVelocity + torqueNoise(m_RandomGenerator);
+
+    frame[8 + 2 * leg] = hipVelocity;
+    frame[8 + 2 * leg + 1] = kneeVelocity;
+
+    frame[15 + leg] = phase;
+    frame[17 + leg] = phase * strideDuration < 0.01 ? 5.0 : 0.0;
+  }
+
+  // The pelvis rises and falls twice per stride, which loads the body weight
+  // support at the double supports
+  double doubleStepAngle = 4 * M_PI * leftPhase;
+  frame[12] = 2.0;
+  frame[13] = 30.0 + 1.5 * std::cos(doubleStepAngle);
+  frame[14] = 20.0 * std::cos(doubleStepAngle);
+
+  for (size_t i = 19; i < m_ChannelCount; i++) {
+    frame[i] = voltageNoise(m_RandomGenerator);
+  }
+}
+
+LokomatDeviceMock::LokomatDeviceMock()
+    : LokomatDevice(std::make_unique<LokomatSimulatorTask>(
+          LOKOMAT_FRAME_RATE, LOKOMAT_SAMPLE_COUNT)) {}
+
+bool LokomatDeviceMock::handleConnect() {
+  if (shouldFailToConnect) {
+    // Simulate a failure to connect after few time
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return false;
+  }
+  return LokomatDevice::handleConnect();
+}
@@ -8,6 +8,7 @@
 #include <filesystem>
 #include <fstream>
 #endif // _WIN32
+#include <algorithm>
 #include <regex>
 #include <thread>
 
@@ -22,23 +23,113 @@ std::unique_ptr<MagstimRapidDevice> MagstimRapidDevice::findMagstimDevice() {
 }
 
 MagstimRapidDevice::MagstimRapidDevice(const std::string &port)
-    : m_IsArmed(false), m_ArmedPokeInterval(std::chrono::milliseconds(500)),
-      m_DisarmedPokeInterval(std::chrono::milliseconds(5000)),
-      UsbDevice(port, "067B", "2303") {
+    : UsbDevice(port, "067B", "2303"), m_IsArmed(false),
+      m_ArmedPokeInterval(std::chrono::milliseconds(500)),
+      m_DisarmedPokeInterval(std::chrono::milliseconds(5000)), m_Power(0),
+      m_ResponseTimeout(std::chrono::milliseconds(500)) {
   m_KeepDeviceWorkerAliveInterval = m_DisarmedPokeInterval;
+  m_FrameDecoder = std::make_unique<MagstimRapidFrameDecoder>();
+  m_ReadTimeout = std::chrono::milliseconds(100);
 }
 
-MagstimRapidDevice::~MagstimRapidDevice() { stopDeviceWorkers(); }
+MagstimRapidDevice::~MagstimRapidDevice() {
+  stopDeviceWorkers();
+  stopSerialPortWorker();
+}
 
 std::string MagstimRapidDevice::deviceName() const {
   return "MagstimRapidDevice";
 }
 
+bool MagstimRapidDevice::disconnect() {
+  if (m_IsConnected) {
+    std::lock_guard<std::mutex> lock(m_AsyncDeviceMutex);
+
+    // Leave the stimulator disarmed and back in local control
+    if (m_IsArmed) {
+      request("EA");
+      m_IsArmed = false;
+      addEventMarker(data::EventMarkerType::STIMULATOR_DISARMED);
+    }
+    request("R@");
+  }
+
+  return UsbDevice::disconnect();
+}
+
+bool MagstimRapidDevice::trigger() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (!m_IsConnected || !m_IsArmed) {
+    logger.warning("Cannot trigger the device " + deviceName() +
+                   " because it is not armed");
+    return false;
+  }
+
+  if (!write("EH", nullptr)) {
+    return false;
+  }
+  addEventMarker(data::EventMarkerType::STIMULATION_PULSE, m_Power);
+  return true;
+}
+
+bool MagstimRapidDevice::getIsArmed() const { return m_IsArmed; }
+
+int MagstimRapidDevice::getPower() const { return m_Power; }
+
+size_t MagstimRapidDevice::responseLength(char firstCharacter,
+                                          char secondCharacter) {
+  switch (firstCharacter) {
+  case '?':
+    // Invalid command error
+    return 3;
+  case 'F':
+  case 'Q':
+  case 'R':
+  case 'E':
+  case '@':
+    break;
+  default:
+    return 0;
+  }
+
+  if (secondCharacter == '?' || secondCharacter == 'S') {
+    // Invalid data and system conflict errors take the place of the response
+    return 3;
+  }
+  // Status, then for [F] the temperature of both coils in tenths of degree
+  return firstCharacter == 'F' ? 9 : 3;
+}
+
+bool MagstimRapidDevice::handleConnect() {
+  auto &logger = utils::Logger::getInstance();
+
+  {
+    std::lock_guard<std::mutex> lock(m_PendingResponsesMutex);
+    m_PendingResponses.clear();
+  }
+  try {
+    if (!UsbDevice::handleConnect()) {
+      return false;
+    }
+  } catch (const std::exception &e) {
+    logger.fatal("Could not open the port " + m_Port + ": " + e.what());
+    return false;
+  }
+
+  // The stimulator only accepts commands once it is under remote control
+  m_IsArmed = false;
+  if (request("Q@").empty()) {
+    UsbDevice::handleDisconnect();
+    return false;
+  }
+  return true;
+}
+
 DeviceResponses
 MagstimRapidDevice::parseAsyncSendCommand(const DeviceCommands &command,
                                           const std::any &data) {
   auto &logger = utils::Logger::getInstance();
-  std::string commandString;
   std::string response;
 
   try {
@@ -49,54 +140,60 @@ MagstimRapidDevice::parseAsyncSendCommand(const DeviceCommands &command,
       return DeviceResponses::OK;
 
     case MagstimRapidCommands::POKE:
+      // Renew the remote control, otherwise the stimulator disarms itself
       logger.info("Sent command: " + std::any_cast<std::string>(data));
-      break;
+      return request("Q@").empty() ? DeviceResponses::NOK
+                                   : DeviceResponses::OK;
 
     case MagstimRapidCommands::GET_TEMPERATURE:
       // We do not need to check if the system is armed for this command
-      commandString = "F@";
-      // asio::write(*m_SerialPort,
-      //             asio::buffer(commandString + computeCRC(commandString)));
-
-      // Wait for the response (9 bytes)
-      // response = std::string(9, '\0');
-
-      // asio::read(*m_SerialPort, asio::buffer(response));
-      return 42;
+      response = request("F@");
+      if (response.empty()) {
+        return DeviceResponses::NOK;
+      }
+      // The temperature of the first coil, in tenths of degree
+      return std::stoi(response.substr(2, 3)) / 10;
 
     case MagstimRapidCommands::SET_FAST_COMMUNICATION:
       setFastCommunication(std::any_cast<bool>(data));
       return DeviceResponses::OK;
 
-    case MagstimRapidCommands::ARM:
-      if (m_IsArmed) {
-        logger.warning("The device is already armed");
+    case MagstimRapidCommands::SET_POWER: {
+      int power = std::any_cast<int>(data);
+      if (power < 0 || power > 100) {
+        logger.warning("The power must be between 0 and 100, got " +
+                       std::to_string(power));
         return DeviceResponses::NOK;
       }
-      m_IsArmed = command.getValue() == MagstimRapidCommands::ARM;
 
-      changePokeInterval(std::chrono::milliseconds(
-          m_IsArmed ? m_ArmedPokeInterval : m_DisarmedPokeInterval));
-
-      logger.info(
-          std::string(m_IsArmed ? "Armed" : "Disarmed") +
-          " the system and changed poke interval to " +
-          std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
-                             m_KeepDeviceWorkerAliveInterval)
-                             .count()) +
-          " ms");
+      std::string powerString = std::to_string(power);
+      powerString.insert(0, 3 - powerString.size(), '0');
+      if (request("@" + powerString).empty()) {
+        return DeviceResponses::NOK;
+      }
+      m_Power = power;
+      logger.info("Set the power to " + std::to_string(power) + "%");
       return DeviceResponses::OK;
+    }
 
-    case MagstimRapidCommands::DISARM:
-      if (!m_IsArmed) {
-        logger.warning("The device is already disarmed");
+    case MagstimRapidCommands::ARM:
+    case MagstimRapidCommands::DISARM: {
+      bool shouldArm = command.getValue() == MagstimRapidCommands::ARM;
+      if (m_IsArmed == shouldArm) {
+        logger.warning(std::string("The device is already ") +
+                       (shouldArm ? "armed" : "disarmed"));
         return DeviceResponses::NOK;
       }
 
-      m_IsArmed = command.getValue() == MagstimRapidCommands::ARM;
+      if (request(shouldArm ? "EB" : "EA").empty()) {
+        return DeviceResponses::NOK;
+      }
+      m_IsArmed = shouldArm;
 
       changePokeInterval(std::chrono::milliseconds(
           m_IsArmed ? m_ArmedPokeInterval : m_DisarmedPokeInterval));
+      addEventMarker(m_IsArmed ? data::EventMarkerType::STIMULATOR_ARMED
+                               : data::EventMarkerType::STIMULATOR_DISARMED);
 
       logger.info(
           std::string(m_IsArmed ? "Armed" : "Disarmed") +
@@ -107,6 +204,7 @@ MagstimRapidDevice::parseAsyncSendCommand(const DeviceCommands &command,
           " ms");
       return DeviceResponses::OK;
     }
+    }
   } catch (const std::exception &e) {
     logger.fatal("Error: " + std::string(e.what()));
     return DeviceResponses::NOK;
@@ -119,6 +217,137 @@ void MagstimRapidDevice::pingDeviceWorker() {
   parseAsyncSendCommand(MagstimRapidCommands::POKE, std::string("POKE"));
 }
 
+std::string MagstimRapidDevice::request(const std::string &command) {
+  auto &logger = utils::Logger::getInstance();
+
+  auto promise = std::make_shared<std::promise<std::string>>();
+  auto future = promise->get_future();
+  if (!write(command, promise)) {
+    return "";
+  }
+
+  if (future.wait_for(m_ResponseTimeout) != std::future_status::ready) {
+    logger.fatal("The device " + deviceName() +
+                 " did not answer the command " + command);
+    std::lock_guard<std::mutex> lock(m_PendingResponsesMutex);
+    m_PendingResponses.erase(
+        std::remove_if(m_PendingResponses.begin(), m_PendingResponses.end(),
+                       [&promise](const PendingResponse &pending) {
+                         return pending.promise == promise;
+                       }),
+        m_PendingResponses.end());
+    return "";
+  }
+
+  auto response = future.get();
+  if (response[0] == '?') {
+    logger.fatal("The device " + deviceName() +
+                 " did not recognize the command " + command);
+    return "";
+  }
+  switch (response[1]) {
+  case '?':
+    logger.fatal("The device " + deviceName() +
+                 " received invalid data with the command " + command);
+    return "";
+  case 'S':
+    logger.fatal("The device " + deviceName() +
+                 " cannot execute the command " + command + " in its state");
+    return "";
+  default:
+    return response;
+  }
+}
+
+bool MagstimRapidDevice::write(
+    const std::string &command,
+    std::shared_ptr<std::promise<std::string>> promise) {
+  std::lock_guard<std::mutex> lock(m_WriteMutex);
+  {
+    std::lock_guard<std::mutex> pendingLock(m_PendingResponsesMutex);
+    m_PendingResponses.push_back(PendingResponse{command[0], promise});
+  }
+
+  try {
+    writeToDevice(command + computeCrc(command));
+  } catch (const std::exception &e) {
+    utils::Logger::getInstance().fatal("Could not write to the device " +
+                                       deviceName() + ": " + e.what());
+    std::lock_guard<std::mutex> pendingLock(m_PendingResponsesMutex);
+    m_PendingResponses.pop_back();
+    return false;
+  }
+  return true;
+}
+
+void MagstimRapidDevice::handleReceivedFrame(const std::string &response) {
+  auto &logger = utils::Logger::getInstance();
+
+  std::shared_ptr<std::promise<std::string>> promise;
+  {
+    std::lock_guard<std::mutex> lock(m_PendingResponsesMutex);
+
+    // The responses come in the order of the commands (errors take the place
+    // of the response), so the commands before this one lost their response
+    bool isError = response[0] == '?' || response[1] == '?' ||
+                   response[1] == 'S';
+    while (!isError && !m_PendingResponses.empty() &&
+           m_PendingResponses.front().command != response[0]) {
+      logger.warning("The device " + deviceName() +
+                     " did not answer a command " +
+                     std::string(1, m_PendingResponses.front().command));
+      m_PendingResponses.pop_front();
+    }
+    if (m_PendingResponses.empty()) {
+      logger.warning("The device " + deviceName() +
+                     " sent an unexpected response");
+      return;
+    }
+
+    promise = m_PendingResponses.front().promise;
+    m_PendingResponses.pop_front();
+  }
+
+  if (promise != nullptr) {
+    promise->set_value(response);
+  }
+}
+
+SerialFrameDecoder::Status
+MagstimRapidFrameDecoder::decode(const utils::ByteRingBuffer &buffer,
+                                 size_t &length) {
+  if (buffer.size() < 2) {
+    if (MagstimRapidDevice::responseLength(buffer[0], 0) == 0) {
+      // Not the start of a response, skip to the next byte
+      length = 1;
+      return Status::SKIP;
+    }
+    // The length depends on the second byte (errors are shorter)
+    return Status::INCOMPLETE;
+  }
+
+  length = MagstimRapidDevice::responseLength(buffer[0], buffer[1]);
+  if (length == 0) {
+    // Not the start of a response, skip to the next byte
+    length = 1;
+    return Status::SKIP;
+  }
+  if (buffer.size() < length) {
+    // Wait for the rest of the response
+    return Status::INCOMPLETE;
+  }
+
+  auto response = buffer.peek(0, length);
+  if (MagstimRapidDevice::computeCrc(response.substr(0, length - 1)) !=
+      response.substr(length - 1)) {
+    utils::Logger::getInstance().warning(
+        "The device MagstimRapidDevice sent a response with a wrong CRC");
+    length = 1;
+    return Status::SKIP;
+  }
+  return Status::FRAME;
+}
+
 std::string MagstimRapidDevice::computeCrc(const std::string &data) {
   // Convert the command string to sum of ASCII/byte values
   int commandSum = 0;
@@ -153,6 +382,8 @@ void MagstimRapidDevice::changePokeInterval(
 MagstimRapidDeviceMock::MagstimRapidDeviceMock(const std::string &port)
     : MagstimRapidDevice(port) {}
 
+MagstimRapidDeviceMock::~MagstimRapidDeviceMock() { stopDeviceWorkers(); }
+
 std::unique_ptr<MagstimRapidDeviceMock>
 MagstimRapidDeviceMock::findMagstimDevice() {
   return std::make_unique<MagstimRapidDeviceMock>("MOCK");
@@ -173,6 +404,32 @@ void MagstimRapidDeviceMock::setFastCommunication(bool isFast) {
   }
 }
 
+void MagstimRapidDeviceMock::writeToDevice(const std::string &bytes) {
+  // Remove the CRC
+  auto command = bytes.substr(0, bytes.size() - 1);
+  if (command == "EB") {
+    isStimulatorArmed = true;
+  } else if (command == "EA") {
+    isStimulatorArmed = false;
+  } else if (command == "EH") {
+    pulseCount++;
+  }
+
+  std::string response(1, command[0]);
+  response += static_cast<char>(
+      static_cast<std::uint8_t>(Status::REMOTE_CONTROL) |
+      static_cast<std::uint8_t>(Status::COIL_PRESENT) |
+      (isStimulatorArmed ? static_cast<std::uint8_t>(Status::ARMED) |
+                               static_cast<std::uint8_t>(Status::READY)
+                         : static_cast<std::uint8_t>(Status::STANDBY)));
+  if (command[0] == 'F') {
+    // 42.0 degrees for the first coil, no second coil
+    response += "420000";
+  }
+  response += computeCrc(response);
+  handleReceivedBytes(response.data(), response.size());
+}
+
 bool MagstimRapidDeviceMock::handleConnect() {
   // Simulate a successful connection after some time
   std::this_thread::sleep_for(std::chrono::milliseconds(50));
@@ -1,24 +1,69 @@
 #include "Devices/Concrete/NidaqDevice.h"
 
+#include "Data/FixedTimeSeries.h"
 #include "Devices/Exceptions.h"
+#include "Utils/Logger.h"
 
-#include <iostream>
 using namespace STIMWALKER_NAMESPACE::devices;
 
+// The reads block until the card has a whole block, so the data worker can
+// check again right away
+std::chrono::microseconds NIDAQ_DATA_COLLECTOR_TIMER(5);
+
+NidaqDevice::AnalogInputTask::AnalogInputTask(
+    size_t channelCount, std::chrono::microseconds deltaTime,
+    size_t sampleCount)
+    : m_ChannelCount(channelCount), m_DeltaTime(deltaTime),
+      m_SampleCount(sampleCount) {}
+
+bool NidaqDevice::AnalogInputTask::open() {
+  utils::Logger::getInstance().fatal(
+      "The NI-DAQmx driver is not available, cannot open the acquisition "
+      "task");
+  return false;
+}
+
+void NidaqDevice::AnalogInputTask::close() {}
+
+bool NidaqDevice::AnalogInputTask::start() { return false; }
+
+void NidaqDevice::AnalogInputTask::stop() {}
+
+bool NidaqDevice::AnalogInputTask::read(
+    [[maybe_unused]] std::vector<double> &buffer) {
+  return false;
+}
+
 NidaqDevice::NidaqDevice(size_t channelCount,
-                         const std::chrono::microseconds &dataCheckIntervals)
-    : AsyncDevice(dataCheckIntervals), DataCollector(channelCount, []() {
-        return std::make_unique<data::TimeSeries>();
-      }) {}
+                         std::chrono::microseconds deltaTime,
+                         size_t sampleCount)
+    : NidaqDevice(std::make_unique<AnalogInputTask>(channelCount, deltaTime,
+                                                    sampleCount),
+                  channelCount, deltaTime, sampleCount) {}
 
-NidaqDevice::~NidaqDevice() {
-  if (m_IsStreamingData) {
-    stopDataStreaming();
-  }
+NidaqDevice::NidaqDevice(std::unique_ptr<AnalogInputTask> task,
+                         size_t channelCount,
+                         std::chrono::microseconds deltaTime,
+                         size_t sampleCount)
+    : AsyncDevice(std::chrono::milliseconds(100)),
+      AsyncDataCollector(channelCount, NIDAQ_DATA_COLLECTOR_TIMER,
+                         [deltaTime]() {
+                           return std::make_unique<data::FixedTimeSeries>(
+                               deltaTime);
+                         }),
+      m_DeltaTime(deltaTime), m_SampleCount(sampleCount),
+      m_Task(std::move(task)), m_DataBuffer(channelCount * sampleCount) {
+  m_DataCheckWaitsForDevice = true;
+  setSamplePeriod(deltaTime);
+}
 
+NidaqDevice::~NidaqDevice() {
   if (m_IsConnected) {
     disconnect();
   }
+
+  stopDataCollectorWorkers();
+  stopDeviceWorkers();
 }
 
 std::string NidaqDevice::deviceName() const { return "NidaqDevice"; }
@@ -27,24 +72,30 @@ std::string NidaqDevice::dataCollectorName() const {
   return "NidaqDataCollector";
 }
 
-bool NidaqDevice::handleConnect() {
-  // TODO Implement the connection to the device
-  return false;
-}
+bool NidaqDevice::handleConnect() { return m_Task->open(); }
 
 bool NidaqDevice::handleDisconnect() {
-  // TODO Implement the disconnection from the device
-  return false;
+  if (m_IsStreamingData) {
+    stopDataStreaming();
+  }
+
+  m_Task->close();
+  return true;
 }
 
 bool NidaqDevice::handleStartDataStreaming() {
-  // TODO Implement the start recording
-  return false;
+  if (!m_IsConnected) {
+    utils::Logger::getInstance().fatal(
+        "Cannot start the acquisition of the device " + deviceName() +
+        " because it is not connected");
+    return false;
+  }
+  return m_Task->start();
 }
 
 bool NidaqDevice::handleStopDataStreaming() {
-  // TODO Implement the stop recording
-  return false;
+  m_Task->stop();
+  return true;
 }
 
 void NidaqDevice::handleNewData(const data::DataPoint &data) {
@@ -57,3 +108,24 @@ NidaqDevice::parseAsyncSendCommand(const DeviceCommands &command,
   throw InvalidMethodException(
       "This method should not be called for NidaqDevice");
 }
+
+void NidaqDevice::dataCheck() {
+  if (!m_Task->read(m_DataBuffer)) {
+    // A read interrupted by the end of the acquisition is not a loss
+    if (m_IsStreamingData) {
+      reportDroppedSamples(m_SampleCount,
+                           data::AcquisitionStatistics::GapReason::FAILED_READ);
+    }
+    return;
+  }
+
+  // The card interleaves the channels, so each frame is a contiguous slice
+  std::vector<std::vector<double>> dataPoints;
+  dataPoints.reserve(m_SampleCount);
+  for (size_t i = 0; i < m_SampleCount; i++) {
+    dataPoints.emplace_back(m_DataBuffer.begin() + i * m_DataChannelCount,
+                            m_DataBuffer.begin() +
+                                (i + 1) * m_DataChannelCount);
+  }
+  addDataPoints(dataPoints);
+}
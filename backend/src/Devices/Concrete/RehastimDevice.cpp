@@ -0,0 +1,1030 @@
+#include "Devices/Concrete/RehastimDevice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include "Data/EventMarkers.h"
+#include "Utils/Logger.h"
+
+using namespace STIMWALKER_NAMESPACE;
+using namespace STIMWALKER_NAMESPACE::devices;
+
+namespace {
+const std::uint8_t START_BYTE(0xF0);
+const std::uint8_t STUFFING_BYTE(0x81);
+const std::uint8_t STOP_BYTE(0x0F);
+const std::uint8_t STUFFING_KEY(0x55);
+
+// The start byte, the stuffed CRC and length and the stop byte
+const size_t FRAME_OVERHEAD(6);
+
+// The start byte and the stuffed CRC and length
+const size_t HEADER_LENGTH(5);
+
+const std::uint16_t MAX_PULSE_WIDTH(500);
+const std::uint8_t MAX_CURRENT(127);
+
+const std::uint8_t CRC_TABLE[256] = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31,
+    0x24, 0x23, 0x2A, 0x2D, 0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65,
+    0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D, 0xE0, 0xE7, 0xEE, 0xE9,
+    0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+    0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1,
+    0xB4, 0xB3, 0xBA, 0xBD, 0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2,
+    0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA, 0xB7, 0xB0, 0xB9, 0xBE,
+    0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+    0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16,
+    0x03, 0x04, 0x0D, 0x0A, 0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42,
+    0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A, 0x89, 0x8E, 0x87, 0x80,
+    0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+    0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8,
+    0xDD, 0xDA, 0xD3, 0xD4, 0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C,
+    0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44, 0x19, 0x1E, 0x17, 0x10,
+    0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+    0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F,
+    0x6A, 0x6D, 0x64, 0x63, 0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B,
+    0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13, 0xAE, 0xA9, 0xA0, 0xA7,
+    0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+    0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF,
+    0xFA, 0xFD, 0xF4, 0xF3};
+
+bool needsStuffing(std::uint8_t byte) {
+  return byte == START_BYTE || byte == STUFFING_BYTE || byte == STOP_BYTE;
+}
+
+// The coded time of the channel-list mode: (time - offset) in steps of 0.5 ms
+std::uint16_t codeTime(const std::chrono::microseconds &time,
+                       const std::chrono::microseconds &offset) {
+  return static_cast<std::uint16_t>((time - offset).count() / 500);
+}
+} // namespace
+
+RehastimDevice::RehastimDevice(const std::string &port)
+    : SerialPortDevice(port, std::chrono::milliseconds(500),
+                       SerialPortSettings{
+                           460800, 8, asio::serial_port_base::parity::even,
+                           asio::serial_port_base::stop_bits::one,
+                           asio::serial_port_base::flow_control::none}),
+      m_StimulationPeriod(std::chrono::milliseconds(25)),
+      m_GroupTime(std::chrono::milliseconds(8)), m_ActiveChannels(0xFF),
+      m_ResponseTimeout(std::chrono::milliseconds(500)), m_PacketNumber(0),
+      m_IsStimulating(false), m_IsUpdateScheduled(false),
+      m_RunningChannels(0), m_RunningPeriod(std::chrono::milliseconds(25)),
+      m_UpdateCount(0), m_AcknowledgedUpdateCount(0), m_ErrorCount(0) {
+  m_StimulatorChannelCount = CHANNEL_COUNT;
+  for (auto &pulse : m_Pulses) {
+    pulse.pulseWidth = 250;
+  }
+  m_FrameDecoder = std::make_unique<RehastimFrameDecoder>();
+  m_ReadTimeout = std::chrono::milliseconds(100);
+  m_UpdateTimer = std::make_unique<asio::steady_timer>(*m_SerialPortContext);
+}
+
+RehastimDevice::~RehastimDevice() {
+  stopDeviceWorkers();
+  stopSerialPortWorker();
+  m_UpdateTimer.reset();
+}
+
+std::string RehastimDevice::deviceName() const { return "RehastimDevice"; }
+
+bool RehastimDevice::disconnect() {
+  if (m_IsConnected) {
+    std::lock_guard<std::mutex> lock(m_AsyncDeviceMutex);
+
+    // Do not leave the stimulator stimulating
+    if (getIsStimulating()) {
+      stopChannelListMode();
+    }
+  }
+
+  return SerialPortDevice::disconnect();
+}
+
+void RehastimDevice::stimulate() {
+  auto &logger = utils::Logger::getInstance();
+
+  std::vector<std::pair<size_t, RehastimPulse>> pulses;
+  {
+    std::lock_guard<std::mutex> lock(m_PulsesMutex);
+    if (m_IsStimulating) {
+      logger.warning("Cannot deliver single pulses with the device {} while "
+                     "the channel-list mode runs",
+                     deviceName());
+      return;
+    }
+    for (size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+      if ((m_ActiveChannels >> channel & 1) && m_Pulses[channel].current > 0) {
+        pulses.push_back({channel, m_Pulses[channel]});
+      }
+    }
+  }
+
+  for (const auto &[channel, pulse] : pulses) {
+    std::string data;
+    data += static_cast<char>(channel);
+    data += static_cast<char>(pulse.pulseWidth >> 8 & 0x01);
+    data += static_cast<char>(pulse.pulseWidth & 0xFF);
+    data += static_cast<char>(pulse.current);
+    if (!write(ProtocolCommand::SINGLE_PULSE, data)) {
+      return;
+    }
+    addEventMarker(data::EventMarkerType::STIMULATION_PULSE, pulse.current);
+  }
+}
+
+void RehastimDevice::setChannelAmplitudes(
+    const std::vector<size_t> &channels,
+    const std::vector<double> &amplitudes) {
+  std::lock_guard<std::mutex> lock(m_PulsesMutex);
+  for (size_t i = 0; i < channels.size(); i++) {
+    if (channels[i] >= CHANNEL_COUNT) {
+      utils::Logger::getInstance().warning(
+          "The device {} has no channel {}", deviceName(), channels[i]);
+      continue;
+    }
+    m_Pulses[channels[i]].current = static_cast<std::uint8_t>(
+        std::clamp(std::round(amplitudes[i]), 0.0,
+                   static_cast<double>(MAX_CURRENT)));
+  }
+  scheduleUpdate();
+}
+
+void RehastimDevice::setChannelPulses(
+    const std::vector<size_t> &channels,
+    const std::vector<RehastimPulse> &pulses) {
+  std::lock_guard<std::mutex> lock(m_PulsesMutex);
+  for (size_t i = 0; i < channels.size(); i++) {
+    if (channels[i] >= CHANNEL_COUNT) {
+      utils::Logger::getInstance().warning(
+          "The device {} has no channel {}", deviceName(), channels[i]);
+      continue;
+    }
+    auto &pulse = m_Pulses[channels[i]];
+    pulse = pulses[i];
+    pulse.pulseWidth = std::min(pulse.pulseWidth, MAX_PULSE_WIDTH);
+    pulse.current = std::min(pulse.current, MAX_CURRENT);
+  }
+  scheduleUpdate();
+}
+
+RehastimPulse RehastimDevice::getChannelPulse(size_t channel) const {
+  std::lock_guard<std::mutex> lock(m_PulsesMutex);
+  return m_Pulses.at(channel);
+}
+
+bool RehastimDevice::getIsStimulating() const {
+  std::lock_guard<std::mutex> lock(m_PulsesMutex);
+  return m_IsStimulating;
+}
+
+size_t RehastimDevice::getUpdateCount() const {
+  std::lock_guard<std::mutex> lock(m_PulsesMutex);
+  return m_UpdateCount;
+}
+
+size_t RehastimDevice::getAcknowledgedUpdateCount() const {
+  std::lock_guard<std::mutex> lock(m_PulsesMutex);
+  return m_AcknowledgedUpdateCount;
+}
+
+size_t RehastimDevice::getErrorCount() const {
+  std::lock_guard<std::mutex> lock(m_PulsesMutex);
+  return m_ErrorCount;
+}
+
+std::string RehastimDevice::encodeFrame(std::uint8_t packetNumber,
+                                        ProtocolCommand command,
+                                        const std::string &data) {
+  std::string payload;
+  payload.reserve(2 * (data.size() + 2));
+  auto append = [&payload](std::uint8_t byte) {
+    if (needsStuffing(byte)) {
+      payload += static_cast<char>(STUFFING_BYTE);
+      byte ^= STUFFING_KEY;
+    }
+    payload += static_cast<char>(byte);
+  };
+  append(packetNumber);
+  append(static_cast<std::uint8_t>(command));
+  for (auto byte : data) {
+    append(static_cast<std::uint8_t>(byte));
+  }
+
+  // The CRC and the length are those of the stuffed payload, and are always
+  // sent stuffed
+  std::string frame;
+  frame.reserve(payload.size() + FRAME_OVERHEAD);
+  frame += static_cast<char>(START_BYTE);
+  frame += static_cast<char>(STUFFING_BYTE);
+  frame += static_cast<char>(computeCrc(payload.data(), payload.size()) ^
+                             STUFFING_KEY);
+  frame += static_cast<char>(STUFFING_BYTE);
+  frame += static_cast<char>(payload.size() ^ STUFFING_KEY);
+  frame += payload;
+  frame += static_cast<char>(STOP_BYTE);
+  return frame;
+}
+
+bool RehastimDevice::decodeFrame(const std::string &frame,
+                                 std::uint8_t &packetNumber,
+                                 ProtocolCommand &command, std::string &data) {
+  if (frame.size() < FRAME_OVERHEAD + 2 ||
+      static_cast<std::uint8_t>(frame[0]) != START_BYTE ||
+      static_cast<std::uint8_t>(frame[1]) != STUFFING_BYTE ||
+      static_cast<std::uint8_t>(frame[3]) != STUFFING_BYTE ||
+      static_cast<std::uint8_t>(frame.back()) != STOP_BYTE) {
+    return false;
+  }
+
+  size_t length = static_cast<std::uint8_t>(frame[4]) ^ STUFFING_KEY;
+  if (length != frame.size() - FRAME_OVERHEAD) {
+    return false;
+  }
+  const char *payload = frame.data() + 5;
+  if ((static_cast<std::uint8_t>(frame[2]) ^ STUFFING_KEY) !=
+      computeCrc(payload, length)) {
+    return false;
+  }
+
+  std::string unstuffed;
+  unstuffed.reserve(length);
+  for (size_t i = 0; i < length; i++) {
+    auto byte = static_cast<std::uint8_t>(payload[i]);
+    if (byte == STUFFING_BYTE) {
+      if (++i == length) {
+        return false;
+      }
+      byte = static_cast<std::uint8_t>(payload[i]) ^ STUFFING_KEY;
+    }
+    unstuffed += static_cast<char>(byte);
+  }
+  if (unstuffed.size() < 2) {
+    return false;
+  }
+
+  packetNumber = static_cast<std::uint8_t>(unstuffed[0]);
+  command = static_cast<ProtocolCommand>(unstuffed[1]);
+  data = unstuffed.substr(2);
+  return true;
+}
+
+std::uint8_t RehastimDevice::computeCrc(const char *bytes, size_t count) {
+  std::uint8_t crc = 0;
+  for (size_t i = 0; i < count; i++) {
+    crc = CRC_TABLE[crc ^ static_cast<std::uint8_t>(bytes[i])];
+  }
+  return crc;
+}
+
+bool RehastimDevice::handleConnect() {
+  auto &logger = utils::Logger::getInstance();
+
+  {
+    std::lock_guard<std::mutex> lock(m_PendingResponsesMutex);
+    m_PendingResponses.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_PulsesMutex);
+    m_IsStimulating = false;
+    m_IsUpdateScheduled = false;
+  }
+  try {
+    if (!SerialPortDevice::handleConnect()) {
+      return false;
+    }
+  } catch (const std::exception &e) {
+    logger.fatal("Could not open the port " + m_Port + ": " + e.what());
+    return false;
+  }
+
+  // A stimulator left in the channel-list mode (e.g. by a previous session)
+  // goes back to its start mode
+  auto mode = request(ProtocolCommand::GET_STIMULATION_MODE);
+  if (!mode) {
+    SerialPortDevice::handleDisconnect();
+    return false;
+  }
+  if (!mode->data.empty() && mode->data[0] != 0 && !stopChannelListMode()) {
+    SerialPortDevice::handleDisconnect();
+    return false;
+  }
+  return true;
+}
+
+void RehastimDevice::pingDeviceWorker() {
+  parseAsyncSendCommand(RehastimCommands::WATCHDOG, std::string("WATCHDOG"));
+}
+
+DeviceResponses
+RehastimDevice::parseAsyncSendCommand(const DeviceCommands &command,
+                                      [[maybe_unused]] const std::any &data) {
+  auto &logger = utils::Logger::getInstance();
+
+  try {
+    switch (command.getValue()) {
+    case RehastimCommands::START_STIMULATION:
+      if (getIsStimulating()) {
+        logger.warning("The device {} is already stimulating", deviceName());
+        return DeviceResponses::NOK;
+      }
+      return startChannelListMode() ? DeviceResponses::OK
+                                    : DeviceResponses::NOK;
+
+    case RehastimCommands::STOP_STIMULATION:
+      if (!getIsStimulating()) {
+        logger.warning("The device {} is not stimulating", deviceName());
+        return DeviceResponses::NOK;
+      }
+      return stopChannelListMode() ? DeviceResponses::OK
+                                   : DeviceResponses::NOK;
+
+    case RehastimCommands::WATCHDOG:
+      // Without news from the host, the stimulator stops by itself
+      return write(ProtocolCommand::WATCHDOG) ? DeviceResponses::OK
+                                              : DeviceResponses::NOK;
+    }
+  } catch (const std::exception &e) {
+    logger.fatal("Error: " + std::string(e.what()));
+    return DeviceResponses::NOK;
+  }
+
+  return DeviceResponses::COMMAND_NOT_FOUND;
+}
+
+void RehastimDevice::HandleStimulation(
+    [[maybe_unused]] const DataPoint &data) {
+  // The pulses are recorded as event markers instead
+}
+
+bool RehastimDevice::startChannelListMode() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (m_StimulationPeriod < std::chrono::milliseconds(8) ||
+      m_StimulationPeriod > std::chrono::milliseconds(1024) ||
+      m_GroupTime < std::chrono::milliseconds(8) ||
+      m_GroupTime > std::chrono::milliseconds(129)) {
+    logger.fatal("The stimulation period must be between 8 and 1024 ms and "
+                 "the group time between 8 and 129 ms");
+    return false;
+  }
+  if (m_ActiveChannels == 0) {
+    logger.fatal("The device {} has no active channel", deviceName());
+    return false;
+  }
+
+  auto mainTime =
+      codeTime(m_StimulationPeriod, std::chrono::microseconds(1000));
+  std::string configuration;
+  configuration += static_cast<char>(0); // No low frequency channel
+  configuration += static_cast<char>(m_ActiveChannels);
+  configuration += static_cast<char>(0);
+  configuration += static_cast<char>(
+      codeTime(m_GroupTime, std::chrono::microseconds(1500)));
+  configuration += static_cast<char>(mainTime >> 8);
+  configuration += static_cast<char>(mainTime & 0xFF);
+  configuration += static_cast<char>(0);
+  if (!request(ProtocolCommand::INIT_CHANNEL_LIST_MODE, configuration)) {
+    return false;
+  }
+
+  // From now on, the changes of the pulses are sent as updates
+  std::string pulses;
+  {
+    std::lock_guard<std::mutex> lock(m_PulsesMutex);
+    m_RunningChannels = m_ActiveChannels;
+    m_RunningPeriod = m_StimulationPeriod;
+    m_IsStimulating = true;
+    pulses = encodePulses();
+    m_UpdateCount++;
+  }
+  asio::post(*m_SerialPortContext, [this]() {
+    m_LastUpdateAt = std::chrono::steady_clock::now();
+  });
+  if (!request(ProtocolCommand::START_CHANNEL_LIST_MODE, pulses)) {
+    std::lock_guard<std::mutex> lock(m_PulsesMutex);
+    m_IsStimulating = false;
+    return false;
+  }
+
+  addEventMarker(data::EventMarkerType::STIMULATOR_ARMED);
+  logger.info("Started the channel-list mode of the device {} with a period "
+              "of {} ms",
+              deviceName(), m_StimulationPeriod.count() / 1000.0);
+  return true;
+}
+
+bool RehastimDevice::stopChannelListMode() {
+  {
+    std::lock_guard<std::mutex> lock(m_PulsesMutex);
+    m_IsStimulating = false;
+  }
+  if (!request(ProtocolCommand::STOP_CHANNEL_LIST_MODE)) {
+    return false;
+  }
+
+  addEventMarker(data::EventMarkerType::STIMULATOR_DISARMED);
+  utils::Logger::getInstance().info(
+      "Stopped the channel-list mode of the device {}", deviceName());
+  return true;
+}
+
+std::string RehastimDevice::encodePulses() const {
+  std::string data;
+  data.reserve(4 * CHANNEL_COUNT);
+  for (size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+    if (!(m_RunningChannels >> channel & 1)) {
+      continue;
+    }
+    const auto &pulse = m_Pulses[channel];
+    data += static_cast<char>(pulse.mode);
+    data += static_cast<char>(pulse.pulseWidth >> 8 & 0x01);
+    data += static_cast<char>(pulse.pulseWidth & 0xFF);
+    data += static_cast<char>(pulse.current);
+  }
+  return data;
+}
+
+void RehastimDevice::scheduleUpdate() {
+  if (!m_IsStimulating || m_IsUpdateScheduled) {
+    return;
+  }
+  m_IsUpdateScheduled = true;
+  asio::post(*m_SerialPortContext, [this]() { sendPendingUpdate(); });
+}
+
+void RehastimDevice::sendPendingUpdate() {
+  auto now = std::chrono::steady_clock::now();
+  std::string frame;
+  {
+    std::lock_guard<std::mutex> lock(m_PulsesMutex);
+    if (!m_IsStimulating) {
+      m_IsUpdateScheduled = false;
+      return;
+    }
+
+    // The stimulator takes the pulses of the last update at each period, so
+    // an earlier update would be overwritten before it is used
+    auto dueAt = m_LastUpdateAt + m_RunningPeriod;
+    if (now < dueAt) {
+      m_UpdateTimer->expires_at(dueAt);
+      m_UpdateTimer->async_wait([this](const asio::error_code &error) {
+        if (!error) {
+          sendPendingUpdate();
+        }
+      });
+      return;
+    }
+
+    m_IsUpdateScheduled = false;
+    frame = encodeFrame(m_PacketNumber++,
+                        ProtocolCommand::START_CHANNEL_LIST_MODE,
+                        encodePulses());
+    m_UpdateCount++;
+  }
+
+  try {
+    writeToDevice(frame);
+  } catch (const std::exception &e) {
+    utils::Logger::getInstance().fatal("Could not write to the device {}: {}",
+                                       deviceName(), e.what());
+    return;
+  }
+  m_LastUpdateAt = now;
+}
+
+std::optional<RehastimAcknowledgment>
+RehastimDevice::request(ProtocolCommand command, const std::string &data) {
+  auto &logger = utils::Logger::getInstance();
+
+  auto promise = std::make_shared<std::promise<RehastimAcknowledgment>>();
+  auto future = promise->get_future();
+  {
+    std::lock_guard<std::mutex> lock(m_PendingResponsesMutex);
+    m_PendingResponses.push_back(PendingResponse{command, promise});
+  }
+  if (!write(command, data)) {
+    std::lock_guard<std::mutex> lock(m_PendingResponsesMutex);
+    m_PendingResponses.pop_back();
+    return std::nullopt;
+  }
+
+  if (future.wait_for(m_ResponseTimeout) != std::future_status::ready) {
+    logger.fatal("The device {} did not acknowledge the command {}",
+                 deviceName(), static_cast<int>(command));
+    std::lock_guard<std::mutex> lock(m_PendingResponsesMutex);
+    m_PendingResponses.erase(
+        std::remove_if(m_PendingResponses.begin(), m_PendingResponses.end(),
+                       [&promise](const PendingResponse &pending) {
+                         return pending.promise == promise;
+                       }),
+        m_PendingResponses.end());
+    return std::nullopt;
+  }
+
+  auto acknowledgment = future.get();
+  if (acknowledgment.errorCode != 0) {
+    logger.fatal("The device {} answered the command {} with the error {}",
+                 deviceName(), static_cast<int>(command),
+                 static_cast<int>(acknowledgment.errorCode));
+    return std::nullopt;
+  }
+  return acknowledgment;
+}
+
+bool RehastimDevice::write(ProtocolCommand command, const std::string &data) {
+  try {
+    writeToDevice(encodeFrame(m_PacketNumber++, command, data));
+  } catch (const std::exception &e) {
+    utils::Logger::getInstance().fatal("Could not write to the device {}: {}",
+                                       deviceName(), e.what());
+    return false;
+  }
+  return true;
+}
+
+void RehastimDevice::handleReceivedFrame(const std::string &) {
+  // The serial layer hands the frames right after the decoder found them, so
+  // the decoder already holds the validated and unstuffed packet
+  handlePacket(
+      static_cast<const RehastimFrameDecoder &>(*m_FrameDecoder).getPacket());
+}
+
+void RehastimDevice::handlePacket(const RehastimPacket &packet) {
+  auto &logger = utils::Logger::getInstance();
+
+  switch (packet.command) {
+  case ProtocolCommand::INIT: {
+    // The stimulator (re)started, it waits for the host to accept it
+    bool wasStimulating;
+    {
+      std::lock_guard<std::mutex> lock(m_PulsesMutex);
+      wasStimulating = m_IsStimulating;
+      m_IsStimulating = false;
+    }
+    if (wasStimulating) {
+      logger.warning("The device {} restarted while stimulating",
+                     deviceName());
+      addEventMarker(data::EventMarkerType::STIMULATOR_DISARMED);
+    }
+    try {
+      writeToDevice(encodeFrame(packet.number, ProtocolCommand::INIT_ACK,
+                                std::string(1, '\0')));
+    } catch (const std::exception &e) {
+      logger.fatal("Could not write to the device {}: {}", deviceName(),
+                   e.what());
+    }
+    return;
+  }
+
+  case ProtocolCommand::STIMULATION_ERROR: {
+    // The stimulator stopped by itself
+    {
+      std::lock_guard<std::mutex> lock(m_PulsesMutex);
+      m_IsStimulating = false;
+      m_ErrorCount++;
+    }
+    logger.fatal("The device {} stopped stimulating on the error {}",
+                 deviceName(),
+                 packet.data.empty() ? 0 : static_cast<int>(packet.data[0]));
+    addEventMarker(data::EventMarkerType::STIMULATOR_DISARMED);
+    return;
+  }
+
+  case ProtocolCommand::UNKNOWN_COMMAND:
+    logger.warning("The device {} did not recognize a command", deviceName());
+    return;
+
+  case ProtocolCommand::GET_STIMULATION_MODE_ACK:
+  case ProtocolCommand::INIT_CHANNEL_LIST_MODE_ACK:
+  case ProtocolCommand::START_CHANNEL_LIST_MODE_ACK:
+  case ProtocolCommand::STOP_CHANNEL_LIST_MODE_ACK:
+  case ProtocolCommand::SINGLE_PULSE_ACK: {
+    // The error code comes first, a missing one is an error
+    RehastimAcknowledgment acknowledgment;
+    acknowledgment.command = static_cast<ProtocolCommand>(
+        static_cast<std::uint8_t>(packet.command) - 1);
+    acknowledgment.packetNumber = packet.number;
+    acknowledgment.errorCode =
+        packet.data.empty() ? -1 : static_cast<std::int8_t>(packet.data[0]);
+    if (packet.data.size() > 1) {
+      acknowledgment.data = packet.data.substr(1);
+    }
+    handleAcknowledgment(acknowledgment);
+    return;
+  }
+
+  default:
+    return;
+  }
+}
+
+void RehastimDevice::handleAcknowledgment(
+    const RehastimAcknowledgment &acknowledgment) {
+  bool isError = acknowledgment.errorCode != 0;
+  {
+    std::lock_guard<std::mutex> lock(m_PulsesMutex);
+    if (acknowledgment.command == ProtocolCommand::START_CHANNEL_LIST_MODE &&
+        !isError) {
+      m_AcknowledgedUpdateCount++;
+    }
+    if (isError) {
+      m_ErrorCount++;
+    }
+  }
+
+  std::shared_ptr<std::promise<RehastimAcknowledgment>> promise;
+  {
+    std::lock_guard<std::mutex> lock(m_PendingResponsesMutex);
+    auto pending = std::find_if(
+        m_PendingResponses.begin(), m_PendingResponses.end(),
+        [&acknowledgment](const PendingResponse &pending) {
+          return pending.command == acknowledgment.command;
+        });
+    if (pending != m_PendingResponses.end()) {
+      promise = pending->promise;
+      m_PendingResponses.erase(pending);
+    }
+  }
+
+  if (promise != nullptr) {
+    promise->set_value(acknowledgment);
+  } else if (isError) {
+    // The acknowledgment of an update or a single pulse, nobody waits for it
+    utils::Logger::getInstance().warning(
+        "The device {} answered the command {} with the error {}",
+        deviceName(), static_cast<int>(acknowledgment.command),
+        static_cast<int>(acknowledgment.errorCode));
+  }
+
+  onAcknowledgment.notifyListeners(acknowledgment);
+}
+
+RehastimFrameDecoder::RehastimFrameDecoder() { reset(); }
+
+SerialFrameDecoder::Status
+RehastimFrameDecoder::decode(const utils::ByteRingBuffer &buffer,
+                             size_t &length) {
+  if (m_Position == 0 && static_cast<std::uint8_t>(
+                             *buffer.readableRegion().first) != START_BYTE) {
+    // Not the start of a frame, skip to the next one
+    auto next = buffer.find(static_cast<char>(START_BYTE), 1);
+    return skip(length, next == utils::ByteRingBuffer::npos ? buffer.size()
+                                                            : next);
+  }
+
+  // Resume where the previous call stopped, reading the bytes in place. The
+  // state is kept in locals so the compiler does not reload it after each
+  // byte written to the payload
+  size_t position = m_Position;
+  std::uint8_t crc = m_Crc;
+  bool isStuffed = m_IsStuffed;
+  size_t payloadLength = m_PayloadLength;
+  size_t size = buffer.size();
+  while (position < size) {
+    auto region = buffer.readableRegion(position);
+    auto bytes = reinterpret_cast<const std::uint8_t *>(region.first);
+    auto end = bytes + region.second;
+
+    if (position == 0 && region.second > HEADER_LENGTH) {
+      // The whole header is here, as when the bytes arrive in large reads
+      if (bytes[1] != STUFFING_BYTE || bytes[3] != STUFFING_BYTE) {
+        return skip(length, 1);
+      }
+      m_ExpectedCrc = bytes[2] ^ STUFFING_KEY;
+      m_ExpectedLength = bytes[4] ^ STUFFING_KEY;
+      if (m_ExpectedLength < 2 || m_ExpectedLength > MAX_PAYLOAD_LENGTH) {
+        return skip(length, 1);
+      }
+      bytes += HEADER_LENGTH;
+      position = HEADER_LENGTH;
+    }
+
+    // The header, one byte at a time
+    for (; position < HEADER_LENGTH && bytes < end; bytes++, position++) {
+      auto byte = *bytes;
+      switch (position) {
+      case 1:
+      case 3:
+        // The CRC and the length are always stuffed
+        if (byte != STUFFING_BYTE) {
+          return skip(length, 1);
+        }
+        break;
+      case 2:
+        m_ExpectedCrc = byte ^ STUFFING_KEY;
+        break;
+      case 4:
+        m_ExpectedLength = byte ^ STUFFING_KEY;
+        if (m_ExpectedLength < 2 || m_ExpectedLength > MAX_PAYLOAD_LENGTH) {
+          return skip(length, 1);
+        }
+        break;
+      default:
+        break;
+      }
+    }
+    if (bytes == end) {
+      continue;
+    }
+
+    // The payload, up to the stop byte or the end of the region
+    size_t stopPosition = HEADER_LENGTH + m_ExpectedLength;
+    auto payloadEnd = bytes + std::min(static_cast<size_t>(end - bytes),
+                                       stopPosition - position);
+    auto payloadStart = bytes;
+    for (; bytes < payloadEnd; bytes++) {
+      auto byte = *bytes;
+      if (byte == START_BYTE) {
+        // The frame was cut, the next one starts here
+        return skip(length, position + (bytes - payloadStart));
+      }
+      crc = CRC_TABLE[crc ^ byte];
+      if (isStuffed) {
+        m_Payload[payloadLength++] = static_cast<char>(byte ^ STUFFING_KEY);
+        isStuffed = false;
+      } else if (byte == STUFFING_BYTE) {
+        isStuffed = true;
+      } else if (byte == STOP_BYTE) {
+        // The frame ends before its announced length
+        return skip(length, 1);
+      } else {
+        m_Payload[payloadLength++] = static_cast<char>(byte);
+      }
+    }
+    position += bytes - payloadStart;
+    if (bytes == end) {
+      continue;
+    }
+
+    // The whole payload arrived, the frame must end here
+    auto byte = *bytes;
+    if (byte == START_BYTE) {
+      return skip(length, position);
+    }
+    if (byte != STOP_BYTE || isStuffed || crc != m_ExpectedCrc ||
+        payloadLength < 2) {
+      utils::Logger::getInstance().warning(
+          "The device RehastimDevice sent a frame with a wrong length or CRC");
+      return skip(length, 1);
+    }
+
+    m_Packet.number = static_cast<std::uint8_t>(m_Payload[0]);
+    m_Packet.command = static_cast<RehastimProtocolCommand>(m_Payload[1]);
+    // Most packets are acknowledgments of the same length, which reuse the
+    // data of the previous one
+    if (m_Packet.data.size() != payloadLength - 2) {
+      m_Packet.data.resize(payloadLength - 2);
+    }
+    std::memcpy(m_Packet.data.data(), m_Payload + 2, payloadLength - 2);
+    length = position + 1;
+    reset();
+    return Status::FRAME;
+  }
+
+  // Wait for the rest of the frame
+  m_Position = position;
+  m_Crc = crc;
+  m_IsStuffed = isStuffed;
+  m_PayloadLength = payloadLength;
+  return Status::INCOMPLETE;
+}
+
+void RehastimFrameDecoder::reset() {
+  m_Position = 0;
+  m_ExpectedCrc = 0;
+  m_ExpectedLength = 0;
+  m_Crc = 0;
+  m_IsStuffed = false;
+  m_PayloadLength = 0;
+}
+
+const RehastimPacket &RehastimFrameDecoder::getPacket() const {
+  return m_Packet;
+}
+
+SerialFrameDecoder::Status RehastimFrameDecoder::skip(size_t &length,
+                                                      size_t count) {
+  reset();
+  length = count;
+  return Status::SKIP;
+}
+
+// --- MOCKER SECTION --- //
+#ifndef _WIN32
+RehastimDeviceMock::RehastimDeviceMock()
+    : RehastimDevice(""), m_PtyMaster(-1), m_IsSimulating(false) {
+  // The device talks to the slave side, the simulated stimulator to the master
+  m_PtyMaster = posix_openpt(O_RDWR | O_NOCTTY);
+  if (m_PtyMaster < 0 || grantpt(m_PtyMaster) != 0 ||
+      unlockpt(m_PtyMaster) != 0) {
+    throw DeviceException("Could not open a pseudo-terminal");
+  }
+  m_Port = ptsname(m_PtyMaster);
+}
+
+RehastimDeviceMock::~RehastimDeviceMock() {
+  stopDeviceWorkers();
+  stopSerialPortWorker();
+  stopSimulator();
+  close(m_PtyMaster);
+}
+
+bool RehastimDeviceMock::isStimulatorRunning() {
+  std::lock_guard<std::mutex> lock(m_SimulatorMutex);
+  return m_IsSimulatedRunning;
+}
+
+RehastimDevice::ChannelPulses RehastimDeviceMock::getStimulatorPulses() {
+  std::lock_guard<std::mutex> lock(m_SimulatorMutex);
+  return m_SimulatedPulses;
+}
+
+size_t RehastimDeviceMock::getStimulatorUpdateCount() {
+  std::lock_guard<std::mutex> lock(m_SimulatorMutex);
+  return m_SimulatedUpdateCount;
+}
+
+size_t RehastimDeviceMock::getSinglePulseCount() {
+  std::lock_guard<std::mutex> lock(m_SimulatorMutex);
+  return m_SinglePulseCount;
+}
+
+bool RehastimDeviceMock::isInitAcknowledged() {
+  std::lock_guard<std::mutex> lock(m_SimulatorMutex);
+  return m_IsInitAcknowledged;
+}
+
+void RehastimDeviceMock::simulateStimulationError(std::int8_t errorCode) {
+  std::string frame;
+  {
+    std::lock_guard<std::mutex> lock(m_SimulatorMutex);
+    m_IsSimulatedRunning = false;
+    frame = encodeFrame(m_SimulatedPacketNumber++,
+                        ProtocolCommand::STIMULATION_ERROR,
+                        std::string(1, static_cast<char>(errorCode)));
+  }
+  ::write(m_PtyMaster, frame.data(), frame.size());
+}
+
+bool RehastimDeviceMock::handleConnect() {
+  if (shouldFailToConnect) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_SimulatorMutex);
+    m_HasSentInit = false;
+    m_IsInitAcknowledged = false;
+  }
+  m_IsSimulating = true;
+  m_SimulatorWorker = std::thread([this]() { simulateStimulator(); });
+  if (!RehastimDevice::handleConnect()) {
+    stopSimulator();
+    return false;
+  }
+  return true;
+}
+
+bool RehastimDeviceMock::handleDisconnect() {
+  SerialPortDevice::handleDisconnect();
+  stopSimulator();
+  return true;
+}
+
+void RehastimDeviceMock::stopSimulator() {
+  m_IsSimulating = false;
+  if (m_SimulatorWorker.joinable()) {
+    m_SimulatorWorker.join();
+  }
+}
+
+void RehastimDeviceMock::simulateStimulator() {
+  utils::ByteRingBuffer received(1024);
+  RehastimFrameDecoder decoder;
+  char buffer[1024];
+
+  while (m_IsSimulating) {
+    pollfd pollDescriptor{m_PtyMaster, POLLIN, 0};
+    if (poll(&pollDescriptor, 1, 10) <= 0) {
+      continue;
+    }
+    auto byteCount = read(m_PtyMaster, buffer, sizeof(buffer));
+    if (byteCount <= 0) {
+      // The slave side is not open (yet or anymore)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      continue;
+    }
+
+    received.write(buffer, static_cast<size_t>(byteCount));
+    while (!received.empty()) {
+      size_t length = 0;
+      auto status = decoder.decode(received, length);
+      if (status == SerialFrameDecoder::Status::INCOMPLETE) {
+        break;
+      }
+      if (status == SerialFrameDecoder::Status::SKIP) {
+        received.consume(length);
+        continue;
+      }
+      received.consume(length);
+      answer(decoder.getPacket());
+    }
+  }
+}
+
+void RehastimDeviceMock::answer(const RehastimPacket &packet) {
+  auto command = packet.command;
+  const auto &data = packet.data;
+  std::string answers;
+  std::lock_guard<std::mutex> lock(m_SimulatorMutex);
+  auto acknowledge = [&](std::string ackData) {
+    answers += encodeFrame(
+        m_SimulatedPacketNumber++,
+        static_cast<ProtocolCommand>(static_cast<std::uint8_t>(command) + 1),
+        ackData);
+  };
+
+  // A stimulator that was just plugged introduces itself
+  if (!m_HasSentInit) {
+    m_HasSentInit = true;
+    answers += encodeFrame(m_SimulatedPacketNumber++, ProtocolCommand::INIT);
+  }
+
+  switch (command) {
+  case ProtocolCommand::INIT_ACK:
+    m_IsInitAcknowledged = true;
+    break;
+
+  case ProtocolCommand::GET_STIMULATION_MODE:
+    acknowledge(std::string(1, '\0') +
+                static_cast<char>(m_IsSimulatedRunning ? 2 : 0));
+    break;
+
+  case ProtocolCommand::INIT_CHANNEL_LIST_MODE:
+    m_SimulatedChannels = data.size() > 1 ? data[1] : 0;
+    acknowledge(std::string(1, '\0'));
+    break;
+
+  case ProtocolCommand::START_CHANNEL_LIST_MODE: {
+    // The pulses of each active channel, in order
+    size_t channelCount = 0;
+    for (size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+      channelCount += m_SimulatedChannels >> channel & 1;
+    }
+    if (data.size() != 4 * channelCount) {
+      // The pulses do not match the initialized channels
+      acknowledge(std::string(1, static_cast<char>(-1)));
+      break;
+    }
+    size_t index = 0;
+    for (size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+      if (!(m_SimulatedChannels >> channel & 1)) {
+        continue;
+      }
+      auto &pulse = m_SimulatedPulses[channel];
+      pulse.mode = static_cast<RehastimPulse::Mode>(data[index]);
+      pulse.pulseWidth = static_cast<std::uint16_t>(
+          (static_cast<std::uint8_t>(data[index + 1]) & 0x01) << 8 |
+          static_cast<std::uint8_t>(data[index + 2]));
+      pulse.current = static_cast<std::uint8_t>(data[index + 3]);
+      index += 4;
+    }
+    m_IsSimulatedRunning = true;
+    m_SimulatedUpdateCount++;
+    acknowledge(std::string(1, '\0'));
+    break;
+  }
+
+  case ProtocolCommand::STOP_CHANNEL_LIST_MODE:
+    m_IsSimulatedRunning = false;
+    acknowledge(std::string(1, '\0'));
+    break;
+
+  case ProtocolCommand::SINGLE_PULSE:
+    m_SinglePulseCount++;
+    acknowledge(std::string(1, '\0'));
+    break;
+
+  case ProtocolCommand::WATCHDOG:
+    break;
+
+  default:
+    answers += encodeFrame(m_SimulatedPacketNumber++,
+                           ProtocolCommand::UNKNOWN_COMMAND);
+    break;
+  }
+
+  if (!answers.empty()) {
+    ::write(m_PtyMaster, answers.data(), answers.size());
+  }
+}
+#endif // _WIN32
@@ -1,5 +1,8 @@
 #include "Devices/Devices.h"
 
+#include "Data/AcquisitionStatistics.h"
+#include "Data/DataCheckTimings.h"
+#include "Data/EventMarkerRecorder.h"
 #include "Data/TimeSeries.h"
 #include "Devices/Exceptions.h"
 #include "Devices/Generic/AsyncDataCollector.h"
@@ -7,10 +10,17 @@
 #include "Devices/Generic/DataCollector.h"
 #include "Utils/Logger.h"
 #include <thread>
+#include <utility>
 
 using namespace STIMWALKER_NAMESPACE;
 using namespace STIMWALKER_NAMESPACE::devices;
 
+Devices::Devices()
+    : m_IsConnected(false), m_IsStreamingData(false), m_IsRecording(false),
+      m_LiveDataTimeWindow(std::chrono::milliseconds(0)),
+      m_PreTriggerDuration(std::chrono::milliseconds(0)),
+      m_EventMarkers(std::make_shared<data::EventMarkerRecorder>()) {}
+
 Devices::~Devices() {
   if (m_IsConnected) {
     disconnect();
@@ -23,6 +33,7 @@ size_t Devices::add(std::unique_ptr<Device> device) {
 
   // Add the device to the device collection if it does not exist yet
   m_Devices[deviceId] = std::move(device);
+  m_Devices[deviceId]->setEventMarkers(m_EventMarkers);
 
   // If we can dynamic cast the device to a data collector, add it to the data
   // collector collection
@@ -30,6 +41,12 @@ size_t Devices::add(std::unique_ptr<Device> device) {
   if (auto dataCollector =
           std::dynamic_pointer_cast<DataCollector>(m_Devices[deviceId])) {
     m_DataCollectors[deviceId] = dataCollector;
+    if (m_LiveDataTimeWindow.count() > 0) {
+      dataCollector->setLiveDataTimeWindow(m_LiveDataTimeWindow);
+    }
+    if (m_PreTriggerDuration.count() > 0) {
+      dataCollector->setPreTriggerDuration(m_PreTriggerDuration);
+    }
   }
 
   return deviceId++;
@@ -44,6 +61,23 @@ bool Devices::zeroLevelDevice(const std::string &deviceName) {
   return true;
 }
 
+void Devices::setLiveDataTimeWindow(const std::chrono::milliseconds &window) {
+  std::lock_guard<std::mutex> lock(m_MutexDataCollectors);
+  m_LiveDataTimeWindow = window;
+  for (auto &[deviceId, dataCollector] : m_DataCollectors) {
+    dataCollector->setLiveDataTimeWindow(window);
+  }
+}
+
+void Devices::setPreTriggerDuration(
+    const std::chrono::milliseconds &duration) {
+  std::lock_guard<std::mutex> lock(m_MutexDataCollectors);
+  m_PreTriggerDuration = duration;
+  for (auto &[deviceId, dataCollector] : m_DataCollectors) {
+    dataCollector->setPreTriggerDuration(duration);
+  }
+}
+
 void Devices::remove(size_t deviceId) {
   m_Devices[deviceId]->disconnect();
   std::lock_guard<std::mutex> lock(m_MutexDataCollectors);
@@ -101,6 +135,10 @@ const Device &Devices::getDevice(size_t deviceId) const {
   }
 }
 
+Device &Devices::getDevice(size_t deviceId) {
+  return const_cast<Device &>(std::as_const(*this).getDevice(deviceId));
+}
+
 const DataCollector &Devices::getDataCollector(size_t deviceId) const {
   try {
     std::lock_guard<std::mutex> lock(
@@ -114,6 +152,11 @@ const DataCollector &Devices::getDataCollector(size_t deviceId) const {
   }
 }
 
+DataCollector &Devices::getDataCollector(size_t deviceId) {
+  return const_cast<DataCollector &>(
+      std::as_const(*this).getDataCollector(deviceId));
+}
+
 bool Devices::connect() {
   m_IsConnected = false;
 
@@ -246,6 +289,7 @@ bool Devices::startDataStreaming() {
       dataCollector->resetLiveData();
     }
   }
+  m_EventMarkers->reset();
 
   utils::Logger::getInstance().info("All devices are now streaming data");
   m_IsStreamingData = true;
@@ -296,6 +340,10 @@ bool Devices::startRecording() {
   }
 
   m_IsRecording = true;
+  m_TrialStartTime = std::chrono::steady_clock::now() - m_PreTriggerDuration;
+  m_TrialStopTime = m_TrialStartTime;
+  m_EventMarkers->add(data::EventMarkerType::RECORDING_STARTED,
+                      m_PreTriggerDuration.count());
   utils::Logger::getInstance().info("All devices are now recording");
   return true;
 }
@@ -318,6 +366,8 @@ bool Devices::stopRecording() {
   }
 
   m_IsRecording = false;
+  m_EventMarkers->add(data::EventMarkerType::RECORDING_STOPPED);
+  m_TrialStopTime = std::chrono::steady_clock::now();
   utils::Logger::getInstance().info("All devices have stopped recording");
   return true;
 }
@@ -328,24 +378,67 @@ nlohmann::json Devices::getLiveDataSerialized() const {
   std::lock_guard<std::mutex> lock(
       const_cast<std::mutex &>(m_MutexDataCollectors));
   for (const auto &[deviceId, dataCollector] : m_DataCollectors) {
-    json[deviceIndex] = {{"name", dataCollector->dataCollectorName()},
-                         {"data", dataCollector->getSerializedLiveData()}};
+    json[deviceIndex] = {
+        {"name", dataCollector->dataCollectorName()},
+        {"data", dataCollector->getSerializedLiveData()},
+        {"acquisition",
+         dataCollector->getAcquisitionStatistics().serializeCounts()},
+        {"clock", dataCollector->getSerializedLiveClock()}};
+    auto asyncDataCollector =
+        dynamic_cast<const AsyncDataCollector *>(dataCollector.get());
+    if (asyncDataCollector) {
+      json[deviceIndex]["dataCheck"] =
+          asyncDataCollector->getSerializedDataCheckSummary();
+    }
     deviceIndex++;
   }
   return json;
 }
 
+nlohmann::json Devices::getDataCheckTimingsSerialized() const {
+  nlohmann::json json = nlohmann::json::array();
+  std::lock_guard<std::mutex> lock(
+      const_cast<std::mutex &>(m_MutexDataCollectors));
+  for (const auto &[deviceId, dataCollector] : m_DataCollectors) {
+    auto asyncDataCollector =
+        dynamic_cast<const AsyncDataCollector *>(dataCollector.get());
+    if (!asyncDataCollector) {
+      continue;
+    }
+    json.push_back(
+        {{"name", dataCollector->dataCollectorName()},
+         {"dataCheckTimings",
+          asyncDataCollector->getDataCheckTimings().serialize()}});
+  }
+  return json;
+}
+
 nlohmann::json Devices::getLastTrialDataSerialized() const {
-  nlohmann::json json;
+  nlohmann::json devices = nlohmann::json::array();
   size_t deviceIndex = 0;
   std::lock_guard<std::mutex> lock(
       const_cast<std::mutex &>(m_MutexDataCollectors));
   for (const auto &[deviceId, dataCollector] : m_DataCollectors) {
-    json[deviceIndex] = {{"name", dataCollector->dataCollectorName()},
-                         {"data", dataCollector->getTrialData().serialize()}};
+    devices[deviceIndex] = {
+        {"name", dataCollector->dataCollectorName()},
+        {"data", dataCollector->getTrialData().serialize()},
+        {"acquisition",
+         dataCollector->getTrialAcquisitionStatistics().serialize()},
+        {"clock", dataCollector->getSerializedTrialClock()}};
     deviceIndex++;
   }
-  return json;
+
+  auto trialStopTime =
+      m_IsRecording ? std::chrono::steady_clock::now() : m_TrialStopTime;
+  return {{DEVICES_KEY, devices},
+          {EVENT_MARKERS_KEY,
+           m_EventMarkers->between(m_TrialStartTime, trialStopTime)
+               .serialize()}};
+}
+
+void Devices::addEventMarker(data::EventMarkerType type,
+                             std::int64_t payload) {
+  m_EventMarkers->add(type, payload);
 }
 
 std::map<std::string, data::TimeSeries>
@@ -356,4 +449,40 @@ Devices::deserializeData(const nlohmann::json &json) {
     data[name] = data::TimeSeries(deviceData["data"]);
   }
   return data;
-}
\ No newline at end of file
+}
+
+std::map<std::string, data::AcquisitionStatistics>
+Devices::deserializeAcquisitionStatistics(const nlohmann::json &json) {
+  auto statistics = std::map<std::string, data::AcquisitionStatistics>();
+  for (const auto &[deviceIndex, deviceData] : json.items()) {
+    if (!deviceData.contains("acquisition")) {
+      continue;
+    }
+    auto name = deviceData["name"].get<std::string>();
+    statistics.emplace(
+        name, data::AcquisitionStatistics(deviceData["acquisition"]));
+  }
+  return statistics;
+}
+
+std::map<std::string, data::DataCheckTimings>
+Devices::deserializeDataCheckTimings(const nlohmann::json &json) {
+  auto timings = std::map<std::string, data::DataCheckTimings>();
+  for (const auto &[deviceIndex, deviceData] : json.items()) {
+    if (!deviceData.contains("dataCheckTimings")) {
+      continue;
+    }
+    auto name = deviceData["name"].get<std::string>();
+    timings.emplace(name,
+                    data::DataCheckTimings(deviceData["dataCheckTimings"]));
+  }
+  return timings;
+}
+
+data::EventMarkers
+Devices::deserializeEventMarkers(const nlohmann::json &json) {
+  if (!json.contains(EVENT_MARKERS_KEY)) {
+    return data::EventMarkers();
+  }
+  return data::EventMarkers(json[EVENT_MARKERS_KEY]);
+}
@@ -1,6 +1,7 @@
 #include "Devices/Generic/AsyncDataCollector.h"
 
 #include "Utils/Logger.h"
+#include "Utils/Tracer.h"
 #include <regex>
 #include <thread>
 
@@ -10,8 +11,9 @@ AsyncDataCollector::AsyncDataCollector(
     size_t channelCount, const std::chrono::microseconds &dataCheckIntervals,
     const std::function<std::unique_ptr<data::TimeSeries>()>
         &timeSeriesGenerator)
-    : m_KeepDataWorkerAliveInterval(dataCheckIntervals),
-      DataCollector(channelCount, timeSeriesGenerator) {}
+    : DataCollector(channelCount, timeSeriesGenerator),
+      m_KeepDataWorkerAliveInterval(dataCheckIntervals),
+      m_DataCheckWaitsForDevice(false) {}
 
 AsyncDataCollector::~AsyncDataCollector() { stopDataCollectorWorkers(); }
 
@@ -36,7 +38,11 @@ void AsyncDataCollector::startDataStreamingAsync() {
       return;
     }
 
-    m_LiveTimeSeries->reset();
+    resetLiveData();
+    {
+      std::lock_guard<std::mutex> lock(m_DataCheckTimingsMutex);
+      m_DataCheckTimings.clear();
+    }
     startKeepDataWorkerAlive();
     m_IsStreamingData = true;
     logger.info("The data collector " + dataCollectorName() +
@@ -99,6 +105,17 @@ bool AsyncDataCollector::stopRecording() {
   return DataCollector::stopRecording();
 }
 
+STIMWALKER_NAMESPACE::data::DataCheckTimings
+AsyncDataCollector::getDataCheckTimings() const {
+  std::lock_guard<std::mutex> lock(m_DataCheckTimingsMutex);
+  return m_DataCheckTimings;
+}
+
+nlohmann::json AsyncDataCollector::getSerializedDataCheckSummary() const {
+  std::lock_guard<std::mutex> lock(m_DataCheckTimingsMutex);
+  return m_DataCheckTimings.serializeSummary();
+}
+
 void AsyncDataCollector::stopDataCollectorWorkers() {
   if (m_IsRecording) {
     stopRecording();
@@ -133,11 +150,12 @@ void AsyncDataCollector::keepDataWorkerAlive(
     std::chrono::microseconds timeout) {
 
   // Set a timer that will call [pingDataWorker] every [timeout] milliseconds
+  m_KeepDataWorkerAliveTimerSetAt = std::chrono::steady_clock::now();
   m_KeepDataWorkerAliveTimer->expires_after(timeout);
 
   m_KeepDataWorkerAliveTimer->async_wait([this](const auto &errorCode) {
     // Get the current time
-    auto now = std::chrono::high_resolution_clock::now();
+    auto now = std::chrono::steady_clock::now();
 
     // If errorCode is not false, it means the timer was stopped by the user, or
     // the device was disconnected. In both cases, do nothing and return
@@ -148,28 +166,37 @@ void AsyncDataCollector::keepDataWorkerAlive(
 
     // Otherwise, send a [dataCheck] command to allow the user to check for
     // new data
-    dataCheck();
+    {
+      STIMWALKER_TRACE_SCOPE("dataCheck", "data");
+      dataCheck();
+    }
 
     // Once it's done, repeat the process, but take into account the time it
     // took to execute the [dataCheck] method
-    auto timeToExecute = std::chrono::high_resolution_clock::now() - now;
+    auto timeToExecute = std::chrono::steady_clock::now() - now;
+    {
+      std::lock_guard<std::mutex> lock(m_DataCheckTimingsMutex);
+      m_DataCheckTimings.add(now - m_KeepDataWorkerAliveTimerSetAt,
+                             now - m_KeepDataWorkerAliveTimer->expiry(),
+                             timeToExecute);
+    }
+
     auto next = m_KeepDataWorkerAliveInterval - timeToExecute;
     if (next < std::chrono::microseconds(1)) {
       next = std::chrono::microseconds(1);
 
       // Send a warning to the user if the delay is more than twice the
       // interval
-      if (!m_IgnoreTooSlowWarning) {
-        utils::Logger::getInstance().warning(
-            "The [dataCheck] for " + dataCollectorName() +
-            " took longer than the sampling rate (" +
-            std::to_string(
-                std::chrono::duration_cast<std::chrono::microseconds>(
-                    timeToExecute)
-                    .count()) +
-            "/" + std::to_string(m_KeepDataWorkerAliveInterval.count()) +
-            " microseconds). Consider increasing the interval, or optimizing "
-            "the [dataCheck] method.");
+      if (!m_DataCheckWaitsForDevice) {
+        reportTimerOverrun();
+        STIMWALKER_LOG_WARNING(
+            "The [dataCheck] for {} took longer than the sampling rate ({}/{} "
+            "microseconds). Consider increasing the interval, or optimizing "
+            "the [dataCheck] method.",
+            dataCollectorName(),
+            std::chrono::duration_cast<std::chrono::microseconds>(timeToExecute)
+                .count(),
+            m_KeepDataWorkerAliveInterval.count());
       }
     }
 
@@ -2,6 +2,7 @@
 
 #include "Devices/Exceptions.h"
 #include "Utils/Logger.h"
+#include "Utils/Tracer.h"
 #include <regex>
 #include <thread>
 
@@ -165,6 +166,7 @@ DeviceResponses AsyncDevice::parseSendCommand(const DeviceCommands &command,
   m_AsyncDeviceContext.post(
       [this, &command, data = data, p = &promise, ignoreResponse]() mutable {
         std::lock_guard<std::mutex> lock(m_AsyncDeviceMutex);
+        STIMWALKER_TRACE_SCOPE("parseAsyncSendCommand", "devices");
 
         // Parse the command and get the response
         auto response = parseAsyncSendCommand(command, data);
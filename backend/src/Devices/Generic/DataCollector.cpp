@@ -1,7 +1,10 @@
 #include "Devices/Generic/DataCollector.h"
 
+#include <algorithm>
+
 #include "Devices/Exceptions.h"
 #include "Utils/Logger.h"
+#include "Utils/Tracer.h"
 
 using namespace STIMWALKER_NAMESPACE::data;
 using namespace STIMWALKER_NAMESPACE::devices;
@@ -11,9 +14,15 @@ DataCollector::DataCollector(
     const std::function<std::unique_ptr<data::TimeSeries>()>
         &timeSeriesGenerator)
     : m_DataChannelCount(channelCount), m_IsStreamingData(false),
-      m_IsRecording(false), m_LiveTimeSeries(timeSeriesGenerator()),
-      m_TrialTimeSeries(timeSeriesGenerator()) {
-  m_LiveTimeSeries->setRollingVectorMaxSize(1000);
+      m_IsRecording(false), m_IsWritingTrial(false),
+      m_LiveTimeSeries(timeSeriesGenerator()),
+      m_TrialTimeSeries(timeSeriesGenerator()),
+      m_SamplePeriod(std::chrono::microseconds(0)),
+      m_LiveDataTimeWindow(DEFAULT_LIVE_DATA_TIME_WINDOW),
+      m_PreTriggerDuration(std::chrono::milliseconds(0)),
+      m_TrialWriter(std::make_unique<data::TrialWriter>()),
+      m_TrialFirstSampleIndex(0), m_TrialOverflowSampleCount(0) {
+  m_LiveTimeSeries->setRollingVectorMaxSize(getLiveDataCapacity());
 }
 
 bool DataCollector::startDataStreaming() {
@@ -27,10 +36,7 @@ bool DataCollector::startDataStreaming() {
 
   m_IsStreamingData = handleStartDataStreaming();
   m_HasFailedToStartDataStreaming = !m_IsStreamingData;
-  {
-    std::lock_guard<std::mutex> lock(m_LiveDataMutex);
-    m_LiveTimeSeries->reset();
-  }
+  resetLiveData();
 
   if (m_IsStreamingData) {
     logger.info("The data collector " + dataCollectorName() +
@@ -81,7 +87,35 @@ bool DataCollector::startRecording() {
   }
 
   m_TrialTimeSeries->reset();
-  m_IsRecording = true;
+  m_TrialWriter->start(*m_TrialTimeSeries);
+  size_t preTriggerSampleCount = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+
+    // The live data are the pre-trigger buffer. Seeding and starting to record
+    // under the same lock, no sample is missed nor repeated
+    if (m_PreTriggerDuration.count() > 0) {
+      preTriggerSampleCount =
+          m_TrialTimeSeries->seedFrom(*m_LiveTimeSeries, m_PreTriggerDuration);
+    }
+    m_TrialAcquisitionStatistics.reset(
+        m_SamplePeriod,
+        std::chrono::steady_clock::now() -
+            m_SamplePeriod * static_cast<int64_t>(preTriggerSampleCount));
+    m_TrialAcquisitionStatistics.addReceivedSamples(preTriggerSampleCount);
+    m_TrialFirstSampleIndex =
+        m_LiveAcquisitionStatistics.getReceivedSampleCount() +
+        m_LiveAcquisitionStatistics.getDroppedSampleCount() -
+        preTriggerSampleCount;
+    m_TrialOverflowSampleCount = 0;
+    m_IsWritingTrial = true;
+    m_IsRecording = true;
+  }
+  if (preTriggerSampleCount > 0) {
+    logger.info("The data collector {} seeded the trial with {} samples "
+                "recorded before the trigger",
+                dataCollectorName(), preTriggerSampleCount);
+  }
 
   logger.info("The data collector " + dataCollectorName() +
               " is now recording");
@@ -97,8 +131,39 @@ bool DataCollector::stopRecording() {
     return true;
   }
 
+  {
+    // No more block can be handed to the writer once this is released
+    std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+    m_IsWritingTrial = false;
+    m_TrialAcquisitionStatistics.updateExpectedSampleCount();
+    m_TrialClockSynchronizer = m_ClockSynchronizer;
+  }
+
+  // The trial is only complete (and readable) once the writer is drained
+  m_TrialWriter->stop();
   m_IsRecording = false;
 
+  auto metrics = m_TrialWriter->getMetrics();
+  if (metrics.droppedSampleCount > 0) {
+    logger.warning(
+        "The data collector {} dropped {} samples of the trial because the "
+        "trial writer could not keep up (maximum queue depth: {}/{})",
+        dataCollectorName(), metrics.droppedSampleCount, metrics.maxQueueDepth,
+        metrics.queueCapacity);
+  }
+  auto statistics = getTrialAcquisitionStatistics();
+  if (statistics.getDroppedSampleCount() > 0 ||
+      statistics.getUnaccountedSampleCount() > 0) {
+    logger.warning("The data collector {} lost {} samples of the trial ({} "
+                   "reported in {} gaps, {} unaccounted for)",
+                   dataCollectorName(),
+                   statistics.getDroppedSampleCount() +
+                       statistics.getUnaccountedSampleCount(),
+                   statistics.getDroppedSampleCount(),
+                   statistics.getGapCount(),
+                   statistics.getUnaccountedSampleCount());
+  }
+
   logger.info("The data collector " + dataCollectorName() +
               " has stopped recording");
   return true;
@@ -109,13 +174,68 @@ void DataCollector::setZeroLevel(const std::chrono::milliseconds &duration) {
 }
 
 void DataCollector::resetLiveData() {
+  std::lock_guard<std::mutex> storageLock(m_LiveDataStorageMutex);
   std::lock_guard<std::mutex> lock(m_LiveDataMutex);
   m_LiveTimeSeries->reset();
+  m_PendingGaps.clear();
+  m_LiveAcquisitionStatistics.reset(m_SamplePeriod);
+  m_ClockSynchronizer.reset(m_SamplePeriod);
+}
+
+void DataCollector::setLiveDataTimeWindow(
+    const std::chrono::milliseconds &window) {
+  std::lock_guard<std::mutex> storageLock(m_LiveDataStorageMutex);
+  std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+  m_LiveDataTimeWindow = window;
+  m_LiveTimeSeries->resizeRollingVector(getLiveDataCapacity());
+}
+
+void DataCollector::setPreTriggerDuration(
+    const std::chrono::milliseconds &duration) {
+  std::lock_guard<std::mutex> storageLock(m_LiveDataStorageMutex);
+  std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+  m_PreTriggerDuration = duration;
+  m_LiveTimeSeries->resizeRollingVector(getLiveDataCapacity());
+}
+
+size_t DataCollector::getLiveDataCapacity() const {
+  if (m_SamplePeriod.count() <= 0) {
+    return DEFAULT_LIVE_DATA_SAMPLE_COUNT;
+  }
+
+  // The whole window must hold the pre-trigger
+  size_t capacity =
+      getSampleCount(std::max(m_LiveDataTimeWindow, m_PreTriggerDuration));
+  return std::max(capacity, static_cast<size_t>(1));
+}
+
+size_t
+DataCollector::getSampleCount(const std::chrono::milliseconds &duration) const {
+  if (m_SamplePeriod.count() <= 0) {
+    return 0;
+  }
+
+  // Round up so the whole duration fits
+  auto microseconds =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  return static_cast<size_t>(
+      (microseconds.count() + m_SamplePeriod.count() - 1) /
+      m_SamplePeriod.count());
 }
 
 nlohmann::json DataCollector::getSerializedLiveData() const {
+  STIMWALKER_TRACE_SCOPE("getSerializedLiveData", "data");
   std::lock_guard<std::mutex> lock(const_cast<std::mutex &>(m_LiveDataMutex));
-  return m_LiveTimeSeries->serialize();
+  if (m_SamplePeriod.count() <= 0 ||
+      m_LiveDataTimeWindow >= m_PreTriggerDuration) {
+    return m_LiveTimeSeries->serialize();
+  }
+
+  // The rest of the live data is only kept to seed the trial
+  return m_LiveTimeSeries
+      ->tail(std::max(getSampleCount(m_LiveDataTimeWindow),
+                      static_cast<size_t>(1)))
+      .serialize();
 }
 
 const TimeSeries &DataCollector::getTrialData() const {
@@ -128,19 +248,173 @@ const TimeSeries &DataCollector::getTrialData() const {
   return *m_TrialTimeSeries;
 }
 
+TrialWriter::Metrics DataCollector::getTrialWriterMetrics() const {
+  return m_TrialWriter->getMetrics();
+}
+
+AcquisitionStatistics DataCollector::getAcquisitionStatistics() const {
+  std::lock_guard<std::mutex> lock(const_cast<std::mutex &>(m_LiveDataMutex));
+  auto statistics = m_LiveAcquisitionStatistics;
+  statistics.updateExpectedSampleCount();
+  return statistics;
+}
+
+AcquisitionStatistics DataCollector::getTrialAcquisitionStatistics() const {
+  std::lock_guard<std::mutex> lock(const_cast<std::mutex &>(m_LiveDataMutex));
+  auto statistics = m_TrialAcquisitionStatistics;
+  if (m_IsWritingTrial) {
+    statistics.updateExpectedSampleCount();
+  }
+  return statistics;
+}
+
+ClockSynchronizer DataCollector::getClockSynchronizer() const {
+  std::lock_guard<std::mutex> lock(const_cast<std::mutex &>(m_LiveDataMutex));
+  return m_ClockSynchronizer;
+}
+
+nlohmann::json DataCollector::getSerializedLiveClock() const {
+  std::lock_guard<std::mutex> lock(const_cast<std::mutex &>(m_LiveDataMutex));
+  size_t sampleCount = m_LiveAcquisitionStatistics.getReceivedSampleCount() +
+                       m_LiveAcquisitionStatistics.getDroppedSampleCount();
+  size_t liveSize = std::min(m_LiveTimeSeries->size(),
+                             m_LiveTimeSeries->getRollingVectorMaxSize());
+  return m_ClockSynchronizer.serialize(sampleCount - liveSize);
+}
+
+nlohmann::json DataCollector::getSerializedTrialClock() const {
+  std::lock_guard<std::mutex> lock(const_cast<std::mutex &>(m_LiveDataMutex));
+  const auto &synchronizer =
+      m_IsWritingTrial ? m_ClockSynchronizer : m_TrialClockSynchronizer;
+  return synchronizer.serialize(m_TrialFirstSampleIndex);
+}
+
+void DataCollector::setSamplePeriod(
+    const std::chrono::microseconds &samplePeriod) {
+  std::lock_guard<std::mutex> storageLock(m_LiveDataStorageMutex);
+  std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+  m_SamplePeriod = samplePeriod;
+  m_LiveTimeSeries->resizeRollingVector(getLiveDataCapacity());
+  m_ClockSynchronizer.reset(samplePeriod);
+}
+
+void DataCollector::reportDroppedSamples(
+    size_t count, AcquisitionStatistics::GapReason reason, size_t offset) {
+  if (!m_IsStreamingData || count == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+  m_LiveAcquisitionStatistics.addGap(count, reason, offset);
+  if (m_IsWritingTrial) {
+    m_TrialAcquisitionStatistics.addGap(count, reason, offset);
+  }
+  if (!m_PendingGaps.empty() && m_PendingGaps.back().first == offset) {
+    m_PendingGaps.back().second += count;
+  } else {
+    m_PendingGaps.emplace_back(offset, count);
+  }
+}
+
+void DataCollector::reportTimerOverrun() {
+  std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+  m_LiveAcquisitionStatistics.addTimerOverrun();
+  if (m_IsWritingTrial) {
+    m_TrialAcquisitionStatistics.addTimerOverrun();
+  }
+}
+
 void DataCollector::addDataPoints(
     const std::vector<std::vector<double>> &data) {
   if (!m_IsStreamingData || data.size() == 0) {
     return;
   }
+  STIMWALKER_TRACE_SCOPE("addDataPoints", "data");
+  // Only keep the live data in place for the block if someone is listening to
+  // it
+  bool hasBlockListeners = onNewDataBlock.getListenerCount() > 0;
+  std::unique_lock<std::mutex> storageLock(m_LiveDataStorageMutex,
+                                           std::defer_lock);
+  if (hasBlockListeners) {
+    storageLock.lock();
+  }
+
+  data::DataPoint lastDataPoint;
   {
     std::lock_guard<std::mutex> lock(m_LiveDataMutex);
-    for (auto d : data) {
-      m_LiveTimeSeries->add(d);
-      if (m_IsRecording) {
-        m_TrialTimeSeries->add(d);
+
+    m_LiveAcquisitionStatistics.addReceivedSamples(data.size());
+    if (m_SamplePeriod.count() > 0) {
+      m_ClockSynchronizer.addBlock(
+          m_LiveAcquisitionStatistics.getReceivedSampleCount() +
+              m_LiveAcquisitionStatistics.getDroppedSampleCount() - 1,
+          std::chrono::steady_clock::now());
+    }
+
+    // The losses after the last sample of the block come before the next one
+    auto firstLaterGap = std::find_if(
+        m_PendingGaps.begin(), m_PendingGaps.end(),
+        [&data](const auto &gap) { return gap.first >= data.size(); });
+    std::vector<std::pair<size_t, size_t>> laterGaps(firstLaterGap,
+                                                     m_PendingGaps.end());
+    m_PendingGaps.erase(firstLaterGap, m_PendingGaps.end());
+    for (auto &gap : laterGaps) {
+      gap.first -= data.size();
+    }
+
+    // The trial is appended by the writer thread
+    if (m_IsWritingTrial) {
+      bool isWritten;
+      if (m_TrialOverflowSampleCount > 0) {
+        // The blocks the writer dropped are a loss before this one
+        auto gaps = m_PendingGaps;
+        gaps.emplace(gaps.begin(), 0, m_TrialOverflowSampleCount);
+        isWritten = m_TrialWriter->write(
+            std::chrono::high_resolution_clock::now(), data, gaps);
+      } else {
+        isWritten = m_TrialWriter->write(
+            std::chrono::high_resolution_clock::now(), data, m_PendingGaps);
+      }
+
+      if (isWritten) {
+        m_TrialOverflowSampleCount = 0;
+        m_TrialAcquisitionStatistics.addReceivedSamples(data.size());
+      } else {
+        // The losses inside the dropped block are already counted, but the
+        // trial must still jump over them
+        m_TrialOverflowSampleCount += data.size();
+        for (const auto &gap : m_PendingGaps) {
+          m_TrialOverflowSampleCount += gap.second;
+        }
+        m_TrialAcquisitionStatistics.addGap(
+            data.size(),
+            AcquisitionStatistics::GapReason::WRITER_OVERFLOW);
+      }
+    }
+
+    auto gap = m_PendingGaps.begin();
+    for (size_t i = 0; i < data.size(); i++) {
+      for (; gap != m_PendingGaps.end() && gap->first == i; gap++) {
+        m_LiveTimeSeries->skip(gap->second);
       }
+      const auto &d = data[i];
+      m_LiveTimeSeries->add(d);
     }
-    onNewData.notifyListeners(m_LiveTimeSeries->back());
+    lastDataPoint = m_LiveTimeSeries->back();
+    m_PendingGaps = std::move(laterGaps);
+  }
+
+  // Notify outside of the lock so the listeners can read the live data
+  onNewData.notifyListeners(lastDataPoint);
+  if (hasBlockListeners) {
+    // The block views the values as stored (time stamped and zero levelled),
+    // without the ones the block itself rolled out
+    const auto &liveData = m_LiveTimeSeries->getData();
+    size_t liveSize = std::min(m_LiveTimeSeries->size(),
+                               m_LiveTimeSeries->getRollingVectorMaxSize());
+    size_t sampleCount = std::min(data.size(), liveSize);
+    onNewDataBlock.notifyListeners(
+        data::DataBlock(liveData, liveSize - sampleCount, sampleCount,
+                        lastDataPoint.size()));
   }
 }
\ No newline at end of file
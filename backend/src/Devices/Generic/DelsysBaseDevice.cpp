@@ -51,6 +51,19 @@ std::string DelsysBaseDevice::DataTcpDevice::deviceName() const {
   return "DelsysDataTcpDevice";
 }
 
+bool DelsysBaseDevice::DataTcpDevice::read(std::vector<char> &buffer) {
+  try {
+    asio::read(m_TcpSocket, asio::buffer(buffer.data(), buffer.size()));
+    return true;
+  } catch (std::exception &e) {
+    utils::Logger::getInstance().fatal(
+        "Error while reading the data to the device " + deviceName() +
+        ", disconnecting. (" + std::string(e.what()) + ")");
+    disconnect();
+    return false;
+  }
+}
+
 DeviceResponses DelsysBaseDevice::DataTcpDevice::parseAsyncSendCommand(
     const DeviceCommands &command, const std::any &data) {
   throw InvalidMethodException(
@@ -71,7 +84,8 @@ DelsysBaseDevice::DelsysBaseDevice(size_t channelCount,
       AsyncDataCollector(channelCount, DATA_COLLECTOR_TIMER, [deltaTime]() {
         return timeSeriesGenerator(deltaTime);
       }) {
-  m_IgnoreTooSlowWarning = true;
+  m_DataCheckWaitsForDevice = true;
+  setSamplePeriod(deltaTime);
 }
 
 DelsysBaseDevice::DelsysBaseDevice(size_t channelCount,
@@ -88,7 +102,8 @@ DelsysBaseDevice::DelsysBaseDevice(size_t channelCount,
       AsyncDataCollector(channelCount, DATA_COLLECTOR_TIMER, [deltaTime]() {
         return timeSeriesGenerator(deltaTime);
       }) {
-  m_IgnoreTooSlowWarning = true;
+  m_DataCheckWaitsForDevice = true;
+  setSamplePeriod(deltaTime);
 }
 
 DelsysBaseDevice::DelsysBaseDevice(
@@ -105,7 +120,8 @@ DelsysBaseDevice::DelsysBaseDevice(
       AsyncDataCollector(channelCount, DATA_COLLECTOR_TIMER, [deltaTime]() {
         return timeSeriesGenerator(deltaTime);
       }) {
-  m_IgnoreTooSlowWarning = true;
+  m_DataCheckWaitsForDevice = true;
+  setSamplePeriod(deltaTime);
 }
 
 DelsysBaseDevice::~DelsysBaseDevice() {
@@ -183,7 +199,16 @@ DelsysBaseDevice::parseAsyncSendCommand(const DeviceCommands &command,
 }
 
 void DelsysBaseDevice::dataCheck() {
-  m_DataDevice->read(m_DataBuffer);
+  bool wasConnected = m_DataDevice->getIsConnected();
+  if (!m_DataDevice->read(m_DataBuffer)) {
+    // The whole block is lost (only count it once, the device disconnects
+    // itself when a read fails)
+    if (wasConnected) {
+      reportDroppedSamples(m_SampleCount,
+                           data::AcquisitionStatistics::GapReason::FAILED_READ);
+    }
+    return;
+  }
 
   // Allocate space for all data in a single vector of floats
   std::vector<float> allData(m_SampleCount * m_DataChannelCount);
@@ -205,9 +230,14 @@ void DelsysBaseDevice::dataCheck() {
                               allDataAsDouble.begin() +
                                   (i + 1) * m_DataChannelCount);
 
-    // If the first frame is all zeros, assume no data were sent at all
+    // If the frame is all zeros, assume no data were sent at all. The gap is
+    // placed after the frames kept so far, so the whole block is still added
+    // at once
     if (std::all_of(frame.begin(), frame.end(),
                     [](double value) { return value == 0.0; })) {
+      reportDroppedSamples(1,
+                           data::AcquisitionStatistics::GapReason::EMPTY_FRAME,
+                           dataPoints.size());
       continue;
     }
     dataPoints.push_back(std::move(frame));
@@ -9,6 +9,18 @@ using namespace STIMWALKER_NAMESPACE::devices;
 
 Device::~Device() {}
 
+void Device::setEventMarkers(
+    std::shared_ptr<data::EventMarkerRecorder> eventMarkers) {
+  std::atomic_store(&m_EventMarkers, std::move(eventMarkers));
+}
+
+void Device::addEventMarker(data::EventMarkerType type, std::int64_t payload) {
+  auto eventMarkers = std::atomic_load(&m_EventMarkers);
+  if (eventMarkers != nullptr) {
+    eventMarkers->add(type, payload);
+  }
+}
+
 bool Device::connect() {
   auto &logger = utils::Logger::getInstance();
 
@@ -0,0 +1,23 @@
+#include "Devices/Generic/SerialFrameDecoder.h"
+
+using namespace STIMWALKER_NAMESPACE::devices;
+
+DelimitedFrameDecoder::DelimitedFrameDecoder(char delimiter)
+    : m_Delimiter(delimiter), m_SearchedLength(0) {}
+
+SerialFrameDecoder::Status
+DelimitedFrameDecoder::decode(const utils::ByteRingBuffer &buffer,
+                              size_t &length) {
+  // Only the bytes received since the previous call have to be searched
+  auto position = buffer.find(m_Delimiter, m_SearchedLength);
+  if (position == utils::ByteRingBuffer::npos) {
+    m_SearchedLength = buffer.size();
+    return Status::INCOMPLETE;
+  }
+
+  m_SearchedLength = 0;
+  length = position + 1;
+  return Status::FRAME;
+}
+
+void DelimitedFrameDecoder::reset() { m_SearchedLength = 0; }
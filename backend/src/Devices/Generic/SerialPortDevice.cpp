@@ -8,44 +8,227 @@
 #include <regex>
 #include <thread>
 
+#include "Devices/Exceptions.h"
 #include "Utils/Logger.h"
 
 using namespace STIMWALKER_NAMESPACE::devices;
 
 SerialPortDevice::SerialPortDevice(
-    const std::string &port, const std::chrono::microseconds &keepAliveInterval)
-    : m_Port(port), m_SerialPortContext(std::make_unique<asio::io_context>()),
-      AsyncDevice(keepAliveInterval) {}
+    const std::string &port, const std::chrono::microseconds &keepAliveInterval,
+    const SerialPortSettings &settings)
+    : AsyncDevice(keepAliveInterval), m_Port(port),
+      m_SerialPortContext(std::make_unique<asio::io_context>()),
+      m_SerialPortSettings(settings),
+      m_ReadTimeout(std::chrono::milliseconds(0)), m_WriteOperationCount(0),
+      m_ReceivedBytes(4096), m_IsWriting(false) {
+  m_ReadTimeoutTimer =
+      std::make_unique<asio::steady_timer>(*m_SerialPortContext);
+}
 
-bool SerialPortDevice::disconnect() {
-  if (m_SerialPort != nullptr && m_SerialPort->is_open()) {
-    m_SerialPort->close();
-  }
+SerialPortDevice::~SerialPortDevice() {
+  stopSerialPortWorker();
 
+  // The port must go before the context it was created with
+  m_ReadTimeoutTimer.reset();
+  m_SerialPort.reset();
+}
+
+bool SerialPortDevice::disconnect() {
+  stopSerialPortWorker();
   return AsyncDevice::disconnect();
 }
 
 bool SerialPortDevice::handleConnect() {
   m_SerialPort =
       std::make_unique<asio::serial_port>(*m_SerialPortContext, m_Port);
-  m_SerialPort->set_option(asio::serial_port_base::baud_rate(9600));
-  m_SerialPort->set_option(asio::serial_port_base::character_size(8));
-  m_SerialPort->set_option(asio::serial_port_base::stop_bits(
-      asio::serial_port_base::stop_bits::one));
   m_SerialPort->set_option(
-      asio::serial_port_base::parity(asio::serial_port_base::parity::none));
-  m_SerialPort->set_option(asio::serial_port_base::flow_control(
-      asio::serial_port_base::flow_control::none));
+      asio::serial_port_base::baud_rate(m_SerialPortSettings.baudRate));
+  m_SerialPort->set_option(asio::serial_port_base::character_size(
+      m_SerialPortSettings.characterSize));
+  m_SerialPort->set_option(
+      asio::serial_port_base::stop_bits(m_SerialPortSettings.stopBits));
+  m_SerialPort->set_option(
+      asio::serial_port_base::parity(m_SerialPortSettings.parity));
+  m_SerialPort->set_option(
+      asio::serial_port_base::flow_control(m_SerialPortSettings.flowControl));
 
+  startSerialPortWorker();
   return true;
 }
 
 bool SerialPortDevice::handleDisconnect() {
+  stopSerialPortWorker();
+  return true;
+}
+
+void SerialPortDevice::writeToDevice(const std::string &bytes) {
+  if (m_SerialPort == nullptr || !m_SerialPort->is_open()) {
+    throw DeviceException("The port " + m_Port + " is not open");
+  }
+
+  std::lock_guard<std::mutex> lock(m_WriteQueueMutex);
+  m_WriteQueue.append(bytes);
+  if (m_IsWriting) {
+    // The completion of the write in flight sends the queue
+    return;
+  }
+  m_IsWriting = true;
+  asio::post(*m_SerialPortContext, [this]() { writeNext(); });
+}
+
+void SerialPortDevice::handleReceivedBytes(const char *data, size_t size) {
+  while (size > 0) {
+    auto written = m_ReceivedBytes.write(data, size);
+    data += written;
+    size -= written;
+    decodeReceivedBytes();
+  }
+}
+
+void SerialPortDevice::handleReceivedFrame(const std::string &) {}
+
+void SerialPortDevice::handleReadTimeout(const std::string &droppedBytes) {
+  utils::Logger::getInstance().warning(
+      "The device {} dropped {} bytes of an incomplete frame", deviceName(),
+      droppedBytes.size());
+}
+
+void SerialPortDevice::startSerialPortWorker() {
+  m_ReceivedBytes.clear();
+  if (m_FrameDecoder != nullptr) {
+    m_FrameDecoder->reset();
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_WriteQueueMutex);
+    m_WriteQueue.clear();
+    m_IsWriting = false;
+  }
+
+  m_SerialPortContext->restart();
+  m_SerialPortWorkGuard = std::make_unique<
+      asio::executor_work_guard<asio::io_context::executor_type>>(
+      m_SerialPortContext->get_executor());
+  readNext();
+  m_SerialPortWorker = std::thread([this]() { m_SerialPortContext->run(); });
+}
+
+void SerialPortDevice::stopSerialPortWorker() {
+  if (m_SerialPortWorker.joinable()) {
+    // The port is not thread safe, so it is closed by the worker (which the
+    // work guard keeps running). Closing it aborts the pending operations,
+    // whose handlers are queued before the context is stopped so they finish
+    // first
+    asio::post(*m_SerialPortContext, [this]() {
+      closeSerialPort();
+      m_SerialPortWorkGuard.reset();
+      asio::post(*m_SerialPortContext,
+                 [this]() { m_SerialPortContext->stop(); });
+    });
+    m_SerialPortWorker.join();
+  }
+
+  // Without a worker, nothing else uses the port
+  closeSerialPort();
+}
+
+void SerialPortDevice::closeSerialPort() {
   if (m_SerialPort != nullptr && m_SerialPort->is_open()) {
-    m_SerialPort->close();
+    asio::error_code error;
+    m_SerialPort->close(error);
   }
+  m_ReadTimeoutTimer->cancel();
+}
 
-  return true;
+void SerialPortDevice::decodeReceivedBytes() {
+  if (m_FrameDecoder == nullptr) {
+    handleReceivedFrame(m_ReceivedBytes.read(m_ReceivedBytes.size()));
+    return;
+  }
+
+  while (!m_ReceivedBytes.empty()) {
+    size_t length = 0;
+    auto status = m_FrameDecoder->decode(m_ReceivedBytes, length);
+    if (status == SerialFrameDecoder::Status::INCOMPLETE) {
+      break;
+    }
+    if (status == SerialFrameDecoder::Status::SKIP) {
+      m_ReceivedBytes.consume(std::max(length, size_t(1)));
+      continue;
+    }
+    handleReceivedFrame(m_ReceivedBytes.read(length));
+  }
+
+  if (m_ReceivedBytes.full()) {
+    // No frame can be that long, start again from the next bytes
+    utils::Logger::getInstance().warning(
+        "The device {} received {} bytes without a frame", deviceName(),
+        m_ReceivedBytes.size());
+    m_ReceivedBytes.clear();
+    m_FrameDecoder->reset();
+  }
+}
+
+void SerialPortDevice::readNext() {
+  auto [region, size] = m_ReceivedBytes.writableRegion();
+  m_SerialPort->async_read_some(
+      asio::buffer(region, size),
+      [this](const asio::error_code &error, size_t byteCount) {
+        // The port was closed (or failed), stop reading
+        if (error) {
+          return;
+        }
+
+        m_ReceivedBytes.commitWrite(byteCount);
+        decodeReceivedBytes();
+
+        // Give a partial frame [ReadTimeout] to complete, from its last bytes
+        if (m_ReadTimeout.count() > 0 && !m_ReceivedBytes.empty()) {
+          m_ReadTimeoutTimer->expires_after(m_ReadTimeout);
+          m_ReadTimeoutTimer->async_wait([this](const asio::error_code &error) {
+            if (error || m_ReceivedBytes.empty()) {
+              return;
+            }
+            auto droppedBytes = m_ReceivedBytes.read(m_ReceivedBytes.size());
+            if (m_FrameDecoder != nullptr) {
+              m_FrameDecoder->reset();
+            }
+            handleReadTimeout(droppedBytes);
+          });
+        } else {
+          m_ReadTimeoutTimer->cancel();
+        }
+
+        readNext();
+      });
+}
+
+void SerialPortDevice::writeNext() {
+  {
+    std::lock_guard<std::mutex> lock(m_WriteQueueMutex);
+    if (m_WriteQueue.empty()) {
+      m_IsWriting = false;
+      return;
+    }
+    // Everything queued so far goes in a single write
+    m_BytesBeingWritten.swap(m_WriteQueue);
+    m_WriteQueue.clear();
+    m_WriteOperationCount++;
+  }
+
+  asio::async_write(
+      *m_SerialPort, asio::buffer(m_BytesBeingWritten),
+      [this](const asio::error_code &error, size_t) {
+        if (error) {
+          utils::Logger::getInstance().fatal(
+              "Could not write to the device {}: {}", deviceName(),
+              error.message());
+          std::lock_guard<std::mutex> lock(m_WriteQueueMutex);
+          m_WriteQueue.clear();
+          m_IsWriting = false;
+          return;
+        }
+        writeNext();
+      });
 }
 
 void SerialPortDevice::setFastCommunication(bool isFast) {
@@ -0,0 +1,85 @@
+#include "Devices/Generic/StimulationPlan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace STIMWALKER_NAMESPACE::devices;
+
+namespace {
+const double INFINITY_VALUE(std::numeric_limits<double>::infinity());
+
+// The largest value below zero, so the unknown (negative) inputs are out of
+// every condition on a known one
+const double BELOW_ZERO(std::nextafter(0.0, -INFINITY_VALUE));
+
+const CompiledCondition ALWAYS_MET = {CompiledCondition::ZERO, -INFINITY_VALUE,
+                                      INFINITY_VALUE};
+
+const CompiledCondition NEVER_MET = {CompiledCondition::ZERO, INFINITY_VALUE,
+                                     INFINITY_VALUE};
+} // namespace
+
+CompiledCondition
+StimulationPlan::compile(const StimulationCondition &condition) {
+  CompiledCondition compiled;
+  double threshold;
+  if (condition.getGaitPercentage() >= 0) {
+    compiled.source = condition.getSide() == StimulationSide::LEFT
+                          ? CompiledCondition::LEFT_PERCENTAGE
+                          : CompiledCondition::RIGHT_PERCENTAGE;
+    threshold = condition.getGaitPercentage();
+  } else {
+    compiled.source = CompiledCondition::STIMULATING_FOR;
+    threshold = static_cast<double>(condition.getDuration().count());
+  }
+
+  // A non-strict comparison is the strict one against the next value
+  switch (condition.getComparison()) {
+  case StimulationComparison::GREATER_OR_EQUAL:
+    compiled.lower =
+        std::max(std::nextafter(threshold, -INFINITY_VALUE), BELOW_ZERO);
+    compiled.upper = INFINITY_VALUE;
+    break;
+  case StimulationComparison::GREATER:
+    compiled.lower = std::max(threshold, BELOW_ZERO);
+    compiled.upper = INFINITY_VALUE;
+    break;
+  case StimulationComparison::LESS_OR_EQUAL:
+    compiled.lower = BELOW_ZERO;
+    compiled.upper = std::nextafter(threshold, INFINITY_VALUE);
+    break;
+  case StimulationComparison::LESS:
+    compiled.lower = BELOW_ZERO;
+    compiled.upper = threshold;
+    break;
+  }
+  return compiled;
+}
+
+CompiledRule StimulationPlan::compile(const StimulationRule &rule) {
+  CompiledRule compiled;
+  compiled.start = compile(*rule.getStart());
+  if (rule.getContinue()) {
+    compiled.keepGoing = compile(*rule.getContinue());
+    compiled.end = NEVER_MET;
+    compiled.stopsWhenStartIsLost = true;
+  } else {
+    compiled.keepGoing = ALWAYS_MET;
+    compiled.end = compile(*rule.getEnd());
+    compiled.stopsWhenStartIsLost = false;
+  }
+  return compiled;
+}
+
+void StimulationPlan::add(const StimulationRule &rule) {
+  m_Rules.push_back(compile(rule));
+}
+
+void StimulationPlan::clear() { m_Rules.clear(); }
+
+size_t StimulationPlan::size() const { return m_Rules.size(); }
+
+const std::vector<CompiledRule> &StimulationPlan::getRules() const {
+  return m_Rules;
+}
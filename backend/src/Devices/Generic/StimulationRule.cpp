@@ -0,0 +1,292 @@
+#include "Devices/Generic/StimulationRule.h"
+
+#include <array>
+#include <fstream>
+
+#include "Utils/Logger.h"
+
+using namespace STIMWALKER_NAMESPACE;
+using namespace STIMWALKER_NAMESPACE::devices;
+
+namespace {
+// The percentage of the stride of the gait events of the Python scheduler
+const std::array<std::pair<const char *, double>, 3> GAIT_EVENTS = {{
+    {"heel_strike_0", 0.0},
+    {"toe_off", 0.6},
+    {"heel_strike_100", 1.0},
+}};
+
+const std::chrono::microseconds NO_DURATION(-1);
+
+// Log [message] and throw it
+[[noreturn]] void invalidRule(const std::string &message) {
+  utils::Logger::getInstance().fatal(message);
+  throw InvalidStimulationRuleException(message);
+}
+
+StimulationComparison comparisonFromString(const std::string &comparison) {
+  if (comparison == "greater_or_equal" || comparison == ">=" ||
+      comparison == "from") {
+    return StimulationComparison::GREATER_OR_EQUAL;
+  } else if (comparison == "greater_than" || comparison == ">" ||
+             comparison == "after") {
+    return StimulationComparison::GREATER;
+  } else if (comparison == "less_or_equal" || comparison == "<=" ||
+             comparison == "up_to") {
+    return StimulationComparison::LESS_OR_EQUAL;
+  } else if (comparison == "less_than" || comparison == "<" ||
+             comparison == "before") {
+    return StimulationComparison::LESS;
+  }
+  invalidRule("Invalid comparison: " + comparison +
+              ". It must be either 'greater_or_equal', '>=' or 'from', "
+              "'greater_than', '>' or 'after', 'less_or_equal', '<=' or "
+              "'up_to', or 'less_than', '<' or 'before'");
+}
+
+std::string comparisonToString(StimulationComparison comparison) {
+  switch (comparison) {
+  case StimulationComparison::GREATER_OR_EQUAL:
+    return ">=";
+  case StimulationComparison::GREATER:
+    return ">";
+  case StimulationComparison::LESS_OR_EQUAL:
+    return "<=";
+  case StimulationComparison::LESS:
+    return "<";
+  }
+  return "";
+}
+
+template <typename T>
+bool compare(StimulationComparison comparison, const T &value,
+             const T &threshold) {
+  switch (comparison) {
+  case StimulationComparison::GREATER_OR_EQUAL:
+    return value >= threshold;
+  case StimulationComparison::GREATER:
+    return value > threshold;
+  case StimulationComparison::LESS_OR_EQUAL:
+    return value <= threshold;
+  case StimulationComparison::LESS:
+    return value < threshold;
+  }
+  return false;
+}
+} // namespace
+
+StimulationCondition::StimulationCondition(
+    StimulationComparison comparison, StimulationSide side,
+    double gaitPercentage, const std::chrono::microseconds &duration)
+    : m_Comparison(comparison), m_Side(side), m_GaitPercentage(gaitPercentage),
+      m_Duration(duration) {}
+
+StimulationCondition
+StimulationCondition::onGaitPercentage(StimulationComparison comparison,
+                                       StimulationSide side,
+                                       double gaitPercentage) {
+  if (side == StimulationSide::NONE) {
+    invalidRule("The side must be defined for a condition on the gait");
+  }
+  return StimulationCondition(comparison, side, gaitPercentage, NO_DURATION);
+}
+
+StimulationCondition
+StimulationCondition::onDuration(StimulationComparison comparison,
+                                 const std::chrono::microseconds &duration) {
+  return StimulationCondition(comparison, StimulationSide::NONE, -1.0,
+                              duration);
+}
+
+StimulationCondition::StimulationCondition(const nlohmann::json &json)
+    : m_Comparison(StimulationComparison::GREATER_OR_EQUAL),
+      m_Side(StimulationSide::NONE), m_GaitPercentage(-1.0),
+      m_Duration(NO_DURATION) {
+  if (json.contains("gait_event")) {
+    auto event = json["gait_event"].get<std::string>();
+    bool isFound = false;
+    for (const auto &[name, percentage] : GAIT_EVENTS) {
+      if (event == name) {
+        m_GaitPercentage = percentage;
+        isFound = true;
+        break;
+      }
+    }
+    if (!isFound) {
+      invalidRule("Invalid gait_event: " + event +
+                  ". It must be either 'heel_strike_0', 'heel_strike_100' or "
+                  "'toe_off'");
+    }
+  } else if (json.contains("gait_percentage")) {
+    m_GaitPercentage = json["gait_percentage"].get<double>();
+  }
+
+  if (json.contains("duration")) {
+    m_Duration = std::chrono::microseconds(
+        static_cast<int64_t>(json["duration"].get<double>() * 1e6));
+  }
+
+  if (m_GaitPercentage < 0 && m_Duration < std::chrono::microseconds(0)) {
+    invalidRule("gait_percentage or duration must be defined");
+  }
+
+  if (json.contains("side")) {
+    auto side = json["side"].get<std::string>();
+    if (side == "left") {
+      m_Side = StimulationSide::LEFT;
+    } else if (side == "right") {
+      m_Side = StimulationSide::RIGHT;
+    } else {
+      invalidRule("Invalid side: " + side +
+                  ". It must be either 'left' or 'right'");
+    }
+  } else if (m_GaitPercentage >= 0) {
+    invalidRule("The side must be defined if gait_percentage is defined");
+  }
+
+  if (!json.contains("comparison")) {
+    invalidRule("comparison must be defined");
+  }
+  m_Comparison = comparisonFromString(json["comparison"].get<std::string>());
+}
+
+bool StimulationCondition::isMet(
+    double leftPercentage, double rightPercentage,
+    const std::chrono::microseconds &stimulatingFor) const {
+  if (m_GaitPercentage >= 0) {
+    double percentage =
+        m_Side == StimulationSide::LEFT ? leftPercentage : rightPercentage;
+    return percentage >= 0 &&
+           compare(m_Comparison, percentage, m_GaitPercentage);
+  }
+  return stimulatingFor >= std::chrono::microseconds(0) &&
+         compare(m_Comparison, stimulatingFor, m_Duration);
+}
+
+nlohmann::json StimulationCondition::serialize() const {
+  nlohmann::json json;
+  json["comparison"] = comparisonToString(m_Comparison);
+  if (m_Side != StimulationSide::NONE) {
+    json["side"] = m_Side == StimulationSide::LEFT ? "left" : "right";
+  }
+
+  if (m_GaitPercentage >= 0) {
+    for (const auto &[name, percentage] : GAIT_EVENTS) {
+      if (m_GaitPercentage == percentage) {
+        json["gait_event"] = name;
+        break;
+      }
+    }
+    if (!json.contains("gait_event")) {
+      json["gait_percentage"] = m_GaitPercentage;
+    }
+  }
+  if (m_Duration >= std::chrono::microseconds(0)) {
+    json["duration"] = std::chrono::duration<double>(m_Duration).count();
+  }
+  return json;
+}
+
+StimulationRule::StimulationRule(
+    const std::string &name, const std::vector<size_t> &channels,
+    const std::vector<double> &amplitudes, const StimulationCondition &start,
+    const std::optional<StimulationCondition> &continueCondition,
+    const std::optional<StimulationCondition> &end)
+    : m_Name(name), m_Channels(channels), m_Amplitudes(amplitudes),
+      m_Start(start), m_Continue(continueCondition), m_End(end) {
+  validate();
+}
+
+StimulationRule::StimulationRule(const nlohmann::json &json) {
+  try {
+    if (!json.contains("name")) {
+      invalidRule("name must be defined");
+    }
+    m_Name = json["name"].get<std::string>();
+
+    if (!json.contains("pulse")) {
+      invalidRule("pulse must be defined");
+    }
+    const auto &pulse = json["pulse"];
+    if (!pulse.contains("channels")) {
+      invalidRule("channels must be defined in pulse");
+    }
+    m_Channels = pulse["channels"].get<std::vector<size_t>>();
+    if (!pulse.contains("amplitudes")) {
+      invalidRule("amplitudes must be defined in pulse");
+    }
+    m_Amplitudes = pulse["amplitudes"].get<std::vector<double>>();
+
+    if (json.contains("start_stimulating_rule")) {
+      m_Start = StimulationCondition(json["start_stimulating_rule"]);
+    }
+    if (json.contains("continue_stimulating_rule")) {
+      m_Continue = StimulationCondition(json["continue_stimulating_rule"]);
+    }
+    if (json.contains("end_stimulating_rule")) {
+      m_End = StimulationCondition(json["end_stimulating_rule"]);
+    }
+  } catch (const nlohmann::json::exception &e) {
+    invalidRule("Invalid stimulation rule: " + std::string(e.what()));
+  }
+  validate();
+}
+
+std::vector<StimulationRule>
+StimulationRule::fromJsonList(const nlohmann::json &json) {
+  if (!json.is_array()) {
+    invalidRule("The stimulation rules must be a list");
+  }
+
+  std::vector<StimulationRule> rules;
+  for (const auto &rule : json) {
+    rules.emplace_back(rule);
+  }
+  return rules;
+}
+
+std::vector<StimulationRule>
+StimulationRule::fromFile(const std::string &path) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    invalidRule("Could not open the stimulation rules file: " + path);
+  }
+
+  nlohmann::json json;
+  try {
+    file >> json;
+  } catch (const nlohmann::json::exception &e) {
+    invalidRule("Could not parse the stimulation rules file " + path + ": " +
+                e.what());
+  }
+  return fromJsonList(json);
+}
+
+nlohmann::json StimulationRule::serialize() const {
+  nlohmann::json json;
+  json["name"] = m_Name;
+  json["pulse"] = {{"channels", m_Channels}, {"amplitudes", m_Amplitudes}};
+  json["start_stimulating_rule"] = m_Start->serialize();
+  if (m_Continue) {
+    json["continue_stimulating_rule"] = m_Continue->serialize();
+  }
+  if (m_End) {
+    json["end_stimulating_rule"] = m_End->serialize();
+  }
+  return json;
+}
+
+void StimulationRule::validate() const {
+  if (m_Channels.size() != m_Amplitudes.size()) {
+    invalidRule("The rule " + m_Name +
+                " must have as many amplitudes as channels");
+  }
+  if (!m_Start) {
+    invalidRule("The rule " + m_Name + " must have a start_stimulating_rule");
+  }
+  if (!m_Continue && !m_End) {
+    invalidRule("The rule " + m_Name +
+                " must have a continue_stimulating_rule or an "
+                "end_stimulating_rule");
+  }
+}
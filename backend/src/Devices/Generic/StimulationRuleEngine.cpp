@@ -0,0 +1,246 @@
+#include "Devices/Generic/StimulationRuleEngine.h"
+
+#include <cmath>
+#include <limits>
+
+#include "Devices/Generic/DataCollector.h"
+#include "Devices/Generic/Stimulator.h"
+#include "Utils/Logger.h"
+
+using namespace STIMWALKER_NAMESPACE;
+using namespace STIMWALKER_NAMESPACE::devices;
+
+StimulationRuleEngine::StimulationRuleEngine(size_t leftHipChannel,
+                                             size_t rightHipChannel)
+    : m_LeftGait(leftHipChannel), m_RightGait(rightHipChannel),
+      m_Stimulator(nullptr), m_Collector(nullptr), m_ListenerId(0),
+      m_LastTimeStamp(0),
+      m_ProcessingTimes(std::chrono::nanoseconds(100), 4000) {}
+
+StimulationRuleEngine::~StimulationRuleEngine() { detach(); }
+
+size_t StimulationRuleEngine::addRule(const StimulationRule &rule) {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Rules.push_back(rule);
+  m_Plan.add(rule);
+  m_RuleStates.emplace_back();
+
+  // Make room for the channels of the rule, so nothing is allocated while
+  // processing the blocks
+  for (auto channel : rule.getChannels()) {
+    if (channel >= m_PendingAmplitudes.size()) {
+      m_PendingAmplitudes.resize(channel + 1,
+                                 std::numeric_limits<double>::quiet_NaN());
+    }
+  }
+  m_ChangedChannels.reserve(m_PendingAmplitudes.size());
+  m_ChangedAmplitudes.reserve(m_PendingAmplitudes.size());
+  m_PendingDecisions.reserve(m_Rules.size());
+  return m_Rules.size() - 1;
+}
+
+void StimulationRuleEngine::addRules(
+    const std::vector<StimulationRule> &rules) {
+  for (const auto &rule : rules) {
+    addRule(rule);
+  }
+}
+
+void StimulationRuleEngine::clearRules() {
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  stopAllRules(m_LastTimeStamp);
+  sendChangesToStimulator();
+  m_Rules.clear();
+  m_Plan.clear();
+  m_RuleStates.clear();
+  publishDecisions(lock);
+}
+
+size_t StimulationRuleEngine::getRuleCount() const {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Rules.size();
+}
+
+StimulationRule StimulationRuleEngine::getRule(size_t index) const {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Rules.at(index);
+}
+
+bool StimulationRuleEngine::isStimulating(size_t index) const {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_RuleStates.at(index).isStimulating;
+}
+
+void StimulationRuleEngine::setStimulator(Stimulator *stimulator) {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Stimulator = stimulator;
+}
+
+bool StimulationRuleEngine::attach(DataCollector &collector) {
+  detach();
+
+  size_t channelCount = collector.getDataChannelCount();
+  if (m_LeftGait.getHipChannel() >= channelCount ||
+      m_RightGait.getHipChannel() >= channelCount) {
+    utils::Logger::getInstance().fatal(
+        "Cannot evaluate the stimulation rules on a collector of {} channels "
+        "(the hip angles are expected on the channels {} and {})",
+        channelCount, m_LeftGait.getHipChannel(), m_RightGait.getHipChannel());
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_LeftGait.reset();
+    m_RightGait.reset();
+    for (auto &state : m_RuleStates) {
+      state = RuleState();
+    }
+    m_Collector = &collector;
+  }
+
+  m_ListenerId = collector.onNewDataBlock.listen(
+      [this](const data::DataBlock &block) { processBlock(block); });
+  return true;
+}
+
+void StimulationRuleEngine::detach() {
+  DataCollector *collector;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    collector = m_Collector;
+    m_Collector = nullptr;
+  }
+  if (collector == nullptr) {
+    return;
+  }
+
+  // This waits for the block being processed, so the lock must not be held
+  collector->onNewDataBlock.clear(m_ListenerId);
+
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  stopAllRules(m_LastTimeStamp);
+  sendChangesToStimulator();
+  publishDecisions(lock);
+}
+
+bool StimulationRuleEngine::isAttached() const {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Collector != nullptr;
+}
+
+void StimulationRuleEngine::processBlock(const data::DataBlock &block) {
+  auto start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(m_Mutex);
+
+  // Plain pointers, so the compiler does not reload the vectors on each write
+  // to a state
+  const CompiledRule *rules = m_Plan.getRules().data();
+  RuleState *states = m_RuleStates.data();
+  size_t ruleCount = m_Plan.size();
+  double inputs[CompiledCondition::SOURCE_COUNT] = {};
+  for (size_t i = 0; i < block.size(); i++) {
+    const auto &timeStamp = block.timeStamp(i);
+    inputs[CompiledCondition::LEFT_PERCENTAGE] =
+        m_LeftGait
+            .addSample(timeStamp, block.value(i, m_LeftGait.getHipChannel()))
+            .percentage;
+    inputs[CompiledCondition::RIGHT_PERCENTAGE] =
+        m_RightGait
+            .addSample(timeStamp, block.value(i, m_RightGait.getHipChannel()))
+            .percentage;
+
+    // The decisions are rare, so only they take a branch. A rule that stops
+    // is armed again if its start condition is not met, a rule that does not
+    // stimulate is armed as soon as its start condition is not met
+    for (size_t j = 0; j < ruleCount; j++) {
+      const auto &rule = rules[j];
+      auto &state = states[j];
+      inputs[CompiledCondition::STIMULATING_FOR] =
+          state.isStimulating
+              ? static_cast<double>((timeStamp - state.startedAt).count())
+              : -1.0;
+
+      bool shouldStart = rule.start.isMet(inputs);
+      bool shouldStop =
+          state.isStimulating &
+          ((rule.stopsWhenStartIsLost & !shouldStart) |
+           !rule.keepGoing.isMet(inputs) | rule.end.isMet(inputs));
+      bool isStarting = !state.isStimulating & shouldStart & state.isArmed;
+      state.isArmed = !(state.isStimulating & !shouldStop) & !shouldStart;
+
+      if (shouldStop | isStarting) {
+        state.isStimulating = isStarting;
+        state.startedAt = timeStamp;
+        queueChannels(j, isStarting);
+        m_PendingDecisions.push_back({timeStamp, j, isStarting});
+      }
+    }
+  }
+  if (!block.empty()) {
+    m_LastTimeStamp = block.timeStamp(block.size() - 1);
+  }
+
+  sendChangesToStimulator();
+  m_ProcessingTimes.add(std::chrono::steady_clock::now() - start);
+  publishDecisions(lock);
+}
+
+data::TimingHistogram StimulationRuleEngine::getProcessingTimes() const {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_ProcessingTimes;
+}
+
+void StimulationRuleEngine::stopAllRules(
+    const std::chrono::microseconds &timeStamp) {
+  for (size_t i = 0; i < m_RuleStates.size(); i++) {
+    auto &state = m_RuleStates[i];
+    if (state.isStimulating) {
+      state.isStimulating = false;
+      state.isArmed = true;
+      queueChannels(i, false);
+      m_PendingDecisions.push_back({timeStamp, i, false});
+    }
+  }
+}
+
+void StimulationRuleEngine::queueChannels(size_t index, bool isStarting) {
+  const auto &channels = m_Rules[index].getChannels();
+  const auto &amplitudes = m_Rules[index].getAmplitudes();
+  for (size_t i = 0; i < channels.size(); i++) {
+    m_PendingAmplitudes[channels[i]] = isStarting ? amplitudes[i] : 0.0;
+  }
+}
+
+void StimulationRuleEngine::sendChangesToStimulator() {
+  m_ChangedChannels.clear();
+  m_ChangedAmplitudes.clear();
+  for (size_t channel = 0; channel < m_PendingAmplitudes.size(); channel++) {
+    if (!std::isnan(m_PendingAmplitudes[channel])) {
+      m_ChangedChannels.push_back(channel);
+      m_ChangedAmplitudes.push_back(m_PendingAmplitudes[channel]);
+      m_PendingAmplitudes[channel] = std::numeric_limits<double>::quiet_NaN();
+    }
+  }
+
+  if (m_Stimulator != nullptr && !m_ChangedChannels.empty()) {
+    m_Stimulator->setChannelAmplitudes(m_ChangedChannels, m_ChangedAmplitudes);
+  }
+}
+
+void StimulationRuleEngine::publishDecisions(
+    std::unique_lock<std::mutex> &lock) {
+  if (m_PendingDecisions.empty()) {
+    lock.unlock();
+    return;
+  }
+
+  auto decisions = std::move(m_PendingDecisions);
+  m_PendingDecisions.clear();
+  m_PendingDecisions.reserve(m_Rules.size());
+  lock.unlock();
+
+  for (const auto &decision : decisions) {
+    onStimulationDecision.notifyListeners(decision);
+  }
+}
@@ -0,0 +1,216 @@
+#include "Devices/Generic/StimulationScheduler.h"
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif // __linux__
+
+#include "Devices/Generic/Stimulator.h"
+#include "Utils/Logger.h"
+
+using namespace STIMWALKER_NAMESPACE::devices;
+
+StimulationScheduler::StimulationScheduler(
+    const std::chrono::microseconds &spinDuration)
+    : m_NextRequestId(0), m_SpinDuration(spinDuration), m_IsRunning(true),
+      m_TimerFileDescriptor(-1), m_WakeUpFileDescriptor(-1) {
+#if defined(__linux__)
+  m_TimerFileDescriptor = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  m_WakeUpFileDescriptor = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (m_TimerFileDescriptor < 0 || m_WakeUpFileDescriptor < 0) {
+    utils::Logger::getInstance().warning(
+        "Could not create the timers of the stimulation scheduler, falling "
+        "back to a condition variable");
+    if (m_TimerFileDescriptor >= 0) {
+      close(m_TimerFileDescriptor);
+    }
+    if (m_WakeUpFileDescriptor >= 0) {
+      close(m_WakeUpFileDescriptor);
+    }
+    m_TimerFileDescriptor = -1;
+    m_WakeUpFileDescriptor = -1;
+  }
+#endif // __linux__
+
+  m_Worker = std::thread([this]() { workerLoop(); });
+}
+
+StimulationScheduler::~StimulationScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_IsRunning = false;
+  }
+  wakeWorker();
+
+  if (m_Worker.joinable()) {
+    m_Worker.join();
+  }
+
+  if (!m_Requests.empty()) {
+    utils::Logger::getInstance().warning(
+        "Dropped {} stimulation(s) that were still scheduled",
+        m_Requests.size());
+  }
+
+#if defined(__linux__)
+  if (m_TimerFileDescriptor >= 0) {
+    close(m_TimerFileDescriptor);
+  }
+  if (m_WakeUpFileDescriptor >= 0) {
+    close(m_WakeUpFileDescriptor);
+  }
+#endif // __linux__
+}
+
+size_t StimulationScheduler::schedule(
+    const std::chrono::steady_clock::time_point &deadline,
+    std::function<void()> action) {
+  size_t id;
+  bool isEarliest;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    id = m_NextRequestId++;
+    auto request = m_Requests.emplace(std::make_pair(deadline, id),
+                                      std::move(action));
+    isEarliest = request.first == m_Requests.begin();
+  }
+
+  // The worker only has to look again if it now sleeps for too long
+  if (isEarliest) {
+    wakeWorker();
+  }
+  return id;
+}
+
+size_t StimulationScheduler::schedule(
+    const std::chrono::steady_clock::time_point &deadline,
+    Stimulator &stimulator) {
+  return schedule(deadline, [&stimulator]() { stimulator.stimulate(); });
+}
+
+bool StimulationScheduler::cancel(size_t id) {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  for (auto it = m_Requests.begin(); it != m_Requests.end(); ++it) {
+    if (it->first.second == id) {
+      m_Requests.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t StimulationScheduler::getPendingCount() const {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Requests.size();
+}
+
+STIMWALKER_NAMESPACE::data::TimingHistogram
+StimulationScheduler::getTimingErrors() const {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_TimingErrors;
+}
+
+void StimulationScheduler::resetTimingErrors() {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_TimingErrors.clear();
+}
+
+void StimulationScheduler::workerLoop() {
+#if defined(__linux__)
+  // The default timer slack (50 us) would delay every wake-up
+  prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+#endif // __linux__
+
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  while (m_IsRunning) {
+    if (m_Requests.empty()) {
+      sleep(lock);
+      continue;
+    }
+
+    // Look at the queue again after any sleep, an earlier request may have
+    // arrived meanwhile
+    auto deadline = m_Requests.begin()->first.first;
+    auto wakeUp = deadline - m_SpinDuration;
+    if (std::chrono::steady_clock::now() < wakeUp) {
+      sleepUntil(lock, wakeUp);
+      continue;
+    }
+
+    auto action = std::move(m_Requests.begin()->second);
+    m_Requests.erase(m_Requests.begin());
+    lock.unlock();
+
+    auto now = std::chrono::steady_clock::now();
+    while (now < deadline) {
+      now = std::chrono::steady_clock::now();
+    }
+    try {
+      action();
+    } catch (const std::exception &e) {
+      utils::Logger::getInstance().fatal(
+          "A scheduled stimulation failed: {}", e.what());
+    }
+
+    lock.lock();
+    m_TimingErrors.add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline));
+  }
+}
+
+void StimulationScheduler::sleepUntil(
+    std::unique_lock<std::mutex> &lock,
+    const std::chrono::steady_clock::time_point &wakeUp) {
+#if defined(__linux__)
+  if (m_TimerFileDescriptor >= 0) {
+    // The steady clock is CLOCK_MONOTONIC, so the deadline is used as is.
+    // Setting the timer also forgets the expirations of the previous sleep
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           wakeUp.time_since_epoch())
+                           .count();
+    itimerspec timer{};
+    timer.it_value.tv_sec = static_cast<time_t>(nanoseconds / 1000000000);
+    timer.it_value.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+    timerfd_settime(m_TimerFileDescriptor, TFD_TIMER_ABSTIME, &timer, nullptr);
+
+    lock.unlock();
+    pollfd fds[2] = {{m_TimerFileDescriptor, POLLIN, 0},
+                     {m_WakeUpFileDescriptor, POLLIN, 0}};
+    poll(fds, 2, -1);
+    if (fds[1].revents & POLLIN) {
+      std::uint64_t count;
+      [[maybe_unused]] auto ignored =
+          read(m_WakeUpFileDescriptor, &count, sizeof(count));
+    }
+    lock.lock();
+    return;
+  }
+#endif // __linux__
+
+  m_Condition.wait_until(lock, wakeUp);
+}
+
+void StimulationScheduler::sleep(std::unique_lock<std::mutex> &lock) {
+  sleepUntil(lock, std::chrono::steady_clock::now() + std::chrono::hours(1));
+}
+
+void StimulationScheduler::wakeWorker() {
+#if defined(__linux__)
+  if (m_WakeUpFileDescriptor >= 0) {
+    std::uint64_t one = 1;
+    [[maybe_unused]] auto written =
+        write(m_WakeUpFileDescriptor, &one, sizeof(one));
+    return;
+  }
+#endif // __linux__
+
+  {
+    // Taking the lock makes sure the worker is either waiting or will see the
+    // change before waiting
+    std::lock_guard<std::mutex> lock(m_Mutex);
+  }
+  m_Condition.notify_one();
+}
@@ -0,0 +1,330 @@
+#include "Devices/Generic/UsbDeviceDiscovery.h"
+
+#include <algorithm>
+#include <cctype>
+
+#if defined(_WIN32)
+#include <cfgmgr32.h>
+#include <regex>
+#include <setupapi.h>
+#include <windows.h>
+#else // Linux or macOS
+#include <filesystem>
+#include <fstream>
+#endif // _WIN32
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif // __linux__
+
+#include "Utils/Logger.h"
+
+using namespace STIMWALKER_NAMESPACE::devices;
+
+namespace {
+std::string toUpper(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(), [](char c) {
+    return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  });
+  return value;
+}
+
+#if !defined(_WIN32)
+bool isUsbSerialPort(const std::string &name) {
+  return name.rfind("ttyUSB", 0) == 0 || name.rfind("ttyACM", 0) == 0;
+}
+
+// Read the first word of a file (empty if it cannot be read)
+std::string readWord(const std::filesystem::path &path) {
+  std::ifstream file(path);
+  std::string word;
+  file >> word;
+  return word;
+}
+#endif // !_WIN32
+} // namespace
+
+UsbDeviceDiscovery &UsbDeviceDiscovery::getInstance() {
+  static UsbDeviceDiscovery instance;
+  return instance;
+}
+
+UsbDeviceDiscovery::UsbDeviceDiscovery(const std::string &devRoot,
+                                       const std::string &sysRoot)
+    : m_DevRoot(devRoot), m_SysRoot(sysRoot), m_ScanCount(0),
+      m_IsIndexed(false), m_WatchFileDescriptor(-1),
+      m_PendingPortTimeout(std::chrono::seconds(5)) {
+#if defined(__linux__)
+  m_WatchFileDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_WatchFileDescriptor >= 0 &&
+      inotify_add_watch(m_WatchFileDescriptor, m_DevRoot.c_str(),
+                        IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) <
+          0) {
+    close(m_WatchFileDescriptor);
+    m_WatchFileDescriptor = -1;
+  }
+  if (m_WatchFileDescriptor < 0) {
+    utils::Logger::getInstance().warning(
+        "Could not watch {} for USB devices, the ports will be rescanned when "
+        "a device is not found",
+        m_DevRoot);
+  }
+#endif // __linux__
+}
+
+UsbDeviceDiscovery::~UsbDeviceDiscovery() {
+#if defined(__linux__)
+  if (m_WatchFileDescriptor >= 0) {
+    close(m_WatchFileDescriptor);
+  }
+#endif // __linux__
+}
+
+std::optional<UsbDeviceDiscovery::UsbPort>
+UsbDeviceDiscovery::find(const std::string &vid, const std::string &pid) {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  update();
+
+  auto names = m_NamesByIds.find(key(vid, pid));
+  if (names == m_NamesByIds.end() && !isWatching()) {
+    // Without hotplug events, the device may have been plugged since the scan
+    scan();
+    names = m_NamesByIds.find(key(vid, pid));
+  }
+  if (names == m_NamesByIds.end()) {
+    return std::nullopt;
+  }
+  return m_PortsByName.at(names->second.front());
+}
+
+std::vector<UsbDeviceDiscovery::UsbPort> UsbDeviceDiscovery::getPorts() {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  update();
+
+  std::vector<std::string> names;
+  for (const auto &[name, port] : m_PortsByName) {
+    names.push_back(name);
+  }
+  std::sort(names.begin(), names.end());
+
+  std::vector<UsbPort> ports;
+  for (const auto &name : names) {
+    ports.push_back(m_PortsByName.at(name));
+  }
+  return ports;
+}
+
+void UsbDeviceDiscovery::refresh() {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  scan();
+}
+
+bool UsbDeviceDiscovery::isWatching() const {
+  return m_WatchFileDescriptor >= 0;
+}
+
+void UsbDeviceDiscovery::update() {
+  if (!m_IsIndexed) {
+    scan();
+    return;
+  }
+
+#if defined(__linux__)
+  if (m_WatchFileDescriptor < 0) {
+    return;
+  }
+
+  alignas(inotify_event) char buffer[4096];
+  while (true) {
+    auto length = read(m_WatchFileDescriptor, buffer, sizeof(buffer));
+    if (length <= 0) {
+      // Nothing pending (the watch does not block)
+      break;
+    }
+
+    for (char *ptr = buffer; ptr < buffer + length;) {
+      auto *event = reinterpret_cast<inotify_event *>(ptr);
+      ptr += sizeof(inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Some events were lost, the index cannot be trusted anymore
+        scan();
+        continue;
+      }
+      if (event->len == 0) {
+        continue;
+      }
+
+      std::string name(event->name);
+      if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+        addPort(name);
+      } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+        removePort(name);
+      }
+    }
+  }
+
+  // The device file can be created before the kernel links it to its USB
+  // device in the sysfs, so the ports missing their IDs are tried again for a
+  // while (a port that never gets them is not a USB device we can use)
+  auto now = std::chrono::steady_clock::now();
+  std::vector<std::string> pendingNames;
+  for (auto pending = m_PendingNames.begin();
+       pending != m_PendingNames.end();) {
+    if (now - pending->second > m_PendingPortTimeout) {
+      utils::Logger::getInstance().warning(
+          "The IDs of the port {} could not be read, it is ignored until the "
+          "next scan",
+          pending->first);
+      pending = m_PendingNames.erase(pending);
+      continue;
+    }
+    pendingNames.push_back(pending->first);
+    pending++;
+  }
+  for (const auto &name : pendingNames) {
+    addPort(name);
+  }
+#endif // __linux__
+}
+
+void UsbDeviceDiscovery::scan() {
+  m_PortsByName.clear();
+  m_NamesByIds.clear();
+  m_PendingNames.clear();
+  m_IsIndexed = true;
+  m_ScanCount++;
+
+#if defined(_WIN32)
+  // Get the device information set for all the USB devices
+  HDEVINFO deviceInfoSet =
+      SetupDiGetClassDevs(NULL, "USB", NULL, DIGCF_PRESENT | DIGCF_ALLCLASSES);
+  if (deviceInfoSet == INVALID_HANDLE_VALUE) {
+    utils::Logger::getInstance().warning(
+        "Failed to get device information set");
+    return;
+  }
+
+  SP_DEVINFO_DATA deviceInfoData;
+  deviceInfoData.cbSize = sizeof(SP_DEVINFO_DATA);
+  DWORD deviceIndex = 0;
+  std::regex vidPidRegex("VID_([0-9A-F]+)&PID_([0-9A-F]+)", std::regex::icase);
+
+  // Iterate through the device info set
+  while (SetupDiEnumDeviceInfo(deviceInfoSet, deviceIndex, &deviceInfoData)) {
+    deviceIndex++;
+
+    // Get the DeviceInstanceID
+    char deviceInstanceId[MAX_DEVICE_ID_LEN];
+    if (!SetupDiGetDeviceInstanceIdA(deviceInfoSet, &deviceInfoData,
+                                     deviceInstanceId,
+                                     sizeof(deviceInstanceId), NULL)) {
+      continue;
+    }
+    std::string deviceInstanceStr(deviceInstanceId);
+
+    // Check if this device is associated with a COM port
+    HKEY hDeviceRegistryKey =
+        SetupDiOpenDevRegKey(deviceInfoSet, &deviceInfoData, DICS_FLAG_GLOBAL,
+                             0, DIREG_DEV, KEY_READ);
+    if (hDeviceRegistryKey == INVALID_HANDLE_VALUE) {
+      continue;
+    }
+
+    char portName[256];
+    DWORD portNameSize = sizeof(portName);
+    DWORD regType = 0;
+    if (RegQueryValueExA(hDeviceRegistryKey, "PortName", NULL, &regType,
+                         (LPBYTE)portName, &portNameSize) == ERROR_SUCCESS) {
+      std::smatch match;
+      if (std::regex_search(deviceInstanceStr, match, vidPidRegex)) {
+        insertPort(portName, UsbPort{portName, toUpper(match.str(1)),
+                                     toUpper(match.str(2))});
+      }
+    }
+    RegCloseKey(hDeviceRegistryKey);
+  }
+  SetupDiDestroyDeviceInfoList(deviceInfoSet);
+
+#else
+  std::error_code error;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(m_DevRoot, error)) {
+    addPort(entry.path().filename().string());
+  }
+#endif // _WIN32
+}
+
+void UsbDeviceDiscovery::addPort(const std::string &name) {
+#if !defined(_WIN32)
+  if (!isUsbSerialPort(name)) {
+    return;
+  }
+
+  // The tty device is an interface (or a port) of the USB device, the IDs are
+  // in the first parent that has them
+  std::error_code error;
+  auto sysRoot = std::filesystem::weakly_canonical(m_SysRoot, error);
+  auto path = std::filesystem::canonical(
+      std::filesystem::path(m_SysRoot) / "class" / "tty" / name / "device",
+      error);
+  if (error) {
+    m_PendingNames.emplace(name, std::chrono::steady_clock::now());
+    return;
+  }
+
+  for (int depth = 0; depth < 4; depth++) {
+    if (std::filesystem::exists(path / "idVendor", error) &&
+        std::filesystem::exists(path / "idProduct", error)) {
+      auto vid = readWord(path / "idVendor");
+      auto pid = readWord(path / "idProduct");
+      if (vid.empty() || pid.empty()) {
+        m_PendingNames.emplace(name, std::chrono::steady_clock::now());
+        return;
+      }
+      insertPort(name,
+                 UsbPort{(std::filesystem::path(m_DevRoot) / name).string(),
+                         toUpper(vid), toUpper(pid)});
+      return;
+    }
+    if (path == sysRoot || !path.has_parent_path()) {
+      return;
+    }
+    path = path.parent_path();
+  }
+#endif // !_WIN32
+}
+
+void UsbDeviceDiscovery::insertPort(const std::string &name,
+                                    const UsbPort &port) {
+  removePort(name);
+  m_PendingNames.erase(name);
+  m_PortsByName[name] = port;
+
+  auto &names = m_NamesByIds[key(port.vid, port.pid)];
+  names.insert(std::upper_bound(names.begin(), names.end(), name), name);
+}
+
+void UsbDeviceDiscovery::removePort(const std::string &name) {
+  m_PendingNames.erase(name);
+  auto port = m_PortsByName.find(name);
+  if (port == m_PortsByName.end()) {
+    return;
+  }
+
+  auto names = m_NamesByIds.find(key(port->second.vid, port->second.pid));
+  if (names != m_NamesByIds.end()) {
+    auto &list = names->second;
+    list.erase(std::remove(list.begin(), list.end(), name), list.end());
+    if (list.empty()) {
+      m_NamesByIds.erase(names);
+    }
+  }
+  m_PortsByName.erase(port);
+}
+
+std::string UsbDeviceDiscovery::key(const std::string &vid,
+                                    const std::string &pid) {
+  return toUpper(vid) + ":" + toUpper(pid);
+}
@@ -13,6 +13,8 @@ TcpClient::TcpClient(std::string host, int commandPort, int responsePort,
                      int liveDataPort)
     : m_Host(host), m_CommandPort(commandPort), m_ResponsePort(responsePort),
       m_LiveDataPort(liveDataPort), m_IsConnected(false),
+      m_LiveDataUpdateCount(0), m_LiveDataByteCount(0),
+      m_LiveDataLatencies(std::chrono::milliseconds(1), 20000),
       m_ProtocolVersion(1) {};
 
 TcpClient::~TcpClient() {
@@ -105,6 +107,32 @@ bool TcpClient::addMagstimDevice() {
   return true;
 }
 
+bool TcpClient::addLokomatDevice() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (sendCommand(TcpServerCommand::CONNECT_LOKOMAT) ==
+      TcpServerResponse::NOK) {
+    logger.fatal("CLIENT: Failed to add Lokomat device");
+    return false;
+  }
+
+  logger.info("CLIENT: Lokomat device added");
+  return true;
+}
+
+bool TcpClient::addRehastimDevice() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (sendCommand(TcpServerCommand::CONNECT_REHASTIM) ==
+      TcpServerResponse::NOK) {
+    logger.fatal("CLIENT: Failed to add RehaStim device");
+    return false;
+  }
+
+  logger.info("CLIENT: RehaStim device added");
+  return true;
+}
+
 bool TcpClient::removeDelsysAnalogDevice() {
   auto &logger = utils::Logger::getInstance();
 
@@ -144,6 +172,32 @@ bool TcpClient::removeMagstimDevice() {
   return true;
 }
 
+bool TcpClient::removeLokomatDevice() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (sendCommand(TcpServerCommand::DISCONNECT_LOKOMAT) ==
+      TcpServerResponse::NOK) {
+    logger.fatal("CLIENT: Failed to remove Lokomat device");
+    return false;
+  }
+
+  logger.info("CLIENT: Lokomat device removed");
+  return true;
+}
+
+bool TcpClient::removeRehastimDevice() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (sendCommand(TcpServerCommand::DISCONNECT_REHASTIM) ==
+      TcpServerResponse::NOK) {
+    logger.fatal("CLIENT: Failed to remove RehaStim device");
+    return false;
+  }
+
+  logger.info("CLIENT: RehaStim device removed");
+  return true;
+}
+
 bool TcpClient::startRecording() {
   auto &logger = utils::Logger::getInstance();
 
@@ -169,6 +223,85 @@ bool TcpClient::stopRecording() {
   return true;
 }
 
+bool TcpClient::startTracing() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (sendCommand(TcpServerCommand::START_TRACING) == TcpServerResponse::NOK) {
+    logger.fatal("CLIENT: Failed to start tracing");
+    return false;
+  }
+
+  logger.info("CLIENT: Tracing started");
+  return true;
+}
+
+bool TcpClient::stopTracing() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (sendCommand(TcpServerCommand::STOP_TRACING) == TcpServerResponse::NOK) {
+    logger.fatal("CLIENT: Failed to stop tracing");
+    return false;
+  }
+
+  logger.info("CLIENT: Tracing stopped");
+  return true;
+}
+
+bool TcpClient::startStimulationRules() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (sendCommand(TcpServerCommand::START_STIMULATION_RULES) ==
+      TcpServerResponse::NOK) {
+    logger.fatal("CLIENT: Failed to start the stimulation rules");
+    return false;
+  }
+
+  logger.info("CLIENT: Stimulation rules started");
+  return true;
+}
+
+bool TcpClient::stopStimulationRules() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (sendCommand(TcpServerCommand::STOP_STIMULATION_RULES) ==
+      TcpServerResponse::NOK) {
+    logger.fatal("CLIENT: Failed to stop the stimulation rules");
+    return false;
+  }
+
+  logger.info("CLIENT: Stimulation rules stopped");
+  return true;
+}
+
+bool TcpClient::setLiveDataTimeWindow(const std::chrono::milliseconds &window) {
+  auto &logger = utils::Logger::getInstance();
+
+  if (sendCommand(TcpServerCommand::SET_LIVE_DATA_TIME_WINDOW,
+                  static_cast<std::uint32_t>(window.count())) ==
+      TcpServerResponse::NOK) {
+    logger.fatal("CLIENT: Failed to set the live data time window");
+    return false;
+  }
+
+  logger.info("CLIENT: Live data time window set to {} ms", window.count());
+  return true;
+}
+
+bool TcpClient::setPreTriggerDuration(
+    const std::chrono::milliseconds &duration) {
+  auto &logger = utils::Logger::getInstance();
+
+  if (sendCommand(TcpServerCommand::SET_PRE_TRIGGER_DURATION,
+                  static_cast<std::uint32_t>(duration.count())) ==
+      TcpServerResponse::NOK) {
+    logger.fatal("CLIENT: Failed to set the pre-trigger duration");
+    return false;
+  }
+
+  logger.info("CLIENT: Pre-trigger duration set to {} ms", duration.count());
+  return true;
+}
+
 std::map<std::string, data::TimeSeries> TcpClient::getLastTrialData() {
   auto &logger = utils::Logger::getInstance();
   logger.info("CLIENT: Fetching the last trial data");
@@ -179,7 +312,8 @@ std::map<std::string, data::TimeSeries> TcpClient::getLastTrialData() {
   // Parse the data
   std::map<std::string, data::TimeSeries> data;
   try {
-    data = devices::Devices::deserializeData(nlohmann::json::parse(dataBuffer));
+    data = devices::Devices::deserializeData(
+        nlohmann::json::parse(dataBuffer).at(devices::Devices::DEVICES_KEY));
   } catch (...) {
     logger.fatal("CLIENT: Failed to parse the last trial data");
     return std::map<std::string, data::TimeSeries>();
@@ -189,6 +323,23 @@ std::map<std::string, data::TimeSeries> TcpClient::getLastTrialData() {
   return data;
 }
 
+std::map<std::string, data::DataCheckTimings>
+TcpClient::getDataCheckTimings() {
+  std::vector<char> dataBuffer =
+      sendCommandWithResponse(TcpServerCommand::GET_DATA_CHECK_TIMINGS);
+
+  std::map<std::string, data::DataCheckTimings> timings;
+  try {
+    timings = devices::Devices::deserializeDataCheckTimings(
+        nlohmann::json::parse(dataBuffer));
+  } catch (...) {
+    utils::Logger::getInstance().fatal(
+        "CLIENT: Failed to parse the timing of the data checks");
+    return std::map<std::string, data::DataCheckTimings>();
+  }
+  return timings;
+}
+
 void TcpClient::startUpdatingLiveData() {
   m_LiveDataWorker = std::thread([this]() {
     while (m_IsConnected) {
@@ -200,7 +351,8 @@ void TcpClient::startUpdatingLiveData() {
 void TcpClient::updateLiveData() {
   auto &logger = utils::Logger::getInstance();
 
-  auto dataBuffer = waitForResponse(*m_LiveDataSocket);
+  std::chrono::system_clock::time_point sentAt;
+  auto dataBuffer = waitForResponse(*m_LiveDataSocket, sentAt);
   std::map<std::string, data::TimeSeries> data;
   try {
     data = devices::Devices::deserializeData(nlohmann::json::parse(dataBuffer));
@@ -209,7 +361,28 @@ void TcpClient::updateLiveData() {
     return;
   }
 
-  logger.debug("CLIENT: Live data received");
+  {
+    std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+    m_LiveDataUpdateCount++;
+    m_LiveDataByteCount += BYTES_IN_SERVER_PACKET_HEADER + dataBuffer.size();
+    m_LiveDataLatencies.add(std::chrono::system_clock::now() - sentAt);
+  }
+  STIMWALKER_LOG_DEBUG("CLIENT: Live data received");
+}
+
+size_t TcpClient::getLiveDataUpdateCount() const {
+  std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+  return m_LiveDataUpdateCount;
+}
+
+size_t TcpClient::getLiveDataByteCount() const {
+  std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+  return m_LiveDataByteCount;
+}
+
+data::TimingHistogram TcpClient::getLiveDataLatencies() const {
+  std::lock_guard<std::mutex> lock(m_LiveDataMutex);
+  return m_LiveDataLatencies;
 }
 
 TcpServerResponse TcpClient::sendCommand(TcpServerCommand command) {
@@ -238,6 +411,37 @@ TcpServerResponse TcpClient::sendCommand(TcpServerCommand command) {
   return response;
 }
 
+TcpServerResponse TcpClient::sendCommand(TcpServerCommand command,
+                                         std::uint32_t argument) {
+  auto &logger = utils::Logger::getInstance();
+
+  if (!m_IsConnected) {
+    logger.fatal("CLIENT: Client is not connected");
+    return TcpServerResponse::NOK;
+  }
+
+  // Send the command and its argument at once
+  auto commandPacket = constructCommandPacket(command);
+  auto argumentPacket = constructArgumentPacket(argument);
+  std::array<asio::const_buffer, 2> packets = {asio::buffer(commandPacket),
+                                               asio::buffer(argumentPacket)};
+  asio::error_code error;
+  size_t byteWritten = asio::write(*m_CommandSocket, packets, error);
+
+  if (byteWritten != 2 * BYTES_IN_CLIENT_PACKET_HEADER || error) {
+    logger.fatal("CLIENT: TCP write error: " + error.message());
+    disconnect();
+    return TcpServerResponse::NOK;
+  }
+
+  auto response = waitForCommandAcknowledgment();
+  if (response == TcpServerResponse::NOK) {
+    logger.warning("CLIENT: Failed to get confirmation for command: " +
+                   std::to_string(static_cast<std::uint32_t>(command)));
+  }
+  return response;
+}
+
 std::vector<char> TcpClient::sendCommandWithResponse(TcpServerCommand command) {
   auto &logger = utils::Logger::getInstance();
 
@@ -280,6 +484,13 @@ TcpServerResponse TcpClient::waitForCommandAcknowledgment() {
 }
 
 std::vector<char> TcpClient::waitForResponse(asio::ip::tcp::socket &socket) {
+  std::chrono::system_clock::time_point sentAt;
+  return waitForResponse(socket, sentAt);
+}
+
+std::vector<char>
+TcpClient::waitForResponse(asio::ip::tcp::socket &socket,
+                           std::chrono::system_clock::time_point &sentAt) {
   auto buffer = std::array<char, BYTES_IN_SERVER_PACKET_HEADER>();
   asio::error_code error;
   size_t byteRead = asio::read(socket, asio::buffer(buffer), error);
@@ -289,6 +500,7 @@ std::vector<char> TcpClient::waitForResponse(asio::ip::tcp::socket &socket) {
     return std::vector<char>();
   }
 
+  sentAt = parseTimeStampFromPacket(buffer);
   std::uint32_t totalByteCount =
       static_cast<std::uint32_t>(parseAcknowledgmentFromPacket(buffer));
   std::vector<char> dataBuffer(totalByteCount);
@@ -332,6 +544,21 @@ TcpClient::constructCommandPacket(TcpServerCommand command) {
   return packet;
 }
 
+std::array<char, BYTES_IN_CLIENT_PACKET_HEADER>
+TcpClient::constructArgumentPacket(std::uint32_t argument) {
+  // Arguments have the same layout as the commands
+  // - First 4 bytes are the version number
+  // - Next 4 bytes are the argument
+
+  auto packet = std::array<char, BYTES_IN_CLIENT_PACKET_HEADER>();
+  packet.fill('\0');
+  std::memcpy(packet.data(), &m_ProtocolVersion, sizeof(std::uint32_t));
+  std::memcpy(packet.data() + sizeof(std::uint32_t), &argument,
+              sizeof(std::uint32_t));
+
+  return packet;
+}
+
 TcpServerResponse TcpClient::parseAcknowledgmentFromPacket(
     const std::array<char, BYTES_IN_SERVER_PACKET_HEADER> &buffer) {
   // Packets are exactly 16 bytes long, little-endian
@@ -1,14 +1,19 @@
 #include "Server/TcpServer.h"
 
 #include "Utils/Logger.h"
+#include "Utils/Tracer.h"
 #include <asio/steady_timer.hpp>
 #include <thread>
 
 #include "Devices/Concrete/DelsysAnalogDevice.h"
 #include "Devices/Concrete/DelsysEmgDevice.h"
+#include "Devices/Concrete/LokomatDevice.h"
 #include "Devices/Concrete/MagstimRapidDevice.h"
+#include "Devices/Concrete/RehastimDevice.h"
 #include "Devices/Generic/DelsysBaseDevice.h"
+#include "Devices/Generic/DataCollector.h"
 #include "Devices/Generic/Device.h"
+#include "Devices/Generic/Stimulator.h"
 
 using namespace STIMWALKER_NAMESPACE::server;
 
@@ -19,18 +24,77 @@ const size_t BYTES_IN_SERVER_PACKET_HEADER = 16;
 const std::string DEVICE_NAME_DELSYS_EMG = "DelsysEmgDevice";
 const std::string DEVICE_NAME_DELSYS_ANALOG = "DelsysAnalogDevice";
 const std::string DEVICE_NAME_MAGSTIM = "MagstimRapidDevice";
+const std::string DEVICE_NAME_LOKOMAT = "LokomatDevice";
+const std::string DEVICE_NAME_REHASTIM = "RehastimDevice";
+
+// The file where the trace is saved if STIMWALKER_TRACE_FILE is not set
+const std::string DEFAULT_TRACE_FILE = "stimwalker_trace.json";
+
+// The file of the stimulation rules if STIMWALKER_STIMULATION_RULES_FILE is
+// not set (the same name as the default rules of the Python scheduler)
+const std::string DEFAULT_STIMULATION_RULES_FILE =
+    "default_stimulations_schedules_rules.json";
+
+// The serial port of the RehaStim if STIMWALKER_REHASTIM_PORT is not set
+#ifdef _WIN32
+const std::string DEFAULT_REHASTIM_PORT = "COM1";
+#else
+const std::string DEFAULT_REHASTIM_PORT = "/dev/ttyUSB0";
+#endif // _WIN32
+
+// The channels of the hip angles of the Lokomat
+const size_t LOKOMAT_LEFT_HIP_CHANNEL = 0;
+const size_t LOKOMAT_RIGHT_HIP_CHANNEL = 2;
+
+namespace {
+std::string defaultStimulationRulesPath() {
+  const char *path = std::getenv("STIMWALKER_STIMULATION_RULES_FILE");
+  return path != nullptr ? path : DEFAULT_STIMULATION_RULES_FILE;
+}
+
+std::string defaultRehastimPort() {
+  const char *port = std::getenv("STIMWALKER_REHASTIM_PORT");
+  return port != nullptr ? port : DEFAULT_REHASTIM_PORT;
+}
+} // namespace
 
 TcpServer::TcpServer(int commandPort, int responsePort, int liveDataPort)
     : m_IsClientConnecting(false), m_IsServerRunning(false),
       m_CommandPort(commandPort), m_ResponsePort(responsePort),
       m_LiveDataPort(liveDataPort),
-      m_TimeoutPeriod(std::chrono::milliseconds(5000)), m_ProtocolVersion(1) {};
+      m_TimeoutPeriod(std::chrono::milliseconds(5000)),
+      m_StimulationRulesPath(defaultStimulationRulesPath()),
+      m_RehastimPort(defaultRehastimPort()),
+      m_StimulationRules(LOKOMAT_LEFT_HIP_CHANNEL, LOKOMAT_RIGHT_HIP_CHANNEL),
+      m_ProtocolVersion(1) {
+  // Keep a trace of the decisions so they can be aligned with the data
+  m_StimulationRules.onStimulationDecision.listen(
+      [this](const devices::StimulationDecision &decision) {
+        auto type = decision.isStarting
+                        ? data::EventMarkerType::STIMULATION_RULE_STARTED
+                        : data::EventMarkerType::STIMULATION_RULE_STOPPED;
+        m_Devices.addEventMarker(type,
+                                 static_cast<std::int64_t>(decision.ruleIndex));
+        STIMWALKER_LOG_INFO("Stimulation rule {} {} stimulating",
+                            decision.ruleIndex,
+                            decision.isStarting ? "started" : "stopped");
+      });
+};
 
 TcpServer::~TcpServer() {
   std::lock_guard<std::mutex> lock(m_Mutex);
   if (m_IsServerRunning) {
     stopServer();
   }
+
+  // The sockets and the acceptors use the services of [m_Context], which is
+  // destroyed before them
+  m_CommandSocket.reset();
+  m_ResponseSocket.reset();
+  m_LiveDataSocket.reset();
+  m_CommandAcceptor.reset();
+  m_ResponseAcceptor.reset();
+  m_LiveDataAcceptor.reset();
 }
 
 void TcpServer::startServer() {
@@ -348,9 +412,14 @@ bool TcpServer::handleHandshake(TcpServerCommand command) {
 }
 
 bool TcpServer::handleCommand(TcpServerCommand command) {
+  STIMWALKER_TRACE_SCOPE("handleCommand", "server");
   auto &logger = utils::Logger::getInstance();
   asio::error_code error;
 
+  // Keep a trace of the command so it can be aligned with the data
+  m_Devices.addEventMarker(data::EventMarkerType::SERVER_COMMAND,
+                           static_cast<std::int64_t>(command));
+
   // Handle the command
   TcpServerResponse response;
   switch (command) {
@@ -369,6 +438,16 @@ bool TcpServer::handleCommand(TcpServerCommand command) {
                                               : TcpServerResponse::NOK;
     break;
 
+  case TcpServerCommand::CONNECT_LOKOMAT:
+    response = addDevice(DEVICE_NAME_LOKOMAT) ? TcpServerResponse::OK
+                                              : TcpServerResponse::NOK;
+    break;
+
+  case TcpServerCommand::CONNECT_REHASTIM:
+    response = addDevice(DEVICE_NAME_REHASTIM) ? TcpServerResponse::OK
+                                               : TcpServerResponse::NOK;
+    break;
+
   case TcpServerCommand::ZERO_DELSYS_ANALOG:
     response = m_Devices.zeroLevelDevice(DEVICE_NAME_DELSYS_ANALOG)
                    ? TcpServerResponse::OK
@@ -396,6 +475,16 @@ bool TcpServer::handleCommand(TcpServerCommand command) {
                                                  : TcpServerResponse::NOK;
     break;
 
+  case TcpServerCommand::DISCONNECT_LOKOMAT:
+    response = removeDevice(DEVICE_NAME_LOKOMAT) ? TcpServerResponse::OK
+                                                 : TcpServerResponse::NOK;
+    break;
+
+  case TcpServerCommand::DISCONNECT_REHASTIM:
+    response = removeDevice(DEVICE_NAME_REHASTIM) ? TcpServerResponse::OK
+                                                  : TcpServerResponse::NOK;
+    break;
+
   case TcpServerCommand::START_RECORDING:
     response = m_Devices.startRecording() ? TcpServerResponse::OK
                                           : TcpServerResponse::NOK;
@@ -407,18 +496,68 @@ bool TcpServer::handleCommand(TcpServerCommand command) {
     break;
 
   case TcpServerCommand::GET_LAST_TRIAL_DATA: {
-    auto data = m_Devices.getLastTrialDataSerialized();
-    auto dataDump = data.dump();
-    asio::write(*m_ResponseSocket,
-                asio::buffer(constructResponsePacket(
-                    static_cast<TcpServerResponse>(dataDump.size()))),
-                error);
-    auto written =
-        asio::write(*m_ResponseSocket, asio::buffer(dataDump), error);
+    auto written = sendResponseData(m_Devices.getLastTrialDataSerialized());
     logger.info("Data size: " + std::to_string(written));
     response = TcpServerResponse::OK;
   } break;
 
+  case TcpServerCommand::GET_DATA_CHECK_TIMINGS:
+    sendResponseData(m_Devices.getDataCheckTimingsSerialized());
+    response = TcpServerResponse::OK;
+    break;
+
+  case TcpServerCommand::START_TRACING: {
+    auto &tracer = utils::Tracer::getInstance();
+    if (tracer.getOutputPath().empty()) {
+      tracer.setOutputPath(DEFAULT_TRACE_FILE);
+    }
+    tracer.start();
+    logger.info("Tracing started");
+    response = TcpServerResponse::OK;
+  } break;
+
+  case TcpServerCommand::STOP_TRACING: {
+    auto &tracer = utils::Tracer::getInstance();
+    response =
+        tracer.isEnabled() ? TcpServerResponse::OK : TcpServerResponse::NOK;
+    tracer.stop();
+  } break;
+
+  case TcpServerCommand::SET_LIVE_DATA_TIME_WINDOW: {
+    std::uint32_t milliseconds;
+    if (!readCommandArgument(milliseconds)) {
+      return false;
+    }
+    if (milliseconds == 0) {
+      logger.warning("The live data time window cannot be empty");
+      response = TcpServerResponse::NOK;
+      break;
+    }
+    m_Devices.setLiveDataTimeWindow(std::chrono::milliseconds(milliseconds));
+    logger.info("Live data time window set to {} ms", milliseconds);
+    response = TcpServerResponse::OK;
+  } break;
+
+  case TcpServerCommand::SET_PRE_TRIGGER_DURATION: {
+    std::uint32_t milliseconds;
+    if (!readCommandArgument(milliseconds)) {
+      return false;
+    }
+    m_Devices.setPreTriggerDuration(std::chrono::milliseconds(milliseconds));
+    logger.info("Pre-trigger duration set to {} ms", milliseconds);
+    response = TcpServerResponse::OK;
+  } break;
+
+  case TcpServerCommand::START_STIMULATION_RULES:
+    response = startStimulationRules() ? TcpServerResponse::OK
+                                       : TcpServerResponse::NOK;
+    break;
+
+  case TcpServerCommand::STOP_STIMULATION_RULES:
+    response = stopStimulationRules() ? TcpServerResponse::OK
+                                      : TcpServerResponse::NOK;
+    break;
+
   default:
     logger.fatal("Invalid command: " +
                  std::to_string(static_cast<std::uint32_t>(command)));
@@ -460,6 +599,51 @@ TcpServerCommand TcpServer::parseCommandPacket(
       *reinterpret_cast<const std::uint32_t *>(buffer.data() + 4));
 }
 
+bool TcpServer::readCommandArgument(std::uint32_t &argument) {
+  auto &logger = utils::Logger::getInstance();
+
+  // The command socket is non-blocking, so the argument may not have arrived
+  // yet
+  auto buffer = std::array<char, BYTES_IN_CLIENT_PACKET_HEADER>();
+  size_t byteRead = 0;
+  auto timeout = std::chrono::steady_clock::now() + m_TimeoutPeriod;
+  while (byteRead < buffer.size()) {
+    asio::error_code error;
+    byteRead += m_CommandSocket->read_some(
+        asio::buffer(buffer.data() + byteRead, buffer.size() - byteRead),
+        error);
+    if (error == asio::error::would_block) {
+      if (std::chrono::steady_clock::now() > timeout) {
+        logger.fatal("Timeout while waiting for the command argument");
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    } else if (error) {
+      logger.fatal("TCP read error: " + error.message());
+      return false;
+    }
+  }
+
+  std::uint32_t version =
+      *reinterpret_cast<const std::uint32_t *>(buffer.data());
+  if (version != m_ProtocolVersion) {
+    logger.fatal("Invalid version: " + std::to_string(version));
+    return false;
+  }
+  argument = *reinterpret_cast<const std::uint32_t *>(buffer.data() + 4);
+  return true;
+}
+
+size_t TcpServer::sendResponseData(const nlohmann::json &data) {
+  asio::error_code error;
+  auto dataDump = data.dump();
+  asio::write(*m_ResponseSocket,
+              asio::buffer(constructResponsePacket(
+                  static_cast<TcpServerResponse>(dataDump.size()))),
+              error);
+  return asio::write(*m_ResponseSocket, asio::buffer(dataDump), error);
+}
+
 std::array<char, BYTES_IN_SERVER_PACKET_HEADER>
 TcpServer::constructResponsePacket(TcpServerResponse response) {
   // Packets are exactly 16 bytes long, big-endian
@@ -563,6 +747,14 @@ void TcpServer::makeAndAddDevice(const std::string &deviceName) {
     m_ConnectedDeviceIds[DEVICE_NAME_MAGSTIM] =
         m_Devices.add(devices::MagstimRapidDevice::findMagstimDevice());
 
+  } else if (deviceName == DEVICE_NAME_LOKOMAT) {
+    m_ConnectedDeviceIds[DEVICE_NAME_LOKOMAT] =
+        m_Devices.add(std::make_unique<devices::LokomatDevice>());
+
+  } else if (deviceName == DEVICE_NAME_REHASTIM) {
+    m_ConnectedDeviceIds[DEVICE_NAME_REHASTIM] = m_Devices.add(
+        std::make_unique<devices::RehastimDevice>(m_RehastimPort));
+
   } else {
     logger.fatal("Invalid device name: " + deviceName);
     throw std::runtime_error("Invalid device name: " + deviceName);
@@ -579,9 +771,17 @@ bool TcpServer::removeDevice(const std::string &deviceName,
     return false;
   }
 
+  // The stimulation rules cannot outlive the devices they use
+  size_t deviceId = m_ConnectedDeviceIds[deviceName];
+  if (m_StimulationRules.isAttached() &&
+      (deviceName == DEVICE_NAME_LOKOMAT ||
+       dynamic_cast<devices::Stimulator *>(&m_Devices.getDevice(deviceId)))) {
+    stopStimulationRules();
+  }
+
   // Stop the data streaming when changing the devices
   m_Devices.stopDataStreaming();
-  m_Devices.remove(m_ConnectedDeviceIds[deviceName]);
+  m_Devices.remove(deviceId);
   m_ConnectedDeviceIds.erase(deviceName);
   if (restartStreaming) {
     m_Devices.startDataStreaming();
@@ -595,8 +795,8 @@ void TcpServer::handleSendLiveData() {
   if (!isClientConnected()) {
     return;
   }
-  auto &logger = utils::Logger::getInstance();
-  logger.debug("Sending live data to client");
+  STIMWALKER_TRACE_SCOPE("handleSendLiveData", "server");
+  STIMWALKER_LOG_DEBUG("Sending live data to client");
 
   auto data = m_Devices.getLiveDataSerialized();
   if (data.size() == 0) {
@@ -610,7 +810,64 @@ void TcpServer::handleSendLiveData() {
                   static_cast<TcpServerResponse>(dataDump.size()))),
               error);
   auto written = asio::write(*m_LiveDataSocket, asio::buffer(dataDump), error);
-  logger.debug("Live data size: " + std::to_string(written));
+  STIMWALKER_LOG_DEBUG("Live data size: {}", written);
+}
+
+bool TcpServer::startStimulationRules() {
+  auto &logger = utils::Logger::getInstance();
+
+  if (m_ConnectedDeviceIds.find(DEVICE_NAME_LOKOMAT) ==
+      m_ConnectedDeviceIds.end()) {
+    logger.warning("Cannot start the stimulation rules as the " +
+                   DEVICE_NAME_LOKOMAT + " is not connected");
+    return false;
+  }
+
+  std::vector<devices::StimulationRule> rules;
+  try {
+    rules = devices::StimulationRule::fromFile(m_StimulationRulesPath);
+  } catch (const devices::InvalidStimulationRuleException &) {
+    // The reason is already logged
+    return false;
+  }
+
+  m_StimulationRules.detach();
+  m_StimulationRules.clearRules();
+  m_StimulationRules.addRules(rules);
+
+  devices::Stimulator *stimulator = nullptr;
+  for (auto id : m_Devices.getDeviceIds()) {
+    stimulator = dynamic_cast<devices::Stimulator *>(&m_Devices.getDevice(id));
+    if (stimulator != nullptr) {
+      break;
+    }
+  }
+  if (stimulator == nullptr) {
+    logger.warning("No stimulator is connected, the decisions of the "
+                   "stimulation rules are only reported");
+  }
+  m_StimulationRules.setStimulator(stimulator);
+
+  if (!m_StimulationRules.attach(m_Devices.getDataCollector(
+          m_ConnectedDeviceIds[DEVICE_NAME_LOKOMAT]))) {
+    return false;
+  }
+  logger.info("Started {} stimulation rule(s) from {}", rules.size(),
+              m_StimulationRulesPath);
+  return true;
+}
+
+bool TcpServer::stopStimulationRules() {
+  if (!m_StimulationRules.isAttached()) {
+    utils::Logger::getInstance().warning(
+        "The stimulation rules are not running");
+    return false;
+  }
+
+  m_StimulationRules.detach();
+  m_StimulationRules.setStimulator(nullptr);
+  utils::Logger::getInstance().info("Stimulation rules stopped");
+  return true;
 }
 
 void TcpServerMock::makeAndAddDevice(const std::string &deviceName) {
@@ -652,6 +909,16 @@ void TcpServerMock::makeAndAddDevice(const std::string &deviceName) {
     m_ConnectedDeviceIds[DEVICE_NAME_MAGSTIM] =
         m_Devices.add(devices::MagstimRapidDeviceMock::findMagstimDevice());
 
+  } else if (deviceName == DEVICE_NAME_LOKOMAT) {
+    m_ConnectedDeviceIds[DEVICE_NAME_LOKOMAT] =
+        m_Devices.add(std::make_unique<devices::LokomatDeviceMock>());
+
+#ifndef _WIN32
+  } else if (deviceName == DEVICE_NAME_REHASTIM) {
+    m_ConnectedDeviceIds[DEVICE_NAME_REHASTIM] =
+        m_Devices.add(std::make_unique<devices::RehastimDeviceMock>());
+#endif // _WIN32
+
   } else {
     logger.fatal("Invalid device name: " + deviceName);
     throw std::runtime_error("Invalid device name: " + deviceName);
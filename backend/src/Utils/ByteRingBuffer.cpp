@@ -0,0 +1,75 @@
+#include "Utils/ByteRingBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace STIMWALKER_NAMESPACE::utils;
+
+ByteRingBuffer::ByteRingBuffer(size_t capacity)
+    : m_Data(std::max(capacity, size_t(1))), m_Head(0), m_Size(0) {}
+
+char ByteRingBuffer::operator[](size_t index) const {
+  if (index >= m_Size) {
+    throw std::out_of_range("Index out of range");
+  }
+  return m_Data[wrap(index)];
+}
+
+size_t ByteRingBuffer::write(const char *data, size_t size) {
+  size_t written = 0;
+  while (written < size) {
+    auto [region, regionSize] = writableRegion();
+    if (regionSize == 0) {
+      break;
+    }
+    size_t count = std::min(regionSize, size - written);
+    std::memcpy(region, data + written, count);
+    commitWrite(count);
+    written += count;
+  }
+  return written;
+}
+
+std::string ByteRingBuffer::peek(size_t offset, size_t count) const {
+  if (offset + count > m_Size) {
+    throw std::out_of_range("Index out of range");
+  }
+
+  std::string bytes(count, '\0');
+  size_t start = wrap(offset);
+  size_t first = std::min(count, m_Data.size() - start);
+  std::memcpy(bytes.data(), m_Data.data() + start, first);
+  std::memcpy(bytes.data() + first, m_Data.data(), count - first);
+  return bytes;
+}
+
+std::string ByteRingBuffer::read(size_t count) {
+  auto bytes = peek(0, count);
+  consume(count);
+  return bytes;
+}
+
+void ByteRingBuffer::clear() { consume(m_Size); }
+
+size_t ByteRingBuffer::find(char value, size_t from) const {
+  if (from >= m_Size) {
+    return npos;
+  }
+
+  // Search the (at most two) contiguous parts of the bytes
+  size_t start = wrap(from);
+  size_t first = std::min(m_Size - from, m_Data.size() - start);
+  auto found = static_cast<const char *>(
+      std::memchr(m_Data.data() + start, value, first));
+  if (found != nullptr) {
+    return from + static_cast<size_t>(found - (m_Data.data() + start));
+  }
+
+  found = static_cast<const char *>(
+      std::memchr(m_Data.data(), value, m_Size - from - first));
+  if (found != nullptr) {
+    return from + first + static_cast<size_t>(found - m_Data.data());
+  }
+  return npos;
+}
@@ -0,0 +1,61 @@
+#include "Utils/EventExecutor.h"
+
+#include <future>
+
+using namespace STIMWALKER_NAMESPACE::utils;
+
+EventExecutor::EventExecutor() : m_IsRunning(true) {
+  m_Worker = std::thread([this]() { workerLoop(); });
+}
+
+EventExecutor::~EventExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_IsRunning = false;
+  }
+  m_Condition.notify_one();
+
+  if (m_Worker.joinable()) {
+    m_Worker.join();
+  }
+}
+
+void EventExecutor::post(std::function<void()> task) {
+  m_Tasks.push(std::move(task));
+  {
+    // Taking the lock makes sure the worker is either waiting or will see the
+    // task before waiting
+    std::lock_guard<std::mutex> lock(m_Mutex);
+  }
+  m_Condition.notify_one();
+}
+
+void EventExecutor::waitUntilIdle() {
+  if (std::this_thread::get_id() == m_Worker.get_id()) {
+    return;
+  }
+
+  std::promise<void> idle;
+  auto future = idle.get_future();
+  post([&idle]() { idle.set_value(); });
+  future.wait();
+}
+
+size_t EventExecutor::getPendingTaskCount() const { return m_Tasks.size(); }
+
+void EventExecutor::workerLoop() {
+  std::function<void()> task;
+  while (true) {
+    while (m_Tasks.pop(task)) {
+      task();
+      task = nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Condition.wait(lock,
+                     [this]() { return !m_Tasks.empty() || !m_IsRunning; });
+    if (!m_IsRunning && m_Tasks.empty()) {
+      return;
+    }
+  }
+}
@@ -1,9 +1,10 @@
 #include "Utils/Logger.h"
 
+#include <cstdio>
+#include <ctime>
 #include <filesystem>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
+#include <vector>
 
 using namespace STIMWALKER_NAMESPACE::utils;
 
@@ -22,10 +23,9 @@ void Logger::warning(const std::string &message) { log(message, WARNING); }
 void Logger::fatal(const std::string &message) { log(message, FATAL); }
 
 // Set the minimum log level. Messages below this level will not be logged.
-void Logger::setLogLevel(Level level) {
-  std::lock_guard<std::mutex> lock(m_Mutex);
-  m_LogLevel = level;
-}
+void Logger::setLogLevel(Level level) { m_LogLevel = level; }
+
+Logger::Level Logger::getLogLevel() const { return m_LogLevel; }
 
 // Set the log file to write logs to a file
 void Logger::setLogFile(const std::string &filename) {
@@ -50,10 +50,75 @@ void Logger::setLogFile(const std::string &filename) {
   m_File.open(filename, std::ios::out | std::ios::app);
 }
 
+void Logger::setIsAsynchronous(bool isAsynchronous) {
+  if (isAsynchronous == m_IsAsynchronous) {
+    return;
+  }
+
+  if (isAsynchronous) {
+    {
+      std::lock_guard<std::mutex> lock(m_WriterMutex);
+      m_IsWriterRunning = true;
+      m_IsWakeRequested = false;
+    }
+    m_Writer = std::thread([this]() { writerLoop(); });
+    m_IsAsynchronous = true;
+  } else {
+    m_IsAsynchronous = false;
+    stopWriter();
+  }
+}
+
+bool Logger::getIsAsynchronous() const { return m_IsAsynchronous; }
+
+void Logger::setFlushPolicy(const std::chrono::milliseconds &interval,
+                            size_t maxBatchSize, Level flushLevel) {
+  std::lock_guard<std::mutex> lock(m_WriterMutex);
+  m_FlushInterval = interval;
+  m_FlushBatchSize = maxBatchSize;
+  m_FlushLevel = flushLevel;
+}
+
+size_t Logger::getFlushBatchSize() const { return m_FlushBatchSize; }
+
+Logger::Level Logger::getFlushLevel() const { return m_FlushLevel; }
+
+void Logger::flush() {
+  if (!m_IsAsynchronous || std::this_thread::get_id() == m_WriterId) {
+    // Nothing to wait for (or a listener is flushing from the writer itself)
+    return;
+  }
+
+  // Push a marker behind every record already in the queue and wait for the
+  // writer to reach it
+  std::promise<void> flushed;
+  auto future = flushed.get_future();
+  LogRecord marker;
+  marker.flushed = &flushed;
+  m_Queue.push(std::move(marker));
+
+  if (m_IsAsynchronous) {
+    wakeWriter();
+  } else {
+    // The writer was stopped in the meantime, so nobody else will consume it
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    drainQueue();
+  }
+  future.wait();
+}
+
 // Private constructor and destructor to prevent direct instantiation
-Logger::Logger() : m_ShouldPrintToConsole(true), m_LogLevel(INFO) {}
+Logger::Logger()
+    : m_ShouldPrintToConsole(true), m_ShouldFlushFatalSynchronously(true),
+      m_LogLevel(INFO), m_IsAsynchronous(false),
+      m_FlushInterval(std::chrono::milliseconds(100)), m_FlushBatchSize(256),
+      m_FlushLevel(WARNING), m_WriterId(std::thread::id()),
+      m_IsWriterRunning(false), m_IsWakeRequested(false) {}
 
 Logger::~Logger() {
+  m_IsAsynchronous = false;
+  stopWriter();
+
   if (m_File.is_open()) {
     m_File.close();
   }
@@ -61,18 +126,34 @@ Logger::~Logger() {
 
 // Log a message if it meets the minimum log level
 void Logger::log(const std::string &message, Level level) {
-  std::lock_guard<std::mutex> lock(m_Mutex);
-
   // Check if the current message meets the log level threshold
   if (level < m_LogLevel) {
     return; // Skip logging if below the minimum log level
   }
 
-  // Get current time as a string
-  std::string timeStamp = getCurrentTime();
+  if (m_IsAsynchronous) {
+    m_Queue.push(LogRecord{std::chrono::system_clock::now(), level, message});
+
+    if (!m_IsAsynchronous) {
+      // The writer was stopped while pushing, make sure the record is written
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      drainQueue();
+      return;
+    }
+
+    if (level == FATAL && m_ShouldFlushFatalSynchronously) {
+      flush();
+    } else if (level >= m_FlushLevel || m_Queue.size() >= m_FlushBatchSize) {
+      wakeWriter();
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
 
   // Prepare the actual message
-  std::string toPrint = timeStamp + getLabel(level) + message;
+  std::string toPrint =
+      formatRecord(LogRecord{std::chrono::system_clock::now(), level, message});
 
   // Log to console
   if (m_ShouldPrintToConsole) {
@@ -88,6 +169,94 @@ void Logger::log(const std::string &message, Level level) {
   onNewLog.notifyListeners(toPrint);
 }
 
+std::string Logger::formatRecord(const LogRecord &record) {
+  return formatTime(record.time) + getLabel(record.level) + record.message;
+}
+
+void Logger::writerLoop() {
+  m_WriterId = std::this_thread::get_id();
+
+  std::unique_lock<std::mutex> lock(m_WriterMutex);
+  while (true) {
+    m_WriterCondition.wait_for(lock, m_FlushInterval, [this]() {
+      return m_IsWakeRequested || !m_IsWriterRunning;
+    });
+    m_IsWakeRequested = false;
+    bool isRunning = m_IsWriterRunning;
+
+    // Do not keep producers waiting to wake us while writing
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> writeLock(m_Mutex);
+      drainQueue();
+    }
+    lock.lock();
+
+    if (!isRunning) {
+      m_WriterId = std::thread::id();
+      return;
+    }
+  }
+}
+
+void Logger::drainQueue() {
+  std::string batch;
+  std::vector<std::promise<void> *> flushMarkers;
+
+  LogRecord record;
+  while (m_Queue.pop(record)) {
+    if (record.flushed != nullptr) {
+      flushMarkers.push_back(record.flushed);
+      continue;
+    }
+
+    std::string toPrint = formatRecord(record);
+    batch += toPrint;
+    batch += '\n';
+
+    // Emit the onNewLog event
+    onNewLog.notifyListeners(toPrint);
+  }
+
+  // Write the whole batch at once and flush only once
+  if (!batch.empty()) {
+    if (m_ShouldPrintToConsole) {
+      std::cout << batch << std::flush;
+    }
+    if (m_File.is_open()) {
+      m_File << batch << std::flush;
+    }
+  }
+
+  for (auto marker : flushMarkers) {
+    marker->set_value();
+  }
+}
+
+void Logger::wakeWriter() {
+  {
+    std::lock_guard<std::mutex> lock(m_WriterMutex);
+    m_IsWakeRequested = true;
+  }
+  m_WriterCondition.notify_one();
+}
+
+void Logger::stopWriter() {
+  {
+    std::lock_guard<std::mutex> lock(m_WriterMutex);
+    m_IsWriterRunning = false;
+  }
+  m_WriterCondition.notify_one();
+
+  if (m_Writer.joinable()) {
+    m_Writer.join();
+  }
+
+  // Write whatever was pushed while the writer was stopping
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  drainQueue();
+}
+
 // Function to convert log level to a string label
 std::string Logger::getLabel(Level level) {
   switch (level) {
@@ -106,27 +275,30 @@ std::string Logger::getLabel(Level level) {
 
 // Function to get current time as a string
 std::string Logger::getCurrentTime() {
+  return formatTime(std::chrono::system_clock::now());
+}
 
-  // Get current time as time_point
-  auto now = std::chrono::system_clock::now();
-
+std::string
+Logger::formatTime(const std::chrono::system_clock::time_point &time) {
   // Extract the milliseconds part
   auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                   now.time_since_epoch()) %
+                   time.time_since_epoch()) %
                1000;
 
   // Format the time as [YYYY-MM-DD HH:MM:SS.MMM]
-  auto nowTimeT = std::chrono::system_clock::to_time_t(now);
-#ifdef _WIN32
+  auto nowTimeT = std::chrono::system_clock::to_time_t(time);
   struct tm localtime = tm();
+#ifdef _WIN32
   localtime_s(&localtime, &nowTimeT);
 #else
-  struct tm localtime = *std::localtime(&nowTimeT);
+  localtime_r(&nowTimeT, &localtime);
 #endif
-  std::stringstream ss;
-  ss << std::put_time(&localtime, "[%Y-%m-%d %H:%M:%S");
-  ss << '.' << std::setfill('0') << std::setw(3)
-     << nowMs.count(); // Add milliseconds
-  ss << "] ";          // Space after the timestamp
-  return ss.str();
-}
\ No newline at end of file
+
+  // Using fixed size buffers is much cheaper than a stringstream
+  char dateTime[32];
+  std::strftime(dateTime, sizeof(dateTime), "%Y-%m-%d %H:%M:%S", &localtime);
+  char formatted[48];
+  std::snprintf(formatted, sizeof(formatted), "[%s.%03d] ", dateTime,
+                static_cast<int>(nowMs.count()));
+  return formatted;
+}
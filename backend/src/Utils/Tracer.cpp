@@ -0,0 +1,237 @@
+#include "Utils/Tracer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include "Utils/Logger.h"
+
+using namespace STIMWALKER_NAMESPACE::utils;
+
+namespace {
+// Append [value] to [out] as a JSON string (the quotes included)
+void appendJsonString(std::string &out, const char *value) {
+  out.push_back('"');
+  for (const char *c = value; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      out.push_back('\\');
+      out.push_back(*c);
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+      out.append(escaped);
+    } else {
+      out.push_back(*c);
+    }
+  }
+  out.push_back('"');
+}
+
+// Append [duration] to [out] as fractional microseconds
+void appendMicroseconds(std::string &out,
+                        const std::chrono::steady_clock::duration &duration) {
+  char buffer[32];
+  int written = std::snprintf(
+      buffer, sizeof(buffer), "%.3f",
+      std::chrono::duration<double, std::micro>(duration).count());
+  out.append(buffer, static_cast<size_t>(written));
+}
+} // namespace
+
+Tracer &Tracer::getInstance() {
+  static Tracer instance;
+  return instance;
+}
+
+Tracer::Tracer()
+    : m_OutputPath(""), m_EventsPerThread(32768), m_IsEnabled(false),
+      m_Generation(0), m_Origin(0) {
+  // Make sure the logger outlives the tracer, which may save when destroyed
+  Logger::getInstance();
+
+  const char *outputPath = std::getenv("STIMWALKER_TRACE_FILE");
+  if (outputPath != nullptr && outputPath[0] != '\0') {
+    m_OutputPath = outputPath;
+    start();
+  }
+}
+
+Tracer::~Tracer() {
+  if (m_IsEnabled) {
+    stop();
+  }
+}
+
+void Tracer::start() {
+  m_IsEnabled = false;
+  m_Origin = std::chrono::steady_clock::now().time_since_epoch().count();
+  m_Generation.fetch_add(1, std::memory_order_acq_rel);
+
+  {
+    // Forget the buffers of the threads that are gone
+    std::lock_guard<std::mutex> lock(m_BuffersMutex);
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    for (auto &buffer : m_Buffers) {
+      if (buffer.use_count() > 1) {
+        buffers.push_back(buffer);
+      }
+    }
+    m_Buffers = std::move(buffers);
+  }
+
+  m_IsEnabled = true;
+}
+
+void Tracer::stop() {
+  m_IsEnabled = false;
+
+  if (!m_OutputPath.empty()) {
+    save(m_OutputPath);
+  }
+}
+
+void Tracer::record(const char *name, const char *category,
+                    const std::chrono::steady_clock::time_point &start,
+                    const std::chrono::steady_clock::time_point &end) {
+  if (!m_IsEnabled.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  auto &buffer = getThreadBuffer();
+
+  // The first event of a new recording resets the buffer
+  size_t generation = m_Generation.load(std::memory_order_acquire);
+  if (buffer.generation.load(std::memory_order_relaxed) != generation) {
+    buffer.count.store(0, std::memory_order_relaxed);
+    buffer.dropped.store(0, std::memory_order_relaxed);
+    buffer.generation.store(generation, std::memory_order_release);
+  }
+
+  size_t index = buffer.count.load(std::memory_order_relaxed);
+  if (index >= buffer.events.size()) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer.events[index] = TraceEvent{name, category, start, end - start};
+  buffer.count.store(index + 1, std::memory_order_release);
+}
+
+std::vector<std::pair<size_t, std::vector<Tracer::TraceEvent>>>
+Tracer::getEvents() const {
+  std::lock_guard<std::mutex> lock(const_cast<std::mutex &>(m_BuffersMutex));
+
+  std::vector<std::pair<size_t, std::vector<TraceEvent>>> events;
+  for (const auto &buffer : m_Buffers) {
+    if (!isCurrent(*buffer)) {
+      continue;
+    }
+    size_t count = buffer->count.load(std::memory_order_acquire);
+    events.emplace_back(buffer->threadId,
+                        std::vector<TraceEvent>(buffer->events.begin(),
+                                                buffer->events.begin() +
+                                                    count));
+  }
+  return events;
+}
+
+size_t Tracer::getEventCount() const {
+  std::lock_guard<std::mutex> lock(const_cast<std::mutex &>(m_BuffersMutex));
+
+  size_t count = 0;
+  for (const auto &buffer : m_Buffers) {
+    if (isCurrent(*buffer)) {
+      count += buffer->count.load(std::memory_order_acquire);
+    }
+  }
+  return count;
+}
+
+size_t Tracer::getDroppedEventCount() const {
+  std::lock_guard<std::mutex> lock(const_cast<std::mutex &>(m_BuffersMutex));
+
+  size_t dropped = 0;
+  for (const auto &buffer : m_Buffers) {
+    if (isCurrent(*buffer)) {
+      dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+  }
+  return dropped;
+}
+
+std::string Tracer::serialize() const {
+  auto origin = std::chrono::steady_clock::time_point(
+      std::chrono::steady_clock::duration(m_Origin.load()));
+
+  std::string out("{\"traceEvents\":[");
+  bool isFirst = true;
+  for (const auto &[threadId, events] : getEvents()) {
+    for (const auto &event : events) {
+      if (!isFirst) {
+        out.push_back(',');
+      }
+      isFirst = false;
+
+      // Complete events ("X") hold both the start and the duration of a span
+      out.append("{\"name\":");
+      appendJsonString(out, event.name);
+      out.append(",\"cat\":");
+      appendJsonString(out, event.category);
+      out.append(",\"ph\":\"X\",\"ts\":");
+      appendMicroseconds(out, event.start - origin);
+      out.append(",\"dur\":");
+      appendMicroseconds(out, event.duration);
+      out.append(",\"pid\":1,\"tid\":");
+      out.append(std::to_string(threadId));
+      out.push_back('}');
+    }
+  }
+  out.append("],\"displayTimeUnit\":\"ms\"}");
+  return out;
+}
+
+bool Tracer::save(const std::string &path) const {
+  auto &logger = Logger::getInstance();
+
+  std::ofstream file(path, std::ios::out | std::ios::trunc);
+  if (!file.is_open()) {
+    logger.fatal("Failed to open the trace file: " + path);
+    return false;
+  }
+  file << serialize();
+  logger.info("Trace saved to " + path);
+  return true;
+}
+
+Tracer::ThreadBuffer &Tracer::getThreadBuffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer;
+  if (buffer == nullptr) {
+    buffer = std::make_shared<ThreadBuffer>();
+    buffer->events.resize(m_EventsPerThread);
+
+    std::lock_guard<std::mutex> lock(m_BuffersMutex);
+    static size_t threadCount = 0;
+    buffer->threadId = ++threadCount;
+    m_Buffers.push_back(buffer);
+  }
+  return *buffer;
+}
+
+bool Tracer::isCurrent(const ThreadBuffer &buffer) const {
+  return buffer.generation.load(std::memory_order_acquire) ==
+         m_Generation.load(std::memory_order_acquire);
+}
+
+ScopedTrace::ScopedTrace(const char *name, const char *category)
+    : m_Name(name), m_Category(category),
+      m_IsRecording(Tracer::getInstance().isEnabled()) {
+  if (m_IsRecording) {
+    m_Start = std::chrono::steady_clock::now();
+  }
+}
+
+ScopedTrace::~ScopedTrace() {
+  if (m_IsRecording) {
+    Tracer::getInstance().record(m_Name, m_Category, m_Start,
+                                 std::chrono::steady_clock::now());
+  }
+}
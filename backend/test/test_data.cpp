@@ -2,8 +2,17 @@
 #include <iostream>
 #include <thread>
 
+#include "Data/AcquisitionStatistics.h"
+#include "Data/ClockSynchronizer.h"
+#include "Data/DataBlock.h"
+#include "Data/DataCheckTimings.h"
+#include "Data/EventMarkerRecorder.h"
+#include "Data/EventMarkers.h"
 #include "Data/FixedTimeSeries.h"
+#include "Data/GaitPhaseEstimator.h"
 #include "Data/TimeSeries.h"
+#include "Data/TimingHistogram.h"
+#include "Data/TrialWriter.h"
 
 #include "utils.h"
 
@@ -67,6 +76,55 @@ TEST(DataPoint, Deserialize) {
   ASSERT_NEAR(data[2], 3.0, requiredPrecision);
 }
 
+TEST(DataBlock, Access) {
+  std::vector<std::chrono::microseconds> timeStamps = {
+      std::chrono::microseconds(10), std::chrono::microseconds(20)};
+  std::vector<double> samples = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  auto block = data::DataBlock(timeStamps.data(), samples.data(), 2, 3);
+
+  ASSERT_EQ(block.size(), 2);
+  ASSERT_FALSE(block.empty());
+  ASSERT_EQ(block.channelCount(), 3);
+  ASSERT_EQ(block.timeStamp(1), std::chrono::microseconds(20));
+  ASSERT_NEAR(block.sample(1)[0], 4.0, requiredPrecision);
+  ASSERT_NEAR(block.value(0, 2), 3.0, requiredPrecision);
+
+  // The block is a view, not a copy
+  ASSERT_EQ(block.samples(), samples.data());
+  ASSERT_EQ(block.timeStamps(), timeStamps.data());
+  samples[5] = 60.0;
+  ASSERT_NEAR(block.value(1, 2), 60.0, requiredPrecision);
+
+  auto dataPoint = block.dataPoint(1);
+  ASSERT_EQ(dataPoint.getTimeStamp(), std::chrono::microseconds(20));
+  ASSERT_EQ(dataPoint.size(), 3);
+  ASSERT_NEAR(dataPoint[2], 60.0, requiredPrecision);
+
+  ASSERT_TRUE(data::DataBlock().empty());
+}
+
+TEST(DataBlock, RollingVectorAccess) {
+  // The last two data points, after the vector rolled
+  utils::RollingVector<data::DataPoint> dataPoints(3);
+  for (int i = 0; i < 4; i++) {
+    dataPoints.push_back(data::DataPoint(std::chrono::microseconds(10 * i),
+                                         {1.0 * i, 2.0 * i}));
+  }
+  auto block = data::DataBlock(dataPoints, 1, 2, 2);
+
+  ASSERT_EQ(block.size(), 2);
+  ASSERT_EQ(block.channelCount(), 2);
+  ASSERT_EQ(block.timeStamp(0), std::chrono::microseconds(20));
+  ASSERT_EQ(block.timeStamp(1), std::chrono::microseconds(30));
+  ASSERT_NEAR(block.value(0, 1), 4.0, requiredPrecision);
+  ASSERT_NEAR(block.sample(1)[0], 3.0, requiredPrecision);
+
+  // The block is a view of the data points
+  ASSERT_EQ(block.sample(1), dataPoints[2].getData().data());
+  ASSERT_EQ(block.samples(), nullptr);
+  ASSERT_EQ(block.timeStamps(), nullptr);
+}
+
 TEST(TimeSeries, StartingTime) {
   auto now = std::chrono::system_clock::now();
   auto data = data::TimeSeries();
@@ -240,6 +298,431 @@ TEST(TimeSeries, Deserialize) {
   ASSERT_NEAR(data[1].getData()[2], 6.0, requiredPrecision);
 }
 
+TEST(TimeSeries, AddAcquiredAt) {
+  auto data = data::TimeSeries();
+  auto acquisitionTime =
+      data.getStopWatch() + std::chrono::milliseconds(100);
+  data.addAcquiredAt(acquisitionTime, {1.0, 2.0});
+  ASSERT_EQ(data[0].getTimeStamp(), std::chrono::milliseconds(100));
+
+  // Fixed time series ignore the acquisition time
+  auto fixedData = data::FixedTimeSeries(std::chrono::microseconds(500));
+  fixedData.addAcquiredAt(acquisitionTime, {1.0, 2.0});
+  fixedData.addAcquiredAt(acquisitionTime, {3.0, 4.0});
+  ASSERT_EQ(fixedData[0].getTimeStamp(), std::chrono::microseconds(0));
+  ASSERT_EQ(fixedData[1].getTimeStamp(), std::chrono::microseconds(500));
+}
+
+TEST(TimeSeries, SeedFrom) {
+  auto live = data::FixedTimeSeries(std::chrono::milliseconds(1));
+  live.setRollingVectorMaxSize(10);
+  for (int i = 0; i < 25; i++) {
+    live.add({static_cast<double>(i), 1.0});
+  }
+
+  // Only the window is kept, in the time frame of the source
+  auto trial = data::FixedTimeSeries(std::chrono::milliseconds(1));
+  trial.add({-1.0, -1.0});
+  size_t seeded = trial.seedFrom(live, std::chrono::microseconds(3500));
+  ASSERT_EQ(seeded, 4);
+  ASSERT_EQ(trial.size(), 4);
+  ASSERT_EQ(trial.getStartingTime(), live.getStartingTime());
+  ASSERT_EQ(trial.front().getTimeStamp(), std::chrono::milliseconds(21));
+  ASSERT_NEAR(trial.front().getData()[0], 21.0, requiredPrecision);
+
+  // The recording goes on from the last seeded sample
+  trial.add({25.0, 1.0});
+  ASSERT_EQ(trial.back().getTimeStamp(), std::chrono::milliseconds(25));
+
+  // A window longer than the source takes all it holds
+  ASSERT_EQ(trial.seedFrom(live, std::chrono::seconds(1)), 10);
+  ASSERT_NEAR(trial.front().getData()[0], 15.0, requiredPrecision);
+  ASSERT_EQ(trial.seedFrom(live, std::chrono::microseconds(0)), 0);
+  ASSERT_EQ(trial.size(), 0);
+
+  // The seeded data are brought back to the zero level of the destination
+  live.setZeroLevel(std::chrono::milliseconds(100));
+  live.add({25.0, 1.0});
+  ASSERT_NEAR(live.back().getData()[1], 0.0, requiredPrecision);
+  trial.seedFrom(live, std::chrono::milliseconds(1));
+  ASSERT_EQ(trial.size(), 2);
+  ASSERT_NEAR(trial.back().getData()[0], 25.0, requiredPrecision);
+  ASSERT_NEAR(trial.back().getData()[1], 1.0, requiredPrecision);
+}
+
+TEST(TrialWriter, WriteBlocks) {
+  auto trial = data::FixedTimeSeries(std::chrono::microseconds(1000));
+  auto writer = data::TrialWriter(8, std::chrono::milliseconds(5));
+  ASSERT_FALSE(writer.isRunning());
+
+  // Nothing is written while the writer is stopped
+  auto now = std::chrono::high_resolution_clock::now();
+  ASSERT_FALSE(writer.write(now, {{1.0, 2.0}}));
+
+  writer.start(trial);
+  ASSERT_TRUE(writer.isRunning());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(writer.write(now, {{i * 2.0, i * 2.0 + 1}, {-1.0, -2.0}}));
+    if (i % 4 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+  writer.stop();
+  ASSERT_FALSE(writer.isRunning());
+
+  // All the samples are appended in order
+  ASSERT_EQ(trial.size(), 200);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_NEAR(trial[2 * i][0], i * 2.0, requiredPrecision);
+    ASSERT_NEAR(trial[2 * i][1], i * 2.0 + 1, requiredPrecision);
+    ASSERT_NEAR(trial[2 * i + 1][0], -1.0, requiredPrecision);
+  }
+  ASSERT_EQ(trial[199].getTimeStamp(), std::chrono::microseconds(199000));
+
+  auto metrics = writer.getMetrics();
+  ASSERT_EQ(metrics.queueDepth, 0);
+  ASSERT_EQ(metrics.queueCapacity, 8);
+  ASSERT_EQ(metrics.writtenBlockCount, 100);
+  ASSERT_EQ(metrics.writtenSampleCount, 200);
+  ASSERT_EQ(metrics.droppedBlockCount, 0);
+  ASSERT_GT(metrics.batchCount, 0);
+  ASSERT_LE(metrics.maxQueueDepth, 8);
+}
+
+TEST(TrialWriter, DropWhenFull) {
+  auto trial = data::TimeSeries();
+  // The writer never wakes by itself during the test
+  auto writer = data::TrialWriter(4, std::chrono::milliseconds(10000));
+  writer.start(trial);
+
+  // Give the writer thread time to go to sleep, then flood the queue faster
+  // than a wake up can empty it
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  auto now = std::chrono::high_resolution_clock::now();
+  size_t queued = 0;
+  for (int i = 0; i < 1000; i++) {
+    queued += writer.write(now, {{1.0}, {2.0}, {3.0}}) ? 1 : 0;
+  }
+  writer.stop();
+
+  auto metrics = writer.getMetrics();
+  ASSERT_EQ(metrics.writtenBlockCount, queued);
+  ASSERT_EQ(metrics.writtenBlockCount + metrics.droppedBlockCount, 1000);
+  ASSERT_EQ(metrics.droppedSampleCount, metrics.droppedBlockCount * 3);
+  ASSERT_EQ(trial.size(), queued * 3);
+  ASSERT_EQ(metrics.maxQueueDepth, 4);
+}
+
+TEST(AcquisitionStatistics, Accounting) {
+  using GapReason = data::AcquisitionStatistics::GapReason;
+  auto statistics = data::AcquisitionStatistics(std::chrono::milliseconds(1));
+
+  statistics.addReceivedSamples(10);
+  statistics.addGap(3, GapReason::EMPTY_FRAME);
+  statistics.addGap(2, GapReason::EMPTY_FRAME);
+  statistics.addReceivedSamples(5);
+  statistics.addGap(4, GapReason::FAILED_READ);
+  statistics.addGap(0, GapReason::FAILED_READ);
+  statistics.addTimerOverrun();
+
+  ASSERT_EQ(statistics.getReceivedSampleCount(), 15);
+  ASSERT_EQ(statistics.getDroppedSampleCount(), 9);
+  ASSERT_EQ(statistics.getTimerOverrunCount(), 1);
+
+  // Consecutive losses for the same reason are merged
+  ASSERT_EQ(statistics.getGapCount(), 2);
+  const auto &gaps = statistics.getGaps();
+  ASSERT_EQ(gaps.size(), 2);
+  ASSERT_EQ(gaps[0].position, 10);
+  ASSERT_EQ(gaps[0].sampleCount, 5);
+  ASSERT_EQ(gaps[0].reason, GapReason::EMPTY_FRAME);
+  ASSERT_EQ(gaps[1].position, 15);
+  ASSERT_EQ(gaps[1].sampleCount, 4);
+  ASSERT_EQ(gaps[1].reason, GapReason::FAILED_READ);
+
+  // The expected count follows the clock
+  ASSERT_EQ(statistics.getExpectedSampleCount(), 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  statistics.updateExpectedSampleCount();
+  ASSERT_GE(statistics.getExpectedSampleCount(), 50);
+  ASSERT_EQ(statistics.getUnaccountedSampleCount(),
+            statistics.getExpectedSampleCount() - 24);
+
+  // Round trip through the serialization
+  auto json = statistics.serialize();
+  ASSERT_EQ(json["unaccounted"], statistics.getUnaccountedSampleCount());
+  auto deserialized = data::AcquisitionStatistics(json);
+  ASSERT_EQ(deserialized.getSamplePeriod(), std::chrono::milliseconds(1));
+  ASSERT_EQ(deserialized.getExpectedSampleCount(),
+            statistics.getExpectedSampleCount());
+  ASSERT_EQ(deserialized.getReceivedSampleCount(), 15);
+  ASSERT_EQ(deserialized.getDroppedSampleCount(), 9);
+  ASSERT_EQ(deserialized.getGapCount(), 2);
+  ASSERT_EQ(deserialized.getTimerOverrunCount(), 1);
+  ASSERT_EQ(deserialized.getGaps().size(), 2);
+  ASSERT_EQ(deserialized.getGaps()[1].position, 15);
+  ASSERT_EQ(deserialized.getGaps()[1].timeStamp, gaps[1].timeStamp);
+  ASSERT_EQ(deserialized.getGaps()[1].reason, GapReason::FAILED_READ);
+
+  // The counts go without the detail of the gaps
+  auto counts = data::AcquisitionStatistics(statistics.serializeCounts());
+  ASSERT_FALSE(statistics.serializeCounts().contains("gaps"));
+  ASSERT_EQ(counts.getDroppedSampleCount(), 9);
+  ASSERT_EQ(counts.getGapCount(), 2);
+  ASSERT_TRUE(counts.getGaps().empty());
+
+  // Without a known rate, nothing is expected
+  statistics.reset(std::chrono::microseconds(0));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  statistics.updateExpectedSampleCount();
+  ASSERT_EQ(statistics.getExpectedSampleCount(), 0);
+  ASSERT_EQ(statistics.getReceivedSampleCount(), 0);
+  ASSERT_TRUE(statistics.getGaps().empty());
+}
+
+TEST(ClockSynchronizer, Drift) {
+  auto period = std::chrono::microseconds(500);
+  auto synchronizer = data::ClockSynchronizer(period);
+  ASSERT_FALSE(synchronizer.isSynchronized());
+  ASSERT_EQ(synchronizer.getEstimatedSamplePeriod(), 500.0);
+
+  // A device 100 ppm slower than announced, sending blocks of 27 samples that
+  // arrive with some jitter, and with a late block every now and then
+  double truePeriod = 500.0 * (1.0 + 100e-6);
+  auto start = std::chrono::steady_clock::now();
+  size_t blockCount = 5000;
+  size_t lateBlockCount = 0;
+  for (size_t block = 0; block < blockCount; block++) {
+    size_t lastIndex = (block + 1) * 27 - 1;
+    double arrival = static_cast<double>(lastIndex) * truePeriod + 200.0 +
+                     static_cast<double>((block * 7919) % 50);
+    if (block % 50 == 25) {
+      arrival += 5000.0;
+      lateBlockCount++;
+    }
+    synchronizer.addBlock(
+        lastIndex,
+        start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double, std::micro>(arrival)));
+  }
+
+  ASSERT_TRUE(synchronizer.isSynchronized());
+  ASSERT_EQ(synchronizer.getBlockCount(), blockCount);
+  ASSERT_NEAR(synchronizer.getDriftPpm(), 100.0, 2.0);
+  ASSERT_NEAR(synchronizer.getEstimatedSamplePeriod(), truePeriod, 1e-3);
+  ASSERT_GE(synchronizer.getOutlierCount(), lateBlockCount);
+  ASSERT_LT(synchronizer.getJitter(), 50.0);
+
+  // The corrected time stamps follow the device clock, not the nominal one
+  double sampleCount = static_cast<double>(blockCount * 27);
+  auto span = std::chrono::duration<double, std::micro>(
+                  synchronizer.getTime(sampleCount) - synchronizer.getTime(0))
+                  .count();
+  ASSERT_NEAR(span, sampleCount * truePeriod, 20.0);
+
+  // The serialized mapping starts at the requested sample
+  auto json = synchronizer.serialize(27);
+  ASSERT_EQ(json["firstSampleIndex"], 27);
+  ASSERT_NEAR(json["period"].get<double>(), truePeriod, 1e-3);
+  ASSERT_NEAR(json["offset"].get<double>() -
+                  synchronizer.serialize(0)["offset"].get<double>(),
+              27 * truePeriod, 1e-3);
+
+  synchronizer.reset(period);
+  ASSERT_FALSE(synchronizer.isSynchronized());
+  ASSERT_EQ(synchronizer.getBlockCount(), 0);
+  ASSERT_EQ(synchronizer.getDriftPpm(), 0.0);
+}
+
+TEST(EventMarkers, Query) {
+  auto startingTime =
+      std::chrono::system_clock::time_point(std::chrono::seconds(1000));
+  auto markers = data::EventMarkers(startingTime);
+  markers.add({std::chrono::milliseconds(10),
+               data::EventMarkerType::STIMULATOR_ARMED, 0});
+  markers.add({std::chrono::milliseconds(30),
+               data::EventMarkerType::STIMULATION_PULSE, 80});
+  // A late marker is put back in order
+  markers.add({std::chrono::milliseconds(20),
+               data::EventMarkerType::SERVER_COMMAND, 30});
+  ASSERT_EQ(markers.size(), 3);
+  ASSERT_EQ(markers[1].type, data::EventMarkerType::SERVER_COMMAND);
+  ASSERT_EQ(markers.getTime(markers[2]),
+            startingTime + std::chrono::milliseconds(30));
+
+  // The range includes its beginning but not its end
+  auto range = markers.between(startingTime + std::chrono::milliseconds(20),
+                               startingTime + std::chrono::milliseconds(30));
+  ASSERT_EQ(range.size(), 1);
+  ASSERT_EQ(range[0].payload, 30);
+  ASSERT_EQ(range.getStartingTime(), startingTime);
+  ASSERT_EQ(markers.between(startingTime + std::chrono::milliseconds(31),
+                            startingTime + std::chrono::seconds(1))
+                .size(),
+            0);
+
+  // Serialize and deserialize
+  auto json = markers.serialize();
+  ASSERT_EQ(json["markers"].size(), 3);
+  auto deserialized = data::EventMarkers(json);
+  ASSERT_EQ(deserialized.getStartingTime(), startingTime);
+  ASSERT_EQ(deserialized.size(), 3);
+  ASSERT_EQ(deserialized[2].timeStamp, std::chrono::milliseconds(30));
+  ASSERT_EQ(deserialized[2].type, data::EventMarkerType::STIMULATION_PULSE);
+  ASSERT_EQ(deserialized[2].payload, 80);
+}
+
+TEST(EventMarkerRecorder, ConcurrentAdd) {
+  auto recorder = data::EventMarkerRecorder();
+  auto start = std::chrono::steady_clock::now();
+
+  // Several threads add markers at the same time
+  std::vector<std::thread> producers;
+  for (int i = 0; i < 4; i++) {
+    producers.emplace_back([&recorder, i]() {
+      for (int j = 0; j < 250; j++) {
+        recorder.add(data::EventMarkerType::STIMULATION_PULSE, i);
+      }
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  auto markers = recorder.getMarkers();
+  ASSERT_EQ(markers.size(), 1000);
+  for (size_t i = 1; i < markers.size(); i++) {
+    ASSERT_LE(markers[i - 1].timeStamp, markers[i].timeStamp);
+  }
+  ASSERT_EQ(recorder.between(start, stop).size(), 1000);
+  ASSERT_EQ(recorder.between(stop, stop + std::chrono::seconds(1)).size(), 0);
+
+  // A range that ends right after a marker (as a trial stopped right after its
+  // RECORDING_STOPPED marker) contains it, even in the same microsecond
+  for (int i = 0; i < 200; i++) {
+    auto from = std::chrono::steady_clock::now();
+    recorder.add(data::EventMarkerType::RECORDING_STOPPED);
+    auto to = std::chrono::steady_clock::now();
+    auto range = recorder.between(from, to);
+    ASSERT_GE(range.size(), 1);
+    ASSERT_EQ(range[range.size() - 1].type,
+              data::EventMarkerType::RECORDING_STOPPED);
+  }
+
+  // Markers in the past (from the previous session) are dropped
+  auto before = std::chrono::steady_clock::now();
+  recorder.reset();
+  recorder.addAt(before, data::EventMarkerType::STIMULATOR_ARMED);
+  recorder.add(data::EventMarkerType::STIMULATOR_DISARMED);
+  ASSERT_EQ(recorder.size(), 1);
+  ASSERT_EQ(recorder.getMarkers()[0].type,
+            data::EventMarkerType::STIMULATOR_DISARMED);
+}
+
+TEST(TimingHistogram, Quantiles) {
+  auto histogram = data::TimingHistogram(std::chrono::microseconds(10), 20);
+  ASSERT_EQ(histogram.size(), 0);
+  ASSERT_EQ(histogram.quantile(0.5), std::chrono::nanoseconds(0));
+
+  // Errors from -5 us to 94 us, one per microsecond
+  for (int i = -5; i < 95; i++) {
+    histogram.add(std::chrono::microseconds(i));
+  }
+  ASSERT_EQ(histogram.size(), 100);
+  ASSERT_EQ(histogram.getMin(), std::chrono::microseconds(-5));
+  ASSERT_EQ(histogram.getMax(), std::chrono::microseconds(94));
+  ASSERT_EQ(histogram.mean(), std::chrono::microseconds(44) +
+                                  std::chrono::nanoseconds(500));
+
+  // The early errors are in the bin just before zero
+  ASSERT_EQ(histogram.getCounts()[9], 5);
+  ASSERT_EQ(histogram.getCounts()[10], 10);
+  ASSERT_EQ(histogram.getCounts()[18], 10);
+  ASSERT_EQ(histogram.getCounts()[19], 5);
+  ASSERT_EQ(histogram.quantile(0.5), std::chrono::microseconds(45));
+  ASSERT_EQ(histogram.quantile(0.0), std::chrono::microseconds(-5));
+  ASSERT_EQ(histogram.quantile(1.0), std::chrono::microseconds(94));
+
+  // Errors out of the range go to the edge bins
+  histogram.add(std::chrono::milliseconds(10));
+  histogram.add(std::chrono::milliseconds(-10));
+  ASSERT_EQ(histogram.getCounts()[19], 6);
+  ASSERT_EQ(histogram.getCounts()[0], 1);
+  ASSERT_EQ(histogram.getMax(), std::chrono::milliseconds(10));
+
+  auto copy = data::TimingHistogram(histogram.serialize());
+  ASSERT_EQ(copy.size(), 102);
+  ASSERT_EQ(copy.getCounts(), histogram.getCounts());
+  ASSERT_EQ(copy.mean(), histogram.mean());
+
+  histogram.clear();
+  ASSERT_EQ(histogram.size(), 0);
+  ASSERT_EQ(histogram.getCounts()[19], 0);
+}
+
+TEST(TimingHistogram, Offset) {
+  // Only positive times, from 0 to 200 us
+  auto histogram = data::TimingHistogram(std::chrono::microseconds(10), 20,
+                                         std::chrono::nanoseconds(0));
+  for (int i = 0; i < 100; i++) {
+    histogram.add(std::chrono::microseconds(2 * i));
+  }
+  histogram.add(std::chrono::microseconds(-1));
+  histogram.add(std::chrono::milliseconds(1));
+
+  ASSERT_EQ(histogram.getCounts()[0], 6);
+  ASSERT_EQ(histogram.getCounts()[1], 5);
+  ASSERT_EQ(histogram.getCounts()[19], 6);
+  ASSERT_EQ(histogram.quantile(0.5), std::chrono::microseconds(105));
+
+  auto copy = data::TimingHistogram(histogram.serialize());
+  ASSERT_EQ(copy.getOffset(), std::chrono::nanoseconds(0));
+  ASSERT_EQ(copy.quantile(0.5), histogram.quantile(0.5));
+
+  // The summary leaves the bins out
+  auto summary = histogram.serializeSummary();
+  ASSERT_FALSE(summary.contains("counts"));
+  ASSERT_EQ(summary["count"], 102);
+  ASSERT_EQ(summary["max"], 1000000);
+  ASSERT_EQ(summary["p99"], histogram.quantile(0.99).count());
+  ASSERT_EQ(summary["mean"], histogram.mean().count());
+}
+
+TEST(DataCheckTimings, Add) {
+  auto timings = data::DataCheckTimings();
+  ASSERT_EQ(timings.size(), 0);
+
+  for (int i = 0; i < 10; i++) {
+    timings.add(std::chrono::microseconds(5), std::chrono::microseconds(i),
+                std::chrono::milliseconds(i));
+  }
+  ASSERT_EQ(timings.size(), 10);
+  ASSERT_EQ(timings.getIdleTimes().mean(), std::chrono::microseconds(5));
+  ASSERT_EQ(timings.getLatenesses().getMax(), std::chrono::microseconds(9));
+  ASSERT_EQ(timings.getDurations().getMax(), std::chrono::milliseconds(9));
+  ASSERT_EQ(timings.getDurations().mean(), std::chrono::microseconds(4500));
+
+  auto copy = data::DataCheckTimings(timings.serialize());
+  ASSERT_EQ(copy.size(), 10);
+  ASSERT_EQ(copy.getDurations().getCounts(),
+            timings.getDurations().getCounts());
+  ASSERT_EQ(copy.getLatenesses().mean(), timings.getLatenesses().mean());
+
+  // The times are never negative, so the bins start at zero
+  ASSERT_EQ(timings.getDurations().getOffset(), std::chrono::nanoseconds(0));
+  ASSERT_EQ(timings.getDurations().getCounts()[0], 1);
+
+  auto summary = timings.serializeSummary();
+  ASSERT_EQ(summary["durations"]["count"], 10);
+  ASSERT_EQ(summary["durations"]["max"], 9000000);
+  ASSERT_FALSE(summary["durations"].contains("counts"));
+
+  timings.clear();
+  ASSERT_EQ(timings.size(), 0);
+  ASSERT_EQ(timings.getIdleTimes().size(), 0);
+}
+
 TEST(FixedTimeSeries, Constructors) {
   // Testing the constructor that uses now as the starting time
   {
@@ -281,3 +764,85 @@ TEST(FixedTimeSeries, Constructors) {
     ASSERT_EQ(data[1].getTimeStamp(), std::chrono::microseconds(0 + 100));
   }
 }
+
+TEST(FixedTimeSeries, Skip) {
+  auto series = data::FixedTimeSeries(std::chrono::milliseconds(1));
+  series.skip(2);
+  series.add(std::vector<double>{1.0});
+  series.add(std::vector<double>{2.0});
+  series.skip(1);
+  series.skip(2);
+  series.add(std::vector<double>{3.0});
+  series.add(std::vector<double>{4.0});
+
+  // The lost data keep their slots
+  ASSERT_EQ(series[0].getTimeStamp(), std::chrono::milliseconds(2));
+  ASSERT_EQ(series[1].getTimeStamp(), std::chrono::milliseconds(3));
+  ASSERT_EQ(series[2].getTimeStamp(), std::chrono::milliseconds(7));
+  ASSERT_EQ(series[3].getTimeStamp(), std::chrono::milliseconds(8));
+}
+
+TEST(GaitPhaseEstimator, TracksStrides) {
+  // A sine hip angle whose maximum is at 25% of a 1.2 s stride. The cadence
+  // changes to 1 s strides halfway
+  auto estimator = data::GaitPhaseEstimator(0, 0.25, 0.6, 0.05);
+  std::vector<data::GaitPhase> phases;
+  estimator.onNewGaitPhase.listen(
+      [&phases](const data::GaitPhase &phase) { phases.push_back(phase); });
+
+  std::vector<std::chrono::microseconds> timeStamps;
+  std::vector<double> hips;
+  std::vector<double> truths;
+  double phase = 0;
+  for (size_t i = 0; i < 20000; i++) {
+    double strideDuration = i < 10000 ? 1.2 : 1.0;
+    timeStamps.push_back(std::chrono::milliseconds(i));
+    hips.push_back(std::sin(2 * M_PI * phase));
+    truths.push_back(phase);
+    phase = std::fmod(phase + 0.001 / strideDuration, 1.0);
+  }
+  for (size_t i = 0; i < hips.size(); i += 10) {
+    estimator.addBlock(data::DataBlock(&timeStamps[i], &hips[i], 10, 1));
+  }
+  ASSERT_EQ(phases.size(), 20000);
+
+  // Nothing is known before two maxima
+  ASSERT_DOUBLE_EQ(phases[0].percentage, -1.0);
+  ASSERT_DOUBLE_EQ(phases[1000].percentage, -1.0);
+  ASSERT_TRUE(estimator.isTracking());
+
+  size_t heelStrikeCount = 0;
+  size_t toeOffCount = 0;
+  for (size_t i = 0; i < phases.size(); i++) {
+    // The estimation settles after a few strides of each cadence
+    bool isSettled = (i > 5000 && i < 10000) || i > 15000;
+    if (isSettled) {
+      double distance = std::abs(phases[i].percentage - truths[i]);
+      ASSERT_LT(std::min(distance, 1.0 - distance), 0.02);
+    }
+
+    if (phases[i].event == data::GaitEvent::HEEL_STRIKE) {
+      heelStrikeCount++;
+      if (isSettled) {
+        ASSERT_TRUE(truths[i] < 0.02 || truths[i] > 0.98);
+      }
+    } else if (phases[i].event == data::GaitEvent::TOE_OFF) {
+      toeOffCount++;
+      if (isSettled) {
+        ASSERT_NEAR(truths[i], 0.6, 0.02);
+      }
+    }
+  }
+
+  // One event per stride once the stride is known (8 + 10 strides)
+  ASSERT_GE(heelStrikeCount, 16);
+  ASSERT_LE(heelStrikeCount, 18);
+  ASSERT_GE(toeOffCount, 16);
+  ASSERT_LE(toeOffCount, 18);
+  ASSERT_NEAR(estimator.getStrideDuration().count(), 1000000, 20000);
+
+  // Once reset, the strides must be learnt again
+  estimator.reset();
+  ASSERT_FALSE(estimator.isTracking());
+  ASSERT_EQ(estimator.getStrideCount(), 0);
+}
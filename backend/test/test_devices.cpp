@@ -2,6 +2,7 @@
 #include <iostream>
 #include <thread>
 
+#include "Data/FixedTimeSeries.h"
 #include "Devices/all.h"
 #include "utils.h"
 
@@ -604,6 +605,455 @@ TEST(Devices, LiveData) {
   }
 }
 
+TEST(Devices, DataBlockEvents) {
+  auto logger = TestLogger();
+  auto devices = devices::Devices();
+  auto deviceId =
+      devices.add(std::make_unique<devices::DelsysEmgDeviceMock>());
+  auto &dataCollector = const_cast<devices::DataCollector &>(
+      devices.getDataCollector(deviceId));
+
+  // Each block carries all the samples added at once, in the same order as
+  // the live data, and the last one is also sent to [onNewData]
+  std::mutex mutex;
+  std::vector<data::DataPoint> blockSamples;
+  size_t blockCount = 0;
+  size_t lastSampleCount = 0;
+  data::DataPoint lastDataPoint;
+  auto blockId = dataCollector.onNewDataBlock.listen(
+      [&](const data::DataBlock &block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        blockCount++;
+        lastSampleCount = block.size();
+        for (size_t i = 0; i < block.size(); i++) {
+          blockSamples.push_back(block.dataPoint(i));
+        }
+      });
+  auto pointId = dataCollector.onNewData.listen(
+      [&](const data::DataPoint &dataPoint) {
+        std::lock_guard<std::mutex> lock(mutex);
+        lastDataPoint = dataPoint;
+      });
+
+  devices.connect();
+  devices.startDataStreaming();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  devices.stopDataStreaming();
+  dataCollector.onNewDataBlock.clear(blockId);
+  dataCollector.onNewData.clear(pointId);
+
+  auto liveData = data::TimeSeries(dataCollector.getSerializedLiveData());
+  ASSERT_GT(blockCount, 0);
+  ASSERT_EQ(lastSampleCount, 27);
+  ASSERT_EQ(blockSamples.size(), blockCount * 27);
+  // The live data may have been reset once all the devices started streaming,
+  // so compare the last blocks only
+  ASSERT_GE(blockSamples.size(), liveData.size());
+  size_t offset = blockSamples.size() - liveData.size();
+  for (size_t i = 0; i < liveData.size(); i++) {
+    ASSERT_EQ(blockSamples[offset + i].getTimeStamp(),
+              liveData[i].getTimeStamp());
+    ASSERT_EQ(blockSamples[offset + i].getData(), liveData[i].getData());
+  }
+  ASSERT_EQ(lastDataPoint.getTimeStamp(), liveData.back().getTimeStamp());
+}
+
+TEST(Devices, AcquisitionStatistics) {
+  auto logger = TestLogger();
+  auto devices = devices::Devices();
+  auto deviceId =
+      devices.add(std::make_unique<devices::DelsysEmgDeviceMock>());
+  const auto &dataCollector = devices.getDataCollector(deviceId);
+
+  devices.connect();
+  devices.startDataStreaming();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  devices.startRecording();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  devices.stopRecording();
+
+  // The mock sends every sample on time, so nothing is lost
+  auto live = dataCollector.getAcquisitionStatistics();
+  ASSERT_GT(live.getReceivedSampleCount(), 0);
+  ASSERT_EQ(live.getDroppedSampleCount(), 0);
+  ASSERT_TRUE(live.getGaps().empty());
+  ASSERT_GT(live.getExpectedSampleCount(), 0);
+  // Allow for the block being read and the scheduling of the test
+  ASSERT_LE(live.getUnaccountedSampleCount(), 27 * 4);
+
+  // The trial statistics cover exactly the recorded samples
+  auto trial = dataCollector.getTrialAcquisitionStatistics();
+  ASSERT_EQ(trial.getReceivedSampleCount(),
+            dataCollector.getTrialData().size());
+  ASSERT_LT(trial.getReceivedSampleCount(), live.getReceivedSampleCount());
+
+  // The statistics are sent along with the data
+  auto liveJson = devices.getLiveDataSerialized();
+  ASSERT_TRUE(liveJson[0].contains("acquisition"));
+  ASSERT_FALSE(liveJson[0]["acquisition"].contains("gaps"));
+  auto trialJson = devices.getLastTrialDataSerialized();
+  auto statistics = devices::Devices::deserializeAcquisitionStatistics(
+      trialJson[devices::Devices::DEVICES_KEY]);
+  ASSERT_EQ(statistics.size(), 1);
+  ASSERT_EQ(statistics.at("DelsysEmgDataCollector").getReceivedSampleCount(),
+            trial.getReceivedSampleCount());
+
+  // The data can still be deserialized
+  auto data = devices::Devices::deserializeData(
+      trialJson[devices::Devices::DEVICES_KEY]);
+  ASSERT_EQ(data.at("DelsysEmgDataCollector").size(),
+            trial.getReceivedSampleCount());
+}
+
+TEST(Devices, DataCheckTimings) {
+  auto logger = TestLogger();
+  auto devices = devices::Devices();
+  auto deviceId =
+      devices.add(std::make_unique<devices::DelsysEmgDeviceMock>());
+  const auto &dataCollector = dynamic_cast<const devices::AsyncDataCollector &>(
+      devices.getDataCollector(deviceId));
+  ASSERT_EQ(dataCollector.getDataCheckTimings().size(), 0);
+
+  devices.connect();
+  devices.startDataStreaming();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  // The checks wait for the blocks of the mock, so they are timed but are not
+  // counted as overruns
+  auto timings = dataCollector.getDataCheckTimings();
+  ASSERT_GT(timings.size(), 0);
+  ASSERT_EQ(timings.getIdleTimes().size(), timings.size());
+  ASSERT_EQ(timings.getLatenesses().size(), timings.size());
+  ASSERT_GE(timings.getIdleTimes().getMin(), std::chrono::nanoseconds(0));
+  ASSERT_GT(timings.getDurations().getMax(), std::chrono::nanoseconds(0));
+  ASSERT_EQ(dataCollector.getAcquisitionStatistics().getTimerOverrunCount(), 0);
+
+  // Their summary is sent along with the live data, the whole histograms on
+  // request
+  auto liveJson = devices.getLiveDataSerialized();
+  ASSERT_GE(liveJson[0]["dataCheck"]["durations"]["count"], timings.size());
+  ASSERT_FALSE(liveJson[0]["dataCheck"]["durations"].contains("counts"));
+  auto sent = devices::Devices::deserializeDataCheckTimings(
+      devices.getDataCheckTimingsSerialized());
+  ASSERT_EQ(sent.size(), 1);
+  ASSERT_GE(sent.at("DelsysEmgDataCollector").size(), timings.size());
+
+  // The timings restart with the data streaming
+  devices.stopDataStreaming();
+  devices.startDataStreaming();
+  ASSERT_LT(dataCollector.getDataCheckTimings().size(), timings.size());
+}
+
+// A collector adding the blocks it is given at once, the zeros being samples
+// lost in the middle of the block (as the empty frames of the Delsys)
+class BlockCollector : public devices::DataCollector {
+public:
+  BlockCollector()
+      : DataCollector(1, []() {
+          return std::make_unique<data::FixedTimeSeries>(
+              std::chrono::milliseconds(1));
+        }) {
+    setSamplePeriod(std::chrono::milliseconds(1));
+  }
+
+  std::string dataCollectorName() const override { return "BlockCollector"; }
+
+  void addBlock(const std::vector<double> &values) {
+    std::vector<std::vector<double>> block;
+    for (auto value : values) {
+      if (value == 0.0) {
+        reportDroppedSamples(
+            1, data::AcquisitionStatistics::GapReason::EMPTY_FRAME,
+            block.size());
+        continue;
+      }
+      block.push_back({value});
+    }
+    addDataPoints(block);
+  }
+
+  void setTrialWriterQueueCapacity(size_t capacity) {
+    m_TrialWriter = std::make_unique<data::TrialWriter>(
+        capacity, std::chrono::milliseconds(1000));
+  }
+
+protected:
+  bool handleStartDataStreaming() override { return true; }
+  bool handleStopDataStreaming() override { return true; }
+  void handleNewData(const data::DataPoint &) override {}
+};
+
+TEST(DataCollector, GapsInsideBlock) {
+  auto logger = TestLogger();
+  auto collector = BlockCollector();
+  size_t blockCount = 0;
+  collector.onNewDataBlock.listen(
+      [&blockCount](const data::DataBlock &) { blockCount++; });
+
+  collector.startDataStreaming();
+  collector.startRecording();
+  collector.addBlock({1.0, 2.0, 0.0, 0.0, 3.0, 0.0});
+  collector.addBlock({0.0, 4.0});
+  collector.stopRecording();
+
+  // Each block is notified once, whatever was lost inside
+  ASSERT_EQ(blockCount, 2);
+
+  // The gaps are at their position in the data (the loss at the end of the
+  // first block and the one at the start of the second are merged)
+  auto statistics = collector.getTrialAcquisitionStatistics();
+  ASSERT_EQ(statistics.getReceivedSampleCount(), 4);
+  ASSERT_EQ(statistics.getDroppedSampleCount(), 4);
+  ASSERT_EQ(statistics.getGaps().size(), 2);
+  ASSERT_EQ(statistics.getGaps()[0].position, 2);
+  ASSERT_EQ(statistics.getGaps()[0].sampleCount, 2);
+  ASSERT_EQ(statistics.getGaps()[1].position, 3);
+  ASSERT_EQ(statistics.getGaps()[1].sampleCount, 2);
+
+  // The time stamps jump over the lost samples, in the live data and in the
+  // trial
+  auto live = data::TimeSeries(collector.getSerializedLiveData());
+  const auto &trial = collector.getTrialData();
+  ASSERT_EQ(live.size(), 4);
+  ASSERT_EQ(trial.size(), 4);
+  std::vector<std::chrono::milliseconds> expected = {
+      std::chrono::milliseconds(0), std::chrono::milliseconds(1),
+      std::chrono::milliseconds(4), std::chrono::milliseconds(7)};
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(live[i].getTimeStamp(), expected[i]);
+    ASSERT_EQ(trial[i].getTimeStamp(), expected[i]);
+  }
+
+  collector.stopDataStreaming();
+}
+
+TEST(DataCollector, TrialWriterOverflow) {
+  auto logger = TestLogger();
+  auto collector = BlockCollector();
+  collector.setTrialWriterQueueCapacity(1);
+
+  // The blocks come faster than the writer can take them, so most are dropped
+  size_t blockCount = 1000;
+  size_t blockSize = 2;
+  collector.startDataStreaming();
+  collector.startRecording();
+  for (size_t i = 0; i < blockCount; i++) {
+    collector.addBlock({static_cast<double>(i * blockSize + 1),
+                        static_cast<double>(i * blockSize + 2)});
+  }
+  collector.stopRecording();
+
+  // The dropped blocks are lost for the trial, not received
+  auto metrics = collector.getTrialWriterMetrics();
+  auto statistics = collector.getTrialAcquisitionStatistics();
+  ASSERT_GT(metrics.droppedBlockCount, 0);
+  ASSERT_EQ(statistics.getReceivedSampleCount(), metrics.writtenSampleCount);
+  ASSERT_EQ(statistics.getDroppedSampleCount(), metrics.droppedSampleCount);
+  ASSERT_EQ(statistics.getReceivedSampleCount() +
+                statistics.getDroppedSampleCount(),
+            blockCount * blockSize);
+  ASSERT_EQ(statistics.getGaps().front().reason,
+            data::AcquisitionStatistics::GapReason::WRITER_OVERFLOW);
+
+  // The time stamps of the trial jump over the dropped blocks
+  const auto &trial = collector.getTrialData();
+  ASSERT_EQ(trial.size(), statistics.getReceivedSampleCount());
+  for (size_t i = 0; i < trial.size(); i++) {
+    auto index = static_cast<int64_t>(trial[i].getData()[0]) - 1;
+    ASSERT_EQ(trial[i].getTimeStamp(), std::chrono::milliseconds(index));
+  }
+
+  collector.stopDataStreaming();
+}
+
+TEST(DataCollector, LiveWindowShorterThanPreTrigger) {
+  auto logger = TestLogger();
+  auto collector = BlockCollector();
+  collector.setLiveDataTimeWindow(std::chrono::milliseconds(10));
+  collector.setPreTriggerDuration(std::chrono::milliseconds(50));
+  ASSERT_EQ(collector.getLiveDataCapacity(), 50);
+
+  collector.startDataStreaming();
+  std::vector<double> values;
+  for (size_t i = 0; i < 100; i++) {
+    values.push_back(static_cast<double>(i + 1));
+  }
+  collector.addBlock(values);
+
+  // Only the window is serialized, the rest is kept for the pre-trigger
+  auto live = data::TimeSeries(collector.getSerializedLiveData());
+  ASSERT_EQ(live.size(), 10);
+  ASSERT_EQ(live.front().getTimeStamp(), std::chrono::milliseconds(90));
+  ASSERT_EQ(live.back().getTimeStamp(), std::chrono::milliseconds(99));
+
+  collector.startRecording();
+  collector.stopRecording();
+  ASSERT_EQ(collector.getTrialData().size(), 50);
+  ASSERT_EQ(collector.getTrialData().front().getTimeStamp(),
+            std::chrono::milliseconds(50));
+
+  collector.stopDataStreaming();
+}
+
+TEST(Devices, ClockSynchronization) {
+  auto logger = TestLogger();
+  auto devices = devices::Devices();
+  auto deviceId =
+      devices.add(std::make_unique<devices::DelsysEmgDeviceMock>());
+  const auto &dataCollector = devices.getDataCollector(deviceId);
+
+  devices.connect();
+  devices.startDataStreaming();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  devices.startRecording();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  devices.stopRecording();
+
+  // The mock sends the samples at the nominal rate of the host clock
+  auto synchronizer = dataCollector.getClockSynchronizer();
+  ASSERT_TRUE(synchronizer.isSynchronized());
+  ASSERT_NEAR(synchronizer.getEstimatedSamplePeriod(),
+              dataCollector.getSamplePeriod().count(),
+              dataCollector.getSamplePeriod().count() * 0.05);
+
+  // The trial mapping starts at the first recorded sample
+  auto trialJson = devices.getLastTrialDataSerialized();
+  const auto &clock = trialJson[devices::Devices::DEVICES_KEY][0]["clock"];
+  ASSERT_GT(clock["firstSampleIndex"].get<size_t>(), 0);
+  ASSERT_TRUE(clock["isSynchronized"].get<bool>());
+  ASSERT_TRUE(devices.getLiveDataSerialized()[0].contains("clock"));
+}
+
+TEST(Devices, LiveDataTimeWindow) {
+  auto logger = TestLogger();
+  auto devices = devices::Devices();
+  auto deviceId =
+      devices.add(std::make_unique<devices::DelsysEmgDeviceMock>());
+  auto &dataCollector = const_cast<devices::DataCollector &>(
+      devices.getDataCollector(deviceId));
+
+  // The live buffer holds the default window at the rate of the device
+  auto period = dataCollector.getSamplePeriod();
+  ASSERT_GT(period.count(), 0);
+  ASSERT_EQ(dataCollector.getLiveDataCapacity(),
+            devices::DataCollector::DEFAULT_LIVE_DATA_TIME_WINDOW / period);
+
+  devices.connect();
+  devices.startDataStreaming();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // Shrinking the window while streaming keeps the most recent data
+  auto before = data::TimeSeries(dataCollector.getSerializedLiveData());
+  devices.setLiveDataTimeWindow(std::chrono::milliseconds(20));
+  size_t capacity = std::chrono::milliseconds(20) / period;
+  ASSERT_EQ(dataCollector.getLiveDataCapacity(), capacity);
+  auto after = data::TimeSeries(dataCollector.getSerializedLiveData());
+  ASSERT_LE(after.size(), capacity);
+  ASSERT_GE(after.front().getTimeStamp(),
+            before[before.size() - capacity].getTimeStamp());
+
+  // The stream goes on in the new buffer
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  auto later = data::TimeSeries(dataCollector.getSerializedLiveData());
+  ASSERT_EQ(later.size(), capacity);
+  ASSERT_GT(later.back().getTimeStamp(), after.back().getTimeStamp());
+
+  // Devices added later get the same window
+  auto otherId =
+      devices.add(std::make_unique<devices::DelsysEmgDeviceMock>());
+  ASSERT_EQ(devices.getDataCollector(otherId).getLiveDataTimeWindow(),
+            std::chrono::milliseconds(20));
+  devices.stopDataStreaming();
+}
+
+TEST(Devices, PreTrigger) {
+  auto logger = TestLogger();
+  auto devices = devices::Devices();
+  auto deviceId =
+      devices.add(std::make_unique<devices::DelsysEmgDeviceMock>());
+  auto &dataCollector = const_cast<devices::DataCollector &>(
+      devices.getDataCollector(deviceId));
+  auto period = dataCollector.getSamplePeriod();
+
+  // The live buffer grows to hold the pre-trigger
+  devices.setPreTriggerDuration(std::chrono::milliseconds(1000));
+  ASSERT_EQ(dataCollector.getLiveDataCapacity(),
+            std::chrono::milliseconds(1000) / period);
+  devices.setPreTriggerDuration(std::chrono::milliseconds(200));
+  ASSERT_EQ(dataCollector.getLiveDataCapacity(),
+            devices::DataCollector::DEFAULT_LIVE_DATA_TIME_WINDOW / period);
+
+  devices.connect();
+  devices.startDataStreaming();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+  auto recordingStart = std::chrono::system_clock::now();
+  devices.startRecording();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  devices.stopRecording();
+
+  // The trial starts about 200 ms before the recording and has no hole
+  const auto &trial = dataCollector.getTrialData();
+  auto trialStart = trial.getStartingTime() + trial.front().getTimeStamp();
+  ASSERT_LT(trialStart, recordingStart - std::chrono::milliseconds(150));
+  ASSERT_GT(trialStart, recordingStart - std::chrono::milliseconds(300));
+  for (size_t i = 1; i < trial.size(); i++) {
+    ASSERT_EQ(trial[i].getTimeStamp() - trial[i - 1].getTimeStamp(), period);
+  }
+  ASSERT_EQ(dataCollector.getTrialAcquisitionStatistics()
+                .getReceivedSampleCount(),
+            trial.size());
+  devices.stopDataStreaming();
+}
+
+TEST(Devices, EventMarkers) {
+  auto logger = TestLogger();
+  auto devices = devices::Devices();
+  devices.add(std::make_unique<devices::DelsysEmgDeviceMock>());
+  auto magstimId =
+      devices.add(devices::MagstimRapidDeviceMock::findMagstimDevice());
+  auto &magstim = const_cast<devices::Device &>(devices.getDevice(magstimId));
+
+  devices.connect();
+  devices.startDataStreaming();
+
+  // Events outside of the trial are not part of it
+  magstim.send(devices::MagstimRapidCommands::ARM);
+  magstim.send(devices::MagstimRapidCommands::DISARM);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  devices.startRecording();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto armTime = std::chrono::system_clock::now();
+  magstim.send(devices::MagstimRapidCommands::ARM);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  devices.stopRecording();
+  magstim.send(devices::MagstimRapidCommands::DISARM);
+
+  auto json = devices.getLastTrialDataSerialized();
+  auto markers = devices::Devices::deserializeEventMarkers(json);
+  ASSERT_EQ(markers.size(), 3);
+  ASSERT_EQ(markers[0].type, data::EventMarkerType::RECORDING_STARTED);
+  ASSERT_EQ(markers[1].type, data::EventMarkerType::STIMULATOR_ARMED);
+  ASSERT_EQ(markers[2].type, data::EventMarkerType::RECORDING_STOPPED);
+
+  // The markers are in the time frame of the data
+  auto armedAt = markers.getTime(markers[1]);
+  ASSERT_GE(armedAt, armTime - std::chrono::milliseconds(5));
+  ASSERT_LE(armedAt, armTime + std::chrono::milliseconds(20));
+  const auto &trial =
+      devices.getDataCollectors().begin()->second->getTrialData();
+  ASSERT_LT(trial.getStartingTime() + trial.front().getTimeStamp(), armedAt);
+  ASSERT_GT(trial.getStartingTime() + trial.back().getTimeStamp(), armedAt);
+
+  // The markers do not get in the way of the data
+  auto data =
+      devices::Devices::deserializeData(json[devices::Devices::DEVICES_KEY]);
+  ASSERT_EQ(data.size(), 1);
+  ASSERT_EQ(devices.getEventMarkers()->size(), 6);
+  devices.disconnect();
+}
+
 TEST(Devices, TrialData) {
   auto logger = TestLogger();
   auto devices = devices::Devices();
@@ -680,7 +1130,9 @@ TEST(Devices, SerializeTrialData) {
   devices.disconnect();
 
   // Serialize the data
-  auto data = devices.getLastTrialDataSerialized();
+  auto trial = devices.getLastTrialDataSerialized();
+  ASSERT_TRUE(trial.contains(devices::Devices::EVENT_MARKERS_KEY));
+  const auto &data = trial[devices::Devices::DEVICES_KEY];
   ASSERT_EQ(data.size(), 2);
   ASSERT_EQ(data[0]["name"], "DelsysEmgDataCollector");
   ASSERT_EQ(data[0]["data"]["startingTime"],
@@ -701,3 +1153,667 @@ TEST(Devices, SerializeTrialData) {
   ASSERT_EQ(data[1]["data"]["data"].size(),
             devices.getDataCollector(deviceIds[2]).getTrialData().size());
 }
+
+TEST(StimulationScheduler, FireAtDeadlines) {
+  auto logger = TestLogger();
+  auto scheduler = devices::StimulationScheduler();
+
+  // Schedule from several threads, out of order
+  size_t requestCount = 40;
+  std::vector<std::chrono::steady_clock::time_point> deadlines(requestCount);
+  std::vector<std::chrono::steady_clock::time_point> fired(requestCount);
+  std::vector<size_t> order;
+  auto start = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+  std::vector<std::thread> producers;
+  for (size_t thread = 0; thread < 2; thread++) {
+    producers.emplace_back([&, thread]() {
+      for (size_t i = thread; i < requestCount; i += 2) {
+        size_t index = requestCount - 1 - i;
+        deadlines[index] = start + std::chrono::milliseconds(2) * index;
+        scheduler.schedule(deadlines[index], [&, index]() {
+          fired[index] = std::chrono::steady_clock::now();
+          order.push_back(index);
+        });
+      }
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  auto cancelled = scheduler.schedule(start + std::chrono::milliseconds(30),
+                                      [&]() { order.push_back(requestCount); });
+  ASSERT_TRUE(scheduler.cancel(cancelled));
+  ASSERT_FALSE(scheduler.cancel(cancelled));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(120));
+  ASSERT_EQ(scheduler.getPendingCount(), 0);
+  auto errors = scheduler.getTimingErrors();
+  ASSERT_EQ(errors.size(), requestCount);
+
+  // Every request fired once, in order and never early
+  ASSERT_EQ(order.size(), requestCount);
+  for (size_t i = 0; i < requestCount; i++) {
+    ASSERT_EQ(order[i], i);
+    ASSERT_GE(fired[i], deadlines[i]);
+  }
+
+  // How close to the deadlines depends on the load of the machine, see
+  // run/bench_stimulation_scheduler.cpp
+  ASSERT_GE(errors.getMin(), std::chrono::nanoseconds(0));
+
+  auto json = errors.serialize();
+  ASSERT_EQ(json["count"], requestCount);
+  scheduler.resetTimingErrors();
+  ASSERT_EQ(scheduler.getTimingErrors().size(), 0);
+}
+
+TEST(StimulationScheduler, TriggerMagstim) {
+  auto logger = TestLogger();
+  auto magstim = devices::MagstimRapidDeviceMock::findMagstimDevice();
+  magstim->connect();
+  magstim->send(devices::MagstimRapidCommands::ARM);
+
+  // A request in the past fires right away, a request pending when the
+  // scheduler is destroyed does not fire
+  {
+    auto scheduler = devices::StimulationScheduler();
+    auto now = std::chrono::steady_clock::now();
+    scheduler.schedule(now - std::chrono::milliseconds(1),
+                       [&]() { magstim->trigger(); });
+    scheduler.schedule(now + std::chrono::milliseconds(5),
+                       [&]() { magstim->trigger(); });
+    scheduler.schedule(now + std::chrono::seconds(10),
+                       [&]() { magstim->trigger(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ASSERT_EQ(scheduler.getPendingCount(), 1);
+    ASSERT_EQ(scheduler.getTimingErrors().size(), 2);
+    ASSERT_GE(scheduler.getTimingErrors().getMax(),
+              std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(magstim->pulseCount, 2);
+  magstim->disconnect();
+}
+
+// The default rules of the Python scheduler
+const std::string DEFAULT_STIMULATION_RULES = R"json([
+  {
+    "name": "Stimulate during swing phase (stride based)",
+    "pulse": {"amplitudes": [50], "channels": [1]},
+    "start_stimulating_rule": {
+      "side": "left", "comparison": "from", "gait_event": "toe_off"
+    },
+    "continue_stimulating_rule": {
+      "side": "left", "comparison": "up_to", "gait_event": "heel_strike_100"
+    }
+  },
+  {
+    "name": "Stimulate during swing phase (percentage based)",
+    "pulse": {"amplitudes": [50], "channels": [2]},
+    "start_stimulating_rule": {
+      "side": "left", "comparison": ">=", "gait_percentage": 0.6
+    },
+    "continue_stimulating_rule": {
+      "side": "left", "comparison": "less_than", "gait_percentage": 1.0
+    }
+  },
+  {
+    "name": "Stimulate during swing phase (duration based)",
+    "pulse": {"amplitudes": [30], "channels": [3]},
+    "start_stimulating_rule": {
+      "side": "right", "comparison": "from", "gait_percentage": 0.6
+    },
+    "continue_stimulating_rule": {"comparison": "up_to", "duration": 0.1}
+  }
+])json";
+
+// A stimulator that records the amplitudes it is given
+class StimulatorRecorder : public devices::Stimulator {
+public:
+  void stimulate() override {}
+
+  void setChannelAmplitudes(const std::vector<size_t> &channels,
+                            const std::vector<double> &amplitudes) override {
+    for (size_t i = 0; i < channels.size(); i++) {
+      changes.push_back({channels[i], amplitudes[i]});
+    }
+  }
+
+  std::vector<std::pair<size_t, double>> changes;
+
+protected:
+  void HandleStimulation(const devices::DataPoint &) override {}
+};
+
+TEST(StimulationRule, FromJson) {
+  auto logger = TestLogger();
+  auto rules = devices::StimulationRule::fromJsonList(
+      nlohmann::json::parse(DEFAULT_STIMULATION_RULES));
+  ASSERT_EQ(rules.size(), 3);
+
+  ASSERT_EQ(rules[0].getName(),
+            "Stimulate during swing phase (stride based)");
+  ASSERT_EQ(rules[0].getChannels(), std::vector<size_t>({1}));
+  ASSERT_EQ(rules[0].getAmplitudes(), std::vector<double>({50}));
+  ASSERT_EQ(rules[0].getStart()->getComparison(),
+            devices::StimulationComparison::GREATER_OR_EQUAL);
+  ASSERT_EQ(rules[0].getStart()->getSide(), devices::StimulationSide::LEFT);
+  ASSERT_DOUBLE_EQ(rules[0].getStart()->getGaitPercentage(), 0.6);
+  ASSERT_FALSE(rules[0].getEnd());
+  ASSERT_EQ(rules[1].getContinue()->getComparison(),
+            devices::StimulationComparison::LESS);
+  ASSERT_EQ(rules[2].getContinue()->getSide(), devices::StimulationSide::NONE);
+  ASSERT_EQ(rules[2].getContinue()->getDuration(),
+            std::chrono::milliseconds(100));
+
+  // The conditions
+  const auto &start = *rules[0].getStart();
+  ASSERT_TRUE(start.isMet(0.6, -1, std::chrono::microseconds(-1)));
+  ASSERT_FALSE(start.isMet(0.59, 0.9, std::chrono::microseconds(-1)));
+  ASSERT_FALSE(start.isMet(-1, 0.9, std::chrono::microseconds(-1)));
+  const auto &duration = *rules[2].getContinue();
+  ASSERT_TRUE(duration.isMet(-1, -1, std::chrono::milliseconds(100)));
+  ASSERT_FALSE(duration.isMet(-1, -1, std::chrono::milliseconds(101)));
+  ASSERT_FALSE(duration.isMet(0.5, 0.5, std::chrono::microseconds(-1)));
+
+  // The serialization can be read back
+  auto json = rules[0].serialize();
+  ASSERT_EQ(json["start_stimulating_rule"]["comparison"], ">=");
+  ASSERT_EQ(json["start_stimulating_rule"]["gait_event"], "toe_off");
+  ASSERT_EQ(json["continue_stimulating_rule"]["gait_event"],
+            "heel_strike_100");
+  for (const auto &rule : rules) {
+    ASSERT_EQ(devices::StimulationRule(rule.serialize()).serialize(),
+              rule.serialize());
+  }
+
+  // Invalid rules
+  auto rule = nlohmann::json::parse(DEFAULT_STIMULATION_RULES)[0];
+  auto withChange = [&](const std::function<void(nlohmann::json &)> &change) {
+    auto changed = rule;
+    change(changed);
+    return changed;
+  };
+  ASSERT_THROW(devices::StimulationRule(
+                   withChange([](auto &json) { json.erase("name"); })),
+               devices::InvalidStimulationRuleException);
+  ASSERT_THROW(devices::StimulationRule(withChange([](auto &json) {
+                 json["pulse"]["amplitudes"] = {50, 20};
+               })),
+               devices::InvalidStimulationRuleException);
+  ASSERT_THROW(devices::StimulationRule(withChange([](auto &json) {
+                 json["start_stimulating_rule"]["comparison"] = "==";
+               })),
+               devices::InvalidStimulationRuleException);
+  ASSERT_THROW(devices::StimulationRule(withChange([](auto &json) {
+                 json["start_stimulating_rule"].erase("side");
+               })),
+               devices::InvalidStimulationRuleException);
+  ASSERT_THROW(devices::StimulationRule(withChange([](auto &json) {
+                 json["start_stimulating_rule"]["gait_event"] = "mid_swing";
+               })),
+               devices::InvalidStimulationRuleException);
+  ASSERT_THROW(devices::StimulationRule(withChange([](auto &json) {
+                 json.erase("continue_stimulating_rule");
+               })),
+               devices::InvalidStimulationRuleException);
+  ASSERT_THROW(devices::StimulationRule(withChange([](auto &json) {
+                 json["pulse"]["channels"] = "1";
+               })),
+               devices::InvalidStimulationRuleException);
+  ASSERT_THROW(devices::StimulationRule::fromFile("not_a_rules_file.json"),
+               devices::InvalidStimulationRuleException);
+}
+
+TEST(StimulationPlan, MatchesConditions) {
+  using devices::CompiledCondition;
+  auto logger = TestLogger();
+
+  // Every comparison, on each source, agrees with the condition it compiles
+  // (the threshold itself and the unknown inputs included)
+  std::vector<double> percentages = {-1, 0, 0.2, 0.3, 0.30001, 0.6, 1};
+  std::vector<std::chrono::microseconds> durations = {
+      std::chrono::microseconds(-1), std::chrono::microseconds(0),
+      std::chrono::microseconds(99999), std::chrono::microseconds(100000),
+      std::chrono::microseconds(100001)};
+  for (int comparison = 0; comparison < 4; comparison++) {
+    auto asComparison = static_cast<devices::StimulationComparison>(comparison);
+    std::vector<devices::StimulationCondition> conditions = {
+        devices::StimulationCondition::onGaitPercentage(
+            asComparison, devices::StimulationSide::LEFT, 0.3),
+        devices::StimulationCondition::onGaitPercentage(
+            asComparison, devices::StimulationSide::RIGHT, 0),
+        devices::StimulationCondition::onDuration(
+            asComparison, std::chrono::milliseconds(100))};
+
+    for (const auto &condition : conditions) {
+      auto compiled = devices::StimulationPlan::compile(condition);
+      for (auto left : percentages) {
+        for (auto right : percentages) {
+          for (auto duration : durations) {
+            double inputs[CompiledCondition::SOURCE_COUNT] = {
+                left, right, static_cast<double>(duration.count()), 0};
+            ASSERT_EQ(compiled.isMet(inputs),
+                      condition.isMet(left, right, duration));
+          }
+        }
+      }
+    }
+  }
+
+  // A rule stops on its end condition, or with a continue condition, as soon
+  // as one of its conditions is no longer met
+  auto rules = devices::StimulationRule::fromJsonList(
+      nlohmann::json::parse(DEFAULT_STIMULATION_RULES));
+  devices::StimulationPlan plan;
+  for (const auto &rule : rules) {
+    plan.add(rule);
+  }
+  ASSERT_EQ(plan.size(), 3);
+  double inputs[CompiledCondition::SOURCE_COUNT] = {0.7, -1, 1000, 0};
+  const auto &swing = plan.getRules()[0];
+  ASSERT_TRUE(swing.stopsWhenStartIsLost);
+  ASSERT_TRUE(swing.keepGoing.isMet(inputs));
+  ASSERT_FALSE(swing.end.isMet(inputs));
+
+  plan.clear();
+  plan.add(devices::StimulationRule(
+      "With an end", {0}, {10},
+      devices::StimulationCondition::onGaitPercentage(
+          devices::StimulationComparison::GREATER_OR_EQUAL,
+          devices::StimulationSide::LEFT, 0.5),
+      std::nullopt,
+      devices::StimulationCondition::onDuration(
+          devices::StimulationComparison::GREATER_OR_EQUAL,
+          std::chrono::milliseconds(1))));
+  const auto &withEnd = plan.getRules()[0];
+  ASSERT_FALSE(withEnd.stopsWhenStartIsLost);
+  ASSERT_TRUE(withEnd.keepGoing.isMet(inputs));
+  ASSERT_TRUE(withEnd.end.isMet(inputs));
+  inputs[CompiledCondition::STIMULATING_FOR] = 999;
+  ASSERT_FALSE(withEnd.end.isMet(inputs));
+}
+
+TEST(StimulationRuleEngine, DrivesStimulator) {
+  auto logger = TestLogger();
+  auto engine = devices::StimulationRuleEngine(0, 2);
+  engine.addRules(devices::StimulationRule::fromJsonList(
+      nlohmann::json::parse(DEFAULT_STIMULATION_RULES)));
+  ASSERT_EQ(engine.getRuleCount(), 3);
+  StimulatorRecorder stimulator;
+  engine.setStimulator(&stimulator);
+
+  std::vector<devices::StimulationDecision> decisions;
+  auto listenerId = engine.onStimulationDecision.listen(
+      [&](const devices::StimulationDecision &decision) {
+        decisions.push_back(decision);
+      });
+
+  // Feed 30 s of the Lokomat simulator, in blocks of 10 samples
+  devices::LokomatSimulatorTask lokomat(std::chrono::microseconds(1000), 1);
+  size_t channelCount = lokomat.getChannelCount();
+  size_t sampleCount = 30000;
+  size_t blockSize = 10;
+  std::vector<std::chrono::microseconds> timeStamps(sampleCount);
+  std::vector<double> samples(sampleCount * channelCount);
+  for (size_t i = 0; i < sampleCount; i++) {
+    timeStamps[i] = std::chrono::milliseconds(i);
+    lokomat.generateFrame(&samples[i * channelCount],
+                          static_cast<double>(i) * 1e-3);
+  }
+  for (size_t i = 0; i < sampleCount; i += blockSize) {
+    engine.processBlock(data::DataBlock(&timeStamps[i],
+                                        &samples[i * channelCount], blockSize,
+                                        channelCount));
+  }
+
+  // The true phases of the legs
+  auto truth = [&](const std::chrono::microseconds &timeStamp, size_t side) {
+    auto index = static_cast<size_t>(timeStamp.count() / 1000);
+    return samples[index * channelCount + 15 + side];
+  };
+
+  // Once the stride is known (after few strides), the swing rules follow the
+  // gait and the duration rule stimulates 100 ms once per stride
+  std::vector<size_t> startCounts(3, 0);
+  std::vector<std::chrono::microseconds> startedAt(3);
+  for (const auto &decision : decisions) {
+    if (decision.timeStamp < std::chrono::seconds(6)) {
+      startedAt[decision.ruleIndex] = decision.timeStamp;
+      continue;
+    }
+    double phase = truth(decision.timeStamp, decision.ruleIndex == 2 ? 1 : 0);
+    if (decision.isStarting) {
+      startCounts[decision.ruleIndex]++;
+      startedAt[decision.ruleIndex] = decision.timeStamp;
+      ASSERT_NEAR(phase, 0.6, 0.05);
+    } else if (decision.ruleIndex == 2) {
+      ASSERT_NEAR((decision.timeStamp - startedAt[2]).count(), 101000, 1);
+    } else {
+      ASSERT_LT(std::min(phase, 1.0 - phase), 0.05);
+    }
+  }
+  for (auto count : startCounts) {
+    ASSERT_GE(count, 16);
+    ASSERT_LE(count, 18);
+  }
+
+  // Every decision reached the stimulator
+  ASSERT_EQ(stimulator.changes.size(), decisions.size());
+  size_t stimulations = 0;
+  for (const auto &[channel, amplitude] : stimulator.changes) {
+    ASSERT_TRUE(channel >= 1 && channel <= 3);
+    if (amplitude > 0) {
+      stimulations++;
+      ASSERT_DOUBLE_EQ(amplitude, channel == 3 ? 30 : 50);
+    }
+  }
+  ASSERT_GE(stimulations, 3 * 16);
+
+  // Each block was timed
+  ASSERT_EQ(engine.getProcessingTimes().size(), sampleCount / blockSize);
+
+  // Clearing the rules stops the stimulations
+  size_t stimulating = 0;
+  for (size_t i = 0; i < engine.getRuleCount(); i++) {
+    stimulating += engine.isStimulating(i) ? 1 : 0;
+  }
+  decisions.clear();
+  stimulator.changes.clear();
+  engine.clearRules();
+  ASSERT_EQ(engine.getRuleCount(), 0);
+  ASSERT_EQ(decisions.size(), stimulating);
+  for (const auto &[channel, amplitude] : stimulator.changes) {
+    ASSERT_DOUBLE_EQ(amplitude, 0.0);
+  }
+  engine.onStimulationDecision.clear(listenerId);
+}
+
+TEST(StimulationRuleEngine, AttachCollector) {
+  auto logger = TestLogger();
+  devices::LokomatDeviceMock lokomat;
+  lokomat.connect();
+  lokomat.startDataStreaming();
+
+  // The hip channels must be in the data
+  {
+    auto engine = devices::StimulationRuleEngine(0, 100);
+    ASSERT_FALSE(engine.attach(lokomat));
+    ASSERT_FALSE(engine.isAttached());
+  }
+
+  auto engine = devices::StimulationRuleEngine(0, 2);
+  engine.addRules(devices::StimulationRule::fromJsonList(
+      nlohmann::json::parse(DEFAULT_STIMULATION_RULES)));
+  ASSERT_TRUE(engine.attach(lokomat));
+  ASSERT_TRUE(engine.isAttached());
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  engine.detach();
+  ASSERT_FALSE(engine.isAttached());
+
+  // The blocks are no longer processed once detached
+  auto processedCount = engine.getProcessingTimes().size();
+  ASSERT_GE(processedCount, 10);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_EQ(engine.getProcessingTimes().size(), processedCount);
+
+  lokomat.stopDataStreaming();
+  lokomat.disconnect();
+}
+
+#ifndef _WIN32
+#include <filesystem>
+#include <fstream>
+
+TEST(UsbDeviceDiscovery, FakeRoot) {
+  auto logger = TestLogger();
+
+  // Build a fake dev and sysfs, a USB serial adapter already plugged
+  auto suffix = std::chrono::steady_clock::now().time_since_epoch().count();
+  auto root = std::filesystem::temp_directory_path() /
+              ("stimwalker_usb_" + std::to_string(suffix));
+  auto dev = root / "dev";
+  auto sys = root / "sys";
+  auto writeFile = [](const std::filesystem::path &path,
+                      const std::string &content) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path) << content << std::endl;
+  };
+  writeFile(sys / "class/tty/ttyUSB0/device/idVendor", "067b");
+  writeFile(sys / "class/tty/ttyUSB0/device/idProduct", "2303");
+  writeFile(dev / "ttyUSB0", "");
+  writeFile(dev / "tty0", "");
+
+  auto discovery = devices::UsbDeviceDiscovery(dev.string(), sys.string());
+  auto port = discovery.find("067B", "2303");
+  ASSERT_TRUE(port.has_value());
+  ASSERT_EQ(port->port, (dev / "ttyUSB0").string());
+  ASSERT_EQ(port->vid, "067B");
+  ASSERT_EQ(port->pid, "2303");
+  ASSERT_TRUE(discovery.find("067b", "2303").has_value());
+  ASSERT_EQ(discovery.getPorts().size(), 1);
+  ASSERT_EQ(discovery.getScanCount(), 1);
+
+  // An ACM device, whose IDs are in the parent of its interface
+  auto usb = sys / "devices/usb1/1-1";
+  writeFile(usb / "idVendor", "1234");
+  writeFile(usb / "idProduct", "abcd");
+  std::filesystem::create_directories(usb / "1-1:1.0/tty/ttyACM0");
+  std::filesystem::create_directories(sys / "class/tty/ttyACM0");
+  std::filesystem::create_directory_symlink(usb / "1-1:1.0",
+                                            sys / "class/tty/ttyACM0/device");
+  writeFile(dev / "ttyACM0", "");
+
+  port = discovery.find("1234", "ABCD");
+  ASSERT_TRUE(port.has_value());
+  ASSERT_EQ(port->port, (dev / "ttyACM0").string());
+  ASSERT_EQ(discovery.getPorts().size(), 2);
+
+  // Unplug the adapter
+  std::filesystem::remove(dev / "ttyUSB0");
+  ASSERT_FALSE(discovery.find("067B", "2303").has_value());
+  ASSERT_EQ(discovery.getPorts().size(), 1);
+
+  // The hotplug events kept the index up to date without scanning again
+  if (discovery.isWatching()) {
+    ASSERT_EQ(discovery.getScanCount(), 1);
+  }
+  discovery.refresh();
+  ASSERT_EQ(discovery.getPorts().size(), 1);
+
+  // A device file created before its sysfs entry is added once the entry is
+  // there
+  auto scanCount = discovery.getScanCount();
+  writeFile(dev / "ttyUSB1", "");
+  ASSERT_FALSE(discovery.find("0403", "6001").has_value());
+  writeFile(sys / "class/tty/ttyUSB1/device/idVendor", "0403");
+  writeFile(sys / "class/tty/ttyUSB1/device/idProduct", "6001");
+  port = discovery.find("0403", "6001");
+  ASSERT_TRUE(port.has_value());
+  ASSERT_EQ(port->port, (dev / "ttyUSB1").string());
+  if (discovery.isWatching()) {
+    ASSERT_EQ(discovery.getScanCount(), scanCount);
+  }
+
+  // A port whose IDs never come is given up, until the next scan
+  discovery.setPendingPortTimeout(std::chrono::milliseconds(10));
+  writeFile(dev / "ttyUSB2", "");
+  ASSERT_FALSE(discovery.find("0483", "5740").has_value());
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_FALSE(discovery.find("0483", "5740").has_value());
+  writeFile(sys / "class/tty/ttyUSB2/device/idVendor", "0483");
+  writeFile(sys / "class/tty/ttyUSB2/device/idProduct", "5740");
+  if (discovery.isWatching()) {
+    ASSERT_FALSE(discovery.find("0483", "5740").has_value());
+  }
+  discovery.refresh();
+  ASSERT_TRUE(discovery.find("0483", "5740").has_value());
+
+  std::filesystem::remove_all(root);
+}
+#endif // _WIN32
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+/// @brief A serial device with frames ending with a new line, talking to the
+/// test through a pseudo-terminal
+class PtySerialDevice : public devices::SerialPortDevice {
+public:
+  PtySerialDevice(const std::string &port)
+      : devices::SerialPortDevice(port, std::chrono::seconds(1)) {
+    m_FrameDecoder = std::make_unique<devices::DelimitedFrameDecoder>('\n');
+  }
+  ~PtySerialDevice() override {
+    stopDeviceWorkers();
+    stopSerialPortWorker();
+  }
+
+  std::string deviceName() const override { return "PtySerialDevice"; }
+
+  void write(const std::string &bytes) { writeToDevice(bytes); }
+
+  size_t frameCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return frames.size();
+  }
+
+  std::vector<std::string> frames;
+  std::vector<std::string> droppedBytes;
+  std::mutex mutex;
+
+protected:
+  devices::DeviceResponses
+  parseAsyncSendCommand([[maybe_unused]] const devices::DeviceCommands &command,
+                        [[maybe_unused]] const std::any &data) override {
+    return devices::DeviceResponses::COMMAND_NOT_FOUND;
+  }
+
+  void handleReceivedFrame(const std::string &frame) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    frames.push_back(frame);
+  }
+
+  void handleReadTimeout(const std::string &bytes) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    droppedBytes.push_back(bytes);
+  }
+};
+
+/// @brief Wait until [condition] is true, checking it every millisecond
+/// @return True if [condition] became true before [timeout]
+bool waitUntil(const std::function<bool()> &condition,
+               const std::chrono::milliseconds &timeout =
+                   std::chrono::milliseconds(5000)) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+/// @brief Read from [descriptor] until [count] bytes are received or nothing
+/// comes for a while
+std::string readFromPty(int descriptor, size_t count) {
+  std::string received;
+  while (received.size() < count) {
+    pollfd pollDescriptor{descriptor, POLLIN, 0};
+    if (poll(&pollDescriptor, 1, 1000) <= 0) {
+      break;
+    }
+    char buffer[4096];
+    auto byteCount = read(descriptor, buffer, sizeof(buffer));
+    if (byteCount <= 0) {
+      break;
+    }
+    received.append(buffer, byteCount);
+  }
+  return received;
+}
+
+TEST(SerialPortDevice, PtyCommunication) {
+  auto logger = TestLogger();
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  ASSERT_GE(master, 0);
+  grantpt(master);
+  unlockpt(master);
+
+  devices::SerialPortSettings settings;
+  settings.baudRate = 115200;
+  auto device = PtySerialDevice(ptsname(master));
+  device.setSerialPortSettings(settings);
+  device.setReadTimeout(std::chrono::milliseconds(20));
+  ASSERT_TRUE(device.connect());
+
+  // Many frames, arriving in arbitrary chunks
+  size_t frameCount = 2000;
+  std::string frame(31, 'a');
+  frame += '\n';
+  std::string stream;
+  for (size_t i = 0; i < frameCount; i++) {
+    stream += frame;
+  }
+  for (size_t sent = 0; sent < stream.size();) {
+    auto count = std::min(stream.size() - sent, size_t(1000));
+    auto written = ::write(master, stream.data() + sent, count);
+    ASSERT_GT(written, 0);
+    sent += written;
+  }
+  ASSERT_TRUE(
+      waitUntil([&]() { return device.frameCount() >= frameCount; }));
+  {
+    std::lock_guard<std::mutex> lock(device.mutex);
+    ASSERT_EQ(device.frames.size(), frameCount);
+    for (const auto &received : device.frames) {
+      ASSERT_EQ(received, frame);
+    }
+    device.frames.clear();
+  }
+
+  // A partial frame is dropped after the read timeout
+  ::write(master, "abc", 3);
+  ASSERT_TRUE(waitUntil([&]() {
+    std::lock_guard<std::mutex> lock(device.mutex);
+    return !device.droppedBytes.empty();
+  }));
+  ::write(master, "def\n", 4);
+  ASSERT_TRUE(waitUntil([&]() { return device.frameCount() > 0; }));
+  {
+    std::lock_guard<std::mutex> lock(device.mutex);
+    ASSERT_EQ(device.droppedBytes, std::vector<std::string>({"abc"}));
+    ASSERT_EQ(device.frames, std::vector<std::string>({"def\n"}));
+    device.frames.clear();
+  }
+
+  // Small writes queued together are coalesced, in order
+  auto writeCount = device.getWriteOperationCount();
+  std::string expected;
+  for (int i = 0; i < 1000; i++) {
+    auto bytes = std::to_string(i) + ",";
+    device.write(bytes);
+    expected += bytes;
+  }
+  ASSERT_EQ(readFromPty(master, expected.size()), expected);
+  ASSERT_LT(device.getWriteOperationCount() - writeCount, 1000);
+
+  // Each write is answered by the other side
+  for (size_t i = 0; i < 50; i++) {
+    device.write("ping\n");
+    ASSERT_EQ(readFromPty(master, 5), "ping\n");
+    ::write(master, "pong\n", 5);
+    ASSERT_TRUE(waitUntil([&]() { return device.frameCount() > i; }));
+  }
+  {
+    std::lock_guard<std::mutex> lock(device.mutex);
+    ASSERT_EQ(device.frames, std::vector<std::string>(50, "pong\n"));
+  }
+
+  ASSERT_TRUE(device.disconnect());
+  ASSERT_THROW(device.write("late"), devices::DeviceException);
+  close(master);
+}
+#endif // _WIN32
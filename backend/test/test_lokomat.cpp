@@ -1,19 +1,92 @@
-// #include <gtest/gtest.h>
-// #include <iostream>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <thread>
 
-// #include "Devices/Generic/Exceptions.h"
-// #include "Devices/Lokomat.h"
+#include "Devices/Concrete/LokomatDevice.h"
+#include "Devices/Exceptions.h"
+#include "utils.h"
 
-// static double requiredPrecision(1e-10);
+using namespace STIMWALKER_NAMESPACE;
 
-// using namespace STIMWALKER_NAMESPACE;
+// Start the tests
 
-// // Start the tests
+TEST(Lokomat, Info) {
+  auto lokomat = devices::LokomatDeviceMock();
 
-// TEST(Lokomat, factory) {
-//   bool isMock = true;
-//   auto lokomat = devices::makeLokomatDevice(isMock);
+  ASSERT_STREQ(lokomat.deviceName().c_str(), "LokomatDevice");
+  ASSERT_STREQ(lokomat.dataCollectorName().c_str(), "LokomatDataCollector");
+  ASSERT_EQ(lokomat.getDataChannelCount(), 25);
+  ASSERT_EQ(lokomat.getDeltaTime(), std::chrono::milliseconds(1));
+}
 
-//   ASSERT_EQ(lokomat->getDataChannelCount(), 25);
-//   ASSERT_EQ(lokomat->getFrameRate(), 1000);
-// }
+TEST(Lokomat, ConnectFailed) {
+  auto logger = TestLogger();
+  auto lokomat = devices::LokomatDeviceMock();
+  lokomat.shouldFailToConnect = true;
+
+  lokomat.connect();
+  ASSERT_FALSE(lokomat.getIsConnected());
+  ASSERT_TRUE(logger.contains("Could not connect to the device LokomatDevice"));
+}
+
+TEST(Lokomat, StartDataStreaming) {
+  auto logger = TestLogger();
+  auto lokomat = devices::LokomatDeviceMock();
+
+  lokomat.connect();
+  ASSERT_TRUE(lokomat.getIsConnected());
+
+  bool isStreamingData = lokomat.startDataStreaming();
+  ASSERT_TRUE(isStreamingData);
+  ASSERT_TRUE(logger.contains(
+      "The data collector LokomatDataCollector is now streaming data"));
+
+  lokomat.disconnect();
+  ASSERT_FALSE(lokomat.getIsStreamingData());
+  ASSERT_TRUE(logger.contains(
+      "The data collector LokomatDataCollector has stopped streaming data"));
+}
+
+TEST(Lokomat, LiveData) {
+  auto logger = TestLogger();
+  auto lokomat = devices::LokomatDeviceMock();
+  lokomat.connect();
+
+  // Keep more than a stride in the live data
+  lokomat.setLiveDataTimeWindow(std::chrono::milliseconds(2000));
+  lokomat.startDataStreaming();
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+  lokomat.stopDataStreaming();
+
+  // Technically it should have recorded exactly 1500 frames (1000Hz). But the
+  // material is not that precise. So we just check that it is at least 1200
+  auto serialized = lokomat.getSerializedLiveData();
+  std::vector<std::vector<double>> data;
+  for (const auto &point : serialized["data"]) {
+    data.push_back(point[1].get<std::vector<double>>());
+  }
+  ASSERT_GE(data.size(), 1200);
+  ASSERT_EQ(data[0].size(), 25);
+
+  // A whole stride (1.4 s) is covered, so the angles span a normal gait
+  double hipMin = 1e9, hipMax = -1e9, kneeMin = 1e9, kneeMax = -1e9;
+  size_t heelStrikeCount = 0;
+  for (size_t i = 0; i < data.size(); i++) {
+    hipMin = std::min(hipMin, data[i][0]);
+    hipMax = std::max(hipMax, data[i][0]);
+    kneeMin = std::min(kneeMin, data[i][1]);
+    kneeMax = std::max(kneeMax, data[i][1]);
+    if (data[i][17] > 2.5 && (i == 0 || data[i - 1][17] < 2.5)) {
+      heelStrikeCount++;
+    }
+
+    // The legs are half a cycle apart
+    double phaseDifference = std::fmod(data[i][16] - data[i][15] + 1.0, 1.0);
+    ASSERT_NEAR(phaseDifference, 0.5, 1e-6);
+  }
+  ASSERT_LT(hipMin, -5.0);
+  ASSERT_GT(hipMax, 25.0);
+  ASSERT_LT(kneeMin, 10.0);
+  ASSERT_GT(kneeMax, 50.0);
+  ASSERT_GE(heelStrikeCount, 1);
+}
@@ -1,7 +1,15 @@
 #include <gtest/gtest.h>
+#include <condition_variable>
 #include <iostream>
+#include <map>
 #include <thread>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif // _WIN32
+
 #include "Devices/Concrete/MagstimRapidDevice.h"
 #include "utils.h"
 
@@ -263,4 +271,281 @@ TEST(Magstim, AutomaticPokingArmed) {
 TEST(Magstim, ComputeCrc) {
   auto magstim = devices::MagstimRapidDeviceMock::findMagstimDevice();
   ASSERT_EQ(magstim->computeCrcInterface("Hello, world!"), "v");
-}
\ No newline at end of file
+}
+
+TEST(Magstim, SetPower) {
+  auto logger = TestLogger();
+  auto magstim = devices::MagstimRapidDeviceMock::findMagstimDevice();
+  magstim->connect();
+
+  auto response =
+      magstim->send(devices::MagstimRapidCommands::SET_POWER, std::any(50));
+  ASSERT_EQ(response.getValue(), devices::DeviceResponses::OK);
+  ASSERT_EQ(magstim->getPower(), 50);
+  ASSERT_TRUE(logger.contains("Set the power to 50%"));
+
+  // The power is a percentage of the maximum output
+  response =
+      magstim->send(devices::MagstimRapidCommands::SET_POWER, std::any(150));
+  ASSERT_EQ(response.getValue(), devices::DeviceResponses::NOK);
+  ASSERT_EQ(magstim->getPower(), 50);
+
+  magstim->disconnect();
+}
+
+TEST(Magstim, Trigger) {
+  auto logger = TestLogger();
+  auto magstim = devices::MagstimRapidDeviceMock::findMagstimDevice();
+  magstim->connect();
+
+  // Cannot fire a disarmed stimulator
+  ASSERT_FALSE(magstim->trigger());
+  ASSERT_TRUE(logger.contains("Cannot trigger the device MagstimRapidDevice "
+                              "because it is not armed"));
+  ASSERT_EQ(magstim->pulseCount, 0);
+
+  magstim->send(devices::MagstimRapidCommands::ARM);
+  ASSERT_TRUE(magstim->isStimulatorArmed);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(magstim->trigger());
+  }
+  ASSERT_EQ(magstim->pulseCount, 3);
+
+  // The stimulator is disarmed when disconnecting
+  magstim->disconnect();
+  ASSERT_FALSE(magstim->isStimulatorArmed);
+  ASSERT_FALSE(magstim->getIsArmed());
+}
+
+#ifndef _WIN32
+/// @brief A stand-in Magstim Rapid on the master side of a pseudo-terminal,
+/// so the device talks to it through an actual serial port
+class PtyMagstim {
+public:
+  PtyMagstim() {
+    m_Master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(m_Master);
+    unlockpt(m_Master);
+    port = ptsname(m_Master);
+    m_Worker = std::thread([this]() { run(); });
+  }
+  ~PtyMagstim() {
+    m_ShouldStop = true;
+    m_Worker.join();
+    close(m_Master);
+  }
+
+  std::string port;
+
+  /// @brief The commands received (without their CRC)
+  std::vector<std::string> commands;
+
+  /// @brief When each fire command was fully received
+  std::vector<std::chrono::high_resolution_clock::time_point> fireTimes;
+
+  /// @brief Notified when a fire command is received
+  std::condition_variable fired;
+
+  /// @brief The error to answer (as the second byte of the response) to the
+  /// commands starting with the key, instead of the status
+  std::map<char, char> errors;
+
+  std::mutex mutex;
+
+protected:
+  void run() {
+    std::string received;
+    while (!m_ShouldStop) {
+      pollfd descriptor{m_Master, POLLIN, 0};
+      if (poll(&descriptor, 1, 10) <= 0 || !(descriptor.revents & POLLIN)) {
+        continue;
+      }
+      char buffer[64];
+      auto byteCount = read(m_Master, buffer, sizeof(buffer));
+      if (byteCount <= 0) {
+        continue;
+      }
+      auto now = std::chrono::high_resolution_clock::now();
+      received.append(buffer, byteCount);
+
+      size_t length;
+      while ((length = commandLength(received)) > 0 &&
+             received.size() >= length) {
+        auto command = received.substr(0, length - 1);
+        received.erase(0, length);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          commands.push_back(command);
+          if (command == "EH") {
+            fireTimes.push_back(now);
+            fired.notify_all();
+          }
+        }
+        answer(command);
+      }
+    }
+  }
+
+  static size_t commandLength(const std::string &received) {
+    if (received.size() < 2) {
+      return 0;
+    }
+    switch (received[0]) {
+    case '@':
+      return 5;
+    default:
+      return 3;
+    }
+  }
+
+  void answer(const std::string &command) {
+    if (command == "EB") {
+      m_IsArmed = true;
+    } else if (command == "EA") {
+      m_IsArmed = false;
+    }
+
+    std::string response(1, command[0]);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto error = errors.find(command[0]);
+      if (error != errors.end()) {
+        response += error->second;
+        response += crc(response);
+        ::write(m_Master, response.data(), response.size());
+        return;
+      }
+    }
+    response += static_cast<char>(m_IsArmed ? 0x8E : 0x89);
+    if (command[0] == 'F') {
+      response += "375000";
+    }
+    response += crc(response);
+
+    if (command[0] == 'F') {
+      // Noise on the line, then a response split in two
+      std::string noise = "\xff";
+      ::write(m_Master, noise.data(), noise.size());
+      ::write(m_Master, response.data(), 4);
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      ::write(m_Master, response.data() + 4, response.size() - 4);
+      return;
+    }
+    ::write(m_Master, response.data(), response.size());
+  }
+
+  static std::string crc(const std::string &data) {
+    int sum = 0;
+    for (const auto &c : data) {
+      sum += c;
+    }
+    return std::string(1, static_cast<char>(~sum & 0xff));
+  }
+
+  int m_Master;
+  std::thread m_Worker;
+  std::atomic<bool> m_ShouldStop = false;
+  bool m_IsArmed = false;
+};
+
+TEST(Magstim, SerialProtocol) {
+  auto logger = TestLogger();
+  auto stimulator = PtyMagstim();
+  auto magstim = devices::MagstimRapidDevice(stimulator.port);
+
+  // Connecting takes the remote control of the stimulator
+  ASSERT_TRUE(magstim.connect());
+  {
+    std::lock_guard<std::mutex> lock(stimulator.mutex);
+    ASSERT_EQ(stimulator.commands, std::vector<std::string>({"Q@"}));
+  }
+
+  // The responses are framed whatever how they arrive
+  auto response = magstim.send(devices::MagstimRapidCommands::GET_TEMPERATURE);
+  ASSERT_EQ(response.getValue(), 37);
+
+  response =
+      magstim.send(devices::MagstimRapidCommands::SET_POWER, std::any(7));
+  ASSERT_EQ(response.getValue(), devices::DeviceResponses::OK);
+  response = magstim.send(devices::MagstimRapidCommands::ARM);
+  ASSERT_EQ(response.getValue(), devices::DeviceResponses::OK);
+
+  // Every fire command reaches the stimulator, in order (the latency is
+  // measured by run/bench_magstim_trigger.cpp)
+  for (int i = 0; i < 50; i++) {
+    ASSERT_TRUE(magstim.trigger());
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  {
+    std::unique_lock<std::mutex> lock(stimulator.mutex);
+    ASSERT_TRUE(stimulator.fired.wait_for(
+        lock, std::chrono::seconds(1),
+        [&stimulator]() { return stimulator.fireTimes.size() >= 50; }));
+    ASSERT_EQ(stimulator.fireTimes.size(), 50);
+    ASSERT_TRUE(std::is_sorted(stimulator.fireTimes.begin(),
+                               stimulator.fireTimes.end()));
+  }
+
+  // The responses to the fire commands do not get in the way of the others
+  response = magstim.send(devices::MagstimRapidCommands::GET_TEMPERATURE);
+  ASSERT_EQ(response.getValue(), 37);
+
+  // Disconnecting disarms and gives the control back
+  ASSERT_TRUE(magstim.disconnect());
+  {
+    std::lock_guard<std::mutex> lock(stimulator.mutex);
+    auto count = stimulator.commands.size();
+    ASSERT_EQ(stimulator.commands[count - 2], "EA");
+    ASSERT_EQ(stimulator.commands[count - 1], "R@");
+  }
+  ASSERT_FALSE(logger.contains("wrong CRC"));
+}
+
+TEST(Magstim, SerialProtocolErrors) {
+  auto logger = TestLogger();
+  auto stimulator = PtyMagstim();
+  auto magstim = devices::MagstimRapidDevice(stimulator.port);
+  ASSERT_TRUE(magstim.connect());
+
+  // The errors are in the second byte and take the place of the response
+  {
+    std::lock_guard<std::mutex> lock(stimulator.mutex);
+    stimulator.errors['@'] = '?';
+    stimulator.errors['F'] = '?';
+    stimulator.errors['E'] = 'S';
+  }
+  auto response =
+      magstim.send(devices::MagstimRapidCommands::SET_POWER, std::any(7));
+  ASSERT_EQ(response.getValue(), devices::DeviceResponses::NOK);
+  ASSERT_TRUE(logger.contains("The device MagstimRapidDevice received "
+                              "invalid data with the command @007"));
+  ASSERT_EQ(magstim.getPower(), 0);
+
+  response = magstim.send(devices::MagstimRapidCommands::GET_TEMPERATURE);
+  ASSERT_EQ(response.getValue(), devices::DeviceResponses::NOK);
+  ASSERT_TRUE(logger.contains("The device MagstimRapidDevice received "
+                              "invalid data with the command F@"));
+
+  response = magstim.send(devices::MagstimRapidCommands::ARM);
+  ASSERT_EQ(response.getValue(), devices::DeviceResponses::NOK);
+  ASSERT_TRUE(logger.contains("The device MagstimRapidDevice cannot execute "
+                              "the command EB in its state"));
+  ASSERT_FALSE(magstim.getIsArmed());
+
+  // The errors are framed on their own, so the next responses still are
+  {
+    std::lock_guard<std::mutex> lock(stimulator.mutex);
+    stimulator.errors.clear();
+  }
+  response = magstim.send(devices::MagstimRapidCommands::GET_TEMPERATURE);
+  ASSERT_EQ(response.getValue(), 37);
+  response =
+      magstim.send(devices::MagstimRapidCommands::SET_POWER, std::any(7));
+  ASSERT_EQ(response.getValue(), devices::DeviceResponses::OK);
+  ASSERT_EQ(magstim.getPower(), 7);
+
+  ASSERT_TRUE(magstim.disconnect());
+  ASSERT_FALSE(logger.contains("did not answer"));
+  ASSERT_FALSE(logger.contains("wrong CRC"));
+}
+#endif // _WIN32
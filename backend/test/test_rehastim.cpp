@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>
+
+#include "Devices/Concrete/RehastimDevice.h"
+#include "Utils/ByteRingBuffer.h"
+#include "utils.h"
+
+using namespace STIMWALKER_NAMESPACE;
+
+TEST(RehastimDevice, Frames) {
+  auto logger = TestLogger();
+  using Command = devices::RehastimDevice::ProtocolCommand;
+
+  // The start, stuffing and stop bytes of the payload are stuffed
+  std::string data("\x01\xF0\x81\x0F\x02", 5);
+  auto frame =
+      devices::RehastimDevice::encodeFrame(0x0F, Command::SINGLE_PULSE, data);
+  ASSERT_EQ(static_cast<std::uint8_t>(frame.front()), 0xF0);
+  ASSERT_EQ(static_cast<std::uint8_t>(frame.back()), 0x0F);
+  ASSERT_EQ(frame.size(), 6 + 2 + data.size() + 4);
+  ASSERT_EQ(frame.substr(1, frame.size() - 2).find('\x0F'), std::string::npos);
+
+  std::uint8_t packetNumber;
+  Command command;
+  std::string decoded;
+  ASSERT_TRUE(devices::RehastimDevice::decodeFrame(frame, packetNumber,
+                                                   command, decoded));
+  ASSERT_EQ(packetNumber, 0x0F);
+  ASSERT_EQ(command, Command::SINGLE_PULSE);
+  ASSERT_EQ(decoded, data);
+
+  // A corrupted frame is rejected
+  auto corrupted = frame;
+  corrupted[6] ^= 0x01;
+  ASSERT_FALSE(devices::RehastimDevice::decodeFrame(corrupted, packetNumber,
+                                                    command, decoded));
+
+  // The decoder finds the frames among noise, a frame cut by the next one
+  // and a corrupted frame
+  auto watchdog = devices::RehastimDevice::encodeFrame(1, Command::WATCHDOG);
+  std::string stream = "noise" + frame + frame.substr(0, 7) + watchdog +
+                       corrupted + watchdog;
+  utils::ByteRingBuffer buffer(256);
+  devices::RehastimFrameDecoder decoder;
+  std::vector<std::string> frames;
+  for (auto byte : stream) {
+    // One byte at a time, the worst case of the framing
+    buffer.write(&byte, 1);
+    while (!buffer.empty()) {
+      size_t length = 0;
+      auto status = decoder.decode(buffer, length);
+      if (status == devices::SerialFrameDecoder::Status::INCOMPLETE) {
+        break;
+      }
+      if (status == devices::SerialFrameDecoder::Status::SKIP) {
+        buffer.consume(length);
+        continue;
+      }
+      frames.push_back(buffer.read(length));
+    }
+  }
+  ASSERT_EQ(frames, std::vector<std::string>({frame, watchdog, watchdog}));
+}
+
+TEST(RehastimFrameDecoder, Fuzz) {
+  auto logger = TestLogger();
+  using Command = devices::RehastimProtocolCommand;
+  std::mt19937 generator(42);
+
+  // The start, stuffing and stop bytes are much more frequent than on a real
+  // line, to stress the stuffing
+  auto randomByte = [&generator]() {
+    const char special[] = {'\xF0', '\x81', '\x0F'};
+    return generator() % 4 == 0 ? special[generator() % 3]
+                                : static_cast<char>(generator() % 256);
+  };
+  auto randomFrame = [&](devices::RehastimPacket &packet) {
+    packet.number = static_cast<std::uint8_t>(generator() % 256);
+    packet.command = static_cast<Command>(generator() % 0x27);
+    packet.data.clear();
+    for (size_t i = generator() % 33; i > 0; i--) {
+      packet.data += randomByte();
+    }
+    return devices::RehastimDevice::encodeFrame(packet.number, packet.command,
+                                                packet.data);
+  };
+
+  // Valid frames among noise, truncated frames and corrupted frames
+  std::string stream;
+  std::vector<devices::RehastimPacket> expected;
+  for (int i = 0; i < 5000; i++) {
+    devices::RehastimPacket packet;
+    auto frame = randomFrame(packet);
+    switch (generator() % 6) {
+    case 0:
+      for (size_t j = 1 + generator() % 10; j > 0; j--) {
+        stream += randomByte();
+      }
+      break;
+    case 1:
+      stream += frame.substr(0, 1 + generator() % (frame.size() - 1));
+      break;
+    case 2:
+      frame[generator() % frame.size()] ^=
+          static_cast<char>(1 + generator() % 255);
+      stream += frame;
+      break;
+    default:
+      stream += frame;
+      expected.push_back(packet);
+      break;
+    }
+  }
+
+  // Fed in chunks of random sizes, as they come from the port
+  utils::ByteRingBuffer buffer(256);
+  devices::RehastimFrameDecoder decoder;
+  std::vector<devices::RehastimPacket> decoded;
+  for (size_t sent = 0; sent < stream.size();) {
+    auto count = std::min(stream.size() - sent, 1 + generator() % 64);
+    sent += buffer.write(stream.data() + sent, count);
+    while (!buffer.empty()) {
+      size_t length = 0;
+      auto status = decoder.decode(buffer, length);
+      if (status == devices::SerialFrameDecoder::Status::INCOMPLETE) {
+        break;
+      }
+      if (status == devices::SerialFrameDecoder::Status::SKIP) {
+        ASSERT_GT(length, 0);
+        buffer.consume(length);
+        continue;
+      }
+
+      // What the decoder found must be a valid frame
+      std::uint8_t number;
+      Command command;
+      std::string data;
+      ASSERT_TRUE(devices::RehastimDevice::decodeFrame(buffer.read(length),
+                                                       number, command, data));
+      ASSERT_EQ(decoder.getPacket().number, number);
+      ASSERT_EQ(decoder.getPacket().command, command);
+      ASSERT_EQ(decoder.getPacket().data, data);
+      decoded.push_back(decoder.getPacket());
+    }
+  }
+
+  // No valid frame is lost, and nothing else comes out
+  ASSERT_EQ(decoded.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(decoded[i].number, expected[i].number);
+    ASSERT_EQ(decoded[i].command, expected[i].command);
+    ASSERT_EQ(decoded[i].data, expected[i].data);
+  }
+}
+
+#ifndef _WIN32
+TEST(RehastimDevice, ChannelListMode) {
+  auto logger = TestLogger();
+  devices::RehastimDeviceMock device;
+  device.setStimulationPeriod(std::chrono::milliseconds(10));
+  device.setActiveChannels(0b00000101);
+  ASSERT_TRUE(device.connect());
+
+  // The stimulator introduced itself and was answered
+  for (int i = 0; i < 100 && !device.isInitAcknowledged(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_TRUE(device.isInitAcknowledged());
+
+  // Every acknowledgment of the stimulator comes out as an event
+  std::mutex acknowledgmentMutex;
+  std::vector<devices::RehastimAcknowledgment> acknowledgments;
+  device.onAcknowledgment.listen(
+      [&](const devices::RehastimAcknowledgment &acknowledgment) {
+        std::lock_guard<std::mutex> lock(acknowledgmentMutex);
+        acknowledgments.push_back(acknowledgment);
+      });
+
+  devices::RehastimPulse pulse;
+  pulse.pulseWidth = 300;
+  pulse.current = 20;
+  device.setChannelPulses({0}, {pulse});
+  ASSERT_EQ(device.send(devices::RehastimCommands::START_STIMULATION),
+            devices::DeviceResponses::OK);
+  ASSERT_TRUE(device.getIsStimulating());
+  ASSERT_TRUE(device.isStimulatorRunning());
+  ASSERT_EQ(device.getStimulatorPulses()[0], pulse);
+  ASSERT_EQ(device.getStimulatorUpdateCount(), 1);
+
+  // Many changes of the currents: they return right away and at most one
+  // update is sent per stimulation period, the last one with the last values
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 200; i++) {
+    device.setChannelAmplitudes({0, 2}, {static_cast<double>(i % 50), 10.0});
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  auto updateCount = device.getUpdateCount();
+  ASSERT_GT(updateCount, 2);
+  ASSERT_LE(updateCount - 1, elapsed / std::chrono::milliseconds(10) + 2);
+  ASSERT_EQ(device.getStimulatorUpdateCount(), updateCount);
+  ASSERT_EQ(device.getAcknowledgedUpdateCount(), updateCount);
+  ASSERT_EQ(device.getStimulatorPulses()[0].current, 199 % 50);
+  ASSERT_EQ(device.getStimulatorPulses()[0].pulseWidth, 300);
+  ASSERT_EQ(device.getStimulatorPulses()[2].current, 10);
+  ASSERT_EQ(device.getErrorCount(), 0);
+  {
+    std::lock_guard<std::mutex> lock(acknowledgmentMutex);
+    ASSERT_EQ(acknowledgments.size(), 1 + updateCount);
+    ASSERT_EQ(acknowledgments[0].command,
+              devices::RehastimProtocolCommand::INIT_CHANNEL_LIST_MODE);
+    for (size_t i = 1; i < acknowledgments.size(); i++) {
+      ASSERT_EQ(acknowledgments[i].command,
+                devices::RehastimProtocolCommand::START_CHANNEL_LIST_MODE);
+      ASSERT_EQ(acknowledgments[i].errorCode, 0);
+    }
+  }
+
+  // Single pulses are only delivered when the channel-list mode is stopped
+  device.stimulate();
+  ASSERT_TRUE(logger.contains("while the channel-list mode runs"));
+  ASSERT_EQ(device.send(devices::RehastimCommands::STOP_STIMULATION),
+            devices::DeviceResponses::OK);
+  ASSERT_FALSE(device.isStimulatorRunning());
+  device.stimulate();
+  for (int i = 0; i < 100 && device.getSinglePulseCount() < 2; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(device.getSinglePulseCount(), 2);
+
+  // The stimulator stops by itself on an error
+  ASSERT_EQ(device.send(devices::RehastimCommands::START_STIMULATION),
+            devices::DeviceResponses::OK);
+  device.simulateStimulationError(-2);
+  for (int i = 0; i < 100 && device.getIsStimulating(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_FALSE(device.getIsStimulating());
+  ASSERT_EQ(device.getErrorCount(), 1);
+  ASSERT_TRUE(logger.contains("stopped stimulating on the error -2"));
+
+  ASSERT_TRUE(device.disconnect());
+}
+#endif // _WIN32
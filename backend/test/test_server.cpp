@@ -1,3 +1,5 @@
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <thread>
@@ -627,6 +629,105 @@ TEST(Server, AddDevices) {
   logger.clear();
 }
 
+TEST(Server, AddLokomat) {
+  auto logger = TestLogger();
+
+  {
+    server::TcpServerMock server(5000, 5001, 5002, sufficientTimeoutPeriod);
+    server.startServer();
+
+    server::TcpClient client;
+    client.connect();
+
+    // The Lokomat streams along with the Delsys
+    bool isDelsysAdded = client.addDelsysEmgDevice();
+    bool isLokomatAdded = client.addLokomatDevice();
+    ASSERT_TRUE(isDelsysAdded);
+    ASSERT_TRUE(isLokomatAdded);
+
+    logger.giveTimeToUpdate();
+    ASSERT_TRUE(logger.contains("The device LokomatDevice is now connected"));
+    ASSERT_TRUE(logger.contains(
+        "The data collector LokomatDataCollector is now streaming data"));
+    ASSERT_TRUE(logger.contains(
+        "The data collector DelsysEmgDataCollector is now streaming data"));
+    logger.clear();
+
+    bool isLokomatRemoved = client.removeLokomatDevice();
+    ASSERT_TRUE(isLokomatRemoved);
+
+    logger.giveTimeToUpdate();
+    ASSERT_TRUE(
+        logger.contains("The device LokomatDevice is now disconnected"));
+  }
+  ASSERT_TRUE(logger.contains("Server has shut down"));
+  logger.clear();
+}
+
+TEST(Server, StimulationRules) {
+  auto logger = TestLogger();
+  auto rulesPath =
+      std::filesystem::temp_directory_path() / "stimwalker_test_rules.json";
+  {
+    std::ofstream file(rulesPath);
+    file << R"json([{
+      "name": "Swing",
+      "pulse": {"amplitudes": [50], "channels": [1]},
+      "start_stimulating_rule": {
+        "side": "left", "comparison": "from", "gait_event": "toe_off"
+      },
+      "continue_stimulating_rule": {
+        "side": "left", "comparison": "up_to", "gait_event": "heel_strike_100"
+      }
+    }])json";
+  }
+
+  {
+    server::TcpServerMock server(5000, 5001, 5002, sufficientTimeoutPeriod);
+    server.setStimulationRulesPath(rulesPath.string());
+    server.startServer();
+
+    server::TcpClient client;
+    client.connect();
+
+    // The rules need the Lokomat
+    ASSERT_FALSE(client.startStimulationRules());
+    ASSERT_TRUE(client.addLokomatDevice());
+    ASSERT_TRUE(client.startStimulationRules());
+
+    logger.giveTimeToUpdate();
+    ASSERT_TRUE(logger.contains("No stimulator is connected, the decisions of "
+                                "the stimulation rules are only reported"));
+    ASSERT_TRUE(logger.contains("Started 1 stimulation rule(s) from " +
+                                rulesPath.string()));
+
+    ASSERT_TRUE(client.stopStimulationRules());
+    ASSERT_FALSE(client.stopStimulationRules());
+
+    // Removing the Lokomat stops the rules
+    ASSERT_TRUE(client.startStimulationRules());
+    ASSERT_TRUE(client.removeLokomatDevice());
+    ASSERT_FALSE(client.stopStimulationRules());
+
+    // The rules drive the RehaStim, and removing it stops them
+    logger.clear();
+    ASSERT_TRUE(client.addLokomatDevice());
+    ASSERT_TRUE(client.addRehastimDevice());
+    ASSERT_TRUE(client.startStimulationRules());
+    logger.giveTimeToUpdate();
+    ASSERT_FALSE(logger.contains("No stimulator is connected"));
+    ASSERT_TRUE(client.removeRehastimDevice());
+    ASSERT_FALSE(client.stopStimulationRules());
+
+    // Removing a device without running rules does not try to stop them
+    logger.clear();
+    ASSERT_TRUE(client.removeLokomatDevice());
+    logger.giveTimeToUpdate();
+    ASSERT_FALSE(logger.contains("The stimulation rules are not running"));
+  }
+  std::filesystem::remove(rulesPath);
+}
+
 TEST(Server, Recording) {
   auto logger = TestLogger();
 
@@ -722,3 +823,38 @@ TEST(Server, LastTrialData) {
   auto data = client.getLastTrialData();
   ASSERT_GE(data["DelsysEmgDataCollector"].size(), 900); // Should be ~1000
 }
+
+TEST(Server, LiveDataStatistics) {
+  auto logger = TestLogger();
+
+  server::TcpServerMock server(5000, 5001, 5002, sufficientTimeoutPeriod);
+  server.startServer();
+  logger.giveTimeToUpdate();
+
+  server::TcpClient client;
+  client.connect();
+  ASSERT_EQ(client.getLiveDataUpdateCount(), 0);
+  ASSERT_EQ(client.getLiveDataByteCount(), 0);
+
+  // The server sends the live data every 100 ms
+  client.addDelsysEmgDevice();
+  std::this_thread::sleep_for(std::chrono::milliseconds(550));
+
+  auto updateCount = client.getLiveDataUpdateCount();
+  ASSERT_GE(updateCount, 3);
+  ASSERT_GT(client.getLiveDataByteCount(), updateCount * 16);
+
+  // The updates are stamped to the millisecond by the server
+  auto latencies = client.getLiveDataLatencies();
+  ASSERT_GE(latencies.size(), updateCount);
+  ASSERT_GE(latencies.getMin(), std::chrono::milliseconds(-1));
+  ASSERT_LT(latencies.getMax(), std::chrono::seconds(1));
+
+  // The whole timing of the data checks is sent on request
+  auto timings = client.getDataCheckTimings();
+  ASSERT_EQ(timings.size(), 1);
+  ASSERT_GT(timings.at("DelsysEmgDataCollector").size(), 0);
+
+  client.disconnect();
+  server.stopServer();
+}
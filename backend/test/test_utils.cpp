@@ -3,9 +3,15 @@
 
 #include "utils.h"
 
+#include "Utils/ByteRingBuffer.h"
+#include "Utils/EventExecutor.h"
 #include "Utils/Logger.h"
+#include "Utils/MpscQueue.h"
 #include "Utils/RollingVector.h"
+#include "Utils/SpscQueue.h"
 #include "Utils/StimwalkerEvent.h"
+#include "Utils/StringFormat.h"
+#include "Utils/Tracer.h"
 
 using namespace STIMWALKER_NAMESPACE;
 
@@ -125,6 +131,303 @@ TEST(Logger, LogFile) {
   }
 }
 
+TEST(Logger, Asynchronous) {
+  auto logger = TestLogger();
+  auto &loggerInstance = utils::Logger::getInstance();
+  loggerInstance.setLogLevel(utils::Logger::INFO);
+
+  // Long flush interval so only [flush] or a FATAL can write the messages
+  loggerInstance.setFlushPolicy(std::chrono::milliseconds(10000), 1000,
+                                utils::Logger::FATAL);
+  loggerInstance.setIsAsynchronous(true);
+  ASSERT_TRUE(loggerInstance.getIsAsynchronous());
+
+  // Messages are queued, not written
+  loggerInstance.info("This is an asynchronous info message");
+  loggerInstance.warning("This is an asynchronous warning message");
+  ASSERT_FALSE(logger.contains("[INFO]: This is an asynchronous info message"));
+
+  // Flushing writes them in order
+  loggerInstance.flush();
+  ASSERT_EQ(logger.count("This is an asynchronous"), 2);
+  ASSERT_TRUE(logger.contains("[INFO]: This is an asynchronous info message"));
+  ASSERT_TRUE(
+      logger.contains("[WARNING]: This is an asynchronous warning message"));
+
+  // A FATAL message is written synchronously along with the pending ones
+  logger.clear();
+  loggerInstance.info("This is a pending info message");
+  loggerInstance.fatal("This is an asynchronous error message");
+  ASSERT_TRUE(logger.contains("[INFO]: This is a pending info message"));
+  ASSERT_TRUE(logger.contains("[FATAL]: This is an asynchronous error message"));
+
+  // Messages from many threads are all written
+  logger.clear();
+  std::vector<std::thread> producers;
+  for (int i = 0; i < 4; i++) {
+    producers.push_back(std::thread([&loggerInstance]() {
+      for (int j = 0; j < 100; j++) {
+        loggerInstance.info("This is a threaded message");
+      }
+    }));
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  loggerInstance.flush();
+  ASSERT_EQ(logger.count("This is a threaded message"), 400);
+
+  // Going back to synchronous writes the pending messages
+  logger.clear();
+  loggerInstance.info("This is a last asynchronous message");
+  loggerInstance.setIsAsynchronous(false);
+  ASSERT_FALSE(loggerInstance.getIsAsynchronous());
+  ASSERT_TRUE(logger.contains("[INFO]: This is a last asynchronous message"));
+  loggerInstance.setFlushPolicy(std::chrono::milliseconds(100), 256,
+                                utils::Logger::WARNING);
+}
+
+TEST(Logger, LazyFormatting) {
+  auto logger = TestLogger();
+  auto &loggerInstance = utils::Logger::getInstance();
+  loggerInstance.setLogLevel(utils::Logger::WARNING);
+  ASSERT_FALSE(loggerInstance.isLevelEnabled(utils::Logger::INFO));
+  ASSERT_TRUE(loggerInstance.isLevelEnabled(utils::Logger::WARNING));
+
+  // Arguments of a disabled level are not even evaluated
+  int evaluationCount = 0;
+  auto evaluate = [&evaluationCount]() { return ++evaluationCount; };
+  STIMWALKER_LOG_INFO("This is a lazy info message {}", evaluate());
+  ASSERT_EQ(evaluationCount, 0);
+  ASSERT_FALSE(logger.contains("This is a lazy info message"));
+
+  STIMWALKER_LOG_WARNING("This is a lazy warning message {}", evaluate());
+  ASSERT_EQ(evaluationCount, 1);
+  ASSERT_TRUE(logger.contains("[WARNING]: This is a lazy warning message 1"));
+
+  // The formatting methods are available directly as well
+  loggerInstance.fatal("This is a formatted error message {} {}", 42, "done");
+  ASSERT_TRUE(
+      logger.contains("[FATAL]: This is a formatted error message 42 done"));
+
+  // DEBUG statements are compiled out below the minimum level
+  loggerInstance.setLogLevel(utils::Logger::DEBUG);
+  STIMWALKER_LOG_DEBUG("This is a lazy debug message {}", evaluate());
+#if STIMWALKER_MIN_LOG_LEVEL > 0
+  ASSERT_EQ(evaluationCount, 1);
+  ASSERT_FALSE(logger.contains("This is a lazy debug message"));
+#else
+  ASSERT_EQ(evaluationCount, 2);
+  ASSERT_TRUE(logger.contains("[DEBUG]: This is a lazy debug message 2"));
+#endif
+  loggerInstance.setLogLevel(utils::Logger::INFO);
+}
+
+TEST(StringFormat, Format) {
+  ASSERT_EQ(utils::format("No argument"), "No argument");
+  ASSERT_EQ(utils::format("{} + {} = {}", 1, 2u, 3L), "1 + 2 = 3");
+  ASSERT_EQ(utils::format("{}, {}, {}", -1.5, true, 'c'), "-1.5, true, c");
+  ASSERT_EQ(utils::format("{} {}", std::string("a"), "b"), "a b");
+  ASSERT_EQ(utils::format("{}us", std::chrono::microseconds(250)), "250us");
+  ASSERT_EQ(utils::format("{{}} {}", 1), "{} 1");
+  ASSERT_EQ(utils::format("{} {}", 1), "1 {}");
+  ASSERT_EQ(utils::format("{}", 1, 2), "1");
+
+  std::string out("Appended: ");
+  utils::formatTo(out, "{}", 10);
+  ASSERT_EQ(out, "Appended: 10");
+}
+
+TEST(Tracer, Spans) {
+  auto &tracer = utils::Tracer::getInstance();
+  tracer.setOutputPath("");
+
+  // Nothing is recorded while disabled
+  tracer.stop();
+  ASSERT_FALSE(tracer.isEnabled());
+  { STIMWALKER_TRACE_SCOPE("disabledSpan", "test"); }
+
+  // Spans from many threads are recorded in their own buffer
+  tracer.start();
+  ASSERT_TRUE(tracer.isEnabled());
+  ASSERT_EQ(tracer.getEventCount(), 0);
+  {
+    STIMWALKER_TRACE_SCOPE("outerSpan", "test");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    { STIMWALKER_TRACE_SCOPE("innerSpan", "test"); }
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.push_back(std::thread([]() {
+      for (int j = 0; j < 10; j++) {
+        STIMWALKER_TRACE_SCOPE("threadedSpan", "test");
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  tracer.stop();
+  ASSERT_EQ(tracer.getEventCount(), 42);
+  ASSERT_EQ(tracer.getDroppedEventCount(), 0);
+
+  // The inner span is closed (and recorded) first
+  auto events = tracer.getEvents();
+  ASSERT_EQ(events.size(), 5);
+  size_t mainIndex = 0;
+  for (size_t i = 0; i < events.size(); i++) {
+    if (events[i].second.size() == 2) {
+      mainIndex = i;
+    }
+  }
+  const auto &mainEvents = events[mainIndex].second;
+  ASSERT_STREQ(mainEvents[0].name, "innerSpan");
+  ASSERT_STREQ(mainEvents[1].name, "outerSpan");
+  ASSERT_GE(mainEvents[1].duration, std::chrono::milliseconds(2));
+  ASSERT_LE(mainEvents[1].start, mainEvents[0].start);
+
+  // The trace is in the Chrome trace event format
+  auto trace = tracer.serialize();
+  ASSERT_EQ(trace.find("{\"traceEvents\":["), 0);
+  ASSERT_NE(
+      trace.find("\"name\":\"outerSpan\",\"cat\":\"test\",\"ph\":\"X\""),
+      std::string::npos);
+  ASSERT_EQ(trace.find("disabledSpan"), std::string::npos);
+
+  // Restarting discards the previous recording
+  tracer.start();
+  ASSERT_EQ(tracer.getEventCount(), 0);
+  tracer.stop();
+}
+
+TEST(MpscQueue, PushAndPop) {
+  utils::MpscQueue<int> queue;
+  ASSERT_TRUE(queue.empty());
+
+  int value = 0;
+  ASSERT_FALSE(queue.pop(value));
+
+  queue.push(1);
+  queue.push(2);
+  ASSERT_EQ(queue.size(), 2);
+  ASSERT_TRUE(queue.pop(value));
+  ASSERT_EQ(value, 1);
+  ASSERT_TRUE(queue.pop(value));
+  ASSERT_EQ(value, 2);
+  ASSERT_FALSE(queue.pop(value));
+  ASSERT_TRUE(queue.empty());
+
+  // Multiple producers keep the order of each producer
+  std::vector<std::thread> producers;
+  for (int i = 0; i < 4; i++) {
+    producers.push_back(std::thread([&queue, i]() {
+      for (int j = 0; j < 1000; j++) {
+        queue.push(i * 1000 + j);
+      }
+    }));
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+
+  std::vector<int> lastIndices(4, -1);
+  size_t count = 0;
+  while (queue.pop(value)) {
+    ASSERT_GT(value % 1000, lastIndices[value / 1000]);
+    lastIndices[value / 1000] = value % 1000;
+    count++;
+  }
+  ASSERT_EQ(count, 4000);
+}
+
+TEST(SpscQueue, PushAndPop) {
+  utils::SpscQueue<int> queue(3);
+  ASSERT_EQ(queue.capacity(), 3);
+  ASSERT_TRUE(queue.empty());
+
+  int value = 0;
+  ASSERT_FALSE(queue.tryPop(value));
+
+  // The queue does not grow once full
+  ASSERT_TRUE(queue.tryPush(1));
+  ASSERT_TRUE(queue.tryPush(2));
+  ASSERT_TRUE(queue.tryPush(3));
+  ASSERT_FALSE(queue.tryPush(4));
+  ASSERT_EQ(queue.size(), 3);
+
+  ASSERT_TRUE(queue.tryPop(value));
+  ASSERT_EQ(value, 1);
+  ASSERT_TRUE(queue.tryPush(5));
+  ASSERT_TRUE(queue.tryPop(value));
+  ASSERT_EQ(value, 2);
+  ASSERT_TRUE(queue.tryPop(value));
+  ASSERT_EQ(value, 3);
+  ASSERT_TRUE(queue.tryPop(value));
+  ASSERT_EQ(value, 5);
+  ASSERT_TRUE(queue.empty());
+
+  // One producer and one consumer see every value in order
+  utils::SpscQueue<int> threadedQueue(16);
+  std::thread producer([&threadedQueue]() {
+    for (int i = 0; i < 10000; i++) {
+      while (!threadedQueue.tryPush(int(i))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  for (int i = 0; i < 10000; i++) {
+    while (!threadedQueue.tryPop(value)) {
+      std::this_thread::yield();
+    }
+    ASSERT_EQ(value, i);
+  }
+  producer.join();
+}
+
+TEST(ByteRingBuffer, WrapAround) {
+  auto buffer = utils::ByteRingBuffer(8);
+  ASSERT_TRUE(buffer.empty());
+  ASSERT_EQ(buffer.capacity(), 8);
+
+  ASSERT_EQ(buffer.write("abcdef", 6), 6);
+  ASSERT_EQ(buffer.read(4), "abcd");
+  ASSERT_EQ(buffer.size(), 2);
+
+  // The bytes wrap around the end of the storage
+  ASSERT_EQ(buffer.write("ghijklmn", 8), 6);
+  ASSERT_TRUE(buffer.full());
+  ASSERT_EQ(buffer.peek(0, 8), "efghijkl");
+  ASSERT_EQ(buffer[5], 'j');
+  ASSERT_EQ(buffer.find('k'), 6);
+  ASSERT_EQ(buffer.find('f', 2), utils::ByteRingBuffer::npos);
+  ASSERT_EQ(buffer.writableRegion().second, 0);
+
+  // The bytes held can be read in place, one contiguous run at a time
+  auto [front, frontSize] = buffer.readableRegion();
+  ASSERT_EQ(std::string(front, frontSize), "efgh");
+  auto [back, backSize] = buffer.readableRegion(5);
+  ASSERT_EQ(std::string(back, backSize), "jkl");
+  ASSERT_EQ(buffer.readableRegion(8).second, 0);
+
+  // The free space after the tail can be filled in place
+  buffer.consume(3);
+  auto [region, size] = buffer.writableRegion();
+  ASSERT_EQ(size, 3);
+  region[0] = 'x';
+  buffer.commitWrite(1);
+  ASSERT_EQ(buffer.read(2), "hi");
+
+  // Clearing does not move the region being filled
+  region = buffer.writableRegion().first;
+  buffer.clear();
+  ASSERT_TRUE(buffer.empty());
+  ASSERT_EQ(buffer.writableRegion().first, region);
+  region[0] = 'y';
+  buffer.commitWrite(1);
+  ASSERT_EQ(buffer.read(1), "y");
+  ASSERT_THROW(buffer.peek(0, 1), std::out_of_range);
+}
+
 TEST(StimwalkerEvent, Calling) {
   // Setup a listener that changes a value to test if it is properly called
   utils::StimwalkerEvent<int> event;
@@ -141,6 +444,112 @@ TEST(StimwalkerEvent, Calling) {
   ASSERT_EQ(result, 42);
 }
 
+TEST(StimwalkerEvent, IdsPerInstance) {
+  utils::StimwalkerEvent<int> firstEvent;
+  utils::StimwalkerEvent<int> secondEvent;
+  ASSERT_EQ(firstEvent.listen([](int) {}), 0);
+  ASSERT_EQ(firstEvent.listen([](int) {}), 1);
+  ASSERT_EQ(secondEvent.listen([](int) {}), 0);
+  ASSERT_EQ(firstEvent.getListenerCount(), 2);
+  ASSERT_EQ(secondEvent.getListenerCount(), 1);
+}
+
+TEST(StimwalkerEvent, ModifyFromCallback) {
+  utils::StimwalkerEvent<int> event;
+  int callCount = 0;
+  size_t selfId = 0;
+
+  // A listener can remove itself and add others without deadlocking
+  selfId = event.listen([&](int) {
+    callCount++;
+    event.clear(selfId);
+    event.listen([&callCount](int) { callCount += 10; });
+  });
+  event.notifyListeners(0);
+  ASSERT_EQ(callCount, 1);
+  ASSERT_EQ(event.getListenerCount(), 1);
+
+  event.notifyListeners(0);
+  ASSERT_EQ(callCount, 11);
+}
+
+TEST(StimwalkerEvent, ClearWaitsForRunningCallbacks) {
+  utils::StimwalkerEvent<int> event;
+  std::atomic<bool> isRunning(false);
+  std::atomic<bool> isDone(false);
+  auto id = event.listen([&](int) {
+    isRunning = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    isDone = true;
+  });
+
+  std::thread notifier([&event]() { event.notifyListeners(0); });
+  while (!isRunning) {
+    std::this_thread::yield();
+  }
+  event.clear(id);
+  ASSERT_TRUE(isDone);
+  notifier.join();
+}
+
+TEST(StimwalkerEvent, ClearWaitsForOlderNotifications) {
+  utils::StimwalkerEvent<int> event;
+  utils::StimwalkerEvent<int> otherEvent;
+  std::atomic<bool> isRunning(false);
+  std::atomic<bool> isDone(false);
+  auto id = event.listen([&](int) {
+    isRunning = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    isDone = true;
+  });
+
+  std::thread notifier([&event]() { event.notifyListeners(0); });
+  while (!isRunning) {
+    std::this_thread::yield();
+  }
+
+  // The list changed after the notification started, and the removal is made
+  // from a callback of another event: it still waits for the notification
+  event.listen([](int) {});
+  otherEvent.listen([&event, id](int) { event.clear(id); });
+  otherEvent.notifyListeners(0);
+  ASSERT_TRUE(isDone);
+  notifier.join();
+}
+
+TEST(StimwalkerEvent, AsynchronousDispatch) {
+  utils::StimwalkerEvent<int> event;
+  auto executor = std::make_shared<utils::EventExecutor>();
+  event.setExecutor(executor);
+  ASSERT_EQ(event.getExecutor(), executor);
+
+  std::vector<int> values;
+  std::thread::id listenerThread;
+  event.listen([&](int value) {
+    values.push_back(value);
+    listenerThread = std::this_thread::get_id();
+  });
+
+  for (int i = 0; i < 100; i++) {
+    event.notifyListeners(i);
+  }
+  executor->waitUntilIdle();
+  ASSERT_EQ(executor->getPendingTaskCount(), 0);
+
+  // All the values are received in order, but not from this thread
+  ASSERT_EQ(values.size(), 100);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(values[i], i);
+  }
+  ASSERT_NE(listenerThread, std::this_thread::get_id());
+
+  // Going back to synchronous calls the listeners right away
+  event.setExecutor(nullptr);
+  event.notifyListeners(100);
+  ASSERT_EQ(values.size(), 101);
+  ASSERT_EQ(listenerThread, std::this_thread::get_id());
+}
+
 TEST(RollingVector, Adding) {
   auto vector = utils::RollingVector<int>(5);
   ASSERT_EQ(vector.getMaxSize(), 5);
@@ -201,6 +610,83 @@ TEST(RollingVector, Adding) {
   ASSERT_EQ(vector.size(), 0);
 }
 
+TEST(RollingVector, Resize) {
+  auto vector = utils::RollingVector<int>(5);
+  for (int i = 1; i <= 7; i++) {
+    vector.push_back(i);
+  }
+
+  // Shrinking keeps the most recent values
+  vector.resize(3);
+  ASSERT_EQ(vector.getMaxSize(), 3);
+  ASSERT_EQ(vector.size(), 3);
+  ASSERT_TRUE(vector.getIsFull());
+  ASSERT_EQ(vector[0], 5);
+  ASSERT_EQ(vector[2], 7);
+  vector.push_back(8);
+  ASSERT_EQ(vector[0], 6);
+  ASSERT_EQ(vector.back(), 8);
+
+  // Growing keeps everything and fills the new room before rolling
+  vector.resize(5);
+  ASSERT_EQ(vector.size(), 3);
+  ASSERT_FALSE(vector.getIsFull());
+  vector.push_back(9);
+  vector.push_back(10);
+  ASSERT_TRUE(vector.getIsFull());
+  std::vector<int> values;
+  for (const auto &v : vector) {
+    values.push_back(v);
+  }
+  ASSERT_EQ(values, std::vector<int>({6, 7, 8, 9, 10}));
+  vector.push_back(11);
+  ASSERT_EQ(vector[0], 7);
+
+  // Unlimited vectors can be bounded
+  auto unlimited = utils::RollingVector<int>();
+  for (int i = 0; i < 10; i++) {
+    unlimited.push_back(i);
+  }
+  unlimited.resize(4);
+  ASSERT_EQ(unlimited.size(), 4);
+  ASSERT_EQ(unlimited.front(), 6);
+  ASSERT_EQ(unlimited.back(), 9);
+
+  EXPECT_THROW(vector.resize(0), std::invalid_argument);
+}
+
+TEST(RollingVector, AppendTail) {
+  // The source rolled, so its tail is split in two blocks
+  auto source = utils::RollingVector<int>(5);
+  for (int i = 1; i <= 8; i++) {
+    source.push_back(i);
+  }
+
+  auto unlimited = utils::RollingVector<int>();
+  unlimited.push_back(0);
+  unlimited.appendTail(source, 4);
+  ASSERT_EQ(unlimited.size(), 5);
+  std::vector<int> values;
+  for (const auto &v : unlimited) {
+    values.push_back(v);
+  }
+  ASSERT_EQ(values, std::vector<int>({0, 5, 6, 7, 8}));
+  unlimited.push_back(9);
+  ASSERT_EQ(unlimited.back(), 9);
+
+  // Asking for more than available copies what there is
+  auto limited = utils::RollingVector<int>(3);
+  limited.appendTail(source, 100);
+  ASSERT_EQ(limited.size(), 5);
+  ASSERT_EQ(limited[0], 6);
+  ASSERT_EQ(limited.back(), 8);
+
+  // Nothing to copy
+  auto empty = utils::RollingVector<int>();
+  empty.appendTail(utils::RollingVector<int>(3), 2);
+  ASSERT_EQ(empty.size(), 0);
+}
+
 TEST(RollingVector, NoLimit) {
   auto vector = utils::RollingVector<int>();
   ASSERT_EQ(vector.getMaxSize(), size_t(-1));
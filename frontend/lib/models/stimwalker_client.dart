@@ -333,7 +333,7 @@ class StimwalkerClient {
     _expectedResponseLength = null;
     final jsonRaw = json.decode(utf8.decode(_responseGetLastTrial));
     if (jsonRaw != null) {
-      lastTrialData.appendFromJson(jsonRaw as List);
+      lastTrialData.appendFromJson(jsonRaw['devices'] as List);
     }
     _responseCompleter!.complete();
   }